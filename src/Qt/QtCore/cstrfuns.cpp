@@ -389,8 +389,8 @@ static Q_ALWAYS_INLINE void qulltoString_helper(qulonglong number, int base, Cha
 
     case 2: SMALL_BASE_LOOP(2); break;
     case 8: SMALL_BASE_LOOP(8); break;
-    case 10: SMALL_BASE_LOOP(10); break;
-    case 16: BIG_BASE_LOOP(16); break;
+    case 10: QtMiscUtils::ulltoDecimal(number, p); break;
+    case 16: QtMiscUtils::ulltoHex(number, p); break;
 #undef SMALL_BASE_LOOP
 #endif
     default: BIG_BASE_LOOP(base); break;
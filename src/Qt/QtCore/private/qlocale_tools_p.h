@@ -47,6 +47,16 @@ qt_asciiToDouble(const char *num, qsizetype numLen,
 void qt_doubleToAscii(double d, QLocaleData::DoubleForm form, int precision,
                       char *buf, qsizetype bufSize,
                       bool &sign, int &length, int &decpt);
+void qt_doubleToShortestAscii(double d, char *buf, qsizetype bufSize,
+                              bool &sign, int &length, int &decpt);
+
+// The algorithm qt_doubleToAscii() uses for QLocale::FloatingPointShortest.
+// Both produce the same digits; this only exists to compare them in benchmarks.
+enum class QShortestDoubleAlgorithm {
+    Schubfach,  // qt_doubleToShortestAscii(), the default
+    Grisu       // libdouble-conversion's Grisu3 with its bignum fallback
+};
+Q_AUTOTEST_EXPORT void qt_setShortestDoubleAlgorithm(QShortestDoubleAlgorithm algorithm);
 
 [[nodiscard]] QString qulltoBasicLatin(qulonglong l, int base, bool negative);
 [[nodiscard]] QString qulltoa(qulonglong l, int base, const QStringView zero);
@@ -54,6 +64,9 @@ void qt_doubleToAscii(double d, QLocaleData::DoubleForm form, int precision,
 [[nodiscard]] Q_CORE_EXPORT QString qdtoa(qreal d, int *decpt, int *sign);
 [[nodiscard]] QString qdtoBasicLatin(double d, QLocaleData::DoubleForm form,
                                      int precision, bool uppercase);
+// Appends to result instead of returning a new string:
+void qdtoBasicLatin(QString &result, double d, QLocaleData::DoubleForm form,
+                    int precision, bool uppercase);
 [[nodiscard]] QByteArray qdtoAscii(double d, QLocaleData::DoubleForm form,
                                    int precision, bool uppercase);
 
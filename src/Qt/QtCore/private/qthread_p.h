@@ -181,6 +181,11 @@ public:
     void setPriority(QThread::Priority prio);
     Qt::HANDLE threadId() const noexcept;
 
+    // CPU topology; implemented for Linux and Windows only
+    static bool setCurrentThreadAffinity(const QList<int> &cpus);
+    static QList<QList<int>> numaNodes();
+    static int numaNodeOfAddress(const void *address);
+
     mutable QMutex mutex;
     QAtomicInt quitLockRef;
 
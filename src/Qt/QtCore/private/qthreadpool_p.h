@@ -22,8 +22,12 @@
 #include "QtCore/qthreadpool.h"
 #include "QtCore/qset.h"
 #include "QtCore/qqueue.h"
+#include "QtCore/qpointer.h"
 #include "private/qobject_p.h"
 
+#include <atomic>
+#include <memory>
+
 QT_REQUIRE_CONFIG(thread);
 
 QT_BEGIN_NAMESPACE
@@ -107,6 +111,106 @@ private:
     QRunnable *m_entries[MaxPageSize];
 };
 
+// A Chase-Lev work-stealing deque of fixed capacity. Only the owning thread
+// pushes and takes at the bottom (LIFO); any thread may steal from the top
+// (FIFO). The memory orders follow Lê et al., "Correct and Efficient
+// Work-Stealing for Weak Memory Models" (PPoPP 2013).
+class QWorkStealingDeque
+{
+public:
+    enum {
+        Capacity = 4096
+    };
+
+    // Returns false if the deque is full
+    bool push(QRunnable *runnable) noexcept
+    {
+        const qint64 b = bottom.load(std::memory_order_relaxed);
+        const qint64 t = top.load(std::memory_order_acquire);
+        if (b - t >= Capacity)
+            return false;
+        entries[b & (Capacity - 1)].store(runnable, std::memory_order_relaxed);
+        bottom.store(b + 1, std::memory_order_release);
+        return true;
+    }
+
+    QRunnable *take() noexcept
+    {
+        const qint64 b = bottom.load(std::memory_order_relaxed) - 1;
+        bottom.store(b, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        qint64 t = top.load(std::memory_order_relaxed);
+        if (t > b) {
+            bottom.store(b + 1, std::memory_order_relaxed);
+            return nullptr;
+        }
+        QRunnable *runnable = entries[b & (Capacity - 1)].load(std::memory_order_relaxed);
+        if (t == b) {
+            // the last one: race the thieves for it
+            if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst,
+                                             std::memory_order_relaxed)) {
+                runnable = nullptr;
+            }
+            bottom.store(b + 1, std::memory_order_relaxed);
+        }
+        return runnable;
+    }
+
+    // Returns nullptr if the deque is empty, or if another thread took the
+    // runnable first; lostRace is set in the latter case.
+    QRunnable *steal(bool *lostRace) noexcept
+    {
+        qint64 t = top.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        const qint64 b = bottom.load(std::memory_order_acquire);
+        if (t >= b)
+            return nullptr;
+        QRunnable *runnable = entries[t & (Capacity - 1)].load(std::memory_order_relaxed);
+        if (!top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst,
+                                         std::memory_order_relaxed)) {
+            *lostRace = true;
+            return nullptr;
+        }
+        return runnable;
+    }
+
+    bool isEmpty() const noexcept
+    {
+        return top.load(std::memory_order_relaxed) >= bottom.load(std::memory_order_relaxed);
+    }
+
+private:
+    alignas(64) std::atomic<qint64> top = 0;
+    alignas(64) std::atomic<qint64> bottom = 0;
+    alignas(64) std::atomic<QRunnable *> entries[Capacity] = {};
+};
+
+// Shared state of the work-stealing mode, created the first time it is
+// enabled. Deques are handed out to the pool's threads and stay alive
+// until the pool is destroyed, so that thieves never see one go away.
+struct QThreadPoolStealingState
+{
+    enum {
+        MaxThreads = 256    // threads beyond this work off the shared queue only
+    };
+
+    ~QThreadPoolStealingState()
+    {
+        for (auto &deque : deques)
+            delete deque.load(std::memory_order_relaxed);
+    }
+
+    std::atomic<bool> enabled = false;
+    std::atomic<int> dequeCount = 0;            // slots ever handed out
+    std::atomic<QWorkStealingDeque *> deques[MaxThreads] = {};
+    bool claimed[MaxThreads] = {};              // guarded by the pool's mutex
+
+    // Lock-free hints for the workers; they may be stale, which at worst
+    // costs a trip to the mutex or some parallelism, never a task.
+    std::atomic<bool> queueHint = false;        // the shared queue may be non-empty
+    std::atomic<bool> needMoreWorkers = true;   // a thread waits or could be started
+};
+
 class QThreadPoolThread;
 class Q_CORE_EXPORT QThreadPoolPrivate : public QObjectPrivate
 {
@@ -127,13 +231,25 @@ public:
     int maxThreadCount() const
     { return qMax(requestedMaxThreadCount, 1); }    // documentation says we start at least one
     void startThread(QRunnable *runnable = nullptr);
+    void restartExpiredThread(QRunnable *runnable = nullptr);
     void reset();
     bool waitForDone(const QDeadlineTimer &timer);
     void clear();
     void stealAndRunRunnable(QRunnable *runnable);
     void deletePageIfFinished(QueuePage *page);
 
+    bool tryPushLocal(QRunnable *runnable);
+    QRunnable *takeQueuedTask();
+    QRunnable *stealTask(QThreadPoolThread *thief);
+    bool hasStealableTasks() const;
+    int claimDeque();
+    void wakeIdleThread();
+    void updateWorkStealingHints();
+
     static QThreadPool *qtGuiInstance();
+    static QList<QThreadPool *> numaNodeInstances();
+    static QList<QPointer<QThreadPool>> &numaNodeInstanceList();
+    static QBasicMutex numaNodeInstanceMutex;
 
     mutable QMutex mutex;
     QSet<QThreadPoolThread *> allThreads;
@@ -149,6 +265,9 @@ public:
     int activeThreads = 0;
     uint stackSize = 0;
     QThread::Priority threadPriority = QThread::InheritPriority;
+    QList<int> cpuAffinity;
+    int affinityGeneration = 0;     // bumped by every setCpuAffinity()
+    std::unique_ptr<QThreadPoolStealingState> stealing;
 };
 
 QT_END_NAMESPACE
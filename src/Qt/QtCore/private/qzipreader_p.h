@@ -21,8 +21,11 @@
 #include <QtCore/qfile.h>
 #include <QtCore/qstring.h>
 
+#include <memory>
+
 QT_BEGIN_NAMESPACE
 
+class QThreadPool;
 class QZipReaderPrivate;
 
 class Q_CORE_EXPORT QZipReader
@@ -61,7 +64,12 @@ public:
 
     FileInfo entryInfoAt(int index) const;
     QByteArray fileData(const QString &fileName) const;
+    std::unique_ptr<QIODevice> openEntry(const QString &fileName) const;
+    std::unique_ptr<QIODevice> openEntry(int index) const;
     bool extractAll(const QString &destinationDir) const;
+#if QT_CONFIG(thread)
+    bool extractAll(const QString &destinationDir, QThreadPool *pool) const;
+#endif
 
     enum Status {
         NoError,
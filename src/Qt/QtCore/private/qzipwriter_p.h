@@ -21,6 +21,7 @@
 
 QT_BEGIN_NAMESPACE
 
+class QThreadPool;
 class QZipWriterPrivate;
 
 class Q_CORE_EXPORT QZipWriter
@@ -58,6 +59,11 @@ public:
     void setCreationPermissions(QFile::Permissions permissions);
     QFile::Permissions creationPermissions() const;
 
+#if QT_CONFIG(thread)
+    void setThreadPool(QThreadPool *pool);
+    QThreadPool *threadPool() const;
+#endif
+
     void addFile(const QString &fileName, const QByteArray &data);
 
     void addFile(const QString &fileName, QIODevice *device);
@@ -7,6 +7,7 @@
 #include <qdatastream.h>
 #include <qdebug.h>
 #include <qendian.h>
+#include <qsimd.h>
 
 #include <limits>
 
@@ -172,6 +173,32 @@ qsizetype QBitArray::count(bool on) const
     // it's the QByteArray implicit NUL, so it will not change the bit count
     const quint8 *const end = reinterpret_cast<const quint8 *>(d.end());
 
+#if defined(Q_PROCESSOR_X86) && defined(__AVX2__)
+    // Look up the count of each nibble with a byte shuffle (Muła's method);
+    // about twice as fast as popcnt on a word at a time.
+    if (end - bits >= 32) {
+        const __m256i lookup = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+                                                0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+        const __m256i lowNibbles = _mm256_set1_epi8(0x0f);
+        __m256i total = _mm256_setzero_si256();
+        while (end - bits >= 32) {
+            // each byte lane grows by at most 8 per round, so 31 rounds fit
+            __m256i partial = _mm256_setzero_si256();
+            for (int round = 0; round < 31 && end - bits >= 32; ++round, bits += 32) {
+                const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(bits));
+                const __m256i lo = _mm256_and_si256(v, lowNibbles);
+                const __m256i hi = _mm256_and_si256(_mm256_srli_epi16(v, 4), lowNibbles);
+                partial = _mm256_add_epi8(partial, _mm256_add_epi8(_mm256_shuffle_epi8(lookup, lo),
+                                                                   _mm256_shuffle_epi8(lookup, hi)));
+            }
+            total = _mm256_add_epi64(total, _mm256_sad_epu8(partial, _mm256_setzero_si256()));
+        }
+        alignas(32) quint64 sums[4];
+        _mm256_store_si256(reinterpret_cast<__m256i *>(sums), total);
+        numBits += qsizetype(sums[0] + sums[1] + sums[2] + sums[3]);
+    }
+#endif
+
     while (bits + 7 <= end) {
         quint64 v = qFromUnaligned<quint64>(bits);
         bits += 8;
@@ -515,6 +542,84 @@ quint32 QBitArray::toUInt32(QSysInfo::Endian endianness, bool *ok) const noexcep
     \sa operator==()
 */
 
+namespace {
+// The operations the bitwise kernels apply, for each width they work with.
+// KeepsTail says whether "x op 0" is x (otherwise it is 0).
+struct BitAnd
+{
+    static constexpr bool KeepsTail = false;
+    template <typename T> T operator()(T a, T b) const { return T(a & b); }
+#if defined(Q_PROCESSOR_X86) && defined(__SSE2__)
+    __m128i operator()(__m128i a, __m128i b) const { return _mm_and_si128(a, b); }
+#endif
+#if defined(Q_PROCESSOR_X86) && defined(__AVX2__)
+    __m256i operator()(__m256i a, __m256i b) const { return _mm256_and_si256(a, b); }
+#endif
+};
+
+struct BitOr
+{
+    static constexpr bool KeepsTail = true;
+    template <typename T> T operator()(T a, T b) const { return T(a | b); }
+#if defined(Q_PROCESSOR_X86) && defined(__SSE2__)
+    __m128i operator()(__m128i a, __m128i b) const { return _mm_or_si128(a, b); }
+#endif
+#if defined(Q_PROCESSOR_X86) && defined(__AVX2__)
+    __m256i operator()(__m256i a, __m256i b) const { return _mm256_or_si256(a, b); }
+#endif
+};
+
+struct BitXor
+{
+    static constexpr bool KeepsTail = true;
+    template <typename T> T operator()(T a, T b) const { return T(a ^ b); }
+#if defined(Q_PROCESSOR_X86) && defined(__SSE2__)
+    __m128i operator()(__m128i a, __m128i b) const { return _mm_xor_si128(a, b); }
+#endif
+#if defined(Q_PROCESSOR_X86) && defined(__AVX2__)
+    __m256i operator()(__m256i a, __m256i b) const { return _mm256_xor_si256(a, b); }
+#endif
+};
+
+struct BitAndNot
+{
+    static constexpr bool KeepsTail = true;
+    template <typename T> T operator()(T a, T b) const { return T(a & ~b); }
+#if defined(Q_PROCESSOR_X86) && defined(__SSE2__)
+    __m128i operator()(__m128i a, __m128i b) const { return _mm_andnot_si128(b, a); }
+#endif
+#if defined(Q_PROCESSOR_X86) && defined(__AVX2__)
+    __m256i operator()(__m256i a, __m256i b) const { return _mm256_andnot_si256(b, a); }
+#endif
+};
+} // unnamed namespace
+
+// dst[i] = op(p1[i], p2[i]) for n bytes, as wide as the target allows.
+// dst may be the same as p1 or p2, but must not otherwise overlap them.
+template <typename BitwiseOp>
+static void bitwiseKernel(uchar *dst, const uchar *p1, const uchar *p2, qsizetype n, BitwiseOp op)
+{
+    qsizetype i = 0;
+#if defined(Q_PROCESSOR_X86) && defined(__AVX2__)
+    for (; i + 32 <= n; i += 32) {
+        const __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p1 + i));
+        const __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p2 + i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i), op(a, b));
+    }
+#endif
+#if defined(Q_PROCESSOR_X86) && defined(__SSE2__)
+    for (; i + 16 <= n; i += 16) {
+        const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p1 + i));
+        const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p2 + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), op(a, b));
+    }
+#endif
+    for (; i + 8 <= n; i += 8)
+        qToUnaligned(op(qFromUnaligned<quint64>(p1 + i), qFromUnaligned<quint64>(p2 + i)), dst + i);
+    for (; i < n; ++i)
+        dst[i] = op(p1[i], p2[i]);
+}
+
 // Returns a new QBitArray that has the same size as the bigger of \a a1 and
 // \a a2, but whose contents are uninitialized.
 static QBitArray sizedForOverwrite(const QBitArray &a1, const QBitArray &a2)
@@ -569,14 +674,21 @@ QBitArray &performBitwiseOperationHelper(QBitArray &out, const QBitArray &a1,
         std::swap(n1, n2);
         std::swap(p1, p2);
     }
-    for (qsizetype i = 1; i < n2; ++i)
-        dst[i] = op(p1[i], p2[i]);
+    if (n2 > 1)
+        bitwiseKernel(dst + 1, p1 + 1, p2 + 1, n2 - 1, op);
 
     // Tail: operate as if both arrays had the same data by padding zeroes to
-    // the end of the shorter of the two (for std::bit_or and std::bit_xor, this is
-    // a memmove; for std::bit_and, it's memset to 0).
-    for (qsizetype i = qMax(n2, qsizetype(1)); i < n1; ++i)
-        dst[i] = op(p1[i], uchar(0));
+    // the end of the shorter of the two (for OR and XOR, this is a memmove;
+    // for AND, it's memset to 0).
+    const qsizetype tail = qMax(n2, qsizetype(1));
+    if (tail < n1) {
+        if constexpr (BitwiseOp::KeepsTail) {
+            if (dst != p1)
+                memmove(dst + tail, p1 + tail, n1 - tail);
+        } else {
+            memset(dst + tail, 0, n1 - tail);
+        }
+    }
 
     return out;
 }
@@ -659,12 +771,12 @@ QBitArray &performBitwiseOperation(QBitArray &self, QBitArray &other, BitwiseOp
 
 QBitArray &QBitArray::operator&=(QBitArray &&other)
 {
-    return performBitwiseOperation(*this, other, std::bit_and<uchar>());
+    return performBitwiseOperation(*this, other, BitAnd());
 }
 
 QBitArray &QBitArray::operator&=(const QBitArray &other)
 {
-    return performBitwiseOperation(*this, other, std::bit_and<uchar>());
+    return performBitwiseOperation(*this, other, BitAnd());
 }
 
 /*!
@@ -687,12 +799,12 @@ QBitArray &QBitArray::operator&=(const QBitArray &other)
 
 QBitArray &QBitArray::operator|=(QBitArray &&other)
 {
-    return performBitwiseOperation(*this, other, std::bit_or<uchar>());
+    return performBitwiseOperation(*this, other, BitOr());
 }
 
 QBitArray &QBitArray::operator|=(const QBitArray &other)
 {
-    return performBitwiseOperation(*this, other, std::bit_or<uchar>());
+    return performBitwiseOperation(*this, other, BitOr());
 }
 
 /*!
@@ -715,12 +827,85 @@ QBitArray &QBitArray::operator|=(const QBitArray &other)
 
 QBitArray &QBitArray::operator^=(QBitArray &&other)
 {
-    return performBitwiseOperation(*this, other, std::bit_xor<uchar>());
+    return performBitwiseOperation(*this, other, BitXor());
 }
 
 QBitArray &QBitArray::operator^=(const QBitArray &other)
 {
-    return performBitwiseOperation(*this, other, std::bit_xor<uchar>());
+    return performBitwiseOperation(*this, other, BitXor());
+}
+
+/*!
+    Clears every bit in this bit array that is set in \a other (an AND
+    with the complement of \a other), and returns a reference to this bit
+    array.
+
+    Unlike the other bitwise operators, this never changes the size of
+    the bit array: bits of \a other beyond size() are ignored, and bits
+    beyond the end of \a other are left as they are.
+
+    \sa operator&=(), operator~()
+*/
+QBitArray &QBitArray::subtract(const QBitArray &other)
+{
+    const qsizetype n = qMin(d.size(), other.d.size());
+    if (n <= 1)
+        return *this;
+    auto dst = reinterpret_cast<uchar *>(d.data()) + 1;
+    auto src = reinterpret_cast<const uchar *>(other.d.constData()) + 1;
+    bitwiseKernel(dst, dst, src, n - 1, BitAndNot());
+    return *this;
+}
+
+/*!
+    Returns the index position of the first bit set to 1 at or after index
+    position \a from, or -1 if there is none.
+
+    This makes it cheap to visit the set bits of a sparse bit array:
+
+    \code
+    for (qsizetype i = bits.nextSetBit(); i != -1; i = bits.nextSetBit(i + 1))
+        process(i);
+    \endcode
+
+    \sa count(), testBit()
+*/
+qsizetype QBitArray::nextSetBit(qsizetype from) const
+{
+    Q_ASSERT_X(from >= 0, "QBitArray::nextSetBit", "Position must be greater than or equal to 0.");
+    if (from >= size())
+        return -1;
+
+    // The bits beyond size() in the last byte are always 0, so they never
+    // produce a match.
+    const uchar *bits = reinterpret_cast<const uchar *>(d.constData()) + 1;
+    const uchar *const end = reinterpret_cast<const uchar *>(d.constData()) + d.size();
+    const uchar *p = bits + (from >> 3);
+    if (uint b = uint(*p) >> (from & 7))
+        return from + qCountTrailingZeroBits(b);
+    ++p;
+
+#if defined(Q_PROCESSOR_X86) && defined(__SSE2__)
+    // skip zero bytes sixteen at a time
+    const __m128i zero = _mm_setzero_si128();
+    for (; end - p >= 16; p += 16) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+        const uint zeroBytes = uint(_mm_movemask_epi8(_mm_cmpeq_epi8(v, zero)));
+        if (zeroBytes != 0xffff) {
+            p += qCountTrailingZeroBits(~zeroBytes);
+            return (p - bits) * 8 + qCountTrailingZeroBits(uint(*p));
+        }
+    }
+#endif
+    for (; end - p >= 8; p += 8) {
+        if (quint64 v = qFromLittleEndian(qFromUnaligned<quint64>(p)))
+            return (p - bits) * 8 + qCountTrailingZeroBits(v);
+    }
+    for (; p < end; ++p) {
+        if (*p)
+            return (p - bits) * 8 + qCountTrailingZeroBits(uint(*p));
+    }
+    return -1;
 }
 
 /*!
@@ -787,7 +972,7 @@ Q_NEVER_INLINE QBitArray QBitArray::inverted_inplace() &&
 QBitArray operator&(const QBitArray &a1, const QBitArray &a2)
 {
     QBitArray tmp = sizedForOverwrite(a1, a2);
-    performBitwiseOperationHelper(tmp, a1, a2, std::bit_and<uchar>());
+    performBitwiseOperationHelper(tmp, a1, a2, BitAnd());
     return tmp;
 }
 
@@ -813,7 +998,7 @@ QBitArray operator&(const QBitArray &a1, const QBitArray &a2)
 QBitArray operator|(const QBitArray &a1, const QBitArray &a2)
 {
     QBitArray tmp = sizedForOverwrite(a1, a2);
-    performBitwiseOperationHelper(tmp, a1, a2, std::bit_or<uchar>());
+    performBitwiseOperationHelper(tmp, a1, a2, BitOr());
     return tmp;
 }
 
@@ -839,7 +1024,7 @@ QBitArray operator|(const QBitArray &a1, const QBitArray &a2)
 QBitArray operator^(const QBitArray &a1, const QBitArray &a2)
 {
     QBitArray tmp = sizedForOverwrite(a1, a2);
-    performBitwiseOperationHelper(tmp, a1, a2, std::bit_xor<uchar>());
+    performBitwiseOperationHelper(tmp, a1, a2, BitXor());
     return tmp;
 }
 
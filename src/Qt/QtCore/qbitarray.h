@@ -112,6 +112,9 @@ public:
     QBitArray &operator&=(const QBitArray &);
     QBitArray &operator|=(const QBitArray &);
     QBitArray &operator^=(const QBitArray &);
+    QBitArray &subtract(const QBitArray &other);
+
+    qsizetype nextSetBit(qsizetype from = 0) const;
 #if QT_CORE_REMOVED_SINCE(6, 7)
     QBitArray operator~() const;
 #endif
@@ -0,0 +1,935 @@
+// Copyright (C) 2025 The Qt Company Ltd.
+
+
+#ifndef QBTREEMAP_H
+#define QBTREEMAP_H
+
+#include <QtCore/qcontainertools_impl.h>
+#include <QtCore/qglobal.h>
+#include <QtCore/qtypeinfo.h>
+
+#include <algorithm>
+#include <cstring>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+QT_BEGIN_NAMESPACE
+
+namespace QBTreeMapPrivate {
+
+// The B+tree behind QBTreeMap (Multi = false) and QMultiBTreeMap
+// (Multi = true). The entries live, in order, in leaves that hold up to
+// LeafCapacity of them in a contiguous array, and the leaves are linked to
+// each other, so iterating over a range touches few cache lines and a tree
+// with N entries needs about N / LeafCapacity allocations instead of N.
+//
+// Internal nodes hold child pointers and separator keys. For the children
+// c[i] and c[i + 1] of a node separated by s[i], every key in c[i] is
+// <= s[i] and every key in c[i + 1] is >= s[i], so lower_bound() and
+// upper_bound() can pick the child with the matching bound on the
+// separators.
+//
+// Every internal node has at least two children. Erasing keeps the nodes
+// other than the root at least a quarter full by merging them with, or
+// borrowing from, a sibling, and replaces a root with a single child by
+// that child. Appending at the right edge starts a new node instead of
+// splitting the last one in half, so sorted input yields full nodes.
+//
+// An insertion allocates all the nodes it needs before it changes the
+// tree, so running out of memory leaves the tree as it was. That doesn't
+// cover moving entries whose key type isn't relocatable: the key of an
+// entry is const, so moving the entry copies it, which may throw.
+template <typename Key, typename T, bool Multi>
+class Tree
+{
+    template <typename, typename, bool> friend class Tree;
+
+    static constexpr int clampCapacity(size_t n) noexcept
+    {
+        return n < 8 ? 8 : n > 64 ? 64 : int(n) & ~1;
+    }
+
+public:
+    using key_type = Key;
+    using mapped_type = T;
+    using value_type = std::pair<const Key, T>;
+    using size_type = size_t;
+    using difference_type = qptrdiff;
+    using key_compare = std::less<Key>;
+    using reference = value_type &;
+    using const_reference = const value_type &;
+
+    // aim for nodes of roughly 512 bytes, but keep leaves small for
+    // entries that can't be moved with memmove(), as every insertion and
+    // erasure shifts up to a leaf's worth of them
+    static constexpr int LeafCapacity =
+            QTypeInfo<Key>::isRelocatable && QTypeInfo<T>::isRelocatable
+            ? clampCapacity(512 / sizeof(value_type))
+            : std::min(clampCapacity(512 / sizeof(value_type)), 16);
+    static constexpr int InternalCapacity = clampCapacity(512 / (sizeof(Key) + sizeof(void *)));
+
+private:
+    static constexpr int MinLeafCount = LeafCapacity / 4;
+    static constexpr int MinInternalCount = InternalCapacity / 4;
+    // with at least two children per internal node
+    static constexpr int MaxHeight = int(sizeof(size_type)) * 8;
+    static constexpr bool IsRelocatable = QTypeInfo<Key>::isRelocatable && QTypeInfo<T>::isRelocatable;
+    static constexpr bool NothrowRelocate = IsRelocatable || std::is_nothrow_move_constructible_v<value_type>;
+
+    struct InternalNode;
+
+    struct NodeBase
+    {
+        InternalNode *parent = nullptr;
+        int count = 0;      // entries in a leaf, children in an internal node
+        bool isLeaf;
+
+        explicit NodeBase(bool leaf) noexcept : isLeaf(leaf) {}
+    };
+
+    struct LeafNode : NodeBase
+    {
+        LeafNode *prev = nullptr;
+        LeafNode *next = nullptr;
+        alignas(value_type) unsigned char storage[LeafCapacity * sizeof(value_type)];
+
+        LeafNode() noexcept : NodeBase(true) {}
+        value_type *entries() noexcept { return reinterpret_cast<value_type *>(storage); }
+    };
+
+    struct InternalNode : NodeBase
+    {
+        NodeBase *children[InternalCapacity];
+        alignas(Key) unsigned char keyStorage[(InternalCapacity - 1) * sizeof(Key)];
+
+        InternalNode() noexcept : NodeBase(false) {}
+        Key *keys() noexcept { return reinterpret_cast<Key *>(keyStorage); }
+
+        int indexOf(const NodeBase *child) const noexcept
+        {
+            int i = 0;
+            while (children[i] != child)
+                ++i;
+            Q_ASSERT(i < this->count);
+            return i;
+        }
+    };
+
+    // The internal nodes that an insertion may need, allocated before the
+    // tree is touched. Whatever isn't used is freed again.
+    struct NodeReserve
+    {
+        InternalNode *nodes[MaxHeight + 1];
+        int count = 0;
+
+        NodeReserve() noexcept = default;
+        Q_DISABLE_COPY_MOVE(NodeReserve)
+        ~NodeReserve()
+        {
+            while (count)
+                delete nodes[--count];
+        }
+
+        void allocate(int n)
+        {
+            Q_ASSERT(n <= MaxHeight + 1);
+            while (count < n) {
+                nodes[count] = new InternalNode;
+                ++count;
+            }
+        }
+        InternalNode *take() noexcept
+        {
+            Q_ASSERT(count > 0);
+            return nodes[--count];
+        }
+    };
+
+    template <bool Const>
+    class Iterator
+    {
+        template <typename, typename, bool> friend class Tree;
+        template <bool> friend class Iterator;
+
+        const Tree *tree = nullptr;
+        LeafNode *leaf = nullptr;   // nullptr for end()
+        int index = 0;
+
+        Iterator(const Tree *t, LeafNode *l, int i) noexcept : tree(t), leaf(l), index(i) {}
+
+    public:
+        using iterator_category = std::bidirectional_iterator_tag;
+        using difference_type = qptrdiff;
+        using value_type = std::pair<const Key, T>;
+        using reference = std::conditional_t<Const, const value_type &, value_type &>;
+        using pointer = std::conditional_t<Const, const value_type *, value_type *>;
+
+        Iterator() = default;
+        template <bool C = Const, std::enable_if_t<C, bool> = true>
+        Q_IMPLICIT Iterator(const Iterator<false> &other) noexcept
+            : tree(other.tree), leaf(other.leaf), index(other.index)
+        {}
+
+        reference operator*() const noexcept { return leaf->entries()[index]; }
+        pointer operator->() const noexcept { return leaf->entries() + index; }
+
+        Iterator &operator++() noexcept
+        {
+            if (++index == leaf->count) {
+                leaf = leaf->next;
+                index = 0;
+            }
+            return *this;
+        }
+        Iterator operator++(int) noexcept { Iterator r = *this; ++*this; return r; }
+        Iterator &operator--() noexcept
+        {
+            if (!leaf) {
+                leaf = tree->lastLeaf;
+                index = leaf->count - 1;
+            } else if (index == 0) {
+                leaf = leaf->prev;
+                index = leaf->count - 1;
+            } else {
+                --index;
+            }
+            return *this;
+        }
+        Iterator operator--(int) noexcept { Iterator r = *this; --*this; return r; }
+
+        friend bool operator==(const Iterator &lhs, const Iterator &rhs) noexcept
+        { return lhs.leaf == rhs.leaf && lhs.index == rhs.index; }
+        friend bool operator!=(const Iterator &lhs, const Iterator &rhs) noexcept
+        { return !(lhs == rhs); }
+    };
+
+public:
+    using iterator = Iterator<false>;
+    using const_iterator = Iterator<true>;
+
+    Tree() noexcept = default;
+    Tree(const Tree &other)
+    {
+        Tree copy;
+        for (const value_type &entry : other)
+            copy.append(entry.first, entry.second);
+        swap(copy);
+    }
+    Tree(Tree &&other) noexcept
+        : root(std::exchange(other.root, nullptr)),
+          firstLeaf(std::exchange(other.firstLeaf, nullptr)),
+          lastLeaf(std::exchange(other.lastLeaf, nullptr)),
+          entries(std::exchange(other.entries, 0))
+    {}
+    template <typename InputIterator, QtPrivate::IfIsInputIterator<InputIterator> = true>
+    Tree(InputIterator first, InputIterator last)
+    {
+        Tree copy;
+        copy.insert(first, last);
+        swap(copy);
+    }
+    ~Tree() { clear(); }
+
+    Tree &operator=(const Tree &other)
+    {
+        if (this != &other) {
+            Tree copy(other);
+            swap(copy);
+        }
+        return *this;
+    }
+    Tree &operator=(Tree &&other) noexcept
+    {
+        Tree moved(std::move(other));
+        swap(moved);
+        return *this;
+    }
+
+    void swap(Tree &other) noexcept
+    {
+        std::swap(root, other.root);
+        std::swap(firstLeaf, other.firstLeaf);
+        std::swap(lastLeaf, other.lastLeaf);
+        std::swap(entries, other.entries);
+    }
+
+    size_type size() const noexcept { return entries; }
+    bool empty() const noexcept { return entries == 0; }
+    key_compare key_comp() const { return key_compare(); }
+
+    iterator begin() noexcept { return iterator(this, firstLeaf, 0); }
+    const_iterator begin() const noexcept { return const_iterator(this, firstLeaf, 0); }
+    const_iterator cbegin() const noexcept { return begin(); }
+    iterator end() noexcept { return iterator(this, nullptr, 0); }
+    const_iterator end() const noexcept { return const_iterator(this, nullptr, 0); }
+    const_iterator cend() const noexcept { return end(); }
+
+    void clear() noexcept
+    {
+        if (root)
+            freeNode(root);
+        root = nullptr;
+        firstLeaf = lastLeaf = nullptr;
+        entries = 0;
+    }
+
+    iterator lower_bound(const Key &key) { return mutableIterator(std::as_const(*this).lower_bound(key)); }
+    const_iterator lower_bound(const Key &key) const
+    {
+        if (!root)
+            return end();
+        LeafNode *leaf = descend(key, false);
+        return normalized(leaf, lowerIndex(leaf, key));
+    }
+
+    iterator upper_bound(const Key &key) { return mutableIterator(std::as_const(*this).upper_bound(key)); }
+    const_iterator upper_bound(const Key &key) const
+    {
+        if (!root)
+            return end();
+        LeafNode *leaf = descend(key, true);
+        return normalized(leaf, upperIndex(leaf, key));
+    }
+
+    std::pair<iterator, iterator> equal_range(const Key &key)
+    { return { lower_bound(key), upper_bound(key) }; }
+    std::pair<const_iterator, const_iterator> equal_range(const Key &key) const
+    { return { lower_bound(key), upper_bound(key) }; }
+
+    iterator find(const Key &key) { return mutableIterator(std::as_const(*this).find(key)); }
+    const_iterator find(const Key &key) const
+    {
+        const_iterator it = lower_bound(key);
+        if (it.leaf && !less(key, it->first))
+            return it;
+        return end();
+    }
+
+    size_type count(const Key &key) const
+    {
+        if constexpr (Multi) {
+            const auto range = equal_range(key);
+            return size_type(std::distance(range.first, range.second));
+        } else {
+            return find(key) != end() ? 1 : 0;
+        }
+    }
+
+    auto insert(const value_type &value) { return emplace(value.first, value.second); }
+    auto insert(value_type &&value) { return emplace(value.first, std::move(value.second)); }
+    iterator insert(const_iterator hint, const value_type &value)
+    { return emplace_hint(hint, value.first, value.second); }
+    iterator insert(const_iterator hint, value_type &&value)
+    { return emplace_hint(hint, value.first, std::move(value.second)); }
+
+    template <typename InputIterator, QtPrivate::IfIsInputIterator<InputIterator> = true>
+    void insert(InputIterator first, InputIterator last)
+    {
+        // appending is cheap, and sorted input (e.g. from another map) always appends
+        for (; first != last; ++first)
+            emplace_hint(cend(), (*first).first, (*first).second);
+    }
+
+    // With Multi, inserts after the entries with an equivalent key, like
+    // std::multimap; without, does nothing if such an entry exists.
+    template <typename K, typename V>
+    auto emplace(K &&key, V &&value)
+    {
+        if constexpr (Multi) {
+            if (!root)
+                return insertAt(nullptr, 0, std::forward<K>(key), std::forward<V>(value));
+            LeafNode *leaf = descend(key, true);
+            return insertAt(leaf, upperIndex(leaf, key), std::forward<K>(key), std::forward<V>(value));
+        } else {
+            if (!root)
+                return std::pair(insertAt(nullptr, 0, std::forward<K>(key), std::forward<V>(value)), true);
+            LeafNode *leaf = descend(key, false);
+            const int i = lowerIndex(leaf, key);
+            const iterator existing = mutableIterator(normalized(leaf, i));
+            if (existing.leaf && !less(key, existing->first))
+                return std::pair(existing, false);
+            return std::pair(insertAt(leaf, i, std::forward<K>(key), std::forward<V>(value)), true);
+        }
+    }
+
+    // Inserts right before hint if that keeps the order, like std::map's
+    // hinted insertion does.
+    template <typename K, typename V>
+    iterator emplace_hint(const_iterator hint, K &&key, V &&value)
+    {
+        if (!root)
+            return insertAt(nullptr, 0, std::forward<K>(key), std::forward<V>(value));
+
+        // the hint is usable if prev(hint) <= key <= hint (with < for unique keys)
+        bool usable = true;
+        if (hint.leaf)
+            usable = Multi ? !less(hint->first, key) : less(key, hint->first);
+        if (usable && hint != cbegin()) {
+            const Key &prev = std::prev(hint)->first;
+            usable = Multi ? !less(key, prev) : less(prev, key);
+        }
+        if (!usable) {
+            if constexpr (Multi)
+                return emplace(std::forward<K>(key), std::forward<V>(value));
+            else
+                return emplace(std::forward<K>(key), std::forward<V>(value)).first;
+        }
+
+        LeafNode *leaf = hint.leaf;
+        int i = hint.index;
+        if (!leaf) {
+            leaf = lastLeaf;
+            i = leaf->count;
+        } else if (i == 0 && leaf->prev && !less(lowerSeparator(leaf), key)) {
+            // keep key <= the separator between the previous leaf and this one
+            leaf = leaf->prev;
+            i = leaf->count;
+        }
+        return insertAt(leaf, i, std::forward<K>(key), std::forward<V>(value));
+    }
+
+    template <typename V>
+    std::pair<iterator, bool> insert_or_assign(const Key &key, V &&value)
+    {
+        static_assert(!Multi);
+        auto result = emplace(key, std::forward<V>(value));
+        if (!result.second)
+            result.first->second = std::forward<V>(value);
+        return result;
+    }
+
+    iterator erase(const_iterator pos)
+    {
+        Q_ASSERT(pos.leaf);
+        LeafNode *leaf = pos.leaf;
+        int i = pos.index;
+        std::destroy_at(leaf->entries() + i);
+        relocateEntries(leaf->entries() + i + 1, leaf->count - i - 1, leaf->entries() + i);
+        --leaf->count;
+        --entries;
+
+        if (leaf->count == 0) {
+            LeafNode *next = leaf->next;
+            removeLeaf(leaf);
+            return iterator(this, next, 0);
+        }
+        if (leaf != root && leaf->count < MinLeafCount)
+            rebalanceLeaf(leaf, i);
+        return mutableIterator(normalized(leaf, i));
+    }
+
+    iterator erase(const_iterator first, const_iterator last)
+    {
+        // erasing moves entries around, so last can't be compared against
+        for (auto n = std::distance(first, last); n > 0; --n)
+            first = erase(first);
+        return mutableIterator(first);
+    }
+
+    size_type erase(const Key &key)
+    {
+        const auto range = equal_range(key);
+        const auto n = std::distance(range.first, range.second);
+        erase(range.first, range.second);
+        return size_type(n);
+    }
+
+    // Like std::map::merge(): moves the entries of source into this tree.
+    // Without Multi, the ones whose key already exists stay in source.
+    // Runs in linear time, building new trees with full leaves.
+    template <bool SourceMulti>
+    void merge(Tree<Key, T, SourceMulti> &&source)
+    {
+        Tree merged;
+        Tree<Key, T, SourceMulti> rest;
+        auto a = begin();
+        auto b = source.begin();
+        const auto takeInto = [](auto &target, auto &it) {
+            target.append(it->first, std::move(it->second));
+            ++it;
+        };
+        // without Multi, source may itself hold several entries with a
+        // key; only the first one that isn't in this tree gets in
+        const auto taken = [&merged](const Key &key) {
+            LeafNode *last = merged.lastLeaf;
+            return !Multi && last && !less(last->entries()[last->count - 1].first, key);
+        };
+        while (a != end() && b != source.end()) {
+            if (less(b->first, a->first)) {
+                if (taken(b->first))
+                    takeInto(rest, b);
+                else
+                    takeInto(merged, b);
+            } else if (Multi || less(a->first, b->first)) {
+                takeInto(merged, a);    // source entries go after equivalent ones
+            } else {
+                takeInto(rest, b);
+            }
+        }
+        while (a != end())
+            takeInto(merged, a);
+        while (b != source.end()) {
+            if (taken(b->first))
+                takeInto(rest, b);
+            else
+                takeInto(merged, b);
+        }
+        *this = std::move(merged);
+        source = std::move(rest);
+    }
+
+    friend bool operator==(const Tree &lhs, const Tree &rhs)
+    {
+        if (lhs.size() != rhs.size())
+            return false;
+        return std::equal(lhs.begin(), lhs.end(), rhs.begin(), [](const auto &a, const auto &b) {
+            return a.first == b.first && a.second == b.second;
+        });
+    }
+    friend bool operator!=(const Tree &lhs, const Tree &rhs) { return !(lhs == rhs); }
+
+private:
+    static bool less(const Key &lhs, const Key &rhs) { return key_compare()(lhs, rhs); }
+
+    // first i with keys[i] >= key, resp. keys[i] > key
+    static int lowerIndex(const Key *keys, int n, const Key &key)
+    { return int(std::lower_bound(keys, keys + n, key, key_compare()) - keys); }
+    static int upperIndex(const Key *keys, int n, const Key &key)
+    { return int(std::upper_bound(keys, keys + n, key, key_compare()) - keys); }
+    static int lowerIndex(LeafNode *leaf, const Key &key)
+    {
+        value_type *e = leaf->entries();
+        return int(std::partition_point(e, e + leaf->count, [&](const value_type &v) {
+                       return less(v.first, key);
+                   }) - e);
+    }
+    static int upperIndex(LeafNode *leaf, const Key &key)
+    {
+        value_type *e = leaf->entries();
+        return int(std::partition_point(e, e + leaf->count, [&](const value_type &v) {
+                       return !less(key, v.first);
+                   }) - e);
+    }
+
+    LeafNode *descend(const Key &key, bool upper) const
+    {
+        NodeBase *node = root;
+        while (!node->isLeaf) {
+            auto *in = static_cast<InternalNode *>(node);
+            const int n = in->count - 1;
+            node = in->children[upper ? upperIndex(in->keys(), n, key) : lowerIndex(in->keys(), n, key)];
+        }
+        return static_cast<LeafNode *>(node);
+    }
+
+    const_iterator normalized(LeafNode *leaf, int i) const noexcept
+    {
+        if (i == leaf->count)
+            return const_iterator(this, leaf->next, 0);
+        return const_iterator(this, leaf, i);
+    }
+    iterator mutableIterator(const_iterator it) noexcept { return iterator(this, it.leaf, it.index); }
+
+    static const Key &lowerSeparator(const NodeBase *node)
+    {
+        // the separator left of the first ancestor that isn't a leftmost child
+        while (node->parent->children[0] == node)
+            node = node->parent;
+        return node->parent->keys()[node->parent->indexOf(node) - 1];
+    }
+
+    static bool isRightmost(const NodeBase *node) noexcept
+    {
+        for (; node->parent; node = node->parent) {
+            if (node->parent->children[node->parent->count - 1] != node)
+                return false;
+        }
+        return true;
+    }
+
+    template <typename K, typename V>
+    void append(K &&key, V &&value)
+    {
+        if (!root)
+            insertAt(nullptr, 0, std::forward<K>(key), std::forward<V>(value));
+        else
+            insertAt(lastLeaf, lastLeaf->count, std::forward<K>(key), std::forward<V>(value));
+    }
+
+    // Moves the n entries at first to d_first; the ranges may overlap.
+    // The keys are const, so unlike q_relocate_overlap_n(), this must not
+    // assign to the entries, and has to copy keys that aren't relocatable.
+    static void relocateEntries(value_type *first, int n, value_type *d_first)
+        noexcept(NothrowRelocate)
+    {
+        if (n <= 0 || first == d_first)
+            return;
+        if constexpr (IsRelocatable) {
+            std::memmove(static_cast<void *>(d_first), static_cast<const void *>(first),
+                         n * sizeof(value_type));
+        } else if (d_first < first) {
+            for (int i = 0; i < n; ++i) {
+                new (d_first + i) value_type(std::move(first[i]));
+                std::destroy_at(first + i);
+            }
+        } else {
+            for (int i = n - 1; i >= 0; --i) {
+                new (d_first + i) value_type(std::move(first[i]));
+                std::destroy_at(first + i);
+            }
+        }
+    }
+
+    // Moves the entries [from, from + n) of source to position at in target
+    static void moveEntries(LeafNode *source, int from, int n, LeafNode *target, int at)
+        noexcept(NothrowRelocate)
+    {
+        Q_ASSERT(target->count + n <= LeafCapacity);
+        value_type *s = source->entries();
+        value_type *t = target->entries();
+        relocateEntries(t + at, target->count - at, t + at + n);
+        relocateEntries(s + from, n, t + at);
+        relocateEntries(s + from + n, source->count - from - n, s + from);
+        source->count -= n;
+        target->count += n;
+    }
+
+    // Internal nodes that splitting a full leaf needs: one for every full
+    // ancestor, and a new root if all of them are full.
+    static int splitCost(const LeafNode *leaf) noexcept
+    {
+        int n = 0;
+        const InternalNode *node = leaf->parent;
+        for (; node && node->count == InternalCapacity; node = node->parent)
+            ++n;
+        return node ? n : n + 1;
+    }
+
+    template <typename K, typename V>
+    iterator insertAt(LeafNode *leaf, int i, K &&k, V &&v)
+    {
+        // construct first, so that a throwing constructor leaves the tree alone
+        Key key(std::forward<K>(k));
+        T value(std::forward<V>(v));
+
+        if (!leaf) {
+            Q_ASSERT(!root);
+            leaf = new LeafNode;
+            root = firstLeaf = lastLeaf = leaf;
+        } else if (leaf->count == LeafCapacity) {
+            // appending: start a new leaf and leave this one full
+            const bool appending = !leaf->next && i == leaf->count;
+            const int mid = appending ? LeafCapacity : LeafCapacity / 2;
+
+            // everything that can throw: the first key of the new leaf,
+            // which goes into the parent, and the nodes
+            Key separator(appending ? key : leaf->entries()[mid].first);
+            std::unique_ptr<LeafNode> newLeaf(new LeafNode);
+            NodeReserve reserve;
+            reserve.allocate(splitCost(leaf));
+
+            LeafNode *right = newLeaf.release();
+            moveEntries(leaf, mid, LeafCapacity - mid, right, 0);
+            right->prev = leaf;
+            right->next = leaf->next;
+            (leaf->next ? leaf->next->prev : lastLeaf) = right;
+            leaf->next = right;
+            insertChild(leaf, std::move(separator), right, reserve);
+            if (i > mid || appending) {
+                i -= mid;
+                leaf = right;
+            }
+        }
+        Q_ASSERT(leaf->count < LeafCapacity);
+        relocateEntries(leaf->entries() + i, leaf->count - i, leaf->entries() + i + 1);
+        new (leaf->entries() + i) value_type(std::move(key), std::move(value));
+        ++leaf->count;
+        ++entries;
+        return iterator(this, leaf, i);
+    }
+
+    // Inserts child right after left in left's parent, separated by separator
+    void insertChild(NodeBase *left, Key &&separator, NodeBase *child, NodeReserve &reserve) noexcept
+    {
+        InternalNode *parent = left->parent;
+        if (!parent) {
+            Q_ASSERT(left == root);
+            parent = reserve.take();
+            parent->children[0] = left;
+            parent->count = 1;
+            left->parent = parent;
+            root = parent;
+        }
+        const int pos = parent->indexOf(left) + 1;
+        if (parent->count < InternalCapacity) {
+            insertIntoInternal(parent, pos, std::move(separator), child);
+            return;
+        }
+
+        // When appending, move just the last child over, so that this node
+        // stays nearly full and the new one has two children.
+        const int mid = pos == parent->count && isRightmost(parent) ? InternalCapacity - 1
+                                                                     : InternalCapacity / 2;
+        InternalNode *right = reserve.take();
+        const int moved = parent->count - mid;
+        std::copy_n(parent->children + mid, moved, right->children);
+        QtPrivate::q_uninitialized_relocate_n(parent->keys() + mid, moved - 1, right->keys());
+        Key promoted(std::move(parent->keys()[mid - 1]));
+        std::destroy_at(parent->keys() + mid - 1);
+        parent->count = mid;
+        right->count = moved;
+        for (int i = 0; i < moved; ++i)
+            right->children[i]->parent = right;
+        if (pos <= mid)
+            insertIntoInternal(parent, pos, std::move(separator), child);
+        else
+            insertIntoInternal(right, pos - mid, std::move(separator), child);
+        insertChild(parent, std::move(promoted), right, reserve);
+    }
+
+    static void insertIntoInternal(InternalNode *node, int pos, Key &&separator, NodeBase *child) noexcept
+    {
+        Q_ASSERT(pos >= 1 && node->count < InternalCapacity);
+        std::copy_backward(node->children + pos, node->children + node->count,
+                           node->children + node->count + 1);
+        QtPrivate::q_relocate_overlap_n(node->keys() + pos - 1, node->count - pos, node->keys() + pos);
+        node->children[pos] = child;
+        new (node->keys() + pos - 1) Key(std::move(separator));
+        ++node->count;
+        child->parent = node;
+    }
+
+    // Removes the child at pos of node together with the separator at key
+    static void eraseFromInternal(InternalNode *node, int pos, int key) noexcept
+    {
+        std::copy(node->children + pos + 1, node->children + node->count, node->children + pos);
+        std::destroy_at(node->keys() + key);
+        QtPrivate::q_relocate_overlap_n(node->keys() + key + 1, node->count - 2 - key, node->keys() + key);
+        --node->count;
+    }
+
+    // Brings a leaf that fell below MinLeafCount back up, by merging it with
+    // a sibling or taking entries from one. i follows the entry it indexes.
+    void rebalanceLeaf(LeafNode *&leaf, int &i)
+    {
+        InternalNode *parent = leaf->parent;
+        const int pos = parent->indexOf(leaf);
+        if (pos + 1 < parent->count) {
+            auto *right = static_cast<LeafNode *>(parent->children[pos + 1]);
+            if (leaf->count + right->count <= LeafCapacity) {
+                moveEntries(right, 0, right->count, leaf, leaf->count);
+                removeLeaf(right);
+            } else {
+                const int n = (right->count - leaf->count) / 2;
+                Key separator(right->entries()[n].first);
+                moveEntries(right, 0, n, leaf, leaf->count);
+                parent->keys()[pos] = std::move(separator);
+            }
+        } else {
+            auto *left = static_cast<LeafNode *>(parent->children[pos - 1]);
+            if (left->count + leaf->count <= LeafCapacity) {
+                i += left->count;
+                moveEntries(leaf, 0, leaf->count, left, left->count);
+                removeLeaf(leaf);
+                leaf = left;
+            } else {
+                const int n = (left->count - leaf->count) / 2;
+                Key separator(left->entries()[left->count - n].first);
+                moveEntries(left, left->count - n, n, leaf, 0);
+                parent->keys()[pos - 1] = std::move(separator);
+                i += n;
+            }
+        }
+    }
+
+    // Does the same for internal nodes, which also lose the separator
+    // between them and their sibling to a merge.
+    void rebalanceInternal(InternalNode *node) noexcept
+    {
+        if (node == root) {
+            if (node->count == 1) {
+                root = node->children[0];
+                root->parent = nullptr;
+                node->count = 0;
+                freeNode(node);
+            }
+            return;
+        }
+        if (node->count >= MinInternalCount)
+            return;
+
+        InternalNode *parent = node->parent;
+        const int pos = parent->indexOf(node);
+        const int sep = pos + 1 < parent->count ? pos : pos - 1;
+        auto *left = static_cast<InternalNode *>(parent->children[sep]);
+        auto *right = static_cast<InternalNode *>(parent->children[sep + 1]);
+
+        if (left->count + right->count <= InternalCapacity) {
+            // pull the separator down between the children of both
+            new (left->keys() + left->count - 1) Key(std::move(parent->keys()[sep]));
+            QtPrivate::q_uninitialized_relocate_n(right->keys(), right->count - 1, left->keys() + left->count);
+            std::copy_n(right->children, right->count, left->children + left->count);
+            for (int i = 0; i < right->count; ++i)
+                right->children[i]->parent = left;
+            left->count += right->count;
+            right->count = 0;
+            freeNode(right);
+            eraseFromInternal(parent, sep + 1, sep);
+            rebalanceInternal(parent);
+        } else if (node == left) {
+            // rotate the first n children of right through the parent
+            const int n = (right->count - left->count) / 2;
+            new (left->keys() + left->count - 1) Key(std::move(parent->keys()[sep]));
+            QtPrivate::q_uninitialized_relocate_n(right->keys(), n - 1, left->keys() + left->count);
+            parent->keys()[sep] = std::move(right->keys()[n - 1]);
+            std::destroy_at(right->keys() + n - 1);
+            QtPrivate::q_relocate_overlap_n(right->keys() + n, right->count - 1 - n, right->keys());
+            std::copy_n(right->children, n, left->children + left->count);
+            std::copy(right->children + n, right->children + right->count, right->children);
+            for (int i = 0; i < n; ++i)
+                left->children[left->count + i]->parent = left;
+            left->count += n;
+            right->count -= n;
+        } else {
+            // rotate the last n children of left through the parent
+            const int n = (left->count - right->count) / 2;
+            const int from = left->count - n;
+            QtPrivate::q_relocate_overlap_n(right->keys(), right->count - 1, right->keys() + n);
+            new (right->keys() + n - 1) Key(std::move(parent->keys()[sep]));
+            QtPrivate::q_uninitialized_relocate_n(left->keys() + from, n - 1, right->keys());
+            parent->keys()[sep] = std::move(left->keys()[from - 1]);
+            std::destroy_at(left->keys() + from - 1);
+            std::copy_backward(right->children, right->children + right->count,
+                               right->children + right->count + n);
+            std::copy_n(left->children + from, n, right->children);
+            for (int i = 0; i < n; ++i)
+                right->children[i]->parent = right;
+            left->count -= n;
+            right->count += n;
+        }
+    }
+
+    void removeLeaf(LeafNode *leaf) noexcept
+    {
+        Q_ASSERT(leaf->count == 0);
+        (leaf->prev ? leaf->prev->next : firstLeaf) = leaf->next;
+        (leaf->next ? leaf->next->prev : lastLeaf) = leaf->prev;
+
+        InternalNode *parent = leaf->parent;
+        if (!parent) {
+            freeNode(leaf);
+            root = nullptr;
+            return;
+        }
+        const int pos = parent->indexOf(leaf);
+        freeNode(leaf);
+        // drop the separator on the side the leaf was on
+        eraseFromInternal(parent, pos, pos > 0 ? pos - 1 : 0);
+        rebalanceInternal(parent);
+    }
+
+    static void freeNode(NodeBase *node) noexcept
+    {
+        if (node->isLeaf) {
+            auto *leaf = static_cast<LeafNode *>(node);
+            std::destroy_n(leaf->entries(), leaf->count);
+            delete leaf;
+        } else {
+            auto *in = static_cast<InternalNode *>(node);
+            for (int i = 0; i < in->count; ++i)
+                freeNode(in->children[i]);
+            if (in->count > 0)
+                std::destroy_n(in->keys(), in->count - 1);
+            delete in;
+        }
+    }
+
+    NodeBase *root = nullptr;
+    LeafNode *firstLeaf = nullptr;
+    LeafNode *lastLeaf = nullptr;
+    size_type entries = 0;
+};
+
+} // namespace QBTreeMapPrivate
+
+// An ordered map that keeps its entries in the leaves of a B+tree, up to
+// 64 to a leaf. Lookups and iteration touch far fewer cache lines than with
+// QMap, and it needs one allocation per leaf instead of one per entry.
+//
+// The price is that entries move within and between leaves: inserting or
+// erasing an entry invalidates all iterators and references into the map,
+// except end(). QMap and QMultiMap keep theirs valid, so they stay the
+// default; switch to QBTreeMap for large maps that are mostly looked up and
+// iterated over. It is not implicitly shared and has the std::map API
+// (keyed by std::less<Key>) plus a few of QMap's convenience functions.
+template <typename Key, typename T>
+class QBTreeMap : public QBTreeMapPrivate::Tree<Key, T, false>
+{
+    using Base = QBTreeMapPrivate::Tree<Key, T, false>;
+
+public:
+    using Base::Base;
+    QBTreeMap() noexcept = default;
+    QBTreeMap(std::initializer_list<std::pair<Key, T>> list)
+        : Base(list.begin(), list.end())
+    {}
+
+    void swap(QBTreeMap &other) noexcept { Base::swap(other); }
+
+    bool isEmpty() const noexcept { return this->empty(); }
+    bool contains(const Key &key) const { return this->find(key) != this->end(); }
+
+    T value(const Key &key, const T &defaultValue = T()) const
+    {
+        const auto it = this->find(key);
+        return it != this->end() ? it->second : defaultValue;
+    }
+
+    T &operator[](const Key &key)
+    {
+        auto it = this->find(key);
+        if (it == this->end())
+            it = this->emplace(key, T()).first;
+        return it->second;
+    }
+
+    qsizetype remove(const Key &key) { return qsizetype(this->erase(key)); }
+};
+
+// Like QBTreeMap, but with any number of entries per key, which keep the
+// order they were inserted in.
+template <typename Key, typename T>
+class QMultiBTreeMap : public QBTreeMapPrivate::Tree<Key, T, true>
+{
+    using Base = QBTreeMapPrivate::Tree<Key, T, true>;
+
+public:
+    using Base::Base;
+    QMultiBTreeMap() noexcept = default;
+    QMultiBTreeMap(std::initializer_list<std::pair<Key, T>> list)
+        : Base(list.begin(), list.end())
+    {}
+
+    void swap(QMultiBTreeMap &other) noexcept { Base::swap(other); }
+
+    bool isEmpty() const noexcept { return this->empty(); }
+    bool contains(const Key &key) const { return this->find(key) != this->end(); }
+
+    // the value of the first entry with key
+    T value(const Key &key, const T &defaultValue = T()) const
+    {
+        const auto it = this->find(key);
+        return it != this->end() ? it->second : defaultValue;
+    }
+
+    qsizetype remove(const Key &key) { return qsizetype(this->erase(key)); }
+};
+
+QT_END_NAMESPACE
+
+#endif // QBTREEMAP_H
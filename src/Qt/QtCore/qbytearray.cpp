@@ -39,6 +39,11 @@
 #include <string.h>
 #include <stdlib.h>
 #include <algorithm>
+#include <limits>
+#include <queue>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
 #include <QtCore/q26numeric.h>
 
 #ifdef Q_OS_WIN
@@ -726,6 +731,390 @@ QByteArray qUncompress(const uchar* data, qsizetype nbytes)
 }
 #endif
 
+#ifndef QT_NO_COMPRESS
+namespace {
+// Per-thread zlib streams used by the dictionary variants of qCompress() and
+// qUncompress(). Resetting a stream is much cheaper than setting it up from
+// scratch, which dominates the cost of compressing small messages.
+struct ZLibStreams
+{
+    z_stream deflater = {};
+    z_stream inflater = {};
+    int deflaterLevel = 0;
+    bool hasDeflater = false;
+    bool hasInflater = false;
+
+    ~ZLibStreams()
+    {
+        if (hasDeflater)
+            deflateEnd(&deflater);
+        if (hasInflater)
+            inflateEnd(&inflater);
+    }
+
+    int resetDeflater(int level)
+    {
+        if (!hasDeflater) {
+            const int err = deflateInit(&deflater, level);
+            hasDeflater = err == Z_OK;
+            deflaterLevel = level;
+            return err;
+        }
+        if (const int err = deflateReset(&deflater); err != Z_OK)
+            return err;
+        if (level != deflaterLevel) {
+            // nothing was fed to the stream yet, so this only changes the settings
+            if (const int err = deflateParams(&deflater, level, Z_DEFAULT_STRATEGY); err != Z_OK)
+                return err;
+            deflaterLevel = level;
+        }
+        return Z_OK;
+    }
+
+    int resetInflater()
+    {
+        if (!hasInflater) {
+            const int err = inflateInit(&inflater);
+            hasInflater = err == Z_OK;
+            return err;
+        }
+        return inflateReset(&inflater);
+    }
+};
+
+ZLibStreams &threadZLibStreams()
+{
+    static thread_local ZLibStreams streams;
+    return streams;
+}
+} // unnamed namespace
+
+// Feeds all of \a input to deflate() or inflate() on the already set up
+// stream \a zs, and writes the output to \a out from \a size on, growing it
+// as needed. Returns \a out truncated to the end of the output.
+static QByteArray zlibProcess(ZLibOp op, z_stream *zs, QByteArray out, qsizetype size,
+                              const uchar *input, qsizetype inputSize,
+                              const QByteArray &dictionary)
+{
+    using ZlibChunkSize_t = decltype(zs->avail_in);
+    static_assert(!std::is_signed_v<ZlibChunkSize_t>);
+    constexpr auto MaxChunkSize = std::numeric_limits<ZlibChunkSize_t>::max();
+
+    size_t inputLeft = size_t(inputSize);
+    zs->next_in = const_cast<uchar *>(input); // 1980s C API...
+    zs->avail_in = 0;
+    zs->avail_out = 0;
+
+    int res;
+    do {
+        if (zs->avail_out == 0) {
+            if (size == out.size()) {
+                if (out.size() > QByteArray::maxSize() / 2)
+                    return tooMuchData(op);
+                out.resize(out.size() * 2);
+            }
+            const size_t avail_out = size_t(out.size() - size);
+            zs->next_out = reinterpret_cast<uchar *>(out.data()) + size;
+            zs->avail_out = avail_out > MaxChunkSize ? MaxChunkSize : ZlibChunkSize_t(avail_out);
+            size += zs->avail_out;
+        }
+
+        if (zs->avail_in == 0 && inputLeft) {
+            // zs->next_in is kept up-to-date by zlib, so only top up the count
+            zs->avail_in = inputLeft > MaxChunkSize ? MaxChunkSize : ZlibChunkSize_t(inputLeft);
+            inputLeft -= zs->avail_in;
+        }
+
+        if (op == ZLibOp::Compression) {
+            res = deflate(zs, inputLeft ? Z_NO_FLUSH : Z_FINISH);
+        } else {
+            res = inflate(zs, Z_NO_FLUSH);
+            if (res == Z_NEED_DICT) {
+                if (dictionary.isEmpty())
+                    return invalidCompressedData();
+                // fails with Z_DATA_ERROR if it's not the dictionary the data was compressed with
+                res = inflateSetDictionary(zs, reinterpret_cast<const Bytef *>(dictionary.constData()),
+                                           uInt(dictionary.size()));
+            }
+        }
+    } while (res == Z_OK);
+
+    switch (res) {
+    case Z_STREAM_END:
+        out.truncate(size - zs->avail_out);
+        return out;
+
+    case Z_MEM_ERROR:
+        return tooMuchData(op);
+
+    case Z_BUF_ERROR:   // input ended before the end of the stream
+    case Z_DATA_ERROR:
+        if (op == ZLibOp::Decompression)
+            return invalidCompressedData();
+        Q_FALLTHROUGH();
+
+    default:
+        return unexpectedZlibError(op, res, zs->msg);
+    }
+}
+
+/*!
+    \relates QByteArray
+    \since 6.9
+    \overload
+
+    Compresses the first \a nbytes of \a data at compression level
+    \a compressionLevel, using \a dictionary as a preset dictionary, and
+    returns the compressed data in a new byte array.
+
+    A preset dictionary holds strings that are likely to occur in the data,
+    so that even the start of a short message can refer back to them. This
+    makes a big difference for small messages with a lot of common structure,
+    such as JSON documents following the same schema; see
+    qTrainCompressionDictionary() for a way to build one from sample data.
+    The result must be uncompressed with qUncompress() and the same
+    dictionary. Only the last 32 KiB of \a dictionary are used.
+
+    This function reuses zlib's compression state between calls on the same
+    thread, which avoids most of the setup cost per call for small inputs.
+*/
+QByteArray qCompress(const uchar *data, qsizetype nbytes, const QByteArray &dictionary,
+                     int compressionLevel)
+{
+    constexpr qsizetype HeaderSize = sizeof(CompressSizeHint_t);
+    if (nbytes == 0) {
+        return QByteArray(HeaderSize, '\0');
+    }
+    if (!data)
+        return dataIsNull(ZLibOp::Compression);
+
+    if (nbytes < 0)
+        return lengthIsNegative(ZLibOp::Compression);
+
+    if (compressionLevel < -1 || compressionLevel > 9)
+        compressionLevel = -1;
+
+    ZLibStreams &streams = threadZLibStreams();
+    if (const int err = streams.resetDeflater(compressionLevel); err != Z_OK)
+        return unexpectedZlibError(ZLibOp::Compression, err, nullptr);
+    z_stream *zs = &streams.deflater;
+    if (!dictionary.isEmpty()) {
+        const int err = deflateSetDictionary(zs, reinterpret_cast<const Bytef *>(dictionary.constData()),
+                                             uInt(dictionary.size()));
+        if (err != Z_OK)
+            return unexpectedZlibError(ZLibOp::Compression, err, zs->msg);
+    }
+
+    // deflateBound() accounts for the dictionary id in the stream header
+    constexpr auto MaxBoundInput = std::numeric_limits<uLong>::max() / 2;
+    const qsizetype capacity = HeaderSize
+            + (size_t(nbytes) < MaxBoundInput ? qsizetype(deflateBound(zs, uLong(nbytes)))
+                                               : nbytes / 2);
+    QByteArray out(capacity, Qt::Uninitialized);
+
+    // 32-bit BE size hint, saturated
+    const CompressSizeHint_t hint = size_t(nbytes) > std::numeric_limits<CompressSizeHint_t>::max()
+            ? std::numeric_limits<CompressSizeHint_t>::max() : CompressSizeHint_t(nbytes);
+    uchar *header = reinterpret_cast<uchar *>(out.data());
+    header[0] = uchar(hint >> 24);
+    header[1] = uchar(hint >> 16);
+    header[2] = uchar(hint >> 8);
+    header[3] = uchar(hint);
+
+    return zlibProcess(ZLibOp::Compression, zs, std::move(out), HeaderSize, data, nbytes, dictionary);
+}
+
+/*!
+    \relates QByteArray
+    \since 6.9
+    \overload
+
+    Uncompresses the first \a nbytes of \a data, which must have been
+    compressed by qCompress() with the preset dictionary \a dictionary, and
+    returns a new byte array with the uncompressed data.
+
+    Returns an empty QByteArray if the input data was corrupt or was
+    compressed with a different dictionary. Data compressed without a
+    dictionary is uncompressed as well, in which case \a dictionary is
+    ignored.
+
+    Like the corresponding qCompress() overload, this function reuses
+    zlib's decompression state between calls on the same thread.
+*/
+QByteArray qUncompress(const uchar *data, qsizetype nbytes, const QByteArray &dictionary)
+{
+    if (!data)
+        return dataIsNull(ZLibOp::Decompression);
+
+    if (nbytes < 0)
+        return lengthIsNegative(ZLibOp::Decompression);
+
+    constexpr qsizetype HeaderSize = sizeof(CompressSizeHint_t);
+    if (nbytes < HeaderSize)
+        return invalidCompressedData();
+
+    const CompressSizeHint_t expectedSize = (CompressSizeHint_t(data[0]) << 24)
+            | (CompressSizeHint_t(data[1]) << 16) | (CompressSizeHint_t(data[2]) << 8)
+            | CompressSizeHint_t(data[3]);
+    if (nbytes == HeaderSize) {
+        if (expectedSize != 0)
+            return invalidCompressedData();
+        return QByteArray();
+    }
+
+    constexpr auto MaxDecompressedSize = size_t(QByteArray::maxSize());
+    if constexpr (MaxDecompressedSize < std::numeric_limits<CompressSizeHint_t>::max()) {
+        if (expectedSize > MaxDecompressedSize)
+            return tooMuchData(ZLibOp::Decompression);
+    }
+
+    ZLibStreams &streams = threadZLibStreams();
+    if (const int err = streams.resetInflater(); err != Z_OK)
+        return unexpectedZlibError(ZLibOp::Decompression, err, nullptr);
+
+    // expectedSize may be truncated, so always use at least nbytes
+    // (larger by at most 1%, according to zlib docs)
+    const qsizetype capacity = std::max({ qsizetype(expectedSize), nbytes, qsizetype(64) });
+    return zlibProcess(ZLibOp::Decompression, &streams.inflater,
+                       QByteArray(capacity, Qt::Uninitialized), 0,
+                       data + HeaderSize, nbytes - HeaderSize, dictionary);
+}
+
+/*!
+    \relates QByteArray
+    \since 6.9
+
+    Builds a preset dictionary of at most \a maxSize bytes for the
+    dictionary variants of qCompress() and qUncompress() from the \a count
+    sample messages starting at \a samples, and returns it.
+
+    The samples should be representative of the data that is going to be
+    compressed; a few hundred messages are usually enough. The dictionary is
+    made of the pieces of the samples that share the most content with other
+    samples, with the most useful ones at the end, where deflate can refer
+    to them most cheaply. Since deflate only looks back 32 KiB, \a maxSize is
+    capped to that.
+
+    Compressing with a dictionary costs time proportional to its size on
+    every call, as deflate has to index it first. For messages of a few
+    hundred bytes to a few KiB, the default of 4 KiB usually captures most
+    of the gain; measure before going larger.
+
+    Returns an empty QByteArray if the samples have nothing in common.
+
+    \sa qCompress()
+*/
+QByteArray qTrainCompressionDictionary(const QByteArray *samples, qsizetype count,
+                                       qsizetype maxSize)
+{
+    constexpr qsizetype MaxDictionarySize = 32 * 1024; // deflate's window size
+    constexpr qsizetype GramSize = 6;       // strings shorter than this are cheap to encode anyway
+    constexpr qsizetype SegmentSize = 64;   // granularity of what goes into the dictionary
+    constexpr qsizetype SegmentStep = SegmentSize / 2;
+
+    maxSize = std::min(maxSize, MaxDictionarySize);
+    if (!samples || count <= 0 || maxSize <= 0)
+        return QByteArray();
+
+    const auto gramAt = [](const char *p) {
+        quint64 gram = 0;
+        memcpy(&gram, p, GramSize);
+        return gram;
+    };
+
+    // Count the samples each gram occurs in; a gram that occurs in only one
+    // sample is of no use to the others.
+    struct GramInfo
+    {
+        qsizetype samples = 0;
+        qsizetype lastSample = -1;
+    };
+    std::unordered_map<quint64, GramInfo> grams;
+    for (qsizetype i = 0; i < count; ++i) {
+        const QByteArray &sample = samples[i];
+        for (qsizetype pos = 0; pos + GramSize <= sample.size(); ++pos) {
+            GramInfo &info = grams[gramAt(sample.constData() + pos)];
+            if (info.lastSample != i) {
+                info.lastSample = i;
+                ++info.samples;
+            }
+        }
+    }
+
+    struct Segment
+    {
+        qsizetype sample;
+        qsizetype offset;
+        qsizetype length;
+        quint64 score;
+        bool operator<(const Segment &other) const noexcept { return score < other.score; }
+    };
+
+    // A segment is worth how many other samples share its grams that are
+    // not in the dictionary yet
+    std::vector<quint64> segmentGrams;
+    const auto score = [&](const Segment &segment) {
+        const char *p = samples[segment.sample].constData() + segment.offset;
+        segmentGrams.clear();
+        for (qsizetype pos = 0; pos + GramSize <= segment.length; ++pos)
+            segmentGrams.push_back(gramAt(p + pos));
+        std::sort(segmentGrams.begin(), segmentGrams.end());
+        segmentGrams.erase(std::unique(segmentGrams.begin(), segmentGrams.end()), segmentGrams.end());
+        quint64 result = 0;
+        for (quint64 gram : segmentGrams) {
+            const qsizetype n = grams[gram].samples;
+            if (n > 1)
+                result += quint64(n - 1);
+        }
+        return result;
+    };
+
+    std::priority_queue<Segment> candidates;
+    for (qsizetype i = 0; i < count; ++i) {
+        const qsizetype size = samples[i].size();
+        for (qsizetype offset = 0; offset + GramSize <= size; offset += SegmentStep) {
+            Segment segment = { i, offset, std::min(SegmentSize, size - offset), 0 };
+            segment.score = score(segment);
+            if (segment.score)
+                candidates.push(segment);
+        }
+    }
+
+    // Greedily take the best segment. Taking one makes others that share
+    // its grams less valuable, so scores are refreshed lazily: a segment is
+    // only taken if it's still the best after rescoring it.
+    std::vector<Segment> chosen;
+    qsizetype total = 0;
+    while (total < maxSize && !candidates.empty()) {
+        Segment segment = candidates.top();
+        candidates.pop();
+        segment.score = score(segment);
+        if (!segment.score)
+            continue;
+        if (!candidates.empty() && segment.score < candidates.top().score) {
+            candidates.push(segment);
+            continue;
+        }
+        for (quint64 gram : segmentGrams)
+            grams[gram].samples = 0;
+        chosen.push_back(segment);
+        total += segment.length;
+    }
+
+    // Fill the dictionary from the end, so that the most valuable segments
+    // come last; if we overshot, the start of the least valuable one is cut.
+    QByteArray dictionary(std::min(total, maxSize), Qt::Uninitialized);
+    qsizetype end = dictionary.size();
+    for (const Segment &segment : chosen) {
+        const qsizetype n = std::min(segment.length, end);
+        end -= n;
+        memcpy(dictionary.data() + end,
+               samples[segment.sample].constData() + segment.offset + segment.length - n, n);
+    }
+    return dictionary;
+}
+#endif // QT_NO_COMPRESS
+
 /*!
     \class QByteArray
     \inmodule QtCore
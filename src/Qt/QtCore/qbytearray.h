@@ -735,6 +735,15 @@
     { return qCompress(reinterpret_cast<const uchar *>(data.constData()), data.size(), compressionLevel); }
     inline QByteArray qUncompress(const QByteArray& data)
     { return qUncompress(reinterpret_cast<const uchar*>(data.constData()), data.size()); }
+    Q_CORE_EXPORT QByteArray qCompress(const uchar *data, qsizetype nbytes, const QByteArray &dictionary,
+                                       int compressionLevel = -1);
+    Q_CORE_EXPORT QByteArray qUncompress(const uchar *data, qsizetype nbytes, const QByteArray &dictionary);
+    inline QByteArray qCompress(const QByteArray &data, const QByteArray &dictionary, int compressionLevel = -1)
+    { return qCompress(reinterpret_cast<const uchar *>(data.constData()), data.size(), dictionary, compressionLevel); }
+    inline QByteArray qUncompress(const QByteArray &data, const QByteArray &dictionary)
+    { return qUncompress(reinterpret_cast<const uchar *>(data.constData()), data.size(), dictionary); }
+    Q_CORE_EXPORT QByteArray qTrainCompressionDictionary(const QByteArray *samples, qsizetype count,
+                                                         qsizetype maxSize = 4 * 1024);
     #endif
 
     Q_DECLARE_SHARED(QByteArray)
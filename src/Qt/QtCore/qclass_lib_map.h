@@ -146,11 +146,14 @@ QT_CLASS_LIB(QWaitCondition, QtCore, qwaitcondition.h)
 QT_CLASS_LIB(QWaitCondition, QtCore, qwaitcondition.h)
 QT_CLASS_LIB(QtAlgorithms, QtCore, qalgorithms.h)
 QT_CLASS_LIB(QBitArray, QtCore, qbitarray.h)
+QT_CLASS_LIB(QRoaringBitmap, QtCore, qroaringbitmap.h)
 QT_CLASS_LIB(QBitRef, QtCore, qbitarray.h)
 QT_CLASS_LIB(QByteArray, QtCore, qbytearray.h)
 QT_CLASS_LIB(QByteRef, QtCore, qbytearray.h)
 QT_CLASS_LIB(QByteArrayMatcher, QtCore, qbytearraymatcher.h)
 QT_CLASS_LIB(QCache, QtCore, qcache.h)
+QT_CLASS_LIB(QConcurrentCache, QtCore, qconcurrentcache.h)
+QT_CLASS_LIB(QConcurrentHash, QtCore, qconcurrenthash.h)
 QT_CLASS_LIB(QLatin1Char, QtCore, qchar.h)
 QT_CLASS_LIB(QChar, QtCore, qchar.h)
 QT_CLASS_LIB(QtContainerFwd, QtCore, qcontainerfwd.h)
@@ -171,6 +174,7 @@ QT_CLASS_LIB(QHash, QtCore, qhash.h)
 QT_CLASS_LIB(QMultiHash, QtCore, qhash.h)
 QT_CLASS_LIB(QHashIterator, QtCore, qhash.h)
 QT_CLASS_LIB(QMutableHashIterator, QtCore, qhash.h)
+QT_CLASS_LIB(QPersistentHash, QtCore, qpersistenthash.h)
 QT_CLASS_LIB(QHashIterator, QtCore, qhash.h)
 QT_CLASS_LIB(QMutableHashIterator, QtCore, qhash.h)
 QT_CLASS_LIB(QLine, QtCore, qline.h)
@@ -179,6 +183,7 @@ QT_CLASS_LIB(QListData, QtCore, qlist.h)
 QT_CLASS_LIB(QList, QtCore, qlist.h)
 QT_CLASS_LIB(QListIterator, QtCore, qlist.h)
 QT_CLASS_LIB(QMutableListIterator, QtCore, qlist.h)
+QT_CLASS_LIB(QPersistentList, QtCore, qpersistentlist.h)
 QT_CLASS_LIB(QListIterator, QtCore, qlist.h)
 QT_CLASS_LIB(QMutableListIterator, QtCore, qlist.h)
 QT_CLASS_LIB(QSystemLocale, QtCore, qlocale.h)
@@ -188,6 +193,10 @@ QT_CLASS_LIB(QMapNode, QtCore, qmap.h)
 QT_CLASS_LIB(QMapPayloadNode, QtCore, qmap.h)
 QT_CLASS_LIB(QMap, QtCore, qmap.h)
 QT_CLASS_LIB(QMultiMap, QtCore, qmap.h)
+QT_CLASS_LIB(QFlatMap, QtCore, qflatmap.h)
+QT_CLASS_LIB(QFlatSet, QtCore, qflatmap.h)
+QT_CLASS_LIB(QBTreeMap, QtCore, qbtreemap.h)
+QT_CLASS_LIB(QMultiBTreeMap, QtCore, qbtreemap.h)
 QT_CLASS_LIB(QMapIterator, QtCore, qmap.h)
 QT_CLASS_LIB(QMutableMapIterator, QtCore, qmap.h)
 QT_CLASS_LIB(QMapIterator, QtCore, qmap.h)
@@ -197,6 +206,10 @@ QT_CLASS_LIB(QPair, QtCore, qpair.h)
 QT_CLASS_LIB(QPoint, QtCore, qpoint.h)
 QT_CLASS_LIB(QPointF, QtCore, qpoint.h)
 QT_CLASS_LIB(QQueue, QtCore, qqueue.h)
+QT_CLASS_LIB(QSpscQueue, QtCore, qconcurrentqueue.h)
+QT_CLASS_LIB(QMpmcQueue, QtCore, qconcurrentqueue.h)
+QT_CLASS_LIB(QBlockingQueue, QtCore, qconcurrentqueue.h)
+QT_CLASS_LIB(QBlockingSpscQueue, QtCore, qconcurrentqueue.h)
 QT_CLASS_LIB(QRect, QtCore, qrect.h)
 QT_CLASS_LIB(QRectF, QtCore, qrect.h)
 QT_CLASS_LIB(QScopedPointerDeleter, QtCore, qscopedpointer.h)
@@ -234,6 +247,8 @@ QT_CLASS_LIB(QStringMatcher, QtCore, qstringmatcher.h)
 QT_CLASS_LIB(QTextBoundaryFinder, QtCore, qtextboundaryfinder.h)
 QT_CLASS_LIB(QTimeLine, QtCore, qtimeline.h)
 QT_CLASS_LIB(QVarLengthArray, QtCore, qvarlengtharray.h)
+QT_CLASS_LIB(QArenaVarLengthArray, QtCore, qvarlengtharray.h)
+QT_CLASS_LIB(QMonotonicArena, QtCore, qmonotonicarena.h)
 QT_CLASS_LIB(QXmlStreamAttribute, QtCore, qxmlstream.h)
 QT_CLASS_LIB(QXmlStreamAttributes, QtCore, qxmlstream.h)
 QT_CLASS_LIB(QXmlStreamNamespaceDeclaration, QtCore, qxmlstream.h)
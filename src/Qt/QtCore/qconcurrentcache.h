@@ -0,0 +1,607 @@
+// Copyright (C) 2025 The Qt Company Ltd.
+
+
+#ifndef QCONCURRENTCACHE_H
+#define QCONCURRENTCACHE_H
+
+#include <QtCore/qhash.h>
+#include <QtCore/qlist.h>
+#include <QtCore/qmath.h>
+#include <QtCore/qmutex.h>
+#include <QtCore/qthread.h>
+
+#include <chrono>
+#include <memory>
+#include <optional>
+
+QT_BEGIN_NAMESPACE
+
+template <class Key, class T>
+class QConcurrentCache
+{
+    using Clock = std::chrono::steady_clock;
+
+    // Each shard keeps its entries on three LRU lists (W-TinyLFU). New
+    // entries go into a small window; the window's least recently used entry
+    // then only moves on to the probation part of the main area if the
+    // frequency sketch says it has been asked for more often than the entry
+    // it would replace. Hits on probation promote an entry to the protected
+    // part. A scan over many keys thus only ever churns the window.
+    enum class Region : quint8 { Window, Probation, Protected };
+
+    struct Chain
+    {
+        Chain() noexcept : prev(this), next(this) { }
+        Chain *prev;
+        Chain *next;
+    };
+
+    struct Value
+    {
+        T t;
+        qsizetype cost = 0;
+        Clock::time_point expiry;
+        size_t hash = 0;
+        Region region = Region::Window;
+
+        Value(const T &tt, qsizetype c, Clock::time_point e, size_t h)
+            : t(tt), cost(c), expiry(e), hash(h)
+        {}
+        // Not defaulted, so that QHashPrivate never considers nodes relocatable:
+        // moving a node has to fix up its neighbours in the LRU list.
+        Value(Value &&other) noexcept(std::is_nothrow_move_constructible_v<T>)
+            : t(std::move(other.t)), cost(other.cost), expiry(other.expiry),
+              hash(other.hash), region(other.region)
+        {}
+
+    private:
+        Q_DISABLE_COPY(Value)
+    };
+
+    struct Node : public Chain
+    {
+        using KeyType = Key;
+        using ValueType = Value;
+
+        Key key;
+        Value value;
+
+        Node(const Key &k, Value &&v)
+            : Chain(),
+              key(k),
+              value(std::move(v))
+        {
+        }
+        static void createInPlace(Node *n, const Key &k, Value &&v)
+        {
+            new (n) Node(k, std::move(v));
+        }
+
+        Node(Node &&other)
+            : Chain(other),
+              key(std::move(other.key)),
+              value(std::move(other.value))
+        {
+            Q_ASSERT(this->prev);
+            Q_ASSERT(this->next);
+            this->prev->next = this;
+            this->next->prev = this;
+        }
+    private:
+        Q_DISABLE_COPY(Node)
+    };
+
+    // Approximate access counts: a count-min sketch of four-bit counters,
+    // sixteen to a word. Once ten times as many accesses were recorded as
+    // there are words, all counters are halved, so that the counts follow
+    // changes in popularity.
+    class FrequencySketch
+    {
+    public:
+        void ensureCapacity(qsizetype n)
+        {
+            if (n <= words)
+                return;
+            words = qsizetype(qNextPowerOfTwo(quint64(qMax(n, qsizetype(15)))));
+            table.reset(new quint64[words]());
+            additions = 0;
+        }
+
+        int frequency(size_t hash) const noexcept
+        {
+            if (!table)
+                return 0;
+            int f = 15;
+            for (int i = 0; i < 4; ++i)
+                f = qMin(f, int(table[indexOf(hash, i)] >> offsetOf(hash, i)) & 15);
+            return f;
+        }
+
+        void increment(size_t hash) noexcept
+        {
+            if (!table)
+                return;
+            bool added = false;
+            for (int i = 0; i < 4; ++i) {
+                quint64 &word = table[indexOf(hash, i)];
+                const int offset = offsetOf(hash, i);
+                if (((word >> offset) & 15) != 15) {
+                    word += quint64(1) << offset;
+                    added = true;
+                }
+            }
+            if (added && ++additions >= 10 * words)
+                halve();
+        }
+
+    private:
+        size_t indexOf(size_t hash, int i) const noexcept
+        {
+            constexpr quint64 seeds[] = {
+                Q_UINT64_C(0xc3a5c85c97cb3127), Q_UINT64_C(0xb492b66fbe98f273),
+                Q_UINT64_C(0x9ae16a3b2f90404f), Q_UINT64_C(0xcbf29ce484222325)
+            };
+            quint64 h = (quint64(hash) + seeds[i]) * seeds[i];
+            h += h >> 32;
+            return size_t(h) & size_t(words - 1);
+        }
+        static int offsetOf(size_t hash, int i) noexcept
+        {
+            return int((hash >> (i * 8)) & 15) * 4;
+        }
+
+        void halve() noexcept
+        {
+            for (qsizetype i = 0; i < words; ++i)
+                table[i] = (table[i] >> 1) & Q_UINT64_C(0x7777777777777777);
+            additions /= 2;
+        }
+
+        std::unique_ptr<quint64[]> table;
+        qsizetype words = 0;
+        qsizetype additions = 0;
+    };
+
+public:
+    struct Statistics
+    {
+        qint64 hits = 0;
+        qint64 misses = 0;
+        qint64 evictions = 0;
+        qint64 expirations = 0;
+    };
+
+private:
+    static constexpr size_t CacheLineSize = 64;
+
+    // All members are guarded by the mutex. Lookups reorder the LRU lists
+    // and update the sketch, so there is no point in a read-write lock.
+    struct alignas(CacheLineSize) Shard
+    {
+        QMutex mutex;
+        QHashPrivate::Data<Node> d;
+        Chain window;
+        Chain probation;
+        Chain protectedEntries;
+        qsizetype windowCost = 0;
+        qsizetype probationCost = 0;
+        qsizetype protectedCost = 0;
+        qsizetype maxCost = 0;
+        qsizetype windowMax = 0;
+        qsizetype protectedMax = 0;
+        Clock::duration timeToLive = Clock::duration::zero();
+        FrequencySketch sketch;
+        Statistics statistics;
+
+        qsizetype totalCost() const noexcept { return windowCost + probationCost + protectedCost; }
+
+        void setMaxCost(qsizetype m)
+        {
+            // 1% of the budget goes to the window, and 80% of the rest to
+            // the protected entries
+            maxCost = m;
+            windowMax = m > 0 ? qMax(qsizetype(1), m / 100) : 0;
+            protectedMax = (m - windowMax) / 5 * 4;
+            maintain();
+        }
+
+        bool isExpired(const Node *n, Clock::time_point now) const noexcept
+        {
+            return n->value.expiry != Clock::time_point::max() && now >= n->value.expiry;
+        }
+        bool isExpired(const Node *n) const
+        {
+            return n->value.expiry != Clock::time_point::max() && Clock::now() >= n->value.expiry;
+        }
+
+        Chain &list(Region region) noexcept
+        {
+            switch (region) {
+            case Region::Window: return window;
+            case Region::Probation: return probation;
+            case Region::Protected: return protectedEntries;
+            }
+            Q_UNREACHABLE_RETURN(window);
+        }
+        qsizetype &cost(Region region) noexcept
+        {
+            switch (region) {
+            case Region::Window: return windowCost;
+            case Region::Probation: return probationCost;
+            case Region::Protected: return protectedCost;
+            }
+            Q_UNREACHABLE_RETURN(windowCost);
+        }
+        static Node *leastRecent(Chain &chain) noexcept
+        {
+            return chain.prev == &chain ? nullptr : static_cast<Node *>(chain.prev);
+        }
+
+        void link(Node *n, Region region) noexcept
+        {
+            Chain &chain = list(region);
+            n->prev = &chain;
+            n->next = chain.next;
+            chain.next->prev = n;
+            chain.next = n;
+            n->value.region = region;
+            cost(region) += n->value.cost;
+        }
+        void unlink(Node *n) noexcept
+        {
+            Q_ASSERT(n->prev);
+            Q_ASSERT(n->next);
+            n->prev->next = n->next;
+            n->next->prev = n->prev;
+            cost(n->value.region) -= n->value.cost;
+        }
+        void moveTo(Node *n, Region region) noexcept
+        {
+            unlink(n);
+            link(n, region);
+        }
+
+        // Invalidates all other Node pointers, as erasing moves nodes around
+        void erase(Node *n) noexcept(std::is_nothrow_destructible_v<Node>)
+        {
+            unlink(n);
+            d.erase(d.findBucket(n->key));
+        }
+        void evict(Node *n)
+        {
+            erase(n);
+            ++statistics.evictions;
+        }
+
+        void touch(Node *n) noexcept
+        {
+            moveTo(n, n->value.region == Region::Window ? Region::Window : Region::Protected);
+            demoteProtected();
+        }
+
+        // Entries the protected part has no room for go back on probation
+        void demoteProtected() noexcept
+        {
+            while (protectedCost > protectedMax)
+                moveTo(leastRecent(protectedEntries), Region::Probation);
+        }
+
+        void maintain()
+        {
+            demoteProtected();
+
+            const qsizetype mainMax = maxCost - windowMax;
+            while (windowCost > windowMax) {
+                bool admit = true;
+                while (probationCost + protectedCost + leastRecent(window)->value.cost > mainMax) {
+                    Node *victim = leastRecent(probation);
+                    if (!victim)
+                        victim = leastRecent(protectedEntries);
+                    const Node *candidate = leastRecent(window);
+                    if (!victim || sketch.frequency(candidate->value.hash)
+                                       <= sketch.frequency(victim->value.hash)) {
+                        admit = false;
+                        break;
+                    }
+                    evict(victim);
+                }
+                if (admit)
+                    moveTo(leastRecent(window), Region::Probation);
+                else
+                    evict(leastRecent(window));
+            }
+
+            // only after an entry in the main area was replaced by a more expensive one
+            while (probationCost + protectedCost > mainMax) {
+                Node *victim = leastRecent(probation);
+                evict(victim ? victim : leastRecent(protectedEntries));
+            }
+        }
+
+        Node *lookup(const Key &key, size_t hash)
+        {
+            Node *n = d.size ? d.findNode(key) : nullptr;
+            if (n && isExpired(n)) {
+                erase(n);
+                ++statistics.expirations;
+                n = nullptr;
+            }
+            sketch.increment(hash);
+            if (n) {
+                ++statistics.hits;
+                touch(n);   // doesn't erase anything, so n stays valid
+            } else {
+                ++statistics.misses;
+            }
+            return n;
+        }
+
+        bool insert(const Key &key, const T &t, qsizetype c, size_t hash)
+        {
+            if (c > maxCost) {
+                if (Node *n = d.size ? d.findNode(key) : nullptr)
+                    erase(n);
+                return false;
+            }
+            const Clock::time_point expiry = timeToLive == Clock::duration::zero()
+                    ? Clock::time_point::max() : Clock::now() + timeToLive;
+            auto result = d.findOrInsert(key);
+            Node *n = result.it.node();
+            if (result.initialized) {
+                unlink(n);
+                n->value.t = t;
+                n->value.cost = c;
+                n->value.expiry = expiry;
+                link(n, n->value.region);
+            } else {
+                Node::createInPlace(n, key, Value(t, c, expiry, hash));
+                link(n, Region::Window);
+                sketch.ensureCapacity(qsizetype(d.size));
+            }
+            sketch.increment(hash);
+            maintain();
+            return true;
+        }
+
+        void clear() noexcept(std::is_nothrow_destructible_v<Node>)
+        {
+            d.clear();
+            for (Chain *chain : { &window, &probation, &protectedEntries })
+                chain->prev = chain->next = chain;
+            windowCost = probationCost = protectedCost = 0;
+        }
+
+        qsizetype removeExpired()
+        {
+            if (!d.size)
+                return 0;
+            // collect first: erasing moves nodes, so we can't erase while walking the lists
+            const Clock::time_point now = Clock::now();
+            QList<Key> expired;
+            for (Chain *chain : { &window, &probation, &protectedEntries }) {
+                for (Chain *c = chain->next; c != chain; c = c->next) {
+                    if (isExpired(static_cast<Node *>(c), now))
+                        expired.append(static_cast<Node *>(c)->key);
+                }
+            }
+            for (const Key &key : std::as_const(expired))
+                erase(d.findNode(key));
+            statistics.expirations += expired.size();
+            return expired.size();
+        }
+    };
+
+public:
+    static constexpr qsizetype MaxShardCount = 1024;
+
+    explicit QConcurrentCache(qsizetype maxCost = 100, qsizetype shardCount = 0)
+        : seed(size_t(QHashSeed::globalSeed()) ^ size_t(0x2545f491))
+    {
+        if (shardCount <= 0) {
+            // don't split small caches so much that every shard only has room for a few entries
+            shardCount = 4 * qMax(1, QThread::idealThreadCount());
+            shardCount = qMin(shardCount, maxCost / 64);
+        }
+        shardCount = qBound(qsizetype(1), shardCount, MaxShardCount);
+        shardBits = qCountTrailingZeroBits(qNextPowerOfTwo(quint32(shardCount - 1)));
+        shards.reset(new Shard[size_t(1) << shardBits]);
+        setMaxCost(maxCost);
+    }
+    ~QConcurrentCache()
+    {
+        static_assert(std::is_nothrow_destructible_v<Key>, "Types with throwing destructors are not supported in Qt containers.");
+        static_assert(std::is_nothrow_destructible_v<T>, "Types with throwing destructors are not supported in Qt containers.");
+    }
+    Q_DISABLE_COPY_MOVE(QConcurrentCache)
+
+    qsizetype shardCount() const noexcept { return qsizetype(1) << shardBits; }
+
+    qsizetype maxCost() const
+    {
+        qsizetype m = 0;
+        for (qsizetype i = 0; i < shardCount(); ++i) {
+            QMutexLocker locker(&shards[i].mutex);
+            m += shards[i].maxCost;
+        }
+        return m;
+    }
+
+    // The budget is split evenly over the shards, and each shard evicts on
+    // its own; a shard with many expensive entries can't borrow from the others.
+    void setMaxCost(qsizetype m)
+    {
+        const qsizetype n = shardCount();
+        for (qsizetype i = 0; i < n; ++i) {
+            QMutexLocker locker(&shards[i].mutex);
+            shards[i].setMaxCost(m / n + (i < m % n ? 1 : 0));
+        }
+    }
+
+    qsizetype totalCost() const
+    {
+        qsizetype total = 0;
+        for (qsizetype i = 0; i < shardCount(); ++i) {
+            QMutexLocker locker(&shards[i].mutex);
+            total += shards[i].totalCost();
+        }
+        return total;
+    }
+
+    // Entries expire this long after they were last inserted. Only applies
+    // to entries inserted after the call; zero (the default) disables expiry.
+    void setTimeToLive(std::chrono::milliseconds ttl)
+    {
+        for (qsizetype i = 0; i < shardCount(); ++i) {
+            QMutexLocker locker(&shards[i].mutex);
+            shards[i].timeToLive = qMax(ttl, std::chrono::milliseconds::zero());
+        }
+    }
+    std::chrono::milliseconds timeToLive() const
+    {
+        QMutexLocker locker(&shards[0].mutex);
+        return std::chrono::duration_cast<std::chrono::milliseconds>(shards[0].timeToLive);
+    }
+
+    qsizetype size() const
+    {
+        qsizetype n = 0;
+        for (qsizetype i = 0; i < shardCount(); ++i) {
+            QMutexLocker locker(&shards[i].mutex);
+            n += qsizetype(shards[i].d.size);
+        }
+        return n;
+    }
+    qsizetype count() const { return size(); }
+    bool isEmpty() const { return size() == 0; }
+
+    void clear()
+    {
+        for (qsizetype i = 0; i < shardCount(); ++i) {
+            QMutexLocker locker(&shards[i].mutex);
+            shards[i].clear();
+        }
+    }
+
+    // Returns false if cost exceeds the budget of the key's shard, like
+    // QCache::insert(). An accepted entry may still be evicted right away if
+    // the admission policy prefers the entries already in the cache.
+    bool insert(const Key &key, const T &value, qsizetype cost = 1)
+    {
+        const size_t h = hash(key);
+        Shard &s = shardFor(h);
+        QMutexLocker locker(&s.mutex);
+        return s.insert(key, value, cost, h);
+    }
+
+    // Unlike find(), doesn't count as an access
+    bool contains(const Key &key) const
+    {
+        Shard &s = shardFor(hash(key));
+        QMutexLocker locker(&s.mutex);
+        const Node *n = s.d.size ? s.d.findNode(key) : nullptr;
+        return n && !s.isExpired(n);
+    }
+
+    std::optional<T> find(const Key &key) const
+    {
+        const size_t h = hash(key);
+        Shard &s = shardFor(h);
+        QMutexLocker locker(&s.mutex);
+        if (const Node *n = s.lookup(key, h))
+            return n->value.t;
+        return std::nullopt;
+    }
+
+    T value(const Key &key, const T &defaultValue = T()) const
+    {
+        const size_t h = hash(key);
+        Shard &s = shardFor(h);
+        QMutexLocker locker(&s.mutex);
+        if (const Node *n = s.lookup(key, h))
+            return n->value.t;
+        return defaultValue;
+    }
+
+    bool remove(const Key &key)
+    {
+        Shard &s = shardFor(hash(key));
+        QMutexLocker locker(&s.mutex);
+        Node *n = s.d.size ? s.d.findNode(key) : nullptr;
+        if (!n)
+            return false;
+        s.erase(n);
+        return true;
+    }
+
+    std::optional<T> take(const Key &key)
+    {
+        Shard &s = shardFor(hash(key));
+        QMutexLocker locker(&s.mutex);
+        Node *n = s.d.size ? s.d.findNode(key) : nullptr;
+        if (!n)
+            return std::nullopt;
+        std::optional<T> result;
+        if (!s.isExpired(n))
+            result.emplace(std::move(n->value.t));
+        s.erase(n);
+        return result;
+    }
+
+    // Expired entries are otherwise only dropped when they are looked up
+    qsizetype removeExpired()
+    {
+        qsizetype n = 0;
+        for (qsizetype i = 0; i < shardCount(); ++i) {
+            QMutexLocker locker(&shards[i].mutex);
+            n += shards[i].removeExpired();
+        }
+        return n;
+    }
+
+    Statistics statistics() const
+    {
+        Statistics result;
+        for (qsizetype i = 0; i < shardCount(); ++i) {
+            QMutexLocker locker(&shards[i].mutex);
+            const Statistics &s = shards[i].statistics;
+            result.hits += s.hits;
+            result.misses += s.misses;
+            result.evictions += s.evictions;
+            result.expirations += s.expirations;
+        }
+        return result;
+    }
+
+    void resetStatistics()
+    {
+        for (qsizetype i = 0; i < shardCount(); ++i) {
+            QMutexLocker locker(&shards[i].mutex);
+            shards[i].statistics = Statistics();
+        }
+    }
+
+private:
+    // The seed is not the one QHash uses, so that the keys in a shard don't
+    // all agree on the hash bits the shard's table uses.
+    size_t hash(const Key &key) const
+    {
+        return QHashPrivate::calculateHash(key, seed);
+    }
+    Shard &shardFor(size_t h) const
+    {
+        if (shardBits == 0)
+            return shards[0];
+        if constexpr (sizeof(size_t) == 8)
+            return shards[(quint64(h) * Q_UINT64_C(0x9e3779b97f4a7c15)) >> (64 - shardBits)];
+        else
+            return shards[(quint32(h) * 0x9e3779b9U) >> (32 - shardBits)];
+    }
+
+    std::unique_ptr<Shard[]> shards;
+    size_t seed;
+    int shardBits = 0;
+};
+
+QT_END_NAMESPACE
+
+#endif // QCONCURRENTCACHE_H
@@ -0,0 +1,187 @@
+// Copyright (C) 2025 The Qt Company Ltd.
+
+
+#ifndef QCONCURRENTHASH_H
+#define QCONCURRENTHASH_H
+
+#include <QtCore/qhash.h>
+#include <QtCore/qmath.h>
+#include <QtCore/qreadwritelock.h>
+#include <QtCore/qthread.h>
+
+#include <memory>
+#include <optional>
+
+QT_BEGIN_NAMESPACE
+
+template <typename Key, typename T>
+class QConcurrentHash
+{
+    // Each shard gets its own cache lines, so that threads working on
+    // different shards don't invalidate each other's lock state.
+    static constexpr size_t CacheLineSize = 64;
+
+    struct alignas(CacheLineSize) Shard
+    {
+        mutable QReadWriteLock lock;
+        QHash<Key, T> hash;
+    };
+
+public:
+    static constexpr qsizetype MaxShardCount = 1024;
+
+    explicit QConcurrentHash(qsizetype shardCount = 0)
+        : seed(size_t(QHashSeed::globalSeed()) ^ size_t(0x5bd1e995))
+    {
+        if (shardCount <= 0)
+            shardCount = 4 * qMax(1, QThread::idealThreadCount());
+        shardCount = qBound(qsizetype(2), shardCount, MaxShardCount);
+        shardBits = qCountTrailingZeroBits(qNextPowerOfTwo(quint32(shardCount - 1)));
+        shards.reset(new Shard[size_t(1) << shardBits]);
+    }
+    Q_DISABLE_COPY_MOVE(QConcurrentHash)
+
+    qsizetype shardCount() const noexcept { return qsizetype(1) << shardBits; }
+
+    qsizetype size() const
+    {
+        qsizetype n = 0;
+        for (qsizetype i = 0; i < shardCount(); ++i) {
+            QReadLocker locker(&shards[i].lock);
+            n += shards[i].hash.size();
+        }
+        return n;
+    }
+    bool isEmpty() const { return size() == 0; }
+
+    void clear()
+    {
+        for (qsizetype i = 0; i < shardCount(); ++i) {
+            QWriteLocker locker(&shards[i].lock);
+            shards[i].hash.clear();
+        }
+    }
+
+    bool contains(const Key &key) const
+    {
+        const Shard &s = shardFor(key);
+        QReadLocker locker(&s.lock);
+        return s.hash.contains(key);
+    }
+
+    T value(const Key &key, const T &defaultValue = T()) const
+    {
+        const Shard &s = shardFor(key);
+        QReadLocker locker(&s.lock);
+        return s.hash.value(key, defaultValue);
+    }
+
+    std::optional<T> find(const Key &key) const
+    {
+        const Shard &s = shardFor(key);
+        QReadLocker locker(&s.lock);
+        if (auto it = s.hash.constFind(key); it != s.hash.cend())
+            return *it;
+        return std::nullopt;
+    }
+
+    bool insert(const Key &key, const T &value)
+    {
+        Shard &s = shardFor(key);
+        QWriteLocker locker(&s.lock);
+        if (s.hash.contains(key))
+            return false;
+        s.hash.emplace(key, value);
+        return true;
+    }
+
+    bool insertOrAssign(const Key &key, const T &value)
+    {
+        Shard &s = shardFor(key);
+        QWriteLocker locker(&s.lock);
+        const qsizetype oldSize = s.hash.size();
+        s.hash.insert(key, value);
+        return s.hash.size() != oldSize;
+    }
+
+    template <typename Factory>
+    T computeIfAbsent(const Key &key, Factory &&factory)
+    {
+        Shard &s = shardFor(key);
+        {
+            QReadLocker locker(&s.lock);
+            if (auto it = s.hash.constFind(key); it != s.hash.cend())
+                return *it;
+        }
+        QWriteLocker locker(&s.lock);
+        // another thread may have inserted the key while we weren't holding the lock
+        if (auto it = s.hash.constFind(key); it != s.hash.cend())
+            return *it;
+        return *s.hash.emplace(key, std::forward<Factory>(factory)(key));
+    }
+
+    bool remove(const Key &key)
+    {
+        Shard &s = shardFor(key);
+        QWriteLocker locker(&s.lock);
+        return s.hash.remove(key);
+    }
+
+    std::optional<T> take(const Key &key)
+    {
+        Shard &s = shardFor(key);
+        QWriteLocker locker(&s.lock);
+        auto it = s.hash.find(key);
+        if (it == s.hash.end())
+            return std::nullopt;
+        std::optional<T> result(std::move(*it));
+        s.hash.erase(it);
+        return result;
+    }
+
+    template <typename Function>
+    void forEach(Function &&f) const
+    {
+        for (qsizetype i = 0; i < shardCount(); ++i) {
+            const QHash<Key, T> snapshot = shardSnapshot(i);
+            for (auto it = snapshot.cbegin(), end = snapshot.cend(); it != end; ++it)
+                f(it.key(), it.value());
+        }
+    }
+
+    QHash<Key, T> snapshot() const
+    {
+        QHash<Key, T> result;
+        forEach([&result](const Key &key, const T &value) { result.emplace(key, value); });
+        return result;
+    }
+
+private:
+    QHash<Key, T> shardSnapshot(qsizetype i) const
+    {
+        // Only shares the data; the next writer to the shard detaches
+        QReadLocker locker(&shards[i].lock);
+        return shards[i].hash;
+    }
+
+    // The shard is picked with a seed of its own, so that the keys in a
+    // shard don't all agree on the hash bits QHash uses inside the shard.
+    size_t shardIndex(const Key &key) const
+    {
+        const size_t h = QHashPrivate::calculateHash(key, seed);
+        if constexpr (sizeof(size_t) == 8)
+            return (quint64(h) * Q_UINT64_C(0x9e3779b97f4a7c15)) >> (64 - shardBits);
+        else
+            return (quint32(h) * 0x9e3779b9U) >> (32 - shardBits);
+    }
+    Shard &shardFor(const Key &key) { return shards[shardIndex(key)]; }
+    const Shard &shardFor(const Key &key) const { return shards[shardIndex(key)]; }
+
+    std::unique_ptr<Shard[]> shards;
+    size_t seed;
+    int shardBits = 1;
+};
+
+QT_END_NAMESPACE
+
+#endif // QCONCURRENTHASH_H
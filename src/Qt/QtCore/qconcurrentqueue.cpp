@@ -0,0 +1,146 @@
+// Copyright (C) 2025 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
+
+#include "qconcurrentqueue.h"
+#include <private/qfutex_p.h>
+#include "qmutex.h"
+#include "qwaitcondition.h"
+
+#include <iterator>
+
+QT_BEGIN_NAMESPACE
+
+/*!
+    \class QSpscQueue
+    \inmodule QtCore
+    \brief The QSpscQueue class is a bounded lock-free queue for one producer
+    and one consumer thread.
+
+    \ingroup thread
+
+    Exactly one thread may call tryPush() and tryEmplace(), and exactly one
+    (other) thread may call tryPop(). Neither ever blocks or takes a lock;
+    they fail instead when the queue is full or empty. The capacity is
+    rounded up to a power of two.
+
+    The producer's and the consumer's positions live on separate cache
+    lines, and each side only reads the other's position when its cached
+    copy says that the queue is full or empty. In a steady stream, the two
+    threads hardly ever touch the same cache line except for the slots
+    themselves.
+
+    \sa QMpmcQueue, QBlockingQueue
+*/
+
+/*!
+    \class QMpmcQueue
+    \inmodule QtCore
+    \brief The QMpmcQueue class is a bounded lock-free queue for any number
+    of producer and consumer threads.
+
+    \ingroup thread
+
+    Every slot carries a sequence number, and producers and consumers claim
+    a slot with a single compare-and-swap on their end of the queue. A
+    thread that loses that race simply tries the next position; nobody ever
+    waits for a thread that was descheduled halfway through an operation
+    on a different slot.
+
+    T must be nothrow move-constructible. Constructors that may throw run
+    before a slot is claimed.
+
+    \sa QSpscQueue, QBlockingQueue
+*/
+
+/*!
+    \class QBlockingQueue
+    \inmodule QtCore
+    \brief The QBlockingQueue class adds blocking push() and pop() functions
+    to QMpmcQueue or QSpscQueue.
+
+    \ingroup thread
+
+    A thread that finds the queue full (in push()) or empty (in pop()) first
+    retries for a short while, then goes to sleep until a thread on the
+    other end makes progress. When nobody sleeps, the only extra cost over
+    the underlying queue is one memory fence and one load per operation.
+
+    QBlockingSpscQueue<T> is QBlockingQueue<T, QSpscQueue<T>>; the
+    single-producer, single-consumer restriction of QSpscQueue applies.
+*/
+
+namespace QtPrivate {
+
+using namespace QtFutex;
+
+namespace {
+// Without futexes, waiters sleep on one of a few condition variables chosen
+// by the event count's address. Sharing them only causes spurious wake-ups.
+struct ParkingSlot
+{
+    QMutex mutex;
+    QWaitCondition condition;
+};
+
+ParkingSlot &parkingSlotFor(const void *address)
+{
+    static ParkingSlot slots[16];
+    return slots[(quintptr(address) / alignof(QEventCount)) % std::size(slots)];
+}
+
+// The futex is the epoch, the low 32 bits of the state
+QBasicAtomicInteger<quint32> *futexLow32(QBasicAtomicInteger<quint64> *ptr)
+{
+    auto result = reinterpret_cast<QBasicAtomicInteger<quint32> *>(ptr);
+#if Q_BYTE_ORDER == Q_BIG_ENDIAN
+    ++result;
+#endif
+    return result;
+}
+} // unnamed namespace
+
+bool QEventCount::wait(quint32 ticket, QDeadlineTimer deadline) noexcept
+{
+    bool woken = true;
+    if (futexAvailable()) {
+        QBasicAtomicInteger<quint32> *epoch = futexLow32(&state);
+        if (deadline.isForever())
+            futexWait(*epoch, ticket);
+        else if (!deadline.hasExpired())
+            woken = futexWait(*epoch, ticket, deadline);
+        else
+            woken = quint32(state.loadAcquire()) != ticket;
+    } else {
+        ParkingSlot &slot = parkingSlotFor(this);
+        QMutexLocker locker(&slot.mutex);
+        while (woken && quint32(state.loadAcquire()) == ticket)
+            woken = slot.condition.wait(&slot.mutex, deadline);
+    }
+    cancelWait(ticket);
+    return woken;
+}
+
+void QEventCount::wake() noexcept
+{
+    // Start a new epoch that nobody waits for yet: the current waiters all
+    // get woken and have to take a new ticket if they want to wait again.
+    quint64 s = state.loadRelaxed();
+    do {
+        if (s < OneWaiter)
+            return;
+    } while (!state.testAndSetRelease(s, quint64(quint32(s) + 1), s));
+
+    if (futexAvailable()) {
+        futexWakeAll(*futexLow32(&state));
+    } else {
+        // taking the mutex orders the new epoch against a waiter that has
+        // checked the old one and is about to sleep
+        ParkingSlot &slot = parkingSlotFor(this);
+        QMutexLocker locker(&slot.mutex);
+        slot.condition.wakeAll();
+    }
+}
+
+} // namespace QtPrivate
+
+QT_END_NAMESPACE
@@ -0,0 +1,371 @@
+// Copyright (C) 2025 The Qt Company Ltd.
+
+
+#ifndef QCONCURRENTQUEUE_H
+#define QCONCURRENTQUEUE_H
+
+#include <QtCore/qatomic.h>
+#include <QtCore/qdeadlinetimer.h>
+#include <QtCore/qmath.h>
+#include <QtCore/qyieldcpu.h>
+
+#include <atomic>
+#include <memory>
+#include <new>
+#include <optional>
+
+QT_BEGIN_NAMESPACE
+
+namespace QtPrivate {
+// Keeps the two ends of a queue on separate cache lines, so that producers
+// and consumers don't invalidate each other's position on every operation.
+static constexpr size_t QueueCacheLineSize = 64;
+
+inline size_t queueCapacityFor(qsizetype capacity)
+{
+    Q_ASSERT(capacity > 0);
+    return qNextPowerOfTwo(quint64(qMax(capacity, qsizetype(2)) - 1));
+}
+
+template <typename T>
+struct alignas(T) QueueSlot
+{
+    unsigned char storage[sizeof(T)];
+
+    T *get() noexcept { return std::launder(reinterpret_cast<T *>(storage)); }
+};
+
+// An event count: waiters take a ticket, check their condition once more,
+// and sleep only while nobody has signalled since they took the ticket.
+// Signalling costs one load when nobody waits, and a thread that was woken
+// up but hasn't run yet doesn't make the next signal wake it again.
+// Sleeping uses a futex where the platform has one.
+class Q_CORE_EXPORT QEventCount
+{
+    // The low half is the epoch (the futex word), the high half counts the
+    // threads waiting for the epoch to change.
+    static constexpr quint64 OneWaiter = Q_UINT64_C(1) << 32;
+
+public:
+    quint32 prepareWait() noexcept
+    {
+        // ordered, so that the caller's re-check of its condition can't be
+        // reordered before this, which would race with notify()
+        return quint32(state.fetchAndAddOrdered(OneWaiter));
+    }
+    void cancelWait(quint32 ticket) noexcept
+    {
+        // once the epoch has moved on, the notifier has stopped counting us
+        quint64 s = state.loadRelaxed();
+        while (quint32(s) == ticket && !state.testAndSetRelaxed(s, s - OneWaiter, s))
+            ;
+    }
+    // Returns false if the deadline expired first. Spurious wake-ups happen.
+    bool wait(quint32 ticket, QDeadlineTimer deadline = QDeadlineTimer::Forever) noexcept;
+
+    // Wakes all threads waiting right now.
+    void notify() noexcept
+    {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (state.loadRelaxed() >= OneWaiter)
+            wake();
+    }
+
+private:
+    void wake() noexcept;
+
+    QBasicAtomicInteger<quint64> state = Q_BASIC_ATOMIC_INITIALIZER(0);
+};
+} // namespace QtPrivate
+
+// A bounded queue for exactly one producer thread and one consumer thread.
+template <typename T>
+class QSpscQueue
+{
+    using Slot = QtPrivate::QueueSlot<T>;
+    static constexpr size_t CacheLineSize = QtPrivate::QueueCacheLineSize;
+
+public:
+    explicit QSpscQueue(qsizetype capacity)
+        : slots(new Slot[QtPrivate::queueCapacityFor(capacity)]),
+          mask(QtPrivate::queueCapacityFor(capacity) - 1)
+    {
+    }
+    ~QSpscQueue()
+    {
+        if constexpr (!std::is_trivially_destructible_v<T>) {
+            const size_t tail = producer.tail.load(std::memory_order_relaxed);
+            for (size_t i = consumer.head.load(std::memory_order_relaxed); i != tail; ++i)
+                slots[i & mask].get()->~T();
+        }
+    }
+    Q_DISABLE_COPY_MOVE(QSpscQueue)
+
+    qsizetype capacity() const noexcept { return qsizetype(mask + 1); }
+    // Only exact when called from the producer or consumer thread while
+    // the other one is idle.
+    qsizetype size() const noexcept
+    {
+        return qsizetype(producer.tail.load(std::memory_order_acquire)
+                         - consumer.head.load(std::memory_order_acquire));
+    }
+    bool isEmpty() const noexcept { return size() == 0; }
+
+    // Producer side
+    bool tryPush(const T &value) { return tryEmplace(value); }
+    bool tryPush(T &&value) { return tryEmplace(std::move(value)); }
+    template <typename... Args>
+    bool tryEmplace(Args &&...args)
+    {
+        const size_t tail = producer.tail.load(std::memory_order_relaxed);
+        if (tail - producer.cachedHead > mask) {
+            producer.cachedHead = consumer.head.load(std::memory_order_acquire);
+            if (tail - producer.cachedHead > mask)
+                return false;
+        }
+        new (slots[tail & mask].storage) T(std::forward<Args>(args)...);
+        producer.tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side
+    std::optional<T> tryPop()
+    {
+        const size_t head = consumer.head.load(std::memory_order_relaxed);
+        if (head == consumer.cachedTail) {
+            consumer.cachedTail = producer.tail.load(std::memory_order_acquire);
+            if (head == consumer.cachedTail)
+                return std::nullopt;
+        }
+        T *item = slots[head & mask].get();
+        std::optional<T> result(std::move(*item));
+        item->~T();
+        consumer.head.store(head + 1, std::memory_order_release);
+        return result;
+    }
+
+private:
+    // Each side keeps a copy of the other side's index and only reloads it
+    // when the copy says the queue is full (or empty).
+    struct alignas(CacheLineSize) Producer
+    {
+        std::atomic<size_t> tail = 0;
+        size_t cachedHead = 0;
+    };
+    struct alignas(CacheLineSize) Consumer
+    {
+        std::atomic<size_t> head = 0;
+        size_t cachedTail = 0;
+    };
+
+    Producer producer;
+    Consumer consumer;
+    std::unique_ptr<Slot[]> slots;
+    const size_t mask;
+};
+
+// A bounded queue for any number of producer and consumer threads, after
+// Dmitry Vyukov's design: every slot carries a sequence number that tells
+// producers and consumers whose turn it is, so claiming a slot is a single
+// compare-and-swap on the respective end of the queue.
+template <typename T>
+class QMpmcQueue
+{
+    static_assert(std::is_nothrow_move_constructible_v<T>,
+                  "QMpmcQueue requires a type that can be moved without throwing.");
+    static constexpr size_t CacheLineSize = QtPrivate::QueueCacheLineSize;
+
+    struct Cell
+    {
+        std::atomic<size_t> sequence;
+        QtPrivate::QueueSlot<T> slot;
+    };
+
+public:
+    explicit QMpmcQueue(qsizetype capacity)
+        : cells(new Cell[QtPrivate::queueCapacityFor(capacity)]),
+          mask(QtPrivate::queueCapacityFor(capacity) - 1)
+    {
+        for (size_t i = 0; i <= mask; ++i)
+            cells[i].sequence.store(i, std::memory_order_relaxed);
+    }
+    ~QMpmcQueue()
+    {
+        if constexpr (!std::is_trivially_destructible_v<T>) {
+            while (tryPop())
+                ;
+        }
+    }
+    Q_DISABLE_COPY_MOVE(QMpmcQueue)
+
+    qsizetype capacity() const noexcept { return qsizetype(mask + 1); }
+    // Approximate while other threads use the queue.
+    qsizetype size() const noexcept
+    {
+        const size_t tail = enqueuePos.load(std::memory_order_acquire);
+        const size_t head = dequeuePos.load(std::memory_order_acquire);
+        return tail > head ? qsizetype(tail - head) : 0;
+    }
+    bool isEmpty() const noexcept { return size() == 0; }
+
+    bool tryPush(const T &value) { return tryEmplace(value); }
+    bool tryPush(T &&value) { return tryEmplace(std::move(value)); }
+    template <typename... Args>
+    bool tryEmplace(Args &&...args)
+    {
+        if constexpr (!std::is_nothrow_constructible_v<T, Args...>) {
+            // a slot, once claimed, must be filled; so construct first
+            T value(std::forward<Args>(args)...);
+            return tryEmplace(std::move(value));
+        } else {
+            size_t pos = enqueuePos.load(std::memory_order_relaxed);
+            Cell *cell;
+            for (;;) {
+                cell = &cells[pos & mask];
+                const size_t seq = cell->sequence.load(std::memory_order_acquire);
+                const qptrdiff diff = qptrdiff(seq) - qptrdiff(pos);
+                if (diff == 0) {
+                    if (enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                        break;
+                } else if (diff < 0) {
+                    return false;   // full
+                } else {
+                    pos = enqueuePos.load(std::memory_order_relaxed);
+                }
+            }
+            new (cell->slot.storage) T(std::forward<Args>(args)...);
+            cell->sequence.store(pos + 1, std::memory_order_release);
+            return true;
+        }
+    }
+
+    std::optional<T> tryPop() noexcept
+    {
+        size_t pos = dequeuePos.load(std::memory_order_relaxed);
+        Cell *cell;
+        for (;;) {
+            cell = &cells[pos & mask];
+            const size_t seq = cell->sequence.load(std::memory_order_acquire);
+            const qptrdiff diff = qptrdiff(seq) - qptrdiff(pos + 1);
+            if (diff == 0) {
+                if (dequeuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                    break;
+            } else if (diff < 0) {
+                return std::nullopt;    // empty
+            } else {
+                pos = dequeuePos.load(std::memory_order_relaxed);
+            }
+        }
+        T *item = cell->slot.get();
+        std::optional<T> result(std::move(*item));
+        item->~T();
+        cell->sequence.store(pos + mask + 1, std::memory_order_release);
+        return result;
+    }
+
+private:
+    std::unique_ptr<Cell[]> cells;
+    const size_t mask;
+    alignas(CacheLineSize) std::atomic<size_t> enqueuePos = 0;
+    alignas(CacheLineSize) std::atomic<size_t> dequeuePos = 0;
+};
+
+// Adds blocking push() and pop() to QSpscQueue or QMpmcQueue. Threads that
+// can't make progress spin for a moment, then sleep until the other side
+// signals.
+template <typename T, typename Queue = QMpmcQueue<T>>
+class QBlockingQueue
+{
+public:
+    explicit QBlockingQueue(qsizetype capacity) : queue(capacity) {}
+    Q_DISABLE_COPY_MOVE(QBlockingQueue)
+
+    qsizetype capacity() const noexcept { return queue.capacity(); }
+    qsizetype size() const noexcept { return queue.size(); }
+    bool isEmpty() const noexcept { return queue.isEmpty(); }
+
+    bool tryPush(const T &value) { return pushed(queue.tryPush(value)); }
+    bool tryPush(T &&value) { return pushed(queue.tryPush(std::move(value))); }
+    std::optional<T> tryPop() { return popped(queue.tryPop()); }
+
+    void push(const T &value)
+    { waitFor(notFull, QDeadlineTimer::Forever, [&] { return tryPush(value); }); }
+    void push(T &&value)
+    { waitFor(notFull, QDeadlineTimer::Forever, [&] { return tryPush(std::move(value)); }); }
+    // Returns false, leaving value alone, if the queue stayed full until deadline
+    bool push(const T &value, QDeadlineTimer deadline)
+    { return waitFor(notFull, deadline, [&] { return tryPush(value); }); }
+    bool push(T &&value, QDeadlineTimer deadline)
+    { return waitFor(notFull, deadline, [&] { return tryPush(std::move(value)); }); }
+
+    T pop()
+    {
+        std::optional<T> result;
+        waitFor(notEmpty, QDeadlineTimer::Forever, [&] { return popInto(result); });
+        return std::move(*result);
+    }
+    std::optional<T> pop(QDeadlineTimer deadline)
+    {
+        std::optional<T> result;
+        waitFor(notEmpty, deadline, [&] { return popInto(result); });
+        return result;
+    }
+
+private:
+    // The queues only move from their argument when they succeed, so a
+    // failed attempt can be retried with the same value.
+    bool pushed(bool ok) noexcept
+    {
+        if (ok)
+            notEmpty.notify();
+        return ok;
+    }
+    std::optional<T> popped(std::optional<T> &&item) noexcept
+    {
+        if (item)
+            notFull.notify();
+        return std::move(item);
+    }
+
+    bool popInto(std::optional<T> &result)
+    {
+        std::optional<T> item = tryPop();
+        if (item)
+            result.emplace(std::move(*item));
+        return item.has_value();
+    }
+
+    template <typename Attempt>
+    static bool waitFor(QtPrivate::QEventCount &event, QDeadlineTimer deadline, Attempt attempt)
+    {
+        // Hand-offs between busy threads usually complete within a few
+        // hundred cycles, much less than a trip through the kernel.
+        for (int i = 0; i < SpinCount; ++i) {
+            if (attempt())
+                return true;
+            qYieldCpu();
+        }
+        for (;;) {
+            const quint32 ticket = event.prepareWait();
+            if (attempt()) {
+                event.cancelWait(ticket);
+                return true;
+            }
+            if (!event.wait(ticket, deadline))
+                return attempt();
+        }
+    }
+
+    static constexpr int SpinCount = 64;
+
+    Queue queue;
+    QtPrivate::QEventCount notEmpty;
+    QtPrivate::QEventCount notFull;
+};
+
+template <typename T>
+using QBlockingSpscQueue = QBlockingQueue<T, QSpscQueue<T>>;
+
+QT_END_NAMESPACE
+
+#endif // QCONCURRENTQUEUE_H
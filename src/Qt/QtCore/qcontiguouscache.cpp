@@ -82,6 +82,15 @@ void QContiguousCacheData::freeData(QContiguousCacheData *data)
     In most cases the indexes will not exceed 0 to INT_MAX, and
     normalizeIndexes() will not need to be used.
 
+    The items are stored in a single block of memory that wraps around, so
+    they occupy at most two contiguous pieces of it. segments() returns these
+    as spans, which lets loops over the whole cache (for example, a sum over
+    a sliding window of samples) run over plain arrays instead of calling
+    at() for each index. The constructor that takes an alignment places the
+    storage at a suitable boundary for SIMD loads. Ranges of items can be
+    added in one go with the append() and prepend() overloads that take a
+    QSpan.
+
     See the \l{Contiguous Cache Example}{Contiguous Cache} example.
 */
 
@@ -92,6 +101,25 @@ void QContiguousCacheData::freeData(QContiguousCacheData *data)
     \sa setCapacity()
 */
 
+/*! \fn template<typename T> QContiguousCache<T>::QContiguousCache(qsizetype capacity, qsizetype alignment)
+
+    Constructs a cache with the given \a capacity, whose first item in
+    storage is aligned to \a alignment bytes. \a alignment must be a power
+    of two, and no less than \c{alignof(T)}. The alignment is kept when the
+    cache is copied or its capacity changes.
+
+    Pass 64 to start the storage on a cache line, which is also enough for
+    any SIMD load instruction.
+
+    \sa alignment(), segments()
+*/
+
+/*! \fn template<typename T> qsizetype QContiguousCache<T>::alignment() const
+
+    Returns the alignment of the cache's storage in bytes. This is
+    \c{alignof(T)} unless a different alignment was passed to the constructor.
+*/
+
 /*! \fn template<typename T> QContiguousCache<T>::QContiguousCache(const QContiguousCache<T> &other)
 
     Constructs a copy of \a other.
@@ -301,6 +329,51 @@ void QContiguousCacheData::freeData(QContiguousCacheData *data)
     \sa append(), insert(), isFull()
 */
 
+/*! \fn template<typename T> void QContiguousCache<T>::append(QSpan<const T> values)
+    \overload
+
+    Appends all of \a values, in order, to the end of the cache. The result
+    is the same as calling append() for each of them, but items that would
+    be pushed out again by later ones are never copied, and the copying
+    is done in at most two blocks.
+
+    \sa prepend(), segments()
+*/
+
+/*! \fn template<typename T> void QContiguousCache<T>::prepend(QSpan<const T> values)
+    \overload
+
+    Inserts all of \a values at the start of the cache, so that the first
+    item of \a values becomes the first item of the cache. If the cache
+    would overflow, the items at the end are removed, as with prepend().
+
+    \sa append(), segments()
+*/
+
+/*! \fn template<typename T> std::pair<QSpan<T>, QSpan<T>> QContiguousCache<T>::segments()
+
+    Returns the items of the cache as two spans over its storage: the items
+    from firstIndex() onwards up to the end of the storage, followed by the
+    items that have wrapped around to its start. The second span is empty
+    if nothing has wrapped around.
+
+    \snippet code/src_corelib_tools_qcontiguouscache.cpp 2
+
+    The spans remain valid until the cache is modified. This overload
+    detaches the cache.
+
+    \sa constSegments()
+*/
+
+/*! \fn template<typename T> std::pair<QSpan<const T>, QSpan<const T>> QContiguousCache<T>::segments() const
+    \overload
+*/
+
+/*! \fn template<typename T> std::pair<QSpan<const T>, QSpan<const T>> QContiguousCache<T>::constSegments() const
+
+    Same as the const overload of segments().
+*/
+
 /*! \fn template<typename T> void QContiguousCache<T>::insert(qsizetype i, const T &value)
 
     Inserts the \a value at the index position \a i.  If the cache already contains
@@ -6,14 +6,18 @@
 
 #include <QtCore/qatomic.h>
 #include <QtCore/qassert.h>
+#include <QtCore/qspan.h>
 #include <QtCore/qtclasshelpermacros.h>
 #include <QtCore/qtcoreexports.h>
 #include <QtCore/qttypetraits.h>
 #include <QtCore/qtypeinfo.h>
 
 #include <climits>
+#include <cstring>
 #include <limits>
+#include <memory>
 #include <new>
+#include <utility>
 
 QT_BEGIN_NAMESPACE
 
@@ -36,10 +40,15 @@ struct Q_CORE_EXPORT QContiguousCacheData
 #endif
 };
 
+// The items follow the header, starting at the first multiple of alignment.
 template <typename T>
 struct QContiguousCacheTypedData : public QContiguousCacheData
 {
-    T array[1];
+    T *array;
+    qsizetype alignment;
+
+    static constexpr qsizetype headerSize(qsizetype alignment) noexcept
+    { return (qsizetype(sizeof(QContiguousCacheTypedData)) + alignment - 1) & ~(alignment - 1); }
 };
 
 template<typename T>
@@ -59,6 +68,7 @@ public:
     typedef qsizetype size_type;
 
     explicit QContiguousCache(qsizetype capacity = 0);
+    QContiguousCache(qsizetype capacity, qsizetype alignment);
     QContiguousCache(const QContiguousCache<T> &v) : d(v.d) { d->ref.ref(); }
 
     inline ~QContiguousCache() { if (!d) return; if (!d->ref.deref()) freeData(d); }
@@ -101,6 +111,7 @@ public:
     inline bool isEmpty() const { return d->count == 0; }
     inline bool isFull() const { return d->count == d->alloc; }
     inline qsizetype available() const { return d->alloc - d->count; }
+    inline qsizetype alignment() const { return d->alignment; }
 
     void clear();
     void setCapacity(qsizetype size);
@@ -115,7 +126,13 @@ public:
     void prepend(const T &value);
     void insert(qsizetype pos, T &&value);
     void insert(qsizetype pos, const T &value);
+    void append(QSpan<const T> values);
+    void prepend(QSpan<const T> values);
 
+    // The items from firstIndex() to lastIndex(), in two pieces of storage
+    std::pair<QSpan<T>, QSpan<T>> segments() { detach(); return segments_helper<T>(); }
+    std::pair<QSpan<const T>, QSpan<const T>> segments() const { return segments_helper<const T>(); }
+    std::pair<QSpan<const T>, QSpan<const T>> constSegments() const { return segments_helper<const T>(); }
 
     inline bool containsIndex(qsizetype pos) const { return pos >= d->offset && pos - d->offset < d->count; }
     inline qsizetype firstIndex() const { return d->offset; }
@@ -143,14 +160,24 @@ public:
 private:
     void detach_helper();
 
-    Data *allocateData(qsizetype aalloc);
+    template <typename U>
+    std::pair<QSpan<U>, QSpan<U>> segments_helper() const
+    {
+        const qsizetype n = qMin(d->count, d->alloc - d->start);
+        return { QSpan<U>(d->array + d->start, n), QSpan<U>(d->array, d->count - n) };
+    }
+    void copyConstruct(qsizetype pos, const T *src, qsizetype n);
+    void destroyFirst(qsizetype n);
+    void destroyLast(qsizetype n);
+
+    Data *allocateData(qsizetype aalloc, qsizetype alignment);
     void freeData(Data *x);
 };
 
 template <typename T>
 void QContiguousCache<T>::detach_helper()
 {
-    Data *x = allocateData(d->alloc);
+    Data *x = allocateData(d->alloc, d->alignment);
     x->ref.storeRelaxed(1);
     x->count = d->count;
     x->start = d->start;
@@ -182,7 +209,7 @@ void QContiguousCache<T>::setCapacity(qsizetype asize)
     if (asize == d->alloc)
         return;
     detach();
-    Data *x = allocateData(asize);
+    Data *x = allocateData(asize, d->alignment);
     x->ref.storeRelaxed(1);
     x->alloc = asize;
     x->count = qMin(d->count, asize);
@@ -229,7 +256,7 @@ void QContiguousCache<T>::clear()
         }
         d->count = d->start = d->offset = 0;
     } else {
-        Data *x = allocateData(d->alloc);
+        Data *x = allocateData(d->alloc, d->alignment);
         x->ref.storeRelaxed(1);
         x->alloc = d->alloc;
         x->count = x->start = x->offset = 0;
@@ -240,16 +267,29 @@ void QContiguousCache<T>::clear()
 }
 
 template <typename T>
-inline typename QContiguousCache<T>::Data *QContiguousCache<T>::allocateData(qsizetype aalloc)
+inline typename QContiguousCache<T>::Data *QContiguousCache<T>::allocateData(qsizetype aalloc, qsizetype alignment)
 {
-    return static_cast<Data *>(QContiguousCacheData::allocateData(sizeof(Data) + (aalloc - 1) * sizeof(T), alignof(Data)));
+    const qsizetype header = Data::headerSize(alignment);
+    Data *x = static_cast<Data *>(QContiguousCacheData::allocateData(header + aalloc * qsizetype(sizeof(T)),
+                                                                     qMax(alignment, qsizetype(alignof(Data)))));
+    x->array = reinterpret_cast<T *>(reinterpret_cast<char *>(x) + header);
+    x->alignment = alignment;
+    return x;
 }
 
 template <typename T>
 QContiguousCache<T>::QContiguousCache(qsizetype cap)
+    : QContiguousCache(cap, alignof(T))
+{
+}
+
+template <typename T>
+QContiguousCache<T>::QContiguousCache(qsizetype cap, qsizetype alignment)
 {
     Q_ASSERT(cap >= 0);
-    d = allocateData(cap);
+    Q_ASSERT_X(alignment >= qsizetype(alignof(T)) && (alignment & (alignment - 1)) == 0,
+               "QContiguousCache", "alignment must be a power of two, and at least alignof(T)");
+    d = allocateData(cap, alignment);
     d->ref.storeRelaxed(1);
     d->alloc = cap;
     d->count = d->start = d->offset = 0;
@@ -387,6 +427,96 @@ void QContiguousCache<T>::insert(qsizetype pos, const T &value)
 {
     return insert(pos, T(value));
 }
+
+// Constructs n items from src at physical position pos, wrapping around at
+// the end of the storage. Both ends of the cache must be set up by the caller.
+template <typename T>
+void QContiguousCache<T>::copyConstruct(qsizetype pos, const T *src, qsizetype n)
+{
+    const qsizetype n1 = qMin(n, d->alloc - pos);
+    if constexpr (QTypeInfo<T>::isComplex) {
+        std::uninitialized_copy_n(src, n1, d->array + pos);
+        std::uninitialized_copy_n(src + n1, n - n1, d->array);
+    } else {
+        if (n1)
+            memcpy(static_cast<void *>(d->array + pos), src, n1 * sizeof(T));
+        if (n - n1)
+            memcpy(static_cast<void *>(d->array), src + n1, (n - n1) * sizeof(T));
+    }
+}
+
+template <typename T>
+void QContiguousCache<T>::destroyFirst(qsizetype n)
+{
+    Q_ASSERT(n <= d->count);
+    if constexpr (QTypeInfo<T>::isComplex) {
+        const qsizetype n1 = qMin(n, d->alloc - d->start);
+        std::destroy_n(d->array + d->start, n1);
+        std::destroy_n(d->array, n - n1);
+    }
+    d->count -= n;
+    d->start = (d->start + n) % d->alloc;
+    d->offset += n;
+}
+
+template <typename T>
+void QContiguousCache<T>::destroyLast(qsizetype n)
+{
+    Q_ASSERT(n <= d->count);
+    if constexpr (QTypeInfo<T>::isComplex) {
+        const qsizetype pos = (d->start + d->count - n) % d->alloc;
+        const qsizetype n1 = qMin(n, d->alloc - pos);
+        std::destroy_n(d->array + pos, n1);
+        std::destroy_n(d->array, n - n1);
+    }
+    d->count -= n;
+}
+
+template <typename T>
+void QContiguousCache<T>::append(QSpan<const T> values)
+{
+    if (!d->alloc || values.isEmpty())
+        return;     // zero capacity or nothing to add
+    detach();
+    const T *src = values.data();
+    qsizetype n = values.size();
+    if (n > d->alloc) {
+        // only the last alloc values survive; the others would have been
+        // pushed out again by the ones after them
+        const qsizetype skipped = n - d->alloc;
+        destroyFirst(d->count);
+        d->start = (d->start + skipped) % d->alloc;
+        d->offset += skipped;
+        src += skipped;
+        n = d->alloc;
+    } else if (d->count + n > d->alloc) {
+        destroyFirst(d->count + n - d->alloc);
+    }
+    copyConstruct((d->start + d->count) % d->alloc, src, n);
+    d->count += n;
+}
+
+template <typename T>
+void QContiguousCache<T>::prepend(QSpan<const T> values)
+{
+    if (!d->alloc || values.isEmpty())
+        return;     // zero capacity or nothing to add
+    detach();
+    qsizetype n = values.size();
+    if (n > d->alloc) {
+        const qsizetype skipped = (n - d->alloc) % d->alloc;
+        destroyLast(d->count);
+        d->start = (d->start - skipped + d->alloc) % d->alloc;
+        d->offset -= n - d->alloc;
+        n = d->alloc;
+    } else if (d->count + n > d->alloc) {
+        destroyLast(d->count + n - d->alloc);
+    }
+    d->start = (d->start - n + d->alloc) % d->alloc;
+    d->offset -= n;
+    copyConstruct(d->start, values.data(), n);
+    d->count += n;
+}
 template <typename T>
 inline const T &QContiguousCache<T>::at(qsizetype pos) const
 { Q_ASSERT_X(pos >= d->offset && pos - d->offset < d->count, "QContiguousCache<T>::at", "index out of range"); return d->array[pos % d->alloc]; }
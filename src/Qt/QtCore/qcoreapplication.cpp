@@ -975,9 +975,11 @@ QCoreApplication::~QCoreApplication()
     // Synchronize and stop the global thread pool threads.
     QThreadPool *globalThreadPool = nullptr;
     QThreadPool *guiThreadPool = nullptr;
+    QList<QThreadPool *> numaThreadPools;
     QT_TRY {
         globalThreadPool = QThreadPool::globalInstance();
         guiThreadPool = QThreadPoolPrivate::qtGuiInstance();
+        numaThreadPools = QThreadPoolPrivate::numaNodeInstances();
     } QT_CATCH (...) {
         // swallow the exception, since destructors shouldn't throw
     }
@@ -989,6 +991,10 @@ QCoreApplication::~QCoreApplication()
         guiThreadPool->waitForDone();
         delete guiThreadPool;
     }
+    for (QThreadPool *pool : std::as_const(numaThreadPools)) {
+        pool->waitForDone();
+        delete pool;
+    }
 #endif
 
 #ifndef QT_NO_QOBJECT
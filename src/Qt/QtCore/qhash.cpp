@@ -3850,6 +3850,159 @@ size_t qHash(long double key, size_t seed) noexcept
     Returns the number of elements removed, if any.
 */
 
+/*! \class QConcurrentHash
+    \inmodule QtCore
+    \since 6.9
+    \brief The QConcurrentHash class is a hash table that can be used from many threads at once.
+
+    \ingroup tools
+
+    \threadsafe
+
+    QConcurrentHash\<Key, T\> splits its entries over a number of shards,
+    each of which is a QHash with a QReadWriteLock of its own. A key always
+    lives in the same shard, picked from a hash of the key that is
+    independent of the one QHash uses, so threads only contend when they
+    work on keys in the same shard. Lookups take the shard's lock for
+    reading and can run in parallel; modifications take it for writing.
+    Every shard is aligned to a cache line, so that locking one shard does
+    not slow down threads using a neighboring one.
+
+    Since no reference into the table can be kept once the shard's lock is
+    released, all functions return values by copy. Use
+    computeIfAbsent() to look up a value and create it if it is missing in
+    one step, and forEach() or snapshot() to visit all entries.
+
+    Key and T have the same requirements as for QHash.
+
+    \sa QHash, QReadWriteLock
+*/
+
+/*! \fn template <typename Key, typename T> QConcurrentHash<Key, T>::QConcurrentHash(qsizetype shardCount)
+
+    Constructs an empty hash with \a shardCount shards, rounded up to a power
+    of two and bounded to the range from 2 to MaxShardCount. If
+    \a shardCount is 0 or less, four shards per QThread::idealThreadCount()
+    are used.
+*/
+
+/*! \variable QConcurrentHash::MaxShardCount
+
+    The maximum number of shards a QConcurrentHash can have.
+*/
+
+/*! \fn template <typename Key, typename T> qsizetype QConcurrentHash<Key, T>::shardCount() const
+
+    Returns the number of shards.
+*/
+
+/*! \fn template <typename Key, typename T> qsizetype QConcurrentHash<Key, T>::size() const
+
+    Returns the number of entries in the hash. The shards are counted one
+    after the other, so the result need not correspond to any single moment
+    if other threads modify the hash at the same time.
+*/
+
+/*! \fn template <typename Key, typename T> bool QConcurrentHash<Key, T>::isEmpty() const
+
+    Returns \c true if the hash contains no entries; otherwise returns
+    \c false. The same caveat as for size() applies.
+*/
+
+/*! \fn template <typename Key, typename T> void QConcurrentHash<Key, T>::clear()
+
+    Removes all entries from the hash, one shard at a time.
+*/
+
+/*! \fn template <typename Key, typename T> bool QConcurrentHash<Key, T>::contains(const Key &key) const
+
+    Returns \c true if the hash contains an entry with the \a key; otherwise
+    returns \c false.
+*/
+
+/*! \fn template <typename Key, typename T> T QConcurrentHash<Key, T>::value(const Key &key, const T &defaultValue) const
+
+    Returns a copy of the value associated with the \a key, or
+    \a defaultValue if the hash contains no such entry.
+
+    \sa find()
+*/
+
+/*! \fn template <typename Key, typename T> std::optional<T> QConcurrentHash<Key, T>::find(const Key &key) const
+
+    Returns a copy of the value associated with the \a key, or
+    \c std::nullopt if the hash contains no such entry.
+
+    \sa value()
+*/
+
+/*! \fn template <typename Key, typename T> bool QConcurrentHash<Key, T>::insert(const Key &key, const T &value)
+
+    Inserts a new entry with the \a key and the \a value, unless the hash
+    already contains the \a key. Returns \c true if the entry was inserted.
+
+    \sa insertOrAssign()
+*/
+
+/*! \fn template <typename Key, typename T> bool QConcurrentHash<Key, T>::insertOrAssign(const Key &key, const T &value)
+
+    Inserts a new entry with the \a key and the \a value. If the hash already
+    contains the \a key, its value is replaced with \a value instead. Returns
+    \c true if a new entry was inserted, and \c false if an existing one was
+    assigned to.
+
+    \sa insert()
+*/
+
+/*! \fn template <typename Key, typename T> template <typename Factory> T QConcurrentHash<Key, T>::computeIfAbsent(const Key &key, Factory &&factory)
+
+    Returns a copy of the value associated with the \a key. If the hash
+    contains no such entry, \a factory is called with the \a key, and the
+    value it returns is inserted and returned.
+
+    \a factory is called while the shard of the \a key is locked for
+    writing, so it is called at most once per key even if several threads
+    ask for the same missing key at once. For the same reason it must not
+    use this hash.
+*/
+
+/*! \fn template <typename Key, typename T> bool QConcurrentHash<Key, T>::remove(const Key &key)
+
+    Removes the entry with the \a key from the hash. Returns \c true if there
+    was such an entry.
+
+    \sa take()
+*/
+
+/*! \fn template <typename Key, typename T> std::optional<T> QConcurrentHash<Key, T>::take(const Key &key)
+
+    Removes the entry with the \a key from the hash and returns its value, or
+    returns \c std::nullopt if there was no such entry.
+
+    \sa remove()
+*/
+
+/*! \fn template <typename Key, typename T> template <typename Function> void QConcurrentHash<Key, T>::forEach(Function &&f) const
+
+    Calls \a f with the key and the value of every entry of the hash, as
+    \c{f(const Key &, const T &)}.
+
+    Each shard is visited through a snapshot taken under its lock, which is
+    an implicitly shared copy of its QHash and therefore cheap. \a f is
+    called without holding any lock, so it may use this hash; changes it
+    makes are not visible in the snapshot being visited. A thread modifying
+    a shard while its snapshot is alive makes a deep copy of that shard
+    first.
+
+    \sa snapshot()
+*/
+
+/*! \fn template <typename Key, typename T> QHash<Key, T> QConcurrentHash<Key, T>::snapshot() const
+
+    Returns a QHash with all entries of this hash, collected one shard at a
+    time as with forEach().
+*/
+
 #ifdef QT_HAS_CONSTEXPR_BITOPS
 namespace QHashPrivate {
 static_assert(qPopulationCount(SpanConstants::NEntries) == 1,
@@ -3860,8 +4013,9 @@ using Node1 = Node<int, int>;
 static_assert(sizeof(Span<Node1>) == sizeof(Span<Node<char, void *>>));
 static_assert(sizeof(Span<Node1>) == sizeof(Span<Node<qsizetype, QHashDummyValue>>));
 static_assert(sizeof(Span<Node1>) == sizeof(Span<Node<QString, QVariant>>));
-static_assert(sizeof(Span<Node1>) > SpanConstants::NEntries);
-static_assert(qNextPowerOfTwo(sizeof(Span<Node1>)) == SpanConstants::NEntries * 2);
+// one offset and one control byte per bucket, plus the entries pointer and bookkeeping
+static_assert(sizeof(Span<Node1>) > SpanConstants::NEntries * 2);
+static_assert(qNextPowerOfTwo(sizeof(Span<Node1>)) == SpanConstants::NEntries * 4);
 
 // ensure allocations are always a power of two, at a minimum NEntries,
 // obeying the fomula
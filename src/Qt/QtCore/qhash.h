@@ -11,6 +11,7 @@
 #include <QtCore/qiterator.h>
 #include <QtCore/qlist.h>
 #include <QtCore/qrefcount.h>
+#include <QtCore/qsimd.h>
 #include <QtCore/qttypetraits.h>
 
 #include <initializer_list>
@@ -224,8 +225,75 @@ struct SpanConstants {
     static constexpr size_t NEntries = (1 << SpanShift);
     static constexpr size_t LocalBucketMask = (NEntries - 1);
     static constexpr size_t UnusedEntry = 0xff;
+    static constexpr unsigned char EmptyTag = 0x80;
 
     static_assert ((NEntries & LocalBucketMask) == 0, "NEntries must be a power of two.");
+
+    // The 7-bit tag stored in the control byte of a used bucket. The bucket
+    // index comes from the low bits of the hash, so the tag is taken from the
+    // high bits of a multiplicative mix, which also helps weak hashes.
+    static constexpr unsigned char tagForHash(size_t hash) noexcept
+    {
+        if constexpr (sizeof(size_t) == 8)
+            return (quint64(hash) * Q_UINT64_C(0x9e3779b97f4a7c15)) >> 57;
+        else
+            return (quint32(hash) * 0x9e3779b9U) >> 25;
+    }
+};
+
+// Compares the control bytes of a group of consecutive buckets with a tag in
+// one go: 16 buckets with SSE2, otherwise 8 buckets packed into a 64-bit word.
+// The masks returned have one bit (SSE2) or one byte (SWAR) per bucket.
+struct ControlGroup {
+#if defined(Q_PROCESSOR_X86) && defined(__SSE2__)
+    static constexpr size_t Size = 16;
+    using Mask = uint;
+
+    __m128i ctrl;
+
+    explicit ControlGroup(const unsigned char *p) noexcept
+        : ctrl(_mm_loadu_si128(reinterpret_cast<const __m128i *>(p)))
+    {}
+    Mask match(unsigned char tag) const noexcept
+    {
+        return uint(_mm_movemask_epi8(_mm_cmpeq_epi8(ctrl, _mm_set1_epi8(char(tag)))));
+    }
+    Mask matchEmpty() const noexcept
+    {
+        // Only EmptyTag has the high bit set
+        return uint(_mm_movemask_epi8(ctrl));
+    }
+    static constexpr Mask lanesFrom(size_t lane) noexcept { return ~Mask(0) << lane; }
+    static size_t lowestLane(Mask mask) noexcept { return qCountTrailingZeroBits(mask); }
+#else
+    static constexpr size_t Size = 8;
+    using Mask = quint64;
+
+    static constexpr quint64 Low7Bits = Q_UINT64_C(0x7f7f7f7f7f7f7f7f);
+    static constexpr quint64 HighBits = Q_UINT64_C(0x8080808080808080);
+    quint64 ctrl = 0;
+
+    explicit ControlGroup(const unsigned char *p) noexcept
+    {
+        // lowestLane() expects the first bucket in the lowest byte
+#if Q_BYTE_ORDER == Q_LITTLE_ENDIAN
+        memcpy(&ctrl, p, Size);
+#else
+        for (size_t i = 0; i < Size; ++i)
+            ctrl |= quint64(p[i]) << (8 * i);
+#endif
+    }
+    Mask match(unsigned char tag) const noexcept
+    {
+        // Sets the high bit of each byte that is zero, without false positives
+        const quint64 x = ctrl ^ (Q_UINT64_C(0x0101010101010101) * tag);
+        return ~(((x & Low7Bits) + Low7Bits) | x | Low7Bits);
+    }
+    Mask matchEmpty() const noexcept { return ctrl & HighBits; }
+    static constexpr Mask lanesFrom(size_t lane) noexcept { return ~Mask(0) << (8 * lane); }
+    static size_t lowestLane(Mask mask) noexcept { return qCountTrailingZeroBits(mask) / 8; }
+#endif
+    static_assert(SpanConstants::NEntries % Size == 0);
 };
 
 // Regular hash tables consist of a list of buckets that can store Nodes. But simply allocating one large array of buckets
@@ -236,6 +304,10 @@ struct SpanConstants {
 // actual storage space for the Nodes (the 'entries' member) or 0xff (UnusedEntry) to flag that the bucket is empty.
 // As we have only 128 entries per Span, the offset array can be represented using an unsigned char. This trick makes the hash
 // table have a very small memory overhead compared to many other implementations.
+//
+// Alongside it, ctrl holds one control byte per bucket: EmptyTag, or 7 bits of the hash of the key stored there. Lookups
+// compare a whole ControlGroup of control bytes with the key's tag at once and only look at the nodes whose tag matches,
+// so probing past occupied buckets, and in particular finding that a key isn't there, rarely touches a node.
 template<typename Node>
 struct Span {
     // Entry is a slot available for storing a Node. The Span holds a pointer to
@@ -251,12 +323,14 @@ struct Span {
         Node &node() { return *reinterpret_cast<Node *>(&storage); }
     };
 
+    unsigned char ctrl[SpanConstants::NEntries];
     unsigned char offsets[SpanConstants::NEntries];
     Entry *entries = nullptr;
     unsigned char allocated = 0;
     unsigned char nextFree = 0;
     Span() noexcept
     {
+        memset(ctrl, SpanConstants::EmptyTag, sizeof(ctrl));
         memset(offsets, SpanConstants::UnusedEntry, sizeof(offsets));
     }
     ~Span()
@@ -276,16 +350,18 @@ struct Span {
             entries = nullptr;
         }
     }
-    Node *insert(size_t i)
+    Node *insert(size_t i, unsigned char tag)
     {
         Q_ASSERT(i < SpanConstants::NEntries);
         Q_ASSERT(offsets[i] == SpanConstants::UnusedEntry);
+        Q_ASSERT(tag < SpanConstants::EmptyTag);
         if (nextFree == allocated)
             addStorage();
         unsigned char entry = nextFree;
         Q_ASSERT(entry < allocated);
         nextFree = entries[entry].nextFree();
         offsets[i] = entry;
+        ctrl[i] = tag;
         return &entries[entry].node();
     }
     void erase(size_t bucket) noexcept(std::is_nothrow_destructible<Node>::value)
@@ -295,6 +371,7 @@ struct Span {
 
         unsigned char entry = offsets[bucket];
         offsets[bucket] = SpanConstants::UnusedEntry;
+        ctrl[bucket] = SpanConstants::EmptyTag;
 
         entries[entry].node().~Node();
         entries[entry].nextFree() = nextFree;
@@ -304,6 +381,10 @@ struct Span {
     {
         return offsets[i];
     }
+    unsigned char tag(size_t i) const noexcept
+    {
+        return ctrl[i];
+    }
     bool hasNode(size_t i) const noexcept
     {
         return (offsets[i] != SpanConstants::UnusedEntry);
@@ -340,6 +421,8 @@ struct Span {
         Q_ASSERT(offsets[to] == SpanConstants::UnusedEntry);
         offsets[to] = offsets[from];
         offsets[from] = SpanConstants::UnusedEntry;
+        ctrl[to] = ctrl[from];
+        ctrl[from] = SpanConstants::EmptyTag;
     }
     void moveFromSpan(Span &fromSpan, size_t fromIndex, size_t to) noexcept(std::is_nothrow_move_constructible_v<Node>)
     {
@@ -356,6 +439,8 @@ struct Span {
 
         size_t fromOffset = fromSpan.offsets[fromIndex];
         fromSpan.offsets[fromIndex] = SpanConstants::UnusedEntry;
+        ctrl[to] = fromSpan.ctrl[fromIndex];
+        fromSpan.ctrl[fromIndex] = SpanConstants::EmptyTag;
         Entry &fromEntry = fromSpan.entries[fromOffset];
 
         if constexpr (isRelocatable<Node>()) {
@@ -507,9 +592,9 @@ struct Data
         {
             return &span->at(index);
         }
-        Node *insert() const
+        Node *insert(unsigned char tag) const
         {
-            return span->insert(index);
+            return span->insert(index, tag);
         }
 
     private:
@@ -570,9 +655,15 @@ struct Data
                 if (!span.hasNode(index))
                     continue;
                 const Node &n = span.at(index);
-                auto it = Resized ? findBucket(n.key) : Bucket { spans + s, index };
-                Q_ASSERT(it.isUnused());
-                Node *newNode = it.insert();
+                Node *newNode;
+                if constexpr (Resized) {
+                    const size_t hash = QHashPrivate::calculateHash(n.key, seed);
+                    auto it = findBucketWithHash(n.key, hash);
+                    Q_ASSERT(it.isUnused());
+                    newNode = it.insert(SpanConstants::tagForHash(hash));
+                } else {
+                    newNode = Bucket { spans + s, index }.insert(span.tag(index));
+                }
                 new (newNode) Node(n);
             }
         }
@@ -655,9 +746,10 @@ struct Data
                 if (!span.hasNode(index))
                     continue;
                 Node &n = span.at(index);
-                auto it = findBucket(n.key);
+                const size_t hash = QHashPrivate::calculateHash(n.key, seed);
+                auto it = findBucketWithHash(n.key, hash);
                 Q_ASSERT(it.isUnused());
-                Node *newNode = it.insert();
+                Node *newNode = it.insert(SpanConstants::tagForHash(hash));
                 new (newNode) Node(std::move(n));
             }
             span.freeData();
@@ -683,24 +775,51 @@ struct Data
     }
 
     template <typename K> Bucket findBucket(const K &key) const noexcept
+    {
+        return findBucketWithHash(key, QHashPrivate::calculateHash(key, seed));
+    }
+
+    template <typename K> Bucket findBucketWithHash(const K &key, size_t hash) const noexcept
     {
         static_assert(std::is_same_v<std::remove_cv_t<Key>, K> ||
                 QHashHeterogeneousSearch<std::remove_cv_t<Key>, K>::value);
         Q_ASSERT(numBuckets > 0);
-        size_t hash = QHashPrivate::calculateHash(key, seed);
-        Bucket bucket(this, GrowthPolicy::bucketForHash(numBuckets, hash));
-        // loop over the buckets until we find the entry we search for
-        // or an empty slot, in which case we know the entry doesn't exist
+        const unsigned char tag = SpanConstants::tagForHash(hash);
+        const size_t home = GrowthPolicy::bucketForHash(numBuckets, hash);
+        Span *span = spans + (home >> SpanConstants::SpanShift);
+        const size_t homeIndex = home & SpanConstants::LocalBucketMask;
+        // Most lookups of existing keys end in their home bucket
+        if (span->ctrl[homeIndex] == tag
+                && qHashEquals(span->atOffset(span->offset(homeIndex)).key, key)) {
+            return Bucket(span, homeIndex);
+        }
+        size_t group = homeIndex & ~(ControlGroup::Size - 1);
+        // Buckets before the home bucket in its group aren't part of the probe sequence
+        auto lanes = ControlGroup::lanesFrom(homeIndex - group);
+
+        // Walk the buckets group by group until we find the entry we search
+        // for or an empty slot, in which case we know the entry doesn't
+        // exist. With linear probing and no tombstones, an entry with our key
+        // can't come after the first empty bucket from home, so checking all
+        // tag matches in a group before its empty buckets is fine.
         while (true) {
-            size_t offset = bucket.offset();
-            if (offset == SpanConstants::UnusedEntry) {
-                return bucket;
-            } else {
-                Node &n = bucket.nodeAtOffset(offset);
-                if (qHashEquals(n.key, key))
-                    return bucket;
+            const ControlGroup g(span->ctrl + group);
+            for (auto matches = g.match(tag) & lanes; matches; matches &= matches - 1) {
+                const size_t index = group + ControlGroup::lowestLane(matches);
+                if (qHashEquals(span->atOffset(span->offset(index)).key, key))
+                    return Bucket(span, index);
+            }
+            if (const auto empty = g.matchEmpty() & lanes)
+                return Bucket(span, group + ControlGroup::lowestLane(empty));
+
+            lanes = ControlGroup::lanesFrom(0);
+            group += ControlGroup::Size;
+            if (group == SpanConstants::NEntries) {
+                group = 0;
+                ++span;
+                if (span - spans == ptrdiff_t(numBuckets >> SpanConstants::SpanShift))
+                    span = spans;
             }
-            bucket.advanceWrapped(this);
         }
     }
 
@@ -721,18 +840,19 @@ struct Data
     template <typename K> InsertionResult findOrInsert(const K &key) noexcept
     {
         Bucket it(static_cast<Span *>(nullptr), 0);
+        const size_t hash = QHashPrivate::calculateHash(key, seed);
         if (numBuckets > 0) {
-            it = findBucket(key);
+            it = findBucketWithHash(key, hash);
             if (!it.isUnused())
                 return { it.toIterator(this), true };
         }
         if (shouldGrow()) {
             rehash(size + 1);
-            it = findBucket(key); // need to get a new iterator after rehashing
+            it = findBucketWithHash(key, hash); // need to get a new iterator after rehashing
         }
         Q_ASSERT(it.span != nullptr);
         Q_ASSERT(it.isUnused());
-        it.insert();
+        it.insert(SpanConstants::tagForHash(hash));
         ++size;
         return { it.toIterator(this), false };
     }
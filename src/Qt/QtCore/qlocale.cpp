@@ -2110,6 +2110,110 @@ QString QLocale::toString(qulonglong i) const
     return d->m_data->unsLongLongToString(i, -1, 10, -1, flags);
 }
 
+// Appends the decimal digits of n to result, with group separators where
+// QLocaleData::applyIntegerFormatting() would put them. Only for locales whose
+// digits are ASCII, so no digit substitution is needed.
+static void appendAsciiDigits(QString &result, quint64 n, const QLocaleData *data,
+                              const QString &group)
+{
+    char16_t buffer[std::numeric_limits<quint64>::digits10 + 1];
+    char16_t *const end = buffer + std::size(buffer);
+    char16_t *p = end;
+    ulltoDecimal(n, p);
+    const QChar *digits = reinterpret_cast<const QChar *>(p);
+    const qsizetype digitCount = end - p;
+
+    const qsizetype firstGroup = digitCount - data->m_grouping_least;
+    if (group.isEmpty() || firstGroup < data->m_grouping_top) {
+        result.append(digits, digitCount);
+        return;
+    }
+    // Separators precede digit indices firstGroup, firstGroup - higher, ... > 0:
+    qsizetype pos = (firstGroup - 1) % data->m_grouping_higher + 1;
+    result.append(digits, pos);
+    while (pos < digitCount) {
+        result.append(group);
+        const qsizetype next = pos < firstGroup ? pos + data->m_grouping_higher : digitCount;
+        result.append(digits + pos, next - pos);
+        pos = next;
+    }
+}
+
+template <typename Integer>
+static QString integersToString(const QLocalePrivate *d, QSpan<const Integer> values,
+                                QStringView separator)
+{
+    const QLocaleData *data = d->m_data;
+    const bool groupDigits = !(d->m_numberOptions & QLocale::OmitGroupSeparator);
+    QString result;
+
+    if (data->zeroDigit() != u"0") {
+        // Digits need substituting, leave that to the single-number code.
+        const int flags = groupDigits ? QLocaleData::GroupDigits : 0;
+        for (qsizetype i = 0; i < values.size(); ++i) {
+            if (i)
+                result.append(separator.data(), separator.size());
+            if constexpr (std::is_signed_v<Integer>)
+                result += data->longLongToString(values[i], -1, 10, -1, flags);
+            else
+                result += data->unsLongLongToString(values[i], -1, 10, -1, flags);
+        }
+        return result;
+    }
+
+    const QString minus = data->negativeSign();
+    const QString group = groupDigits ? data->groupSeparator() : QString();
+    result.reserve(values.size() * (separator.size() + 8));
+    for (qsizetype i = 0; i < values.size(); ++i) {
+        if (i)
+            result.append(separator.data(), separator.size());
+        const Integer n = values[i];
+        if constexpr (std::is_signed_v<Integer>) {
+            if (n < 0) {
+                // See longLongToString() for why not -n:
+                result.append(minus);
+                appendAsciiDigits(result, 1u + quint64(-(n + 1)), data, group);
+                continue;
+            }
+        }
+        appendAsciiDigits(result, quint64(n), data, group);
+    }
+    return result;
+}
+
+/*!
+    \since 6.9
+    \overload
+
+    Returns the localized representations of all \a values, in order, with
+    \a separator between each two of them. This gives the same text as
+    joining toString(qlonglong) for each value, but builds it in one string
+    and looks up the locale's number symbols only once.
+
+    For the C locale, and any other locale whose digits are the ASCII digits,
+    the digits are written directly into the result.
+
+    \sa toLongLong(), numberOptions()
+*/
+QString QLocale::toString(QSpan<const qlonglong> values, QStringView separator) const
+{
+    return integersToString(d.data(), values, separator);
+}
+
+/*!
+    \since 6.9
+    \overload
+
+    Returns the localized representations of all \a values, in order, with
+    \a separator between each two of them.
+
+    \sa toULongLong(), numberOptions()
+*/
+QString QLocale::toString(QSpan<const qulonglong> values, QStringView separator) const
+{
+    return integersToString(d.data(), values, separator);
+}
+
 /*!
     Returns a localized string representation of the given \a date in the
     specified \a format.
@@ -2837,10 +2941,13 @@ QString QLocale::exponential() const
         QLocale::FloatingPointPrecisionOption
 */
 
-QString QLocale::toString(double f, char format, int precision) const
+// The form and flags QLocaleData::doubleToString() needs for a
+// toString(double, char, int) format character and the number options.
+static QLocaleData::DoubleForm doubleFormAndFlags(char format, QLocale::NumberOptions options,
+                                                  uint *flags)
 {
     QLocaleData::DoubleForm form = QLocaleData::DFDecimal;
-    uint flags = isAsciiUpper(format) ? QLocaleData::CapitalEorX : 0;
+    *flags = isAsciiUpper(format) ? QLocaleData::CapitalEorX : 0;
 
     switch (QtMiscUtils::toAsciiLower(format)) {
     case 'f':
@@ -2856,15 +2963,142 @@ QString QLocale::toString(double f, char format, int precision) const
         break;
     }
 
-    if (!(d->m_numberOptions & OmitGroupSeparator))
-        flags |= QLocaleData::GroupDigits;
-    if (!(d->m_numberOptions & OmitLeadingZeroInExponent))
-        flags |= QLocaleData::ZeroPadExponent;
-    if (d->m_numberOptions & IncludeTrailingZeroesAfterDot)
-        flags |= QLocaleData::AddTrailingZeroes;
+    if (!(options & QLocale::OmitGroupSeparator))
+        *flags |= QLocaleData::GroupDigits;
+    if (!(options & QLocale::OmitLeadingZeroInExponent))
+        *flags |= QLocaleData::ZeroPadExponent;
+    if (options & QLocale::IncludeTrailingZeroesAfterDot)
+        *flags |= QLocaleData::AddTrailingZeroes;
+    return form;
+}
+
+QString QLocale::toString(double f, char format, int precision) const
+{
+    uint flags;
+    const QLocaleData::DoubleForm form = doubleFormAndFlags(format, numberOptions(), &flags);
     return d->m_data->doubleToString(f, precision, form, -1, flags);
 }
 
+/*!
+    \since 6.9
+    \overload
+
+    Returns the localized representations of all \a values, in order, with
+    \a separator between each two of them. Each value is formatted as by
+    toString(double, char, int) with the given \a format and \a precision.
+
+    When the locale uses ASCII digits and single-character signs, decimal
+    point and exponent separator, as the C locale does, every value is
+    formatted straight into the result and only those symbols are replaced;
+    otherwise this is equivalent to joining the individual strings.
+
+    \sa toDouble(), numberOptions()
+*/
+QString QLocale::toString(QSpan<const double> values, QStringView separator,
+                          char format, int precision) const
+{
+    uint flags;
+    const QLocaleData::DoubleForm form = doubleFormAndFlags(format, numberOptions(), &flags);
+    const QLocaleData *data = d->m_data;
+    const bool upper = flags & QLocaleData::CapitalEorX;
+    const bool groupDigits = flags & QLocaleData::GroupDigits;
+    QString decimal = data->decimalPoint();
+    QString exponent = data->exponentSeparator();
+    const QString minus = data->negativeSign();
+    const QString plus = data->positiveSign();
+    QString result;
+
+    // qdtoBasicLatin() makes the same choices as doubleToString() does for a
+    // locale like this, except that grouping can change which form is
+    // shortest for 'g' and that it always pads exponents to two digits.
+    const bool basicLatin = data->zeroDigit() == u"0"
+            && decimal.size() == 1 && exponent.size() == 1
+            && minus.size() == 1 && plus.size() == 1
+            && (flags & QLocaleData::ZeroPadExponent)
+            && !(flags & QLocaleData::AddTrailingZeroes)
+            && !(groupDigits && form == QLocaleData::DFSignificantDigits
+                 && precision == QLocale::FloatingPointShortest);
+    if (!basicLatin) {
+        for (qsizetype i = 0; i < values.size(); ++i) {
+            if (i)
+                result.append(separator.data(), separator.size());
+            result += data->doubleToString(values[i], precision, form, -1, flags);
+        }
+        return result;
+    }
+
+    if (upper) {
+        // doubleToString() upper-cases everything but the leading sign
+        decimal = std::move(decimal).toUpper();
+        exponent = std::move(exponent).toUpper();
+    }
+    const QChar decimalChar = decimal.at(0);
+    const QChar exponentChar = exponent.at(0);
+    const QChar minusChar = minus.at(0);
+    const QChar exponentMinusChar = upper ? minusChar.toUpper() : minusChar;
+    const QChar plusChar = upper ? plus.at(0).toUpper() : plus.at(0);
+    const bool substitute = decimalChar != u'.' || exponentChar != QChar(upper ? u'E' : u'e')
+            || minusChar != u'-' || exponentMinusChar != u'-' || plusChar != u'+';
+    const QString group = groupDigits ? data->groupSeparator() : QString();
+
+    result.reserve(values.size() * (separator.size() + 12));
+    for (qsizetype i = 0; i < values.size(); ++i) {
+        if (i)
+            result.append(separator.data(), separator.size());
+        const qsizetype start = result.size();
+        qdtoBasicLatin(result, values[i], form, precision, upper);
+
+        // Find the digits before the decimal point while the text is still
+        // plain ASCII, grouping them (as decimalForm() does) after substituting,
+        // since the group separator may well be one of the ASCII symbols.
+        qsizetype digitsStart = start;
+        qsizetype wholeDigits = 0;
+        if (!group.isEmpty()) {
+            const QChar *text = result.constData();
+            const qsizetype end = result.size();
+            if (text[digitsStart] == u'-')
+                ++digitsStart;
+            qsizetype digitsEnd = digitsStart;
+            while (digitsEnd < end && isAsciiDigit(text[digitsEnd].unicode()))
+                ++digitsEnd;
+            const bool exponentForm = std::any_of(text + digitsEnd, text + end, [](QChar c) {
+                return c == u'e' || c == u'E';
+            });
+            if (!exponentForm)
+                wholeDigits = digitsEnd - digitsStart;
+        }
+
+        if (substitute) {
+            QChar *text = result.data();
+            for (qsizetype j = start; j < result.size(); ++j) {
+                switch (text[j].unicode()) {
+                case u'.':
+                    text[j] = decimalChar;
+                    break;
+                case u'e':
+                case u'E':
+                    text[j] = exponentChar;
+                    break;
+                case u'+':
+                    text[j] = plusChar;
+                    break;
+                case u'-':
+                    text[j] = j == start ? minusChar : exponentMinusChar;
+                    break;
+                }
+            }
+        }
+
+        qsizetype at = wholeDigits - data->m_grouping_least;
+        if (wholeDigits && at >= data->m_grouping_top) {
+            result.insert(digitsStart + at, group);
+            while ((at -= data->m_grouping_higher) > 0)
+                result.insert(digitsStart + at, group);
+        }
+    }
+    return result;
+}
+
 /*!
     \fn QLocale QLocale::c()
 
@@ -8,6 +8,7 @@
 #include <QtCore/qstring.h>
 #include <QtCore/qobjectdefs.h>
 #include <QtCore/qshareddata.h>
+#include <QtCore/qspan.h>
 
 QT_BEGIN_NAMESPACE
 
@@ -994,6 +995,10 @@ public:
     QString toString(double f, char format = 'g', int precision = 6) const;
     QString toString(float f, char format = 'g', int precision = 6) const
     { return toString(double(f), format, precision); }
+    QString toString(QSpan<const qlonglong> values, QStringView separator) const;
+    QString toString(QSpan<const qulonglong> values, QStringView separator) const;
+    QString toString(QSpan<const double> values, QStringView separator,
+                     char format = 'g', int precision = 6) const;
 
     // (Can't inline first two: passing by value doesn't work when only forward-declared.)
     QString toString(QDate date, const QString &format) const;
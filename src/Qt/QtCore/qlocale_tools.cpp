@@ -6,6 +6,7 @@
 #include <private/qdoublescanprint_p.h>
 #include <private/qlocale_p.h>
 #include "qstring.h"
+#include "qendian.h"
 
 #include <private/qtools_p.h>
 #include <private/qnumeric_p.h>
@@ -20,6 +21,7 @@
 #include <stdlib.h>
 #include <time.h>
 
+#include <atomic>
 #include <limits>
 #include <charconv>
 
@@ -44,6 +46,14 @@ using namespace QtMiscUtils;
 
 QT_CLOCALE_HOLDER
 
+Q_CONSTINIT static std::atomic<QShortestDoubleAlgorithm>
+shortestDoubleAlgorithm = QShortestDoubleAlgorithm::Schubfach;
+
+void qt_setShortestDoubleAlgorithm(QShortestDoubleAlgorithm algorithm)
+{
+    shortestDoubleAlgorithm.store(algorithm, std::memory_order_relaxed);
+}
+
 void qt_doubleToAscii(double d, QLocaleData::DoubleForm form, int precision,
                       char *buf, qsizetype bufSize,
                       bool &sign, int &length, int &decpt)
@@ -86,6 +96,18 @@ void qt_doubleToAscii(double d, QLocaleData::DoubleForm form, int precision,
     if (form == QLocaleData::DFSignificantDigits && precision == 0)
         precision = 1; // 0 significant digits is silently converted to 1
 
+    // The shortest representation doesn't depend on the form. Schubfach
+    // doesn't need libdouble-conversion, so it also gives proper shortest
+    // output where we'd otherwise fall back to snprintf below.
+    if (precision == QLocale::FloatingPointShortest
+#if !defined(QT_NO_DOUBLECONVERSION) && !defined(QT_BOOTSTRAPPED)
+        && shortestDoubleAlgorithm.load(std::memory_order_relaxed) == QShortestDoubleAlgorithm::Schubfach
+#endif
+        && bufSize > std::numeric_limits<double>::max_digits10) {
+        qt_doubleToShortestAscii(d, buf, bufSize, sign, length, decpt);
+        return;
+    }
+
 #if !defined(QT_NO_DOUBLECONVERSION) && !defined(QT_BOOTSTRAPPED)
     // one digit before the decimal dot, counts as significant digit for DoubleToStringConverter
     if (form == QLocaleData::DFExponent && precision >= 0)
@@ -421,6 +443,53 @@ static bool isDigitForBase(char d, int base)
     return false;
 }
 
+// True if all eight bytes of the little-endian word chunk are ASCII digits.
+static constexpr bool isEightDigits(quint64 chunk) noexcept
+{
+    // Digits are 0x30 to 0x39: the high nibble must be 3, and adding 6 to
+    // the byte must not carry into it.
+    return ((chunk & 0xF0F0F0F0F0F0F0F0) | (((chunk + 0x0606060606060606) & 0xF0F0F0F0F0F0F0F0) >> 4))
+            == 0x3333333333333333;
+}
+
+// The value of the eight ASCII digits in the little-endian word chunk, found
+// by adding neighbouring lanes pairwise: 8 one-digit lanes, then 4 two-digit,
+// 2 four-digit and finally one eight-digit lane, one multiplication each.
+static constexpr quint32 parseEightDigits(quint64 chunk) noexcept
+{
+    chunk = ((chunk & 0x0F0F0F0F0F0F0F0F) * 2561) >> 8;
+    chunk = ((chunk & 0x00FF00FF00FF00FF) * 6553601) >> 16;
+    return quint32(((chunk & 0x0000FFFF0000FFFF) * 42949672960001) >> 32);
+}
+
+// Equivalent to std::from_chars(begin, stop, value, 10) for quint64, but
+// reading eight digits per step where it can.
+static std::from_chars_result fromDecimalChars(const char *begin, const char *stop,
+                                               quint64 &value) noexcept
+{
+    const char *p = begin;
+    quint64 result = 0;
+    // Sixteen digits can't overflow:
+    while (stop - p >= 8 && p - begin < 16) {
+        const quint64 chunk = qFromLittleEndian<quint64>(p);
+        if (!isEightDigits(chunk))
+            break;
+        result = result * 100000000 + parseEightDigits(chunk);
+        p += 8;
+    }
+    bool overflow = false;
+    for (; p < stop && isAsciiDigit(*p); ++p) {
+        overflow = overflow || qMulOverflow(result, quint64(10), &result)
+                || qAddOverflow(result, quint64(*p - '0'), &result);
+    }
+    if (p == begin)
+        return { begin, std::errc::invalid_argument };
+    if (overflow)
+        return { p, std::errc::result_out_of_range };
+    value = result;
+    return { p, std::errc{} };
+}
+
 QSimpleParsedNumber<qulonglong> qstrntoull(const char *begin, qsizetype size, int base)
 {
     const char *p = begin, *const stop = begin + size;
@@ -433,7 +502,9 @@ QSimpleParsedNumber<qulonglong> qstrntoull(const char *begin, qsizetype size, in
     if (!prefix.base || prefix.next >= stop)
         return { };
 
-    const auto res = std::from_chars(prefix.next, stop, result, prefix.base);
+    const auto res = prefix.base == 10
+            ? fromDecimalChars(prefix.next, stop, result)
+            : std::from_chars(prefix.next, stop, result, prefix.base);
     if (res.ec != std::errc{})
         return { };
     return { result, res.ptr == prefix.next ? 0 : res.ptr - begin };
@@ -457,6 +528,16 @@ QSimpleParsedNumber<qlonglong> qstrntoll(const char *begin, qsizetype size, int
     if (!prefix.base || prefix.next >= stop || !isDigitForBase(*prefix.next, prefix.base))
         return { };
 
+    if (prefix.base == 10) {
+        quint64 magnitude = 0;
+        const auto res = fromDecimalChars(prefix.next, stop, magnitude);
+        constexpr quint64 maxMagnitude = quint64(std::numeric_limits<long long>::max());
+        if (res.ec != std::errc{} || magnitude > maxMagnitude + (negate ? 1 : 0))
+            return { };
+        // Negate in unsigned arithmetic, so that LLONG_MIN works out:
+        return { qlonglong(negate ? 0 - magnitude : magnitude), res.ptr - begin };
+    }
+
     long long result = 0;
     auto res = std::from_chars(prefix.next, stop, result, prefix.base);
     if (negate && res.ec == std::errc::result_out_of_range) {
@@ -492,8 +573,8 @@ static Q_ALWAYS_INLINE void qulltoString_helper(qulonglong number, int base, Cha
 
     case 2: SMALL_BASE_LOOP(2); break;
     case 8: SMALL_BASE_LOOP(8); break;
-    case 10: SMALL_BASE_LOOP(10); break;
-    case 16: BIG_BASE_LOOP(16); break;
+    case 10: ulltoDecimal(number, p); break;
+    case 16: ulltoHex(number, p); break;
 #undef SMALL_BASE_LOOP
 #endif
     default: BIG_BASE_LOOP(base); break;
@@ -649,9 +730,10 @@ static constexpr int digits(int number)
     return i;
 }
 
-// Used generically for both QString and QByteArray
+// Used generically for both QString and QByteArray; appends to \a result
 template <typename T>
-static T dtoString(double d, QLocaleData::DoubleForm form, int precision, bool uppercase)
+static void dtoString(T &result, double d, QLocaleData::DoubleForm form, int precision,
+                      bool uppercase)
 {
     // Undocumented: aside from F.P.Shortest, precision < 0 is treated as
     // default, 6 - same as printf().
@@ -718,15 +800,17 @@ static T dtoString(double d, QLocaleData::DoubleForm form, int precision, bool u
     constexpr bool IsQString = std::is_same_v<T, QString>;
     using Char = std::conditional_t<IsQString, char16_t, char>;
 
-    T result;
-    result.reserve(total);
+    // Everything below is relative to what's already in result. When
+    // appending, leave the growth to append(), which over-allocates:
+    const qsizetype start = result.size();
+    if (start == 0)
+        result.reserve(total);
 
     if (negative && !isZero(d)) // We don't return "-0"
         result.append(Char('-'));
     if (!qt_is_finite(d)) {
-        result.append(view);
-        if (uppercase)
-            result = std::move(result).toUpper();
+        for (char c : view)
+            result.append(Char(uppercase ? toAsciiUpper(c) : c));
     } else {
         switch (form) {
         case QLocaleData::DFExponent: {
@@ -764,7 +848,7 @@ static T dtoString(double d, QLocaleData::DoubleForm form, int precision, bool u
                     result.append(Char('0'));
                 result.append(view);
                 if (!succinct) {
-                    auto numDecimals = result.size() - 2 - (negative ? 1 : 0);
+                    auto numDecimals = result.size() - start - 2 - (negative ? 1 : 0);
                     for (qsizetype i = numDecimals; i < precision; ++i)
                         result.append(Char('0'));
                 }
@@ -772,7 +856,7 @@ static T dtoString(double d, QLocaleData::DoubleForm form, int precision, bool u
                 if (decpt > view.size()) {
                     result.append(view);
                     const int sign = negative ? 1 : 0;
-                    while (result.size() - sign < decpt)
+                    while (result.size() - start - sign < decpt)
                         result.append(Char('0'));
                     view = {};
                 } else if (decpt) {
@@ -796,18 +880,27 @@ static T dtoString(double d, QLocaleData::DoubleForm form, int precision, bool u
             break;
         }
     }
-    Q_ASSERT(total >= result.size()); // No reallocations are needed
-    return result;
+    Q_ASSERT(total >= result.size() - start); // No reallocations are needed
 }
 
 QString qdtoBasicLatin(double d, QLocaleData::DoubleForm form, int precision, bool uppercase)
 {
-    return dtoString<QString>(d, form, precision, uppercase);
+    QString result;
+    dtoString(result, d, form, precision, uppercase);
+    return result;
+}
+
+void qdtoBasicLatin(QString &result, double d, QLocaleData::DoubleForm form, int precision,
+                    bool uppercase)
+{
+    dtoString(result, d, form, precision, uppercase);
 }
 
 QByteArray qdtoAscii(double d, QLocaleData::DoubleForm form, int precision, bool uppercase)
 {
-    return dtoString<QByteArray>(d, form, precision, uppercase);
+    QByteArray result;
+    dtoString(result, d, form, precision, uppercase);
+    return result;
 }
 
 #if defined(QT_SUPPORTS_INT128) || defined(QT_USE_MSVC_INT128)
@@ -0,0 +1,113 @@
+// Copyright (C) 2025 The Qt Company Ltd.
+
+
+#ifndef QMONOTONICARENA_H
+#define QMONOTONICARENA_H
+
+#include <QtCore/qglobal.h>
+
+#include <cstddef>
+#include <stdlib.h>
+#include <utility>
+
+QT_BEGIN_NAMESPACE
+
+// A bump allocator for short-lived scratch memory: allocations are carved
+// out of a caller-supplied buffer, then out of malloc()ed blocks of growing
+// size once that is used up. Nothing is returned to the system until
+// release() or destruction, except that the most recent allocation can be
+// resized or given back in place. Not thread-safe.
+class QMonotonicArena
+{
+    struct Block
+    {
+        Block *next;
+    };
+
+public:
+    QMonotonicArena() noexcept = default;
+    QMonotonicArena(void *buffer, qsizetype size) noexcept
+        : initial(static_cast<char *>(buffer)), initialSize(size),
+          cur(initial), end(initial + size)
+    {
+        Q_ASSERT(buffer || size == 0);
+    }
+    ~QMonotonicArena() { release(); }
+    Q_DISABLE_COPY_MOVE(QMonotonicArena)
+
+    void *allocate(qsizetype size, qsizetype alignment = alignof(std::max_align_t))
+    {
+        Q_ASSERT(size >= 0);
+        Q_ASSERT(alignment > 0 && (alignment & (alignment - 1)) == 0);
+        const quintptr p = (quintptr(cur) + quintptr(alignment - 1)) & ~quintptr(alignment - 1);
+        if (p <= quintptr(end) && quintptr(end) - p >= quintptr(size)) {
+            last = reinterpret_cast<char *>(p);
+            cur = last + size;
+            return last;
+        }
+        return allocateInNewBlock(size, alignment);
+    }
+
+    // Grows or shrinks the most recent allocation without moving it, if
+    // there is room. Returns false (and does nothing) otherwise.
+    bool resize(void *p, qsizetype newSize) noexcept
+    {
+        Q_ASSERT(newSize >= 0);
+        if (!p || p != last || end - last < newSize)
+            return false;
+        cur = last + newSize;
+        return true;
+    }
+
+    // Only the most recent allocation actually gets reused.
+    void deallocate(void *p, qsizetype size) noexcept
+    {
+        if (p && p == last && last + size == cur) {
+            cur = last;
+            last = nullptr;
+        }
+    }
+
+    // Frees the overflow blocks and starts over at the caller's buffer.
+    // Everything allocated so far becomes invalid.
+    void release() noexcept
+    {
+        while (blocks)
+            free(std::exchange(blocks, blocks->next));
+        cur = initial;
+        end = initial + initialSize;
+        last = nullptr;
+        nextBlockSize = FirstBlockSize;
+    }
+
+private:
+    static constexpr qsizetype FirstBlockSize = 4096;
+    static constexpr qsizetype MaxBlockSize = 1024 * 1024;
+
+    void *allocateInNewBlock(qsizetype size, qsizetype alignment)
+    {
+        const qsizetype needed = qsizetype(sizeof(Block)) + size + alignment;
+        const qsizetype blockSize = qMax(nextBlockSize, needed);
+        Block *block = static_cast<Block *>(malloc(blockSize));
+        Q_CHECK_PTR(block);
+        block->next = blocks;
+        blocks = block;
+        nextBlockSize = qMin(nextBlockSize * 2, MaxBlockSize);
+
+        cur = reinterpret_cast<char *>(block + 1);
+        end = reinterpret_cast<char *>(block) + blockSize;
+        return allocate(size, alignment);
+    }
+
+    char *initial = nullptr;
+    qsizetype initialSize = 0;
+    char *cur = nullptr;
+    char *end = nullptr;
+    char *last = nullptr;
+    Block *blocks = nullptr;
+    qsizetype nextBlockSize = FirstBlockSize;
+};
+
+QT_END_NAMESPACE
+
+#endif // QMONOTONICARENA_H
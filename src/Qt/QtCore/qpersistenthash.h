@@ -0,0 +1,578 @@
+// Copyright (C) 2025 The Qt Company Ltd.
+
+
+#ifndef QPERSISTENTHASH_H
+#define QPERSISTENTHASH_H
+
+#include <QtCore/qalgorithms.h>
+#include <QtCore/qatomic.h>
+#include <QtCore/qhashfunctions.h>
+#include <QtCore/qlist.h>
+#include <QtCore/qswap.h>
+#include <QtCore/qttypetraits.h>
+
+#include <cstddef>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <stdlib.h>
+#include <utility>
+
+QT_BEGIN_NAMESPACE
+
+namespace QPersistentHashPrivate {
+
+// A hash array mapped trie in the compressed (CHAMP) layout. Every node
+// indexes 32 ways by five bits of the hash; for each of them, it either
+// stores one entry inline, points to a child node, or has nothing. The two
+// bitmaps say which; entries and children are packed in that order behind
+// the node header, in a single allocation.
+//
+// Nodes are reference counted and never change once they are shared. An
+// update copies the nodes on the path from the root to the entry (at most
+// one per five bits of hash) and shares everything else with the previous
+// version. Nodes that are only referenced from a path that is not shared
+// either are updated in place instead.
+//
+// The trie is kept canonical: a node other than the root always holds at
+// least two entries in its subtree, so removing an entry pulls its last
+// sibling up into the parent.
+constexpr int BitsPerLevel = 5;
+constexpr int HashBits = int(sizeof(size_t)) * 8;
+
+inline quint32 bitFor(size_t hash, int shift) noexcept
+{
+    return 1u << ((hash >> shift) & 31);
+}
+
+inline int indexFor(quint32 map, quint32 bit) noexcept
+{
+    return qPopulationCount(map & (bit - 1));
+}
+
+template <typename Key, typename T>
+struct Entry
+{
+    size_t hash;
+    Key key;
+    T value;
+};
+
+template <typename Key, typename T>
+struct Node
+{
+    using Entry = QPersistentHashPrivate::Entry<Key, T>;
+
+    QBasicAtomicInt ref;
+    quint32 dataMap;
+    quint32 nodeMap;
+    quint32 entryCount;     // popcount(dataMap), except in collision nodes
+
+    // Collision nodes sit below the last level that has any hash bits left.
+    // They use neither bitmap and keep their entries in no particular order.
+    static bool isCollisionShift(int shift) noexcept { return shift >= HashBits; }
+
+    qsizetype childCount() const noexcept { return qPopulationCount(nodeMap); }
+
+    static constexpr size_t entriesOffset()
+    { return (sizeof(Node) + alignof(Entry) - 1) & ~(alignof(Entry) - 1); }
+    static size_t childrenOffset(qsizetype entries)
+    {
+        const size_t end = entriesOffset() + size_t(entries) * sizeof(Entry);
+        return (end + alignof(Node *) - 1) & ~(alignof(Node *) - 1);
+    }
+
+    Entry *entries() noexcept
+    { return reinterpret_cast<Entry *>(reinterpret_cast<char *>(this) + entriesOffset()); }
+    const Entry *entries() const noexcept
+    { return reinterpret_cast<const Entry *>(reinterpret_cast<const char *>(this) + entriesOffset()); }
+    Node **children() noexcept
+    { return reinterpret_cast<Node **>(reinterpret_cast<char *>(this) + childrenOffset(entryCount)); }
+    Node *const *children() const noexcept
+    { return reinterpret_cast<Node *const *>(reinterpret_cast<const char *>(this) + childrenOffset(entryCount)); }
+
+    // Allocates a node whose entries and children the caller has to construct
+    static Node *allocate(quint32 dataMap, quint32 nodeMap, quint32 entryCount)
+    {
+        constexpr size_t alignment = alignof(Node) > alignof(Entry) ? alignof(Node) : alignof(Entry);
+        static_assert(alignment <= alignof(std::max_align_t),
+                      "Over-aligned keys and values are not supported");
+        const size_t size = childrenOffset(entryCount) + qPopulationCount(nodeMap) * sizeof(Node *);
+        Node *n = static_cast<Node *>(malloc(size));
+        Q_CHECK_PTR(n);
+        n->ref.storeRelaxed(1);
+        n->dataMap = dataMap;
+        n->nodeMap = nodeMap;
+        n->entryCount = entryCount;
+        return n;
+    }
+
+    static void release(Node *n) noexcept
+    {
+        if (!n || n->ref.deref())
+            return;
+        std::destroy_n(n->entries(), n->entryCount);
+        Node **c = n->children();
+        for (qsizetype i = 0, end = n->childCount(); i != end; ++i)
+            release(c[i]);
+        free(n);
+    }
+
+    // Builds a copy of n with the given layout: entries are taken from n,
+    // except that the entry at skipEntry (if any) is left out and an
+    // uninitialized slot is left at holeEntry (if any). The same goes for
+    // the children, except that the child left out is not released: the
+    // caller has taken over that reference. Then drops the reference to n.
+    // If that was the only one, the entries are moved rather than copied.
+    static Node *rebuild(Node *n, quint32 dataMap, quint32 nodeMap, quint32 entryCount,
+                         qsizetype skipEntry, qsizetype holeEntry,
+                         qsizetype skipChild, qsizetype holeChild)
+    {
+        Node *x = allocate(dataMap, nodeMap, entryCount);
+        const bool unique = n->ref.loadRelaxed() == 1;
+        Q_ASSERT(unique || skipChild < 0);
+        Entry *to = x->entries();
+        for (qsizetype i = 0; i != n->entryCount; ++i) {
+            if (to - x->entries() == holeEntry)
+                ++to;
+            if (i == skipEntry)
+                continue;
+            if (unique)
+                new (to++) Entry(std::move(n->entries()[i]));
+            else
+                new (to++) Entry(n->entries()[i]);
+        }
+        Node **cto = x->children();
+        Node **c = n->children();
+        for (qsizetype i = 0, end = n->childCount(); i != end; ++i) {
+            if (cto - x->children() == holeChild)
+                ++cto;
+            if (i != skipChild) {
+                if (!unique)
+                    c[i]->ref.ref();
+                *cto++ = c[i];
+            }
+        }
+        if (unique) {
+            std::destroy_n(n->entries(), n->entryCount);
+            free(n);
+        } else {
+            release(n);     // someone else may have let go in the meantime
+        }
+        return x;
+    }
+
+    // Returns n itself if nothing else refers to it, or else a private copy
+    static Node *editable(Node *n)
+    {
+        if (n->ref.loadRelaxed() == 1)
+            return n;
+        return rebuild(n, n->dataMap, n->nodeMap, n->entryCount, -1, -1, -1, -1);
+    }
+
+    // A node with exactly one entry and no children; in canonical form,
+    // only the root may look like that.
+    bool isSingleton() const noexcept { return entryCount == 1 && nodeMap == 0; }
+
+    const T *find(size_t hash, const Key &key, int shift) const
+    {
+        const Node *n = this;
+        for (;; shift += BitsPerLevel) {
+            if (isCollisionShift(shift)) {
+                for (qsizetype i = 0; i != n->entryCount; ++i) {
+                    if (n->entries()[i].key == key)
+                        return &n->entries()[i].value;
+                }
+                return nullptr;
+            }
+            const quint32 bit = bitFor(hash, shift);
+            if (n->dataMap & bit) {
+                const Entry &e = n->entries()[indexFor(n->dataMap, bit)];
+                return e.hash == hash && e.key == key ? &e.value : nullptr;
+            }
+            if (!(n->nodeMap & bit))
+                return nullptr;
+            n = n->children()[indexFor(n->nodeMap, bit)];
+        }
+    }
+
+    // A subtree holding the two entries, which differ in key
+    static Node *mergeTwo(Entry &&e1, Entry &&e2, int shift)
+    {
+        if (isCollisionShift(shift)) {
+            Node *x = allocate(0, 0, 2);
+            new (x->entries()) Entry(std::move(e1));
+            new (x->entries() + 1) Entry(std::move(e2));
+            return x;
+        }
+        const quint32 bit1 = bitFor(e1.hash, shift);
+        const quint32 bit2 = bitFor(e2.hash, shift);
+        if (bit1 == bit2) {
+            Node *x = allocate(0, bit1, 0);
+            x->children()[0] = mergeTwo(std::move(e1), std::move(e2), shift + BitsPerLevel);
+            return x;
+        }
+        Node *x = allocate(bit1 | bit2, 0, 2);
+        const bool firstIsFirst = bit1 < bit2;
+        new (x->entries() + (firstIsFirst ? 0 : 1)) Entry(std::move(e1));
+        new (x->entries() + (firstIsFirst ? 1 : 0)) Entry(std::move(e2));
+        return x;
+    }
+
+    // Takes over the reference to n and returns the node to replace it with.
+    // added is set if the key was not there before.
+    template <typename K, typename V>
+    static Node *insert(Node *n, size_t hash, K &&key, V &&value, int shift, bool *added)
+    {
+        if (isCollisionShift(shift)) {
+            for (qsizetype i = 0; i != n->entryCount; ++i) {
+                if (n->entries()[i].key == key) {
+                    n = editable(n);
+                    n->entries()[i].value = std::forward<V>(value);
+                    return n;
+                }
+            }
+            *added = true;
+            const quint32 count = n->entryCount;
+            Node *x = rebuild(n, 0, 0, count + 1, -1, count, -1, -1);
+            new (x->entries() + count) Entry{hash, std::forward<K>(key), std::forward<V>(value)};
+            return x;
+        }
+
+        const quint32 bit = bitFor(hash, shift);
+        if (n->dataMap & bit) {
+            const qsizetype i = indexFor(n->dataMap, bit);
+            Entry &e = n->entries()[i];
+            if (e.hash == hash && e.key == key) {
+                n = editable(n);
+                n->entries()[i].value = std::forward<V>(value);
+                return n;
+            }
+            // push the entry down into a new child together with the new one
+            *added = true;
+            Entry old = n->ref.loadRelaxed() == 1 ? std::move(e) : Entry(e);
+            Node *child = mergeTwo(std::move(old),
+                                   Entry{hash, std::forward<K>(key), std::forward<V>(value)},
+                                   shift + BitsPerLevel);
+            const qsizetype ci = indexFor(n->nodeMap, bit);
+            Node *x = rebuild(n, n->dataMap & ~bit, n->nodeMap | bit, n->entryCount - 1,
+                              i, -1, -1, ci);
+            x->children()[ci] = child;
+            return x;
+        }
+        if (n->nodeMap & bit) {
+            n = editable(n);
+            Node *&child = n->children()[indexFor(n->nodeMap, bit)];
+            child = insert(child, hash, std::forward<K>(key), std::forward<V>(value),
+                           shift + BitsPerLevel, added);
+            return n;
+        }
+        *added = true;
+        const qsizetype i = indexFor(n->dataMap, bit);
+        Node *x = rebuild(n, n->dataMap | bit, n->nodeMap, n->entryCount + 1, -1, i, -1, -1);
+        new (x->entries() + i) Entry{hash, std::forward<K>(key), std::forward<V>(value)};
+        return x;
+    }
+
+    // Like insert(), for a key that is known to be in the subtree. Returns
+    // nullptr if that leaves the subtree empty.
+    static Node *remove(Node *n, size_t hash, const Key &key, int shift)
+    {
+        if (isCollisionShift(shift)) {
+            qsizetype i = 0;
+            while (!(n->entries()[i].key == key))
+                ++i;
+            if (n->entryCount == 1) {
+                release(n);
+                return nullptr;
+            }
+            return rebuild(n, 0, 0, n->entryCount - 1, i, -1, -1, -1);
+        }
+
+        const quint32 bit = bitFor(hash, shift);
+        if (n->dataMap & bit) {
+            if (n->entryCount == 1 && n->nodeMap == 0) {
+                release(n);
+                return nullptr;
+            }
+            return rebuild(n, n->dataMap & ~bit, n->nodeMap, n->entryCount - 1,
+                           indexFor(n->dataMap, bit), -1, -1, -1);
+        }
+
+        Q_ASSERT(n->nodeMap & bit);
+        n = editable(n);
+        const qsizetype ci = indexFor(n->nodeMap, bit);
+        Node *child = remove(n->children()[ci], hash, key, shift + BitsPerLevel);
+        if (!child->isSingleton()) {
+            n->children()[ci] = child;
+            return n;
+        }
+        // The child is down to one entry: move that up into n. If n is
+        // left with nothing else, its own parent will do the same.
+        const qsizetype i = indexFor(n->dataMap, bit);
+        Node *x = rebuild(n, n->dataMap | bit, n->nodeMap & ~bit, n->entryCount + 1,
+                          -1, i, ci, -1);
+        new (x->entries() + i) Entry(std::move(child->entries()[0]));
+        release(child);
+        return x;
+    }
+};
+
+} // namespace QPersistentHashPrivate
+
+template <typename Key, typename T>
+class QPersistentHash
+{
+    using Node = QPersistentHashPrivate::Node<Key, T>;
+    using Entry = typename Node::Entry;
+    static constexpr int MaxDepth = (QPersistentHashPrivate::HashBits + QPersistentHashPrivate::BitsPerLevel - 1)
+                                    / QPersistentHashPrivate::BitsPerLevel + 1;
+
+public:
+    using key_type = Key;
+    using mapped_type = T;
+    using value_type = T;
+    using size_type = qsizetype;
+    using difference_type = qptrdiff;
+
+    QPersistentHash() noexcept = default;
+    QPersistentHash(std::initializer_list<std::pair<Key, T>> list)
+    {
+        for (const auto &p : list)
+            insert(p.first, p.second);
+    }
+    QPersistentHash(const QPersistentHash &other) noexcept
+        : root(other.root), m_size(other.m_size)
+    {
+        if (root)
+            root->ref.ref();
+    }
+    QPersistentHash(QPersistentHash &&other) noexcept
+        : root(std::exchange(other.root, nullptr)), m_size(std::exchange(other.m_size, 0))
+    {
+    }
+    ~QPersistentHash() { Node::release(root); }
+
+    QPersistentHash &operator=(const QPersistentHash &other) noexcept
+    {
+        QPersistentHash copy(other);
+        swap(copy);
+        return *this;
+    }
+    QT_MOVE_ASSIGNMENT_OPERATOR_IMPL_VIA_PURE_SWAP(QPersistentHash)
+    void swap(QPersistentHash &other) noexcept
+    {
+        qt_ptr_swap(root, other.root);
+        std::swap(m_size, other.m_size);
+    }
+
+    qsizetype size() const noexcept { return m_size; }
+    qsizetype count() const noexcept { return m_size; }
+    bool isEmpty() const noexcept { return m_size == 0; }
+    void clear() noexcept { QPersistentHash().swap(*this); }
+
+    // True if both hashes are copies of each other that haven't been
+    // modified since; then comparing them is free.
+    bool isSharedWith(const QPersistentHash &other) const noexcept { return root == other.root; }
+
+    bool contains(const Key &key) const { return find(key) != nullptr; }
+
+    T value(const Key &key) const
+    {
+        if (const T *v = find(key))
+            return *v;
+        return T();
+    }
+    T value(const Key &key, const T &defaultValue) const
+    {
+        if (const T *v = find(key))
+            return *v;
+        return defaultValue;
+    }
+
+    void insert(const Key &key, const T &value) { emplace(key, value); }
+    void insert(const Key &key, T &&value) { emplace(key, std::move(value)); }
+
+    template <typename V>
+    void emplace(const Key &key, V &&value)
+    {
+        const size_t h = hash(key);
+        bool added = false;
+        if (!root) {
+            root = Node::allocate(QPersistentHashPrivate::bitFor(h, 0), 0, 1);
+            new (root->entries()) Entry{h, key, T(std::forward<V>(value))};
+            added = true;
+        } else {
+            root = Node::insert(root, h, key, T(std::forward<V>(value)), 0, &added);
+        }
+        if (added)
+            ++m_size;
+    }
+
+    bool remove(const Key &key)
+    {
+        const size_t h = hash(key);
+        if (!root || !root->find(h, key, 0))
+            return false;
+        root = Node::remove(root, h, key, 0);
+        --m_size;
+        return true;
+    }
+
+    T take(const Key &key)
+    {
+        const T *v = find(key);
+        if (!v)
+            return T();
+        T t = *v;
+        remove(key);
+        return t;
+    }
+
+    class const_iterator
+    {
+        friend class QPersistentHash;
+
+        // The path from the root to the current node, with the position
+        // reached in each: entries first, then children.
+        struct Level
+        {
+            const Node *node;
+            qsizetype pos;
+        };
+        Level stack[MaxDepth];
+        int depth = -1;
+
+        explicit const_iterator(const Node *root)
+        {
+            if (root) {
+                stack[0] = { root, 0 };
+                depth = 0;
+                settle();
+            }
+        }
+
+        // Moves on from the current position to the next entry
+        void settle()
+        {
+            while (depth >= 0) {
+                Level &l = stack[depth];
+                if (l.pos < l.node->entryCount)
+                    return;
+                const qsizetype child = l.pos - l.node->entryCount;
+                if (child < l.node->childCount()) {
+                    ++l.pos;
+                    stack[++depth] = { l.node->children()[child], 0 };
+                } else {
+                    --depth;
+                }
+            }
+        }
+
+        const Entry &entry() const noexcept { return stack[depth].node->entries()[stack[depth].pos]; }
+
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using difference_type = qptrdiff;
+        using value_type = T;
+        using pointer = const T *;
+        using reference = const T &;
+
+        const_iterator() noexcept = default;
+
+        const Key &key() const noexcept { return entry().key; }
+        const T &value() const noexcept { return entry().value; }
+        const T &operator*() const noexcept { return entry().value; }
+        const T *operator->() const noexcept { return &entry().value; }
+
+        const_iterator &operator++()
+        {
+            ++stack[depth].pos;
+            settle();
+            return *this;
+        }
+        const_iterator operator++(int)
+        {
+            const_iterator r = *this;
+            ++*this;
+            return r;
+        }
+
+        friend bool operator==(const const_iterator &lhs, const const_iterator &rhs) noexcept
+        {
+            if (lhs.depth != rhs.depth)
+                return false;
+            return lhs.depth < 0 || (lhs.stack[lhs.depth].node == rhs.stack[rhs.depth].node
+                                     && lhs.stack[lhs.depth].pos == rhs.stack[rhs.depth].pos);
+        }
+        friend bool operator!=(const const_iterator &lhs, const const_iterator &rhs) noexcept
+        { return !(lhs == rhs); }
+    };
+    using ConstIterator = const_iterator;
+
+    const_iterator begin() const { return const_iterator(root); }
+    const_iterator end() const noexcept { return const_iterator(); }
+    const_iterator cbegin() const { return begin(); }
+    const_iterator cend() const noexcept { return end(); }
+    const_iterator constBegin() const { return begin(); }
+    const_iterator constEnd() const noexcept { return end(); }
+
+    QList<Key> keys() const
+    {
+        QList<Key> result;
+        result.reserve(m_size);
+        for (auto it = begin(); it != end(); ++it)
+            result.append(it.key());
+        return result;
+    }
+    QList<T> values() const
+    {
+        QList<T> result;
+        result.reserve(m_size);
+        for (const T &v : *this)
+            result.append(v);
+        return result;
+    }
+
+#ifndef Q_QDOC
+    template <typename U = T>
+    QTypeTraits::compare_eq_result<U> operator==(const QPersistentHash &other) const
+    {
+        if (root == other.root)
+            return true;
+        if (m_size != other.m_size)
+            return false;
+        for (auto it = begin(); it != end(); ++it) {
+            const T *v = other.find(it.key());
+            if (!v || !(*v == it.value()))
+                return false;
+        }
+        return true;
+    }
+    template <typename U = T>
+    QTypeTraits::compare_eq_result<U> operator!=(const QPersistentHash &other) const
+    { return !(*this == other); }
+#else
+    bool operator==(const QPersistentHash &other) const;
+    bool operator!=(const QPersistentHash &other) const;
+#endif // Q_QDOC
+
+private:
+    static size_t hash(const Key &key)
+    { return qHash(key, QHashSeed::globalSeed()); }
+
+    const T *find(const Key &key) const
+    { return root ? root->find(hash(key), key, 0) : nullptr; }
+
+    Node *root = nullptr;
+    qsizetype m_size = 0;
+};
+
+template <typename Key, typename T>
+void swap(QPersistentHash<Key, T> &lhs, QPersistentHash<Key, T> &rhs) noexcept
+{ lhs.swap(rhs); }
+
+QT_END_NAMESPACE
+
+#endif // QPERSISTENTHASH_H
@@ -0,0 +1,445 @@
+// Copyright (C) 2025 The Qt Company Ltd.
+
+
+#ifndef QPERSISTENTLIST_H
+#define QPERSISTENTLIST_H
+
+#include <QtCore/qatomic.h>
+#include <QtCore/qswap.h>
+#include <QtCore/qttypetraits.h>
+
+#include <algorithm>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <utility>
+
+QT_BEGIN_NAMESPACE
+
+namespace QPersistentListPrivate {
+
+// A 32-way radix trie over the index, with the last (up to) 32 items kept
+// in a separate tail leaf so that append() and removeLast() rarely touch
+// the trie. Nodes are reference counted and shared between copies of the
+// list; a modification copies the nodes on the path to the item, unless
+// nothing else refers to them.
+constexpr int BitsPerLevel = 5;
+constexpr qsizetype NodeSize = qsizetype(1) << BitsPerLevel;
+constexpr qsizetype IndexMask = NodeSize - 1;
+
+struct NodeBase
+{
+    QBasicAtomicInt ref = Q_BASIC_ATOMIC_INITIALIZER(1);
+};
+
+template <typename T>
+struct Leaf : NodeBase
+{
+    qsizetype count = 0;
+    alignas(T) char storage[NodeSize * sizeof(T)];
+
+    T *data() noexcept { return reinterpret_cast<T *>(storage); }
+    const T *data() const noexcept { return reinterpret_cast<const T *>(storage); }
+
+    Leaf() = default;
+    Leaf(const Leaf &other) : NodeBase()
+    {
+        std::uninitialized_copy_n(other.data(), other.count, data());
+        count = other.count;
+    }
+    ~Leaf() { std::destroy_n(data(), count); }
+};
+
+struct Branch : NodeBase
+{
+    NodeBase *children[NodeSize] = {};
+};
+
+} // namespace QPersistentListPrivate
+
+template <typename T>
+class QPersistentList
+{
+    using NodeBase = QPersistentListPrivate::NodeBase;
+    using Leaf = QPersistentListPrivate::Leaf<T>;
+    using Branch = QPersistentListPrivate::Branch;
+    static constexpr int BitsPerLevel = QPersistentListPrivate::BitsPerLevel;
+    static constexpr qsizetype NodeSize = QPersistentListPrivate::NodeSize;
+    static constexpr qsizetype IndexMask = QPersistentListPrivate::IndexMask;
+
+public:
+    using value_type = T;
+    using size_type = qsizetype;
+    using difference_type = qptrdiff;
+    using reference = T &;
+    using const_reference = const T &;
+
+    QPersistentList() noexcept = default;
+    QPersistentList(std::initializer_list<T> list)
+    {
+        for (const T &t : list)
+            append(t);
+    }
+    QPersistentList(const QPersistentList &other) noexcept
+        : root(other.root), tail(other.tail), m_size(other.m_size), shift(other.shift)
+    {
+        if (root)
+            root->ref.ref();
+        if (tail)
+            tail->ref.ref();
+    }
+    QPersistentList(QPersistentList &&other) noexcept
+        : root(std::exchange(other.root, nullptr)), tail(std::exchange(other.tail, nullptr)),
+          m_size(std::exchange(other.m_size, 0)), shift(std::exchange(other.shift, BitsPerLevel))
+    {
+    }
+    ~QPersistentList()
+    {
+        release(root, shift);
+        release(tail, 0);
+    }
+
+    QPersistentList &operator=(const QPersistentList &other) noexcept
+    {
+        QPersistentList copy(other);
+        swap(copy);
+        return *this;
+    }
+    QT_MOVE_ASSIGNMENT_OPERATOR_IMPL_VIA_PURE_SWAP(QPersistentList)
+    void swap(QPersistentList &other) noexcept
+    {
+        qt_ptr_swap(root, other.root);
+        qt_ptr_swap(tail, other.tail);
+        std::swap(m_size, other.m_size);
+        std::swap(shift, other.shift);
+    }
+
+    qsizetype size() const noexcept { return m_size; }
+    qsizetype count() const noexcept { return m_size; }
+    qsizetype length() const noexcept { return m_size; }
+    bool isEmpty() const noexcept { return m_size == 0; }
+    void clear() noexcept { QPersistentList().swap(*this); }
+
+    bool isSharedWith(const QPersistentList &other) const noexcept
+    { return root == other.root && tail == other.tail; }
+
+    const T &at(qsizetype i) const noexcept
+    {
+        Q_ASSERT_X(size_t(i) < size_t(m_size), "QPersistentList::at", "index out of range");
+        return leafFor(i)[i & IndexMask];
+    }
+    const T &operator[](qsizetype i) const noexcept { return at(i); }
+    T value(qsizetype i) const { return value(i, T()); }
+    T value(qsizetype i, const T &defaultValue) const
+    { return size_t(i) < size_t(m_size) ? at(i) : defaultValue; }
+
+    const T &first() const noexcept { Q_ASSERT(!isEmpty()); return at(0); }
+    const T &last() const noexcept { Q_ASSERT(!isEmpty()); return tail->data()[tail->count - 1]; }
+    const T &constFirst() const noexcept { return first(); }
+    const T &constLast() const noexcept { return last(); }
+
+    void append(const T &t) { emplaceBack(t); }
+    void append(T &&t) { emplaceBack(std::move(t)); }
+    template <typename... Args>
+    void emplaceBack(Args &&...args);
+    void push_back(const T &t) { append(t); }
+    void push_back(T &&t) { append(std::move(t)); }
+
+    void replace(qsizetype i, const T &t) { T copy(t); replace(i, std::move(copy)); }
+    void replace(qsizetype i, T &&t);
+
+    void removeLast();
+    void pop_back() { removeLast(); }
+    T takeLast()
+    {
+        T t = last();
+        removeLast();
+        return t;
+    }
+
+    class const_iterator
+    {
+        friend class QPersistentList;
+
+        const QPersistentList *list = nullptr;
+        qsizetype i = 0;
+        const T *leaf = nullptr;    // the items of the leaf holding item i
+
+        const_iterator(const QPersistentList *l, qsizetype index) noexcept
+            : list(l), i(index), leaf(index < l->m_size ? l->leafFor(index) : nullptr)
+        {
+        }
+
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using difference_type = qptrdiff;
+        using value_type = T;
+        using pointer = const T *;
+        using reference = const T &;
+
+        constexpr const_iterator() noexcept = default;
+
+        const T &operator*() const noexcept { return leaf[i & IndexMask]; }
+        const T *operator->() const noexcept { return &leaf[i & IndexMask]; }
+
+        const_iterator &operator++() noexcept
+        {
+            if ((++i & IndexMask) == 0)
+                leaf = i < list->m_size ? list->leafFor(i) : nullptr;
+            return *this;
+        }
+        const_iterator operator++(int) noexcept
+        {
+            const_iterator r = *this;
+            ++*this;
+            return r;
+        }
+
+        friend bool operator==(const const_iterator &lhs, const const_iterator &rhs) noexcept
+        { return lhs.i == rhs.i; }
+        friend bool operator!=(const const_iterator &lhs, const const_iterator &rhs) noexcept
+        { return lhs.i != rhs.i; }
+    };
+    using ConstIterator = const_iterator;
+
+    const_iterator begin() const noexcept { return const_iterator(this, 0); }
+    const_iterator end() const noexcept { return const_iterator(this, m_size); }
+    const_iterator cbegin() const noexcept { return begin(); }
+    const_iterator cend() const noexcept { return end(); }
+    const_iterator constBegin() const noexcept { return begin(); }
+    const_iterator constEnd() const noexcept { return end(); }
+
+#ifndef Q_QDOC
+    template <typename U = T>
+    QTypeTraits::compare_eq_result<U> operator==(const QPersistentList &other) const
+    {
+        if (m_size != other.m_size)
+            return false;
+        if (isSharedWith(other))
+            return true;
+        return std::equal(begin(), end(), other.begin());
+    }
+    template <typename U = T>
+    QTypeTraits::compare_eq_result<U> operator!=(const QPersistentList &other) const
+    { return !(*this == other); }
+#else
+    bool operator==(const QPersistentList &other) const;
+    bool operator!=(const QPersistentList &other) const;
+#endif // Q_QDOC
+
+private:
+    // All leaves in the trie are full; the tail holds the items from here on
+    qsizetype tailOffset() const noexcept
+    { return m_size ? ((m_size - 1) & ~IndexMask) : 0; }
+
+    const Leaf *leafNodeFor(qsizetype i) const noexcept
+    {
+        if (i >= tailOffset())
+            return tail;
+        const NodeBase *node = root;
+        for (int level = shift; level > 0; level -= BitsPerLevel)
+            node = static_cast<const Branch *>(node)->children[(i >> level) & IndexMask];
+        return static_cast<const Leaf *>(node);
+    }
+    // The items of the leaf holding item i
+    const T *leafFor(qsizetype i) const noexcept { return leafNodeFor(i)->data(); }
+
+    // Nodes at level 0 are leaves; the others are branches whose children
+    // are one level further down.
+    static void release(NodeBase *node, int level) noexcept
+    {
+        if (!node || node->ref.deref())
+            return;
+        if (level == 0) {
+            delete static_cast<Leaf *>(node);
+            return;
+        }
+        Branch *b = static_cast<Branch *>(node);
+        for (NodeBase *child : b->children)
+            release(child, level - BitsPerLevel);
+        delete b;
+    }
+
+    static Leaf *editable(Leaf *leaf)
+    {
+        if (leaf->ref.loadRelaxed() == 1)
+            return leaf;
+        Leaf *copy = new Leaf(*leaf);
+        release(leaf, 0);
+        return copy;
+    }
+    static Branch *editable(Branch *branch, int level)
+    {
+        if (branch->ref.loadRelaxed() == 1)
+            return branch;
+        Branch *copy = new Branch;
+        for (qsizetype i = 0; i != NodeSize; ++i) {
+            if ((copy->children[i] = branch->children[i]))
+                copy->children[i]->ref.ref();
+        }
+        release(branch, level);
+        return copy;
+    }
+
+    // A chain of branches down to level 0, where the leaf goes
+    static NodeBase *newPath(int level, NodeBase *leaf)
+    {
+        if (level == 0)
+            return leaf;
+        Branch *b = new Branch;
+        b->children[0] = newPath(level - BitsPerLevel, leaf);
+        return b;
+    }
+
+    Branch *pushTail(Branch *node, int level, Leaf *leaf);
+    NodeBase *popTail(Branch *node, int level);
+    T *assign(NodeBase *&node, int level, qsizetype i);
+
+    Branch *root = nullptr;
+    Leaf *tail = nullptr;
+    qsizetype m_size = 0;
+    int shift = BitsPerLevel;   // the level of the root
+};
+
+template <typename T>
+template <typename... Args>
+void QPersistentList<T>::emplaceBack(Args &&...args)
+{
+    if (tail && tail->count < NodeSize) {
+        // construct first, so that a throwing constructor leaves the list as it was
+        T t(std::forward<Args>(args)...);
+        tail = editable(tail);
+        new (tail->data() + tail->count) T(std::move(t));
+        ++tail->count;
+        ++m_size;
+        return;
+    }
+
+    auto newTail = std::make_unique<Leaf>();
+    new (newTail->data()) T(std::forward<Args>(args)...);
+    newTail->count = 1;
+    if (tail) {
+        // the tail is full: it becomes the last leaf of the trie
+        if (!root) {
+            root = static_cast<Branch *>(newPath(BitsPerLevel, tail));
+        } else if ((m_size >> BitsPerLevel) > (qsizetype(1) << shift)) {
+            Branch *newRoot = new Branch;
+            newRoot->children[0] = root;
+            newRoot->children[1] = newPath(shift, tail);
+            root = newRoot;
+            shift += BitsPerLevel;
+        } else {
+            root = pushTail(root, shift, tail);
+        }
+    }
+    tail = newTail.release();
+    ++m_size;
+}
+
+// Hangs the full leaf into the trie as its new last leaf
+template <typename T>
+auto QPersistentList<T>::pushTail(Branch *node, int level, Leaf *leaf) -> Branch *
+{
+    node = editable(node, level);
+    NodeBase *&slot = node->children[((m_size - 1) >> level) & IndexMask];
+    if (level == BitsPerLevel)
+        slot = leaf;
+    else if (slot)
+        slot = pushTail(static_cast<Branch *>(slot), level - BitsPerLevel, leaf);
+    else
+        slot = newPath(level - BitsPerLevel, leaf);
+    return node;
+}
+
+template <typename T>
+void QPersistentList<T>::replace(qsizetype i, T &&t)
+{
+    Q_ASSERT_X(size_t(i) < size_t(m_size), "QPersistentList::replace", "index out of range");
+    if (i >= tailOffset()) {
+        tail = editable(tail);
+        tail->data()[i & IndexMask] = std::move(t);
+        return;
+    }
+    NodeBase *r = root;
+    *assign(r, shift, i) = std::move(t);
+    root = static_cast<Branch *>(r);
+}
+
+// Makes the path to item i editable and returns the item
+template <typename T>
+T *QPersistentList<T>::assign(NodeBase *&node, int level, qsizetype i)
+{
+    if (level == 0) {
+        Leaf *leaf = editable(static_cast<Leaf *>(node));
+        node = leaf;
+        return leaf->data() + (i & IndexMask);
+    }
+    Branch *b = editable(static_cast<Branch *>(node), level);
+    node = b;
+    return assign(b->children[(i >> level) & IndexMask], level - BitsPerLevel, i);
+}
+
+template <typename T>
+void QPersistentList<T>::removeLast()
+{
+    Q_ASSERT(!isEmpty());
+    if (m_size == 1) {
+        clear();
+        return;
+    }
+    if (tail->count > 1) {
+        tail = editable(tail);
+        std::destroy_at(tail->data() + --tail->count);
+        --m_size;
+        return;
+    }
+
+    // the tail is going to be empty: the trie's last leaf takes its place
+    Leaf *newTail = const_cast<Leaf *>(leafNodeFor(m_size - 2));
+    newTail->ref.ref();
+    root = static_cast<Branch *>(popTail(root, shift));
+    if (shift > BitsPerLevel && root && !root->children[1]) {
+        Branch *oldRoot = root;
+        root = static_cast<Branch *>(oldRoot->children[0]);
+        root->ref.ref();
+        release(oldRoot, shift);
+        shift -= BitsPerLevel;
+    }
+    if (!root)
+        shift = BitsPerLevel;
+    release(tail, 0);
+    tail = newTail;
+    --m_size;
+}
+
+// Takes the last leaf out of the trie. Returns nullptr if the subtree
+// is left empty.
+template <typename T>
+auto QPersistentList<T>::popTail(Branch *node, int level) -> NodeBase *
+{
+    const qsizetype i = ((m_size - 2) >> level) & IndexMask;
+    if (level == BitsPerLevel && i == 0) {
+        release(node, level);
+        return nullptr;
+    }
+    node = editable(node, level);
+    if (level > BitsPerLevel) {
+        node->children[i] = popTail(static_cast<Branch *>(node->children[i]), level - BitsPerLevel);
+        if (node->children[i] || i != 0)
+            return node;
+    } else {
+        release(std::exchange(node->children[i], nullptr), 0);
+        return node;
+    }
+    release(node, level);
+    return nullptr;
+}
+
+template <typename T>
+void swap(QPersistentList<T> &lhs, QPersistentList<T> &rhs) noexcept
+{ lhs.swap(rhs); }
+
+QT_END_NAMESPACE
+
+#endif // QPERSISTENTLIST_H
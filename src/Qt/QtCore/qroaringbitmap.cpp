@@ -0,0 +1,694 @@
+// Copyright (C) 2025 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
+
+#include "qroaringbitmap.h"
+#include <qbytearray.h>
+#include <qendian.h>
+
+#include <algorithm>
+#include <iterator>
+
+#include <string.h>
+
+QT_BEGIN_NAMESPACE
+
+/*!
+    \class QRoaringBitmap
+    \inmodule QtCore
+    \brief The QRoaringBitmap class is a compressed set of 32-bit unsigned integers.
+
+    \ingroup tools
+    \ingroup shared
+    \reentrant
+
+    QRoaringBitmap stores the same information as a QBitArray with up to
+    2^32 bits, but only spends memory on the parts of the range that are
+    populated. The values are split into chunks of 65536 by their upper 16
+    bits. A chunk with few values keeps them as a sorted array of 16-bit
+    integers, a dense chunk as a bitmap of 8 KiB. Chunks without any values
+    take no space at all.
+
+    This makes QRoaringBitmap a good fit for sparse sets, such as row filters
+    over large tables that only select a small fraction of the rows. Combining
+    such filters with \l{operator&=()}{AND}, \l{operator|=()}{OR},
+    \l{operator^=()}{XOR} or subtract() works chunk by chunk, skipping the
+    chunks that only one side has, and picks the cheapest way to combine
+    each pair of chunks.
+
+    Use fromBitArray() and toBitArray() to convert from and to the dense
+    representation.
+
+    \sa QBitArray
+*/
+
+using Container = QtPrivate::QRoaringContainer;
+
+static constexpr quint64 bitFor(quint16 low) noexcept
+{
+    return Q_UINT64_C(1) << (low & 63);
+}
+
+static bool testBit(const Container &c, quint16 low) noexcept
+{
+    return c.words.at(low >> 6) & bitFor(low);
+}
+
+static qsizetype countBits(const QList<quint64> &words) noexcept
+{
+    qsizetype n = 0;
+    for (quint64 w : words)
+        n += qsizetype(qPopulationCount(w));
+    return n;
+}
+
+static void convertToBitmap(Container &c)
+{
+    QList<quint64> words(Container::BitmapWords, 0);
+    for (quint16 low : std::as_const(c.values))
+        words[low >> 6] |= bitFor(low);
+    c.words = std::move(words);
+    c.values = QList<quint16>();
+}
+
+static void convertToArray(Container &c)
+{
+    QList<quint16> values;
+    values.reserve(c.cardinality);
+    for (qsizetype i = 0; i < Container::BitmapWords; ++i) {
+        for (quint64 w = c.words.at(i); w; w &= w - 1)
+            values.append(quint16(i * 64 + qCountTrailingZeroBits(w)));
+    }
+    c.values = std::move(values);
+    c.words = QList<quint64>();
+}
+
+// Picks the representation that fits the cardinality; equal sets always end
+// up with equal containers.
+static void normalize(Container &c)
+{
+    if (c.isBitmap() && c.cardinality <= Container::MaxArraySize)
+        convertToArray(c);
+    else if (!c.isBitmap() && c.cardinality > Container::MaxArraySize)
+        convertToBitmap(c);
+}
+
+static bool containsLow(const Container &c, quint16 low) noexcept
+{
+    if (c.isBitmap())
+        return testBit(c, low);
+    return std::binary_search(c.values.cbegin(), c.values.cend(), low);
+}
+
+// Intersects two sorted arrays. When one is much smaller than the other,
+// it gallops through the larger one instead of walking it.
+static QList<quint16> intersectArrays(const QList<quint16> &a, const QList<quint16> &b)
+{
+    const QList<quint16> &small = a.size() <= b.size() ? a : b;
+    const QList<quint16> &large = a.size() <= b.size() ? b : a;
+    QList<quint16> result;
+    result.reserve(small.size());
+
+    if (small.size() * 32 < large.size()) {
+        auto it = large.cbegin();
+        const auto end = large.cend();
+        for (quint16 v : small) {
+            qsizetype step = 1;
+            auto hi = it;
+            while (end - hi > step && hi[step] < v) {
+                hi += step;
+                step *= 2;
+            }
+            it = std::lower_bound(hi, end - hi > step ? hi + step + 1 : end, v);
+            if (it == end)
+                break;
+            if (*it == v)
+                result.append(v);
+        }
+        return result;
+    }
+
+    // a branch-free merge: the comparisons are too unpredictable to branch on
+    result.resize(small.size());
+    quint16 *out = result.data();
+    const quint16 *x = a.constData(), *xend = x + a.size();
+    const quint16 *y = b.constData(), *yend = y + b.size();
+    qsizetype n = 0;
+    while (x != xend && y != yend) {
+        const quint16 u = *x, v = *y;
+        out[n] = u;
+        n += u == v;
+        x += u <= v;
+        y += v <= u;
+    }
+    result.resize(n);
+    return result;
+}
+
+static Container intersect(const Container &a, const Container &b)
+{
+    Container r;
+    r.key = a.key;
+    if (a.isBitmap() && b.isBitmap()) {
+        QList<quint64> words(Container::BitmapWords);
+        quint64 *dst = words.data();
+        const quint64 *x = a.words.constData();
+        const quint64 *y = b.words.constData();
+        qsizetype n = 0;
+        for (qsizetype i = 0; i < Container::BitmapWords; ++i) {
+            dst[i] = x[i] & y[i];
+            n += qsizetype(qPopulationCount(dst[i]));
+        }
+        r.words = std::move(words);
+        r.cardinality = n;
+        normalize(r);
+    } else if (a.isBitmap() || b.isBitmap()) {
+        const Container &array = a.isBitmap() ? b : a;
+        const Container &bitmap = a.isBitmap() ? a : b;
+        r.values.reserve(array.cardinality);
+        for (quint16 low : array.values) {
+            if (testBit(bitmap, low))
+                r.values.append(low);
+        }
+        r.cardinality = r.values.size();
+    } else {
+        r.values = intersectArrays(a.values, b.values);
+        r.cardinality = r.values.size();
+    }
+    return r;
+}
+
+static bool intersects(const Container &a, const Container &b) noexcept
+{
+    if (a.isBitmap() && b.isBitmap()) {
+        const quint64 *x = a.words.constData();
+        const quint64 *y = b.words.constData();
+        for (qsizetype i = 0; i < Container::BitmapWords; ++i) {
+            if (x[i] & y[i])
+                return true;
+        }
+        return false;
+    }
+    if (a.isBitmap() || b.isBitmap()) {
+        const Container &array = a.isBitmap() ? b : a;
+        const Container &bitmap = a.isBitmap() ? a : b;
+        return std::any_of(array.values.cbegin(), array.values.cend(),
+                           [&](quint16 low) { return testBit(bitmap, low); });
+    }
+    auto i = a.values.cbegin(), j = b.values.cbegin();
+    while (i != a.values.cend() && j != b.values.cend()) {
+        if (*i < *j)
+            ++i;
+        else if (*j < *i)
+            ++j;
+        else
+            return true;
+    }
+    return false;
+}
+
+// Combines two containers of which at least one is too large to stay an
+// array, as bitmaps.
+template <typename WordOp>
+static Container combineAsBitmaps(const Container &a, const Container &b, WordOp op)
+{
+    Container r;
+    r.key = a.key;
+    Container bitmapA = a;
+    Container bitmapB = b;
+    if (!bitmapA.isBitmap())
+        convertToBitmap(bitmapA);
+    if (!bitmapB.isBitmap())
+        convertToBitmap(bitmapB);
+    QList<quint64> words(Container::BitmapWords);
+    quint64 *dst = words.data();
+    const quint64 *x = bitmapA.words.constData();
+    const quint64 *y = bitmapB.words.constData();
+    for (qsizetype i = 0; i < Container::BitmapWords; ++i)
+        dst[i] = op(x[i], y[i]);
+    r.cardinality = countBits(words);
+    r.words = std::move(words);
+    normalize(r);
+    return r;
+}
+
+static Container unite(const Container &a, const Container &b)
+{
+    if (!a.isBitmap() && !b.isBitmap() && a.cardinality + b.cardinality <= Container::MaxArraySize) {
+        Container r;
+        r.key = a.key;
+        r.values.reserve(a.cardinality + b.cardinality);
+        std::set_union(a.values.cbegin(), a.values.cend(), b.values.cbegin(), b.values.cend(),
+                       std::back_inserter(r.values));
+        r.cardinality = r.values.size();
+        return r;
+    }
+    return combineAsBitmaps(a, b, [](quint64 x, quint64 y) { return x | y; });
+}
+
+static Container symmetricDifference(const Container &a, const Container &b)
+{
+    if (!a.isBitmap() && !b.isBitmap() && a.cardinality + b.cardinality <= Container::MaxArraySize) {
+        Container r;
+        r.key = a.key;
+        r.values.reserve(a.cardinality + b.cardinality);
+        std::set_symmetric_difference(a.values.cbegin(), a.values.cend(),
+                                      b.values.cbegin(), b.values.cend(),
+                                      std::back_inserter(r.values));
+        r.cardinality = r.values.size();
+        return r;
+    }
+    return combineAsBitmaps(a, b, [](quint64 x, quint64 y) { return x ^ y; });
+}
+
+static Container difference(const Container &a, const Container &b)
+{
+    Container r;
+    r.key = a.key;
+    if (!a.isBitmap()) {
+        r.values.reserve(a.cardinality);
+        if (b.isBitmap()) {
+            for (quint16 low : a.values) {
+                if (!testBit(b, low))
+                    r.values.append(low);
+            }
+        } else {
+            std::set_difference(a.values.cbegin(), a.values.cend(),
+                                 b.values.cbegin(), b.values.cend(),
+                                 std::back_inserter(r.values));
+        }
+        r.cardinality = r.values.size();
+        return r;
+    }
+
+    r.words = a.words;
+    quint64 *dst = r.words.data();
+    if (b.isBitmap()) {
+        const quint64 *y = b.words.constData();
+        for (qsizetype i = 0; i < Container::BitmapWords; ++i)
+            dst[i] &= ~y[i];
+        r.cardinality = countBits(r.words);
+    } else {
+        r.cardinality = a.cardinality;
+        for (quint16 low : b.values) {
+            if (dst[low >> 6] & bitFor(low)) {
+                dst[low >> 6] &= ~bitFor(low);
+                --r.cardinality;
+            }
+        }
+    }
+    normalize(r);
+    return r;
+}
+
+static auto findContainer(const QList<Container> &containers, quint16 key) noexcept
+{
+    return std::lower_bound(containers.cbegin(), containers.cend(), key,
+                            [](const Container &c, quint16 k) { return c.key < k; });
+}
+
+/*!
+    \fn QRoaringBitmap::QRoaringBitmap()
+
+    Constructs an empty bitmap.
+*/
+
+/*!
+    Constructs a bitmap containing the given \a values.
+*/
+QRoaringBitmap::QRoaringBitmap(std::initializer_list<quint32> values)
+{
+    for (quint32 v : values)
+        add(v);
+}
+
+/*!
+    Returns a bitmap that contains the index positions of all the bits set
+    in \a bits. \a bits must not have more than 2^32 bits.
+
+    \sa toBitArray()
+*/
+QRoaringBitmap QRoaringBitmap::fromBitArray(const QBitArray &bits)
+{
+    QRoaringBitmap result;
+    const qsizetype size = bits.size();
+    Q_ASSERT_X(quint64(size) <= Q_UINT64_C(1) << 32, "QRoaringBitmap::fromBitArray",
+               "The bit array must not have more than 2^32 bits.");
+    if (size == 0)
+        return result;
+
+    constexpr qsizetype ChunkBytes = Container::BitmapWords * 8;
+    const uchar *data = reinterpret_cast<const uchar *>(bits.bits());
+    const qsizetype bytes = (size + 7) / 8;
+    for (qsizetype offset = 0; offset < bytes; offset += ChunkBytes) {
+        const qsizetype n = qMin(ChunkBytes, bytes - offset);
+        QList<quint64> words(Container::BitmapWords, 0);
+        qFromLittleEndian<quint64>(data + offset, n / 8, words.data());
+        if (const qsizetype rest = n % 8) {
+            quint64 last = 0;
+            for (qsizetype i = 0; i < rest; ++i)
+                last |= quint64(data[offset + n - rest + i]) << (8 * i);
+            words[n / 8] = last;
+        }
+
+        // The bits beyond size() are always 0 in a QBitArray
+        const qsizetype cardinality = countBits(words);
+        if (cardinality == 0)
+            continue;
+        Container c;
+        c.key = quint16(offset / ChunkBytes);
+        c.cardinality = cardinality;
+        c.words = std::move(words);
+        normalize(c);
+        result.containers.append(std::move(c));
+    }
+    return result;
+}
+
+/*!
+    Returns a bit array of \a size bits, in which the bits at the index
+    positions contained in this bitmap are set. Values greater than or equal
+    to \a size are left out.
+
+    \sa fromBitArray()
+*/
+QBitArray QRoaringBitmap::toBitArray(qsizetype size) const
+{
+    Q_ASSERT_X(size >= 0, "QRoaringBitmap::toBitArray", "Size must be greater than or equal to 0.");
+    const qsizetype bytes = (size + 7) / 8;
+    QByteArray buffer(bytes, '\0');
+    uchar *data = reinterpret_cast<uchar *>(buffer.data());
+
+    for (const Container &c : containers) {
+        const qsizetype high = qsizetype(c.key) << 16;
+        if (high >= size)
+            break;
+        if (c.isBitmap()) {
+            for (qsizetype i = 0; i < Container::BitmapWords; ++i) {
+                const qsizetype byte = (high + i * 64) / 8;
+                if (byte >= bytes)
+                    break;
+                const quint64 w = qToLittleEndian(c.words.at(i));
+                memcpy(data + byte, &w, qMin(qsizetype(8), bytes - byte));
+            }
+        } else {
+            for (quint16 low : c.values) {
+                const qsizetype pos = high | low;
+                if (pos >= size)
+                    break;
+                data[pos >> 3] |= uchar(1U << (pos & 7));
+            }
+        }
+    }
+    // fromBits() clears the bits beyond size in the last byte
+    return QBitArray::fromBits(buffer.constData(), size);
+}
+
+/*!
+    \fn void QRoaringBitmap::swap(QRoaringBitmap &other)
+
+    Swaps this bitmap with \a other. This operation is very fast and never
+    fails.
+*/
+
+/*!
+    \fn bool QRoaringBitmap::isEmpty() const
+
+    Returns \c true if the bitmap contains no values; otherwise returns
+    \c false.
+*/
+
+/*!
+    Returns the number of values in the bitmap.
+
+    \sa isEmpty()
+*/
+qsizetype QRoaringBitmap::count() const noexcept
+{
+    qsizetype n = 0;
+    for (const Container &c : containers)
+        n += c.cardinality;
+    return n;
+}
+
+/*!
+    \fn qsizetype QRoaringBitmap::size() const
+
+    Same as count().
+*/
+
+/*!
+    \fn void QRoaringBitmap::clear()
+
+    Removes all values from the bitmap.
+*/
+
+/*!
+    Returns \c true if the bitmap contains \a value; otherwise returns
+    \c false.
+*/
+bool QRoaringBitmap::contains(quint32 value) const noexcept
+{
+    const quint16 key = quint16(value >> 16);
+    const auto it = findContainer(containers, key);
+    return it != containers.cend() && it->key == key && containsLow(*it, quint16(value));
+}
+
+/*!
+    Adds \a value to the bitmap. Returns \c true if it wasn't in the bitmap
+    before; otherwise returns \c false.
+*/
+bool QRoaringBitmap::add(quint32 value)
+{
+    const quint16 key = quint16(value >> 16);
+    const quint16 low = quint16(value);
+    const qsizetype i = findContainer(containers, key) - containers.cbegin();
+    if (i == containers.size() || containers.at(i).key != key) {
+        Container c;
+        c.key = key;
+        c.cardinality = 1;
+        c.values.append(low);
+        containers.insert(i, std::move(c));
+        return true;
+    }
+
+    Container &c = containers[i];
+    if (c.isBitmap()) {
+        quint64 &w = c.words[low >> 6];
+        if (w & bitFor(low))
+            return false;
+        w |= bitFor(low);
+    } else {
+        const auto it = std::lower_bound(c.values.cbegin(), c.values.cend(), low);
+        if (it != c.values.cend() && *it == low)
+            return false;
+        c.values.insert(it - c.values.cbegin(), low);
+    }
+    ++c.cardinality;
+    normalize(c);
+    return true;
+}
+
+/*!
+    Removes \a value from the bitmap. Returns \c true if it was in the bitmap;
+    otherwise returns \c false.
+*/
+bool QRoaringBitmap::remove(quint32 value)
+{
+    const quint16 key = quint16(value >> 16);
+    const quint16 low = quint16(value);
+    const qsizetype i = findContainer(containers, key) - containers.cbegin();
+    if (i == containers.size() || containers.at(i).key != key
+            || !containsLow(containers.at(i), low)) {
+        return false;
+    }
+
+    Container &c = containers[i];
+    if (--c.cardinality == 0) {
+        containers.remove(i);
+        return true;
+    }
+    if (c.isBitmap()) {
+        c.words[low >> 6] &= ~bitFor(low);
+        normalize(c);
+    } else {
+        c.values.removeOne(low);
+    }
+    return true;
+}
+
+/*!
+    Returns \c true if this bitmap and \a other have at least one value in
+    common; otherwise returns \c false. This is cheaper than computing the
+    intersection.
+*/
+bool QRoaringBitmap::intersects(const QRoaringBitmap &other) const noexcept
+{
+    auto i = containers.cbegin(), j = other.containers.cbegin();
+    while (i != containers.cend() && j != other.containers.cend()) {
+        if (i->key < j->key) {
+            ++i;
+        } else if (j->key < i->key) {
+            ++j;
+        } else {
+            if (QT_PREPEND_NAMESPACE(intersects)(*i, *j))
+                return true;
+            ++i;
+            ++j;
+        }
+    }
+    return false;
+}
+
+/*!
+    Removes all values from this bitmap that are not in \a other, and returns
+    a reference to this bitmap.
+
+    \sa operator&()
+*/
+QRoaringBitmap &QRoaringBitmap::operator&=(const QRoaringBitmap &other)
+{
+    QList<Container> result;
+    auto i = containers.cbegin(), j = other.containers.cbegin();
+    while (i != containers.cend() && j != other.containers.cend()) {
+        if (i->key < j->key) {
+            ++i;
+        } else if (j->key < i->key) {
+            ++j;
+        } else {
+            Container c = intersect(*i, *j);
+            if (c.cardinality)
+                result.append(std::move(c));
+            ++i;
+            ++j;
+        }
+    }
+    containers = std::move(result);
+    return *this;
+}
+
+/*!
+    Adds all values of \a other to this bitmap, and returns a reference to
+    this bitmap.
+
+    \sa operator|()
+*/
+QRoaringBitmap &QRoaringBitmap::operator|=(const QRoaringBitmap &other)
+{
+    QList<Container> result;
+    result.reserve(containers.size() + other.containers.size());
+    auto i = containers.cbegin(), j = other.containers.cbegin();
+    while (i != containers.cend() || j != other.containers.cend()) {
+        if (j == other.containers.cend() || (i != containers.cend() && i->key < j->key)) {
+            result.append(*i++);
+        } else if (i == containers.cend() || j->key < i->key) {
+            result.append(*j++);
+        } else {
+            result.append(unite(*i, *j));
+            ++i;
+            ++j;
+        }
+    }
+    containers = std::move(result);
+    return *this;
+}
+
+/*!
+    Makes this bitmap contain the values that are either in it or in \a other,
+    but not in both, and returns a reference to this bitmap.
+
+    \sa operator^()
+*/
+QRoaringBitmap &QRoaringBitmap::operator^=(const QRoaringBitmap &other)
+{
+    QList<Container> result;
+    result.reserve(containers.size() + other.containers.size());
+    auto i = containers.cbegin(), j = other.containers.cbegin();
+    while (i != containers.cend() || j != other.containers.cend()) {
+        if (j == other.containers.cend() || (i != containers.cend() && i->key < j->key)) {
+            result.append(*i++);
+        } else if (i == containers.cend() || j->key < i->key) {
+            result.append(*j++);
+        } else {
+            Container c = symmetricDifference(*i, *j);
+            if (c.cardinality)
+                result.append(std::move(c));
+            ++i;
+            ++j;
+        }
+    }
+    containers = std::move(result);
+    return *this;
+}
+
+/*!
+    Removes all values of \a other from this bitmap, and returns a reference
+    to this bitmap.
+*/
+QRoaringBitmap &QRoaringBitmap::subtract(const QRoaringBitmap &other)
+{
+    QList<Container> result;
+    result.reserve(containers.size());
+    auto j = other.containers.cbegin();
+    for (const Container &c : std::as_const(containers)) {
+        while (j != other.containers.cend() && j->key < c.key)
+            ++j;
+        if (j == other.containers.cend() || j->key != c.key) {
+            result.append(c);
+            continue;
+        }
+        Container d = difference(c, *j);
+        if (d.cardinality)
+            result.append(std::move(d));
+    }
+    containers = std::move(result);
+    return *this;
+}
+
+/*!
+    \fn QRoaringBitmap operator&(QRoaringBitmap lhs, const QRoaringBitmap &rhs)
+
+    Returns a bitmap with the values that are in both \a lhs and \a rhs.
+*/
+
+/*!
+    \fn QRoaringBitmap operator|(QRoaringBitmap lhs, const QRoaringBitmap &rhs)
+
+    Returns a bitmap with the values that are in \a lhs or in \a rhs.
+*/
+
+/*!
+    \fn QRoaringBitmap operator^(QRoaringBitmap lhs, const QRoaringBitmap &rhs)
+
+    Returns a bitmap with the values that are in exactly one of \a lhs and
+    \a rhs.
+*/
+
+/*!
+    \fn template <typename Function> void QRoaringBitmap::forEach(Function f) const
+
+    Calls \a f with every value in the bitmap, in ascending order.
+*/
+
+/*!
+    Returns the values in the bitmap as a sorted list.
+*/
+QList<quint32> QRoaringBitmap::toList() const
+{
+    QList<quint32> result;
+    result.reserve(count());
+    forEach([&result](quint32 value) { result.append(value); });
+    return result;
+}
+
+bool comparesEqual(const QRoaringBitmap &lhs, const QRoaringBitmap &rhs) noexcept
+{
+    // containers are kept in canonical form, so equal sets are stored the same way
+    return std::equal(lhs.containers.cbegin(), lhs.containers.cend(),
+                      rhs.containers.cbegin(), rhs.containers.cend(),
+                      [](const Container &a, const Container &b) {
+        return a.key == b.key && a.cardinality == b.cardinality
+                && a.values == b.values && a.words == b.words;
+    });
+}
+
+QT_END_NAMESPACE
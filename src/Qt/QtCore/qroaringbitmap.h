@@ -0,0 +1,100 @@
+// Copyright (C) 2025 The Qt Company Ltd.
+
+
+#ifndef QROARINGBITMAP_H
+#define QROARINGBITMAP_H
+
+#include <QtCore/qalgorithms.h>
+#include <QtCore/qbitarray.h>
+#include <QtCore/qlist.h>
+
+#include <initializer_list>
+
+QT_BEGIN_NAMESPACE
+
+namespace QtPrivate {
+// One chunk of 65536 values sharing their upper 16 bits. Small chunks keep
+// the lower 16 bits of their values as a sorted array; once that would be
+// bigger than a plain bitmap, they switch to 1024 words of bits.
+struct QRoaringContainer
+{
+    static constexpr qsizetype MaxArraySize = 4096;
+    static constexpr qsizetype BitmapWords = 65536 / 64;
+
+    quint16 key = 0;
+    qsizetype cardinality = 0;
+    QList<quint16> values;      // used iff cardinality <= MaxArraySize
+    QList<quint64> words;       // used otherwise
+
+    bool isBitmap() const noexcept { return !words.isEmpty(); }
+};
+} // namespace QtPrivate
+
+class Q_CORE_EXPORT QRoaringBitmap
+{
+    using Container = QtPrivate::QRoaringContainer;
+
+public:
+    QRoaringBitmap() noexcept = default;
+    QRoaringBitmap(std::initializer_list<quint32> values);
+
+    static QRoaringBitmap fromBitArray(const QBitArray &bits);
+    QBitArray toBitArray(qsizetype size) const;
+
+    void swap(QRoaringBitmap &other) noexcept { containers.swap(other.containers); }
+
+    bool isEmpty() const noexcept { return containers.isEmpty(); }
+    qsizetype count() const noexcept;
+    qsizetype size() const noexcept { return count(); }
+    void clear() { containers.clear(); }
+
+    bool contains(quint32 value) const noexcept;
+    bool add(quint32 value);
+    bool remove(quint32 value);
+
+    bool intersects(const QRoaringBitmap &other) const noexcept;
+
+    QRoaringBitmap &operator&=(const QRoaringBitmap &other);
+    QRoaringBitmap &operator|=(const QRoaringBitmap &other);
+    QRoaringBitmap &operator^=(const QRoaringBitmap &other);
+    QRoaringBitmap &subtract(const QRoaringBitmap &other);
+
+    friend QRoaringBitmap operator&(QRoaringBitmap lhs, const QRoaringBitmap &rhs)
+    { return lhs &= rhs; }
+    friend QRoaringBitmap operator|(QRoaringBitmap lhs, const QRoaringBitmap &rhs)
+    { return lhs |= rhs; }
+    friend QRoaringBitmap operator^(QRoaringBitmap lhs, const QRoaringBitmap &rhs)
+    { return lhs ^= rhs; }
+
+    // Calls f(value) for every value in the bitmap, in ascending order.
+    template <typename Function>
+    void forEach(Function f) const
+    {
+        for (const Container &c : containers) {
+            const quint32 high = quint32(c.key) << 16;
+            if (c.isBitmap()) {
+                for (qsizetype i = 0; i < Container::BitmapWords; ++i) {
+                    for (quint64 w = c.words.at(i); w; w &= w - 1)
+                        f(high | quint32(i * 64 + qCountTrailingZeroBits(w)));
+                }
+            } else {
+                for (quint16 low : c.values)
+                    f(high | low);
+            }
+        }
+    }
+    QList<quint32> toList() const;
+
+private:
+    friend Q_CORE_EXPORT bool comparesEqual(const QRoaringBitmap &lhs,
+                                            const QRoaringBitmap &rhs) noexcept;
+    Q_DECLARE_EQUALITY_COMPARABLE(QRoaringBitmap)
+
+    QList<Container> containers;    // sorted by key, none of them empty
+};
+
+Q_DECLARE_SHARED(QRoaringBitmap)
+
+QT_END_NAMESPACE
+
+#endif // QROARINGBITMAP_H
@@ -0,0 +1,869 @@
+// Copyright (C) 2024 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR LGPL-3.0-only OR GPL-2.0-only OR GPL-3.0-only
+
+#include "qlocale_tools_p.h"
+
+#include <private/qnumeric_p.h>
+
+#if defined(Q_CC_MSVC) && defined(Q_PROCESSOR_X86_64) && !defined(QT_SUPPORTS_INT128)
+#  include <intrin.h>
+#endif
+
+#include <limits>
+
+#include <string.h>
+
+QT_BEGIN_NAMESPACE
+
+/*
+    Shortest round-trip conversion of doubles to decimal, after Raffaello
+    Giulietti's "The Schubfach way to render doubles" (2020), the algorithm
+    Dragonbox builds on as well.
+
+    Unlike Grisu, which can fail to prove its result shortest for about 0.5%
+    of the inputs and then falls back to bignum arithmetic, Schubfach always
+    succeeds with a few 64x128-bit multiplications against a table of
+    rounded-up powers of ten. It returns the shortest decimal that reads back
+    as the same double and, among those, the one closest to the exact value.
+*/
+
+namespace {
+
+struct UInt128
+{
+    quint64 hi;
+    quint64 lo;
+};
+
+// The significands g of 10^k for k in [MinPow10, MaxPow10], such that
+// 2^127 <= g < 2^128 and g - 1 <= 10^k * 2^(127 - floor(log2(10^k))) < g.
+constexpr int MinPow10 = -292;
+constexpr int MaxPow10 = 324;
+constexpr UInt128 pow10Significands[MaxPow10 - MinPow10 + 1] = {
+    { Q_UINT64_C(0xff77b1fcbebcdc4f), Q_UINT64_C(0x25e8e89c13bb0f7b) },
+    { Q_UINT64_C(0x9faacf3df73609b1), Q_UINT64_C(0x77b191618c54e9ad) },
+    { Q_UINT64_C(0xc795830d75038c1d), Q_UINT64_C(0xd59df5b9ef6a2418) },
+    { Q_UINT64_C(0xf97ae3d0d2446f25), Q_UINT64_C(0x4b0573286b44ad1e) },
+    { Q_UINT64_C(0x9becce62836ac577), Q_UINT64_C(0x4ee367f9430aec33) },
+    { Q_UINT64_C(0xc2e801fb244576d5), Q_UINT64_C(0x229c41f793cda740) },
+    { Q_UINT64_C(0xf3a20279ed56d48a), Q_UINT64_C(0x6b43527578c11110) },
+    { Q_UINT64_C(0x9845418c345644d6), Q_UINT64_C(0x830a13896b78aaaa) },
+    { Q_UINT64_C(0xbe5691ef416bd60c), Q_UINT64_C(0x23cc986bc656d554) },
+    { Q_UINT64_C(0xedec366b11c6cb8f), Q_UINT64_C(0x2cbfbe86b7ec8aa9) },
+    { Q_UINT64_C(0x94b3a202eb1c3f39), Q_UINT64_C(0x7bf7d71432f3d6aa) },
+    { Q_UINT64_C(0xb9e08a83a5e34f07), Q_UINT64_C(0xdaf5ccd93fb0cc54) },
+    { Q_UINT64_C(0xe858ad248f5c22c9), Q_UINT64_C(0xd1b3400f8f9cff69) },
+    { Q_UINT64_C(0x91376c36d99995be), Q_UINT64_C(0x23100809b9c21fa2) },
+    { Q_UINT64_C(0xb58547448ffffb2d), Q_UINT64_C(0xabd40a0c2832a78b) },
+    { Q_UINT64_C(0xe2e69915b3fff9f9), Q_UINT64_C(0x16c90c8f323f516d) },
+    { Q_UINT64_C(0x8dd01fad907ffc3b), Q_UINT64_C(0xae3da7d97f6792e4) },
+    { Q_UINT64_C(0xb1442798f49ffb4a), Q_UINT64_C(0x99cd11cfdf41779d) },
+    { Q_UINT64_C(0xdd95317f31c7fa1d), Q_UINT64_C(0x40405643d711d584) },
+    { Q_UINT64_C(0x8a7d3eef7f1cfc52), Q_UINT64_C(0x482835ea666b2573) },
+    { Q_UINT64_C(0xad1c8eab5ee43b66), Q_UINT64_C(0xda3243650005eed0) },
+    { Q_UINT64_C(0xd863b256369d4a40), Q_UINT64_C(0x90bed43e40076a83) },
+    { Q_UINT64_C(0x873e4f75e2224e68), Q_UINT64_C(0x5a7744a6e804a292) },
+    { Q_UINT64_C(0xa90de3535aaae202), Q_UINT64_C(0x711515d0a205cb37) },
+    { Q_UINT64_C(0xd3515c2831559a83), Q_UINT64_C(0x0d5a5b44ca873e04) },
+    { Q_UINT64_C(0x8412d9991ed58091), Q_UINT64_C(0xe858790afe9486c3) },
+    { Q_UINT64_C(0xa5178fff668ae0b6), Q_UINT64_C(0x626e974dbe39a873) },
+    { Q_UINT64_C(0xce5d73ff402d98e3), Q_UINT64_C(0xfb0a3d212dc81290) },
+    { Q_UINT64_C(0x80fa687f881c7f8e), Q_UINT64_C(0x7ce66634bc9d0b9a) },
+    { Q_UINT64_C(0xa139029f6a239f72), Q_UINT64_C(0x1c1fffc1ebc44e81) },
+    { Q_UINT64_C(0xc987434744ac874e), Q_UINT64_C(0xa327ffb266b56221) },
+    { Q_UINT64_C(0xfbe9141915d7a922), Q_UINT64_C(0x4bf1ff9f0062baa9) },
+    { Q_UINT64_C(0x9d71ac8fada6c9b5), Q_UINT64_C(0x6f773fc3603db4aa) },
+    { Q_UINT64_C(0xc4ce17b399107c22), Q_UINT64_C(0xcb550fb4384d21d4) },
+    { Q_UINT64_C(0xf6019da07f549b2b), Q_UINT64_C(0x7e2a53a146606a49) },
+    { Q_UINT64_C(0x99c102844f94e0fb), Q_UINT64_C(0x2eda7444cbfc426e) },
+    { Q_UINT64_C(0xc0314325637a1939), Q_UINT64_C(0xfa911155fefb5309) },
+    { Q_UINT64_C(0xf03d93eebc589f88), Q_UINT64_C(0x793555ab7eba27cb) },
+    { Q_UINT64_C(0x96267c7535b763b5), Q_UINT64_C(0x4bc1558b2f3458df) },
+    { Q_UINT64_C(0xbbb01b9283253ca2), Q_UINT64_C(0x9eb1aaedfb016f17) },
+    { Q_UINT64_C(0xea9c227723ee8bcb), Q_UINT64_C(0x465e15a979c1cadd) },
+    { Q_UINT64_C(0x92a1958a7675175f), Q_UINT64_C(0x0bfacd89ec191eca) },
+    { Q_UINT64_C(0xb749faed14125d36), Q_UINT64_C(0xcef980ec671f667c) },
+    { Q_UINT64_C(0xe51c79a85916f484), Q_UINT64_C(0x82b7e12780e7401b) },
+    { Q_UINT64_C(0x8f31cc0937ae58d2), Q_UINT64_C(0xd1b2ecb8b0908811) },
+    { Q_UINT64_C(0xb2fe3f0b8599ef07), Q_UINT64_C(0x861fa7e6dcb4aa16) },
+    { Q_UINT64_C(0xdfbdcece67006ac9), Q_UINT64_C(0x67a791e093e1d49b) },
+    { Q_UINT64_C(0x8bd6a141006042bd), Q_UINT64_C(0xe0c8bb2c5c6d24e1) },
+    { Q_UINT64_C(0xaecc49914078536d), Q_UINT64_C(0x58fae9f773886e19) },
+    { Q_UINT64_C(0xda7f5bf590966848), Q_UINT64_C(0xaf39a475506a899f) },
+    { Q_UINT64_C(0x888f99797a5e012d), Q_UINT64_C(0x6d8406c952429604) },
+    { Q_UINT64_C(0xaab37fd7d8f58178), Q_UINT64_C(0xc8e5087ba6d33b84) },
+    { Q_UINT64_C(0xd5605fcdcf32e1d6), Q_UINT64_C(0xfb1e4a9a90880a65) },
+    { Q_UINT64_C(0x855c3be0a17fcd26), Q_UINT64_C(0x5cf2eea09a550680) },
+    { Q_UINT64_C(0xa6b34ad8c9dfc06f), Q_UINT64_C(0xf42faa48c0ea481f) },
+    { Q_UINT64_C(0xd0601d8efc57b08b), Q_UINT64_C(0xf13b94daf124da27) },
+    { Q_UINT64_C(0x823c12795db6ce57), Q_UINT64_C(0x76c53d08d6b70859) },
+    { Q_UINT64_C(0xa2cb1717b52481ed), Q_UINT64_C(0x54768c4b0c64ca6f) },
+    { Q_UINT64_C(0xcb7ddcdda26da268), Q_UINT64_C(0xa9942f5dcf7dfd0a) },
+    { Q_UINT64_C(0xfe5d54150b090b02), Q_UINT64_C(0xd3f93b35435d7c4d) },
+    { Q_UINT64_C(0x9efa548d26e5a6e1), Q_UINT64_C(0xc47bc5014a1a6db0) },
+    { Q_UINT64_C(0xc6b8e9b0709f109a), Q_UINT64_C(0x359ab6419ca1091c) },
+    { Q_UINT64_C(0xf867241c8cc6d4c0), Q_UINT64_C(0xc30163d203c94b63) },
+    { Q_UINT64_C(0x9b407691d7fc44f8), Q_UINT64_C(0x79e0de63425dcf1e) },
+    { Q_UINT64_C(0xc21094364dfb5636), Q_UINT64_C(0x985915fc12f542e5) },
+    { Q_UINT64_C(0xf294b943e17a2bc4), Q_UINT64_C(0x3e6f5b7b17b2939e) },
+    { Q_UINT64_C(0x979cf3ca6cec5b5a), Q_UINT64_C(0xa705992ceecf9c43) },
+    { Q_UINT64_C(0xbd8430bd08277231), Q_UINT64_C(0x50c6ff782a838354) },
+    { Q_UINT64_C(0xece53cec4a314ebd), Q_UINT64_C(0xa4f8bf5635246429) },
+    { Q_UINT64_C(0x940f4613ae5ed136), Q_UINT64_C(0x871b7795e136be9a) },
+    { Q_UINT64_C(0xb913179899f68584), Q_UINT64_C(0x28e2557b59846e40) },
+    { Q_UINT64_C(0xe757dd7ec07426e5), Q_UINT64_C(0x331aeada2fe589d0) },
+    { Q_UINT64_C(0x9096ea6f3848984f), Q_UINT64_C(0x3ff0d2c85def7622) },
+    { Q_UINT64_C(0xb4bca50b065abe63), Q_UINT64_C(0x0fed077a756b53aa) },
+    { Q_UINT64_C(0xe1ebce4dc7f16dfb), Q_UINT64_C(0xd3e8495912c62895) },
+    { Q_UINT64_C(0x8d3360f09cf6e4bd), Q_UINT64_C(0x64712dd7abbbd95d) },
+    { Q_UINT64_C(0xb080392cc4349dec), Q_UINT64_C(0xbd8d794d96aacfb4) },
+    { Q_UINT64_C(0xdca04777f541c567), Q_UINT64_C(0xecf0d7a0fc5583a1) },
+    { Q_UINT64_C(0x89e42caaf9491b60), Q_UINT64_C(0xf41686c49db57245) },
+    { Q_UINT64_C(0xac5d37d5b79b6239), Q_UINT64_C(0x311c2875c522ced6) },
+    { Q_UINT64_C(0xd77485cb25823ac7), Q_UINT64_C(0x7d633293366b828c) },
+    { Q_UINT64_C(0x86a8d39ef77164bc), Q_UINT64_C(0xae5dff9c02033198) },
+    { Q_UINT64_C(0xa8530886b54dbdeb), Q_UINT64_C(0xd9f57f830283fdfd) },
+    { Q_UINT64_C(0xd267caa862a12d66), Q_UINT64_C(0xd072df63c324fd7c) },
+    { Q_UINT64_C(0x8380dea93da4bc60), Q_UINT64_C(0x4247cb9e59f71e6e) },
+    { Q_UINT64_C(0xa46116538d0deb78), Q_UINT64_C(0x52d9be85f074e609) },
+    { Q_UINT64_C(0xcd795be870516656), Q_UINT64_C(0x67902e276c921f8c) },
+    { Q_UINT64_C(0x806bd9714632dff6), Q_UINT64_C(0x00ba1cd8a3db53b7) },
+    { Q_UINT64_C(0xa086cfcd97bf97f3), Q_UINT64_C(0x80e8a40eccd228a5) },
+    { Q_UINT64_C(0xc8a883c0fdaf7df0), Q_UINT64_C(0x6122cd128006b2ce) },
+    { Q_UINT64_C(0xfad2a4b13d1b5d6c), Q_UINT64_C(0x796b805720085f82) },
+    { Q_UINT64_C(0x9cc3a6eec6311a63), Q_UINT64_C(0xcbe3303674053bb1) },
+    { Q_UINT64_C(0xc3f490aa77bd60fc), Q_UINT64_C(0xbedbfc4411068a9d) },
+    { Q_UINT64_C(0xf4f1b4d515acb93b), Q_UINT64_C(0xee92fb5515482d45) },
+    { Q_UINT64_C(0x991711052d8bf3c5), Q_UINT64_C(0x751bdd152d4d1c4b) },
+    { Q_UINT64_C(0xbf5cd54678eef0b6), Q_UINT64_C(0xd262d45a78a0635e) },
+    { Q_UINT64_C(0xef340a98172aace4), Q_UINT64_C(0x86fb897116c87c35) },
+    { Q_UINT64_C(0x9580869f0e7aac0e), Q_UINT64_C(0xd45d35e6ae3d4da1) },
+    { Q_UINT64_C(0xbae0a846d2195712), Q_UINT64_C(0x8974836059cca10a) },
+    { Q_UINT64_C(0xe998d258869facd7), Q_UINT64_C(0x2bd1a438703fc94c) },
+    { Q_UINT64_C(0x91ff83775423cc06), Q_UINT64_C(0x7b6306a34627ddd0) },
+    { Q_UINT64_C(0xb67f6455292cbf08), Q_UINT64_C(0x1a3bc84c17b1d543) },
+    { Q_UINT64_C(0xe41f3d6a7377eeca), Q_UINT64_C(0x20caba5f1d9e4a94) },
+    { Q_UINT64_C(0x8e938662882af53e), Q_UINT64_C(0x547eb47b7282ee9d) },
+    { Q_UINT64_C(0xb23867fb2a35b28d), Q_UINT64_C(0xe99e619a4f23aa44) },
+    { Q_UINT64_C(0xdec681f9f4c31f31), Q_UINT64_C(0x6405fa00e2ec94d5) },
+    { Q_UINT64_C(0x8b3c113c38f9f37e), Q_UINT64_C(0xde83bc408dd3dd05) },
+    { Q_UINT64_C(0xae0b158b4738705e), Q_UINT64_C(0x9624ab50b148d446) },
+    { Q_UINT64_C(0xd98ddaee19068c76), Q_UINT64_C(0x3badd624dd9b0958) },
+    { Q_UINT64_C(0x87f8a8d4cfa417c9), Q_UINT64_C(0xe54ca5d70a80e5d7) },
+    { Q_UINT64_C(0xa9f6d30a038d1dbc), Q_UINT64_C(0x5e9fcf4ccd211f4d) },
+    { Q_UINT64_C(0xd47487cc8470652b), Q_UINT64_C(0x7647c32000696720) },
+    { Q_UINT64_C(0x84c8d4dfd2c63f3b), Q_UINT64_C(0x29ecd9f40041e074) },
+    { Q_UINT64_C(0xa5fb0a17c777cf09), Q_UINT64_C(0xf468107100525891) },
+    { Q_UINT64_C(0xcf79cc9db955c2cc), Q_UINT64_C(0x7182148d4066eeb5) },
+    { Q_UINT64_C(0x81ac1fe293d599bf), Q_UINT64_C(0xc6f14cd848405531) },
+    { Q_UINT64_C(0xa21727db38cb002f), Q_UINT64_C(0xb8ada00e5a506a7d) },
+    { Q_UINT64_C(0xca9cf1d206fdc03b), Q_UINT64_C(0xa6d90811f0e4851d) },
+    { Q_UINT64_C(0xfd442e4688bd304a), Q_UINT64_C(0x908f4a166d1da664) },
+    { Q_UINT64_C(0x9e4a9cec15763e2e), Q_UINT64_C(0x9a598e4e043287ff) },
+    { Q_UINT64_C(0xc5dd44271ad3cdba), Q_UINT64_C(0x40eff1e1853f29fe) },
+    { Q_UINT64_C(0xf7549530e188c128), Q_UINT64_C(0xd12bee59e68ef47d) },
+    { Q_UINT64_C(0x9a94dd3e8cf578b9), Q_UINT64_C(0x82bb74f8301958cf) },
+    { Q_UINT64_C(0xc13a148e3032d6e7), Q_UINT64_C(0xe36a52363c1faf02) },
+    { Q_UINT64_C(0xf18899b1bc3f8ca1), Q_UINT64_C(0xdc44e6c3cb279ac2) },
+    { Q_UINT64_C(0x96f5600f15a7b7e5), Q_UINT64_C(0x29ab103a5ef8c0ba) },
+    { Q_UINT64_C(0xbcb2b812db11a5de), Q_UINT64_C(0x7415d448f6b6f0e8) },
+    { Q_UINT64_C(0xebdf661791d60f56), Q_UINT64_C(0x111b495b3464ad22) },
+    { Q_UINT64_C(0x936b9fcebb25c995), Q_UINT64_C(0xcab10dd900beec35) },
+    { Q_UINT64_C(0xb84687c269ef3bfb), Q_UINT64_C(0x3d5d514f40eea743) },
+    { Q_UINT64_C(0xe65829b3046b0afa), Q_UINT64_C(0x0cb4a5a3112a5113) },
+    { Q_UINT64_C(0x8ff71a0fe2c2e6dc), Q_UINT64_C(0x47f0e785eaba72ac) },
+    { Q_UINT64_C(0xb3f4e093db73a093), Q_UINT64_C(0x59ed216765690f57) },
+    { Q_UINT64_C(0xe0f218b8d25088b8), Q_UINT64_C(0x306869c13ec3532d) },
+    { Q_UINT64_C(0x8c974f7383725573), Q_UINT64_C(0x1e414218c73a13fc) },
+    { Q_UINT64_C(0xafbd2350644eeacf), Q_UINT64_C(0xe5d1929ef90898fb) },
+    { Q_UINT64_C(0xdbac6c247d62a583), Q_UINT64_C(0xdf45f746b74abf3a) },
+    { Q_UINT64_C(0x894bc396ce5da772), Q_UINT64_C(0x6b8bba8c328eb784) },
+    { Q_UINT64_C(0xab9eb47c81f5114f), Q_UINT64_C(0x066ea92f3f326565) },
+    { Q_UINT64_C(0xd686619ba27255a2), Q_UINT64_C(0xc80a537b0efefebe) },
+    { Q_UINT64_C(0x8613fd0145877585), Q_UINT64_C(0xbd06742ce95f5f37) },
+    { Q_UINT64_C(0xa798fc4196e952e7), Q_UINT64_C(0x2c48113823b73705) },
+    { Q_UINT64_C(0xd17f3b51fca3a7a0), Q_UINT64_C(0xf75a15862ca504c6) },
+    { Q_UINT64_C(0x82ef85133de648c4), Q_UINT64_C(0x9a984d73dbe722fc) },
+    { Q_UINT64_C(0xa3ab66580d5fdaf5), Q_UINT64_C(0xc13e60d0d2e0ebbb) },
+    { Q_UINT64_C(0xcc963fee10b7d1b3), Q_UINT64_C(0x318df905079926a9) },
+    { Q_UINT64_C(0xffbbcfe994e5c61f), Q_UINT64_C(0xfdf17746497f7053) },
+    { Q_UINT64_C(0x9fd561f1fd0f9bd3), Q_UINT64_C(0xfeb6ea8bedefa634) },
+    { Q_UINT64_C(0xc7caba6e7c5382c8), Q_UINT64_C(0xfe64a52ee96b8fc1) },
+    { Q_UINT64_C(0xf9bd690a1b68637b), Q_UINT64_C(0x3dfdce7aa3c673b1) },
+    { Q_UINT64_C(0x9c1661a651213e2d), Q_UINT64_C(0x06bea10ca65c084f) },
+    { Q_UINT64_C(0xc31bfa0fe5698db8), Q_UINT64_C(0x486e494fcff30a63) },
+    { Q_UINT64_C(0xf3e2f893dec3f126), Q_UINT64_C(0x5a89dba3c3efccfb) },
+    { Q_UINT64_C(0x986ddb5c6b3a76b7), Q_UINT64_C(0xf89629465a75e01d) },
+    { Q_UINT64_C(0xbe89523386091465), Q_UINT64_C(0xf6bbb397f1135824) },
+    { Q_UINT64_C(0xee2ba6c0678b597f), Q_UINT64_C(0x746aa07ded582e2d) },
+    { Q_UINT64_C(0x94db483840b717ef), Q_UINT64_C(0xa8c2a44eb4571cdd) },
+    { Q_UINT64_C(0xba121a4650e4ddeb), Q_UINT64_C(0x92f34d62616ce414) },
+    { Q_UINT64_C(0xe896a0d7e51e1566), Q_UINT64_C(0x77b020baf9c81d18) },
+    { Q_UINT64_C(0x915e2486ef32cd60), Q_UINT64_C(0x0ace1474dc1d122f) },
+    { Q_UINT64_C(0xb5b5ada8aaff80b8), Q_UINT64_C(0x0d819992132456bb) },
+    { Q_UINT64_C(0xe3231912d5bf60e6), Q_UINT64_C(0x10e1fff697ed6c6a) },
+    { Q_UINT64_C(0x8df5efabc5979c8f), Q_UINT64_C(0xca8d3ffa1ef463c2) },
+    { Q_UINT64_C(0xb1736b96b6fd83b3), Q_UINT64_C(0xbd308ff8a6b17cb3) },
+    { Q_UINT64_C(0xddd0467c64bce4a0), Q_UINT64_C(0xac7cb3f6d05ddbdf) },
+    { Q_UINT64_C(0x8aa22c0dbef60ee4), Q_UINT64_C(0x6bcdf07a423aa96c) },
+    { Q_UINT64_C(0xad4ab7112eb3929d), Q_UINT64_C(0x86c16c98d2c953c7) },
+    { Q_UINT64_C(0xd89d64d57a607744), Q_UINT64_C(0xe871c7bf077ba8b8) },
+    { Q_UINT64_C(0x87625f056c7c4a8b), Q_UINT64_C(0x11471cd764ad4973) },
+    { Q_UINT64_C(0xa93af6c6c79b5d2d), Q_UINT64_C(0xd598e40d3dd89bd0) },
+    { Q_UINT64_C(0xd389b47879823479), Q_UINT64_C(0x4aff1d108d4ec2c4) },
+    { Q_UINT64_C(0x843610cb4bf160cb), Q_UINT64_C(0xcedf722a585139bb) },
+    { Q_UINT64_C(0xa54394fe1eedb8fe), Q_UINT64_C(0xc2974eb4ee658829) },
+    { Q_UINT64_C(0xce947a3da6a9273e), Q_UINT64_C(0x733d226229feea33) },
+    { Q_UINT64_C(0x811ccc668829b887), Q_UINT64_C(0x0806357d5a3f5260) },
+    { Q_UINT64_C(0xa163ff802a3426a8), Q_UINT64_C(0xca07c2dcb0cf26f8) },
+    { Q_UINT64_C(0xc9bcff6034c13052), Q_UINT64_C(0xfc89b393dd02f0b6) },
+    { Q_UINT64_C(0xfc2c3f3841f17c67), Q_UINT64_C(0xbbac2078d443ace3) },
+    { Q_UINT64_C(0x9d9ba7832936edc0), Q_UINT64_C(0xd54b944b84aa4c0e) },
+    { Q_UINT64_C(0xc5029163f384a931), Q_UINT64_C(0x0a9e795e65d4df12) },
+    { Q_UINT64_C(0xf64335bcf065d37d), Q_UINT64_C(0x4d4617b5ff4a16d6) },
+    { Q_UINT64_C(0x99ea0196163fa42e), Q_UINT64_C(0x504bced1bf8e4e46) },
+    { Q_UINT64_C(0xc06481fb9bcf8d39), Q_UINT64_C(0xe45ec2862f71e1d7) },
+    { Q_UINT64_C(0xf07da27a82c37088), Q_UINT64_C(0x5d767327bb4e5a4d) },
+    { Q_UINT64_C(0x964e858c91ba2655), Q_UINT64_C(0x3a6a07f8d510f870) },
+    { Q_UINT64_C(0xbbe226efb628afea), Q_UINT64_C(0x890489f70a55368c) },
+    { Q_UINT64_C(0xeadab0aba3b2dbe5), Q_UINT64_C(0x2b45ac74ccea842f) },
+    { Q_UINT64_C(0x92c8ae6b464fc96f), Q_UINT64_C(0x3b0b8bc90012929e) },
+    { Q_UINT64_C(0xb77ada0617e3bbcb), Q_UINT64_C(0x09ce6ebb40173745) },
+    { Q_UINT64_C(0xe55990879ddcaabd), Q_UINT64_C(0xcc420a6a101d0516) },
+    { Q_UINT64_C(0x8f57fa54c2a9eab6), Q_UINT64_C(0x9fa946824a12232e) },
+    { Q_UINT64_C(0xb32df8e9f3546564), Q_UINT64_C(0x47939822dc96abfa) },
+    { Q_UINT64_C(0xdff9772470297ebd), Q_UINT64_C(0x59787e2b93bc56f8) },
+    { Q_UINT64_C(0x8bfbea76c619ef36), Q_UINT64_C(0x57eb4edb3c55b65b) },
+    { Q_UINT64_C(0xaefae51477a06b03), Q_UINT64_C(0xede622920b6b23f2) },
+    { Q_UINT64_C(0xdab99e59958885c4), Q_UINT64_C(0xe95fab368e45ecee) },
+    { Q_UINT64_C(0x88b402f7fd75539b), Q_UINT64_C(0x11dbcb0218ebb415) },
+    { Q_UINT64_C(0xaae103b5fcd2a881), Q_UINT64_C(0xd652bdc29f26a11a) },
+    { Q_UINT64_C(0xd59944a37c0752a2), Q_UINT64_C(0x4be76d3346f04960) },
+    { Q_UINT64_C(0x857fcae62d8493a5), Q_UINT64_C(0x6f70a4400c562ddc) },
+    { Q_UINT64_C(0xa6dfbd9fb8e5b88e), Q_UINT64_C(0xcb4ccd500f6bb953) },
+    { Q_UINT64_C(0xd097ad07a71f26b2), Q_UINT64_C(0x7e2000a41346a7a8) },
+    { Q_UINT64_C(0x825ecc24c873782f), Q_UINT64_C(0x8ed400668c0c28c9) },
+    { Q_UINT64_C(0xa2f67f2dfa90563b), Q_UINT64_C(0x728900802f0f32fb) },
+    { Q_UINT64_C(0xcbb41ef979346bca), Q_UINT64_C(0x4f2b40a03ad2ffba) },
+    { Q_UINT64_C(0xfea126b7d78186bc), Q_UINT64_C(0xe2f610c84987bfa9) },
+    { Q_UINT64_C(0x9f24b832e6b0f436), Q_UINT64_C(0x0dd9ca7d2df4d7ca) },
+    { Q_UINT64_C(0xc6ede63fa05d3143), Q_UINT64_C(0x91503d1c79720dbc) },
+    { Q_UINT64_C(0xf8a95fcf88747d94), Q_UINT64_C(0x75a44c6397ce912b) },
+    { Q_UINT64_C(0x9b69dbe1b548ce7c), Q_UINT64_C(0xc986afbe3ee11abb) },
+    { Q_UINT64_C(0xc24452da229b021b), Q_UINT64_C(0xfbe85badce996169) },
+    { Q_UINT64_C(0xf2d56790ab41c2a2), Q_UINT64_C(0xfae27299423fb9c4) },
+    { Q_UINT64_C(0x97c560ba6b0919a5), Q_UINT64_C(0xdccd879fc967d41b) },
+    { Q_UINT64_C(0xbdb6b8e905cb600f), Q_UINT64_C(0x5400e987bbc1c921) },
+    { Q_UINT64_C(0xed246723473e3813), Q_UINT64_C(0x290123e9aab23b69) },
+    { Q_UINT64_C(0x9436c0760c86e30b), Q_UINT64_C(0xf9a0b6720aaf6522) },
+    { Q_UINT64_C(0xb94470938fa89bce), Q_UINT64_C(0xf808e40e8d5b3e6a) },
+    { Q_UINT64_C(0xe7958cb87392c2c2), Q_UINT64_C(0xb60b1d1230b20e05) },
+    { Q_UINT64_C(0x90bd77f3483bb9b9), Q_UINT64_C(0xb1c6f22b5e6f48c3) },
+    { Q_UINT64_C(0xb4ecd5f01a4aa828), Q_UINT64_C(0x1e38aeb6360b1af4) },
+    { Q_UINT64_C(0xe2280b6c20dd5232), Q_UINT64_C(0x25c6da63c38de1b1) },
+    { Q_UINT64_C(0x8d590723948a535f), Q_UINT64_C(0x579c487e5a38ad0f) },
+    { Q_UINT64_C(0xb0af48ec79ace837), Q_UINT64_C(0x2d835a9df0c6d852) },
+    { Q_UINT64_C(0xdcdb1b2798182244), Q_UINT64_C(0xf8e431456cf88e66) },
+    { Q_UINT64_C(0x8a08f0f8bf0f156b), Q_UINT64_C(0x1b8e9ecb641b5900) },
+    { Q_UINT64_C(0xac8b2d36eed2dac5), Q_UINT64_C(0xe272467e3d222f40) },
+    { Q_UINT64_C(0xd7adf884aa879177), Q_UINT64_C(0x5b0ed81dcc6abb10) },
+    { Q_UINT64_C(0x86ccbb52ea94baea), Q_UINT64_C(0x98e947129fc2b4ea) },
+    { Q_UINT64_C(0xa87fea27a539e9a5), Q_UINT64_C(0x3f2398d747b36225) },
+    { Q_UINT64_C(0xd29fe4b18e88640e), Q_UINT64_C(0x8eec7f0d19a03aae) },
+    { Q_UINT64_C(0x83a3eeeef9153e89), Q_UINT64_C(0x1953cf68300424ad) },
+    { Q_UINT64_C(0xa48ceaaab75a8e2b), Q_UINT64_C(0x5fa8c3423c052dd8) },
+    { Q_UINT64_C(0xcdb02555653131b6), Q_UINT64_C(0x3792f412cb06794e) },
+    { Q_UINT64_C(0x808e17555f3ebf11), Q_UINT64_C(0xe2bbd88bbee40bd1) },
+    { Q_UINT64_C(0xa0b19d2ab70e6ed6), Q_UINT64_C(0x5b6aceaeae9d0ec5) },
+    { Q_UINT64_C(0xc8de047564d20a8b), Q_UINT64_C(0xf245825a5a445276) },
+    { Q_UINT64_C(0xfb158592be068d2e), Q_UINT64_C(0xeed6e2f0f0d56713) },
+    { Q_UINT64_C(0x9ced737bb6c4183d), Q_UINT64_C(0x55464dd69685606c) },
+    { Q_UINT64_C(0xc428d05aa4751e4c), Q_UINT64_C(0xaa97e14c3c26b887) },
+    { Q_UINT64_C(0xf53304714d9265df), Q_UINT64_C(0xd53dd99f4b3066a9) },
+    { Q_UINT64_C(0x993fe2c6d07b7fab), Q_UINT64_C(0xe546a8038efe402a) },
+    { Q_UINT64_C(0xbf8fdb78849a5f96), Q_UINT64_C(0xde98520472bdd034) },
+    { Q_UINT64_C(0xef73d256a5c0f77c), Q_UINT64_C(0x963e66858f6d4441) },
+    { Q_UINT64_C(0x95a8637627989aad), Q_UINT64_C(0xdde7001379a44aa9) },
+    { Q_UINT64_C(0xbb127c53b17ec159), Q_UINT64_C(0x5560c018580d5d53) },
+    { Q_UINT64_C(0xe9d71b689dde71af), Q_UINT64_C(0xaab8f01e6e10b4a7) },
+    { Q_UINT64_C(0x9226712162ab070d), Q_UINT64_C(0xcab3961304ca70e9) },
+    { Q_UINT64_C(0xb6b00d69bb55c8d1), Q_UINT64_C(0x3d607b97c5fd0d23) },
+    { Q_UINT64_C(0xe45c10c42a2b3b05), Q_UINT64_C(0x8cb89a7db77c506b) },
+    { Q_UINT64_C(0x8eb98a7a9a5b04e3), Q_UINT64_C(0x77f3608e92adb243) },
+    { Q_UINT64_C(0xb267ed1940f1c61c), Q_UINT64_C(0x55f038b237591ed4) },
+    { Q_UINT64_C(0xdf01e85f912e37a3), Q_UINT64_C(0x6b6c46dec52f6689) },
+    { Q_UINT64_C(0x8b61313bbabce2c6), Q_UINT64_C(0x2323ac4b3b3da016) },
+    { Q_UINT64_C(0xae397d8aa96c1b77), Q_UINT64_C(0xabec975e0a0d081b) },
+    { Q_UINT64_C(0xd9c7dced53c72255), Q_UINT64_C(0x96e7bd358c904a22) },
+    { Q_UINT64_C(0x881cea14545c7575), Q_UINT64_C(0x7e50d64177da2e55) },
+    { Q_UINT64_C(0xaa242499697392d2), Q_UINT64_C(0xdde50bd1d5d0b9ea) },
+    { Q_UINT64_C(0xd4ad2dbfc3d07787), Q_UINT64_C(0x955e4ec64b44e865) },
+    { Q_UINT64_C(0x84ec3c97da624ab4), Q_UINT64_C(0xbd5af13bef0b113f) },
+    { Q_UINT64_C(0xa6274bbdd0fadd61), Q_UINT64_C(0xecb1ad8aeacdd58f) },
+    { Q_UINT64_C(0xcfb11ead453994ba), Q_UINT64_C(0x67de18eda5814af3) },
+    { Q_UINT64_C(0x81ceb32c4b43fcf4), Q_UINT64_C(0x80eacf948770ced8) },
+    { Q_UINT64_C(0xa2425ff75e14fc31), Q_UINT64_C(0xa1258379a94d028e) },
+    { Q_UINT64_C(0xcad2f7f5359a3b3e), Q_UINT64_C(0x096ee45813a04331) },
+    { Q_UINT64_C(0xfd87b5f28300ca0d), Q_UINT64_C(0x8bca9d6e188853fd) },
+    { Q_UINT64_C(0x9e74d1b791e07e48), Q_UINT64_C(0x775ea264cf55347e) },
+    { Q_UINT64_C(0xc612062576589dda), Q_UINT64_C(0x95364afe032a819e) },
+    { Q_UINT64_C(0xf79687aed3eec551), Q_UINT64_C(0x3a83ddbd83f52205) },
+    { Q_UINT64_C(0x9abe14cd44753b52), Q_UINT64_C(0xc4926a9672793543) },
+    { Q_UINT64_C(0xc16d9a0095928a27), Q_UINT64_C(0x75b7053c0f178294) },
+    { Q_UINT64_C(0xf1c90080baf72cb1), Q_UINT64_C(0x5324c68b12dd6339) },
+    { Q_UINT64_C(0x971da05074da7bee), Q_UINT64_C(0xd3f6fc16ebca5e04) },
+    { Q_UINT64_C(0xbce5086492111aea), Q_UINT64_C(0x88f4bb1ca6bcf585) },
+    { Q_UINT64_C(0xec1e4a7db69561a5), Q_UINT64_C(0x2b31e9e3d06c32e6) },
+    { Q_UINT64_C(0x9392ee8e921d5d07), Q_UINT64_C(0x3aff322e62439fd0) },
+    { Q_UINT64_C(0xb877aa3236a4b449), Q_UINT64_C(0x09befeb9fad487c3) },
+    { Q_UINT64_C(0xe69594bec44de15b), Q_UINT64_C(0x4c2ebe687989a9b4) },
+    { Q_UINT64_C(0x901d7cf73ab0acd9), Q_UINT64_C(0x0f9d37014bf60a11) },
+    { Q_UINT64_C(0xb424dc35095cd80f), Q_UINT64_C(0x538484c19ef38c95) },
+    { Q_UINT64_C(0xe12e13424bb40e13), Q_UINT64_C(0x2865a5f206b06fba) },
+    { Q_UINT64_C(0x8cbccc096f5088cb), Q_UINT64_C(0xf93f87b7442e45d4) },
+    { Q_UINT64_C(0xafebff0bcb24aafe), Q_UINT64_C(0xf78f69a51539d749) },
+    { Q_UINT64_C(0xdbe6fecebdedd5be), Q_UINT64_C(0xb573440e5a884d1c) },
+    { Q_UINT64_C(0x89705f4136b4a597), Q_UINT64_C(0x31680a88f8953031) },
+    { Q_UINT64_C(0xabcc77118461cefc), Q_UINT64_C(0xfdc20d2b36ba7c3e) },
+    { Q_UINT64_C(0xd6bf94d5e57a42bc), Q_UINT64_C(0x3d32907604691b4d) },
+    { Q_UINT64_C(0x8637bd05af6c69b5), Q_UINT64_C(0xa63f9a49c2c1b110) },
+    { Q_UINT64_C(0xa7c5ac471b478423), Q_UINT64_C(0x0fcf80dc33721d54) },
+    { Q_UINT64_C(0xd1b71758e219652b), Q_UINT64_C(0xd3c36113404ea4a9) },
+    { Q_UINT64_C(0x83126e978d4fdf3b), Q_UINT64_C(0x645a1cac083126ea) },
+    { Q_UINT64_C(0xa3d70a3d70a3d70a), Q_UINT64_C(0x3d70a3d70a3d70a4) },
+    { Q_UINT64_C(0xcccccccccccccccc), Q_UINT64_C(0xcccccccccccccccd) },
+    { Q_UINT64_C(0x8000000000000000), Q_UINT64_C(0x0000000000000001) },
+    { Q_UINT64_C(0xa000000000000000), Q_UINT64_C(0x0000000000000001) },
+    { Q_UINT64_C(0xc800000000000000), Q_UINT64_C(0x0000000000000001) },
+    { Q_UINT64_C(0xfa00000000000000), Q_UINT64_C(0x0000000000000001) },
+    { Q_UINT64_C(0x9c40000000000000), Q_UINT64_C(0x0000000000000001) },
+    { Q_UINT64_C(0xc350000000000000), Q_UINT64_C(0x0000000000000001) },
+    { Q_UINT64_C(0xf424000000000000), Q_UINT64_C(0x0000000000000001) },
+    { Q_UINT64_C(0x9896800000000000), Q_UINT64_C(0x0000000000000001) },
+    { Q_UINT64_C(0xbebc200000000000), Q_UINT64_C(0x0000000000000001) },
+    { Q_UINT64_C(0xee6b280000000000), Q_UINT64_C(0x0000000000000001) },
+    { Q_UINT64_C(0x9502f90000000000), Q_UINT64_C(0x0000000000000001) },
+    { Q_UINT64_C(0xba43b74000000000), Q_UINT64_C(0x0000000000000001) },
+    { Q_UINT64_C(0xe8d4a51000000000), Q_UINT64_C(0x0000000000000001) },
+    { Q_UINT64_C(0x9184e72a00000000), Q_UINT64_C(0x0000000000000001) },
+    { Q_UINT64_C(0xb5e620f480000000), Q_UINT64_C(0x0000000000000001) },
+    { Q_UINT64_C(0xe35fa931a0000000), Q_UINT64_C(0x0000000000000001) },
+    { Q_UINT64_C(0x8e1bc9bf04000000), Q_UINT64_C(0x0000000000000001) },
+    { Q_UINT64_C(0xb1a2bc2ec5000000), Q_UINT64_C(0x0000000000000001) },
+    { Q_UINT64_C(0xde0b6b3a76400000), Q_UINT64_C(0x0000000000000001) },
+    { Q_UINT64_C(0x8ac7230489e80000), Q_UINT64_C(0x0000000000000001) },
+    { Q_UINT64_C(0xad78ebc5ac620000), Q_UINT64_C(0x0000000000000001) },
+    { Q_UINT64_C(0xd8d726b7177a8000), Q_UINT64_C(0x0000000000000001) },
+    { Q_UINT64_C(0x878678326eac9000), Q_UINT64_C(0x0000000000000001) },
+    { Q_UINT64_C(0xa968163f0a57b400), Q_UINT64_C(0x0000000000000001) },
+    { Q_UINT64_C(0xd3c21bcecceda100), Q_UINT64_C(0x0000000000000001) },
+    { Q_UINT64_C(0x84595161401484a0), Q_UINT64_C(0x0000000000000001) },
+    { Q_UINT64_C(0xa56fa5b99019a5c8), Q_UINT64_C(0x0000000000000001) },
+    { Q_UINT64_C(0xcecb8f27f4200f3a), Q_UINT64_C(0x0000000000000001) },
+    { Q_UINT64_C(0x813f3978f8940984), Q_UINT64_C(0x4000000000000001) },
+    { Q_UINT64_C(0xa18f07d736b90be5), Q_UINT64_C(0x5000000000000001) },
+    { Q_UINT64_C(0xc9f2c9cd04674ede), Q_UINT64_C(0xa400000000000001) },
+    { Q_UINT64_C(0xfc6f7c4045812296), Q_UINT64_C(0x4d00000000000001) },
+    { Q_UINT64_C(0x9dc5ada82b70b59d), Q_UINT64_C(0xf020000000000001) },
+    { Q_UINT64_C(0xc5371912364ce305), Q_UINT64_C(0x6c28000000000001) },
+    { Q_UINT64_C(0xf684df56c3e01bc6), Q_UINT64_C(0xc732000000000001) },
+    { Q_UINT64_C(0x9a130b963a6c115c), Q_UINT64_C(0x3c7f400000000001) },
+    { Q_UINT64_C(0xc097ce7bc90715b3), Q_UINT64_C(0x4b9f100000000001) },
+    { Q_UINT64_C(0xf0bdc21abb48db20), Q_UINT64_C(0x1e86d40000000001) },
+    { Q_UINT64_C(0x96769950b50d88f4), Q_UINT64_C(0x1314448000000001) },
+    { Q_UINT64_C(0xbc143fa4e250eb31), Q_UINT64_C(0x17d955a000000001) },
+    { Q_UINT64_C(0xeb194f8e1ae525fd), Q_UINT64_C(0x5dcfab0800000001) },
+    { Q_UINT64_C(0x92efd1b8d0cf37be), Q_UINT64_C(0x5aa1cae500000001) },
+    { Q_UINT64_C(0xb7abc627050305ad), Q_UINT64_C(0xf14a3d9e40000001) },
+    { Q_UINT64_C(0xe596b7b0c643c719), Q_UINT64_C(0x6d9ccd05d0000001) },
+    { Q_UINT64_C(0x8f7e32ce7bea5c6f), Q_UINT64_C(0xe4820023a2000001) },
+    { Q_UINT64_C(0xb35dbf821ae4f38b), Q_UINT64_C(0xdda2802c8a800001) },
+    { Q_UINT64_C(0xe0352f62a19e306e), Q_UINT64_C(0xd50b2037ad200001) },
+    { Q_UINT64_C(0x8c213d9da502de45), Q_UINT64_C(0x4526f422cc340001) },
+    { Q_UINT64_C(0xaf298d050e4395d6), Q_UINT64_C(0x9670b12b7f410001) },
+    { Q_UINT64_C(0xdaf3f04651d47b4c), Q_UINT64_C(0x3c0cdd765f114001) },
+    { Q_UINT64_C(0x88d8762bf324cd0f), Q_UINT64_C(0xa5880a69fb6ac801) },
+    { Q_UINT64_C(0xab0e93b6efee0053), Q_UINT64_C(0x8eea0d047a457a01) },
+    { Q_UINT64_C(0xd5d238a4abe98068), Q_UINT64_C(0x72a4904598d6d881) },
+    { Q_UINT64_C(0x85a36366eb71f041), Q_UINT64_C(0x47a6da2b7f864751) },
+    { Q_UINT64_C(0xa70c3c40a64e6c51), Q_UINT64_C(0x999090b65f67d925) },
+    { Q_UINT64_C(0xd0cf4b50cfe20765), Q_UINT64_C(0xfff4b4e3f741cf6e) },
+    { Q_UINT64_C(0x82818f1281ed449f), Q_UINT64_C(0xbff8f10e7a8921a5) },
+    { Q_UINT64_C(0xa321f2d7226895c7), Q_UINT64_C(0xaff72d52192b6a0e) },
+    { Q_UINT64_C(0xcbea6f8ceb02bb39), Q_UINT64_C(0x9bf4f8a69f764491) },
+    { Q_UINT64_C(0xfee50b7025c36a08), Q_UINT64_C(0x02f236d04753d5b5) },
+    { Q_UINT64_C(0x9f4f2726179a2245), Q_UINT64_C(0x01d762422c946591) },
+    { Q_UINT64_C(0xc722f0ef9d80aad6), Q_UINT64_C(0x424d3ad2b7b97ef6) },
+    { Q_UINT64_C(0xf8ebad2b84e0d58b), Q_UINT64_C(0xd2e0898765a7deb3) },
+    { Q_UINT64_C(0x9b934c3b330c8577), Q_UINT64_C(0x63cc55f49f88eb30) },
+    { Q_UINT64_C(0xc2781f49ffcfa6d5), Q_UINT64_C(0x3cbf6b71c76b25fc) },
+    { Q_UINT64_C(0xf316271c7fc3908a), Q_UINT64_C(0x8bef464e3945ef7b) },
+    { Q_UINT64_C(0x97edd871cfda3a56), Q_UINT64_C(0x97758bf0e3cbb5ad) },
+    { Q_UINT64_C(0xbde94e8e43d0c8ec), Q_UINT64_C(0x3d52eeed1cbea318) },
+    { Q_UINT64_C(0xed63a231d4c4fb27), Q_UINT64_C(0x4ca7aaa863ee4bde) },
+    { Q_UINT64_C(0x945e455f24fb1cf8), Q_UINT64_C(0x8fe8caa93e74ef6b) },
+    { Q_UINT64_C(0xb975d6b6ee39e436), Q_UINT64_C(0xb3e2fd538e122b45) },
+    { Q_UINT64_C(0xe7d34c64a9c85d44), Q_UINT64_C(0x60dbbca87196b617) },
+    { Q_UINT64_C(0x90e40fbeea1d3a4a), Q_UINT64_C(0xbc8955e946fe31ce) },
+    { Q_UINT64_C(0xb51d13aea4a488dd), Q_UINT64_C(0x6babab6398bdbe42) },
+    { Q_UINT64_C(0xe264589a4dcdab14), Q_UINT64_C(0xc696963c7eed2dd2) },
+    { Q_UINT64_C(0x8d7eb76070a08aec), Q_UINT64_C(0xfc1e1de5cf543ca3) },
+    { Q_UINT64_C(0xb0de65388cc8ada8), Q_UINT64_C(0x3b25a55f43294bcc) },
+    { Q_UINT64_C(0xdd15fe86affad912), Q_UINT64_C(0x49ef0eb713f39ebf) },
+    { Q_UINT64_C(0x8a2dbf142dfcc7ab), Q_UINT64_C(0x6e3569326c784338) },
+    { Q_UINT64_C(0xacb92ed9397bf996), Q_UINT64_C(0x49c2c37f07965405) },
+    { Q_UINT64_C(0xd7e77a8f87daf7fb), Q_UINT64_C(0xdc33745ec97be907) },
+    { Q_UINT64_C(0x86f0ac99b4e8dafd), Q_UINT64_C(0x69a028bb3ded71a4) },
+    { Q_UINT64_C(0xa8acd7c0222311bc), Q_UINT64_C(0xc40832ea0d68ce0d) },
+    { Q_UINT64_C(0xd2d80db02aabd62b), Q_UINT64_C(0xf50a3fa490c30191) },
+    { Q_UINT64_C(0x83c7088e1aab65db), Q_UINT64_C(0x792667c6da79e0fb) },
+    { Q_UINT64_C(0xa4b8cab1a1563f52), Q_UINT64_C(0x577001b891185939) },
+    { Q_UINT64_C(0xcde6fd5e09abcf26), Q_UINT64_C(0xed4c0226b55e6f87) },
+    { Q_UINT64_C(0x80b05e5ac60b6178), Q_UINT64_C(0x544f8158315b05b5) },
+    { Q_UINT64_C(0xa0dc75f1778e39d6), Q_UINT64_C(0x696361ae3db1c722) },
+    { Q_UINT64_C(0xc913936dd571c84c), Q_UINT64_C(0x03bc3a19cd1e38ea) },
+    { Q_UINT64_C(0xfb5878494ace3a5f), Q_UINT64_C(0x04ab48a04065c724) },
+    { Q_UINT64_C(0x9d174b2dcec0e47b), Q_UINT64_C(0x62eb0d64283f9c77) },
+    { Q_UINT64_C(0xc45d1df942711d9a), Q_UINT64_C(0x3ba5d0bd324f8395) },
+    { Q_UINT64_C(0xf5746577930d6500), Q_UINT64_C(0xca8f44ec7ee3647a) },
+    { Q_UINT64_C(0x9968bf6abbe85f20), Q_UINT64_C(0x7e998b13cf4e1ecc) },
+    { Q_UINT64_C(0xbfc2ef456ae276e8), Q_UINT64_C(0x9e3fedd8c321a67f) },
+    { Q_UINT64_C(0xefb3ab16c59b14a2), Q_UINT64_C(0xc5cfe94ef3ea101f) },
+    { Q_UINT64_C(0x95d04aee3b80ece5), Q_UINT64_C(0xbba1f1d158724a13) },
+    { Q_UINT64_C(0xbb445da9ca61281f), Q_UINT64_C(0x2a8a6e45ae8edc98) },
+    { Q_UINT64_C(0xea1575143cf97226), Q_UINT64_C(0xf52d09d71a3293be) },
+    { Q_UINT64_C(0x924d692ca61be758), Q_UINT64_C(0x593c2626705f9c57) },
+    { Q_UINT64_C(0xb6e0c377cfa2e12e), Q_UINT64_C(0x6f8b2fb00c77836d) },
+    { Q_UINT64_C(0xe498f455c38b997a), Q_UINT64_C(0x0b6dfb9c0f956448) },
+    { Q_UINT64_C(0x8edf98b59a373fec), Q_UINT64_C(0x4724bd4189bd5ead) },
+    { Q_UINT64_C(0xb2977ee300c50fe7), Q_UINT64_C(0x58edec91ec2cb658) },
+    { Q_UINT64_C(0xdf3d5e9bc0f653e1), Q_UINT64_C(0x2f2967b66737e3ee) },
+    { Q_UINT64_C(0x8b865b215899f46c), Q_UINT64_C(0xbd79e0d20082ee75) },
+    { Q_UINT64_C(0xae67f1e9aec07187), Q_UINT64_C(0xecd8590680a3aa12) },
+    { Q_UINT64_C(0xda01ee641a708de9), Q_UINT64_C(0xe80e6f4820cc9496) },
+    { Q_UINT64_C(0x884134fe908658b2), Q_UINT64_C(0x3109058d147fdcde) },
+    { Q_UINT64_C(0xaa51823e34a7eede), Q_UINT64_C(0xbd4b46f0599fd416) },
+    { Q_UINT64_C(0xd4e5e2cdc1d1ea96), Q_UINT64_C(0x6c9e18ac7007c91b) },
+    { Q_UINT64_C(0x850fadc09923329e), Q_UINT64_C(0x03e2cf6bc604ddb1) },
+    { Q_UINT64_C(0xa6539930bf6bff45), Q_UINT64_C(0x84db8346b786151d) },
+    { Q_UINT64_C(0xcfe87f7cef46ff16), Q_UINT64_C(0xe612641865679a64) },
+    { Q_UINT64_C(0x81f14fae158c5f6e), Q_UINT64_C(0x4fcb7e8f3f60c07f) },
+    { Q_UINT64_C(0xa26da3999aef7749), Q_UINT64_C(0xe3be5e330f38f09e) },
+    { Q_UINT64_C(0xcb090c8001ab551c), Q_UINT64_C(0x5cadf5bfd3072cc6) },
+    { Q_UINT64_C(0xfdcb4fa002162a63), Q_UINT64_C(0x73d9732fc7c8f7f7) },
+    { Q_UINT64_C(0x9e9f11c4014dda7e), Q_UINT64_C(0x2867e7fddcdd9afb) },
+    { Q_UINT64_C(0xc646d63501a1511d), Q_UINT64_C(0xb281e1fd541501b9) },
+    { Q_UINT64_C(0xf7d88bc24209a565), Q_UINT64_C(0x1f225a7ca91a4227) },
+    { Q_UINT64_C(0x9ae757596946075f), Q_UINT64_C(0x3375788de9b06959) },
+    { Q_UINT64_C(0xc1a12d2fc3978937), Q_UINT64_C(0x0052d6b1641c83af) },
+    { Q_UINT64_C(0xf209787bb47d6b84), Q_UINT64_C(0xc0678c5dbd23a49b) },
+    { Q_UINT64_C(0x9745eb4d50ce6332), Q_UINT64_C(0xf840b7ba963646e1) },
+    { Q_UINT64_C(0xbd176620a501fbff), Q_UINT64_C(0xb650e5a93bc3d899) },
+    { Q_UINT64_C(0xec5d3fa8ce427aff), Q_UINT64_C(0xa3e51f138ab4cebf) },
+    { Q_UINT64_C(0x93ba47c980e98cdf), Q_UINT64_C(0xc66f336c36b10138) },
+    { Q_UINT64_C(0xb8a8d9bbe123f017), Q_UINT64_C(0xb80b0047445d4185) },
+    { Q_UINT64_C(0xe6d3102ad96cec1d), Q_UINT64_C(0xa60dc059157491e6) },
+    { Q_UINT64_C(0x9043ea1ac7e41392), Q_UINT64_C(0x87c89837ad68db30) },
+    { Q_UINT64_C(0xb454e4a179dd1877), Q_UINT64_C(0x29babe4598c311fc) },
+    { Q_UINT64_C(0xe16a1dc9d8545e94), Q_UINT64_C(0xf4296dd6fef3d67b) },
+    { Q_UINT64_C(0x8ce2529e2734bb1d), Q_UINT64_C(0x1899e4a65f58660d) },
+    { Q_UINT64_C(0xb01ae745b101e9e4), Q_UINT64_C(0x5ec05dcff72e7f90) },
+    { Q_UINT64_C(0xdc21a1171d42645d), Q_UINT64_C(0x76707543f4fa1f74) },
+    { Q_UINT64_C(0x899504ae72497eba), Q_UINT64_C(0x6a06494a791c53a9) },
+    { Q_UINT64_C(0xabfa45da0edbde69), Q_UINT64_C(0x0487db9d17636893) },
+    { Q_UINT64_C(0xd6f8d7509292d603), Q_UINT64_C(0x45a9d2845d3c42b7) },
+    { Q_UINT64_C(0x865b86925b9bc5c2), Q_UINT64_C(0x0b8a2392ba45a9b3) },
+    { Q_UINT64_C(0xa7f26836f282b732), Q_UINT64_C(0x8e6cac7768d7141f) },
+    { Q_UINT64_C(0xd1ef0244af2364ff), Q_UINT64_C(0x3207d795430cd927) },
+    { Q_UINT64_C(0x8335616aed761f1f), Q_UINT64_C(0x7f44e6bd49e807b9) },
+    { Q_UINT64_C(0xa402b9c5a8d3a6e7), Q_UINT64_C(0x5f16206c9c6209a7) },
+    { Q_UINT64_C(0xcd036837130890a1), Q_UINT64_C(0x36dba887c37a8c10) },
+    { Q_UINT64_C(0x802221226be55a64), Q_UINT64_C(0xc2494954da2c978a) },
+    { Q_UINT64_C(0xa02aa96b06deb0fd), Q_UINT64_C(0xf2db9baa10b7bd6d) },
+    { Q_UINT64_C(0xc83553c5c8965d3d), Q_UINT64_C(0x6f92829494e5acc8) },
+    { Q_UINT64_C(0xfa42a8b73abbf48c), Q_UINT64_C(0xcb772339ba1f17fa) },
+    { Q_UINT64_C(0x9c69a97284b578d7), Q_UINT64_C(0xff2a760414536efc) },
+    { Q_UINT64_C(0xc38413cf25e2d70d), Q_UINT64_C(0xfef5138519684abb) },
+    { Q_UINT64_C(0xf46518c2ef5b8cd1), Q_UINT64_C(0x7eb258665fc25d6a) },
+    { Q_UINT64_C(0x98bf2f79d5993802), Q_UINT64_C(0xef2f773ffbd97a62) },
+    { Q_UINT64_C(0xbeeefb584aff8603), Q_UINT64_C(0xaafb550ffacfd8fb) },
+    { Q_UINT64_C(0xeeaaba2e5dbf6784), Q_UINT64_C(0x95ba2a53f983cf39) },
+    { Q_UINT64_C(0x952ab45cfa97a0b2), Q_UINT64_C(0xdd945a747bf26184) },
+    { Q_UINT64_C(0xba756174393d88df), Q_UINT64_C(0x94f971119aeef9e5) },
+    { Q_UINT64_C(0xe912b9d1478ceb17), Q_UINT64_C(0x7a37cd5601aab85e) },
+    { Q_UINT64_C(0x91abb422ccb812ee), Q_UINT64_C(0xac62e055c10ab33b) },
+    { Q_UINT64_C(0xb616a12b7fe617aa), Q_UINT64_C(0x577b986b314d600a) },
+    { Q_UINT64_C(0xe39c49765fdf9d94), Q_UINT64_C(0xed5a7e85fda0b80c) },
+    { Q_UINT64_C(0x8e41ade9fbebc27d), Q_UINT64_C(0x14588f13be847308) },
+    { Q_UINT64_C(0xb1d219647ae6b31c), Q_UINT64_C(0x596eb2d8ae258fc9) },
+    { Q_UINT64_C(0xde469fbd99a05fe3), Q_UINT64_C(0x6fca5f8ed9aef3bc) },
+    { Q_UINT64_C(0x8aec23d680043bee), Q_UINT64_C(0x25de7bb9480d5855) },
+    { Q_UINT64_C(0xada72ccc20054ae9), Q_UINT64_C(0xaf561aa79a10ae6b) },
+    { Q_UINT64_C(0xd910f7ff28069da4), Q_UINT64_C(0x1b2ba1518094da05) },
+    { Q_UINT64_C(0x87aa9aff79042286), Q_UINT64_C(0x90fb44d2f05d0843) },
+    { Q_UINT64_C(0xa99541bf57452b28), Q_UINT64_C(0x353a1607ac744a54) },
+    { Q_UINT64_C(0xd3fa922f2d1675f2), Q_UINT64_C(0x42889b8997915ce9) },
+    { Q_UINT64_C(0x847c9b5d7c2e09b7), Q_UINT64_C(0x69956135febada12) },
+    { Q_UINT64_C(0xa59bc234db398c25), Q_UINT64_C(0x43fab9837e699096) },
+    { Q_UINT64_C(0xcf02b2c21207ef2e), Q_UINT64_C(0x94f967e45e03f4bc) },
+    { Q_UINT64_C(0x8161afb94b44f57d), Q_UINT64_C(0x1d1be0eebac278f6) },
+    { Q_UINT64_C(0xa1ba1ba79e1632dc), Q_UINT64_C(0x6462d92a69731733) },
+    { Q_UINT64_C(0xca28a291859bbf93), Q_UINT64_C(0x7d7b8f7503cfdcff) },
+    { Q_UINT64_C(0xfcb2cb35e702af78), Q_UINT64_C(0x5cda735244c3d43f) },
+    { Q_UINT64_C(0x9defbf01b061adab), Q_UINT64_C(0x3a0888136afa64a8) },
+    { Q_UINT64_C(0xc56baec21c7a1916), Q_UINT64_C(0x088aaa1845b8fdd1) },
+    { Q_UINT64_C(0xf6c69a72a3989f5b), Q_UINT64_C(0x8aad549e57273d46) },
+    { Q_UINT64_C(0x9a3c2087a63f6399), Q_UINT64_C(0x36ac54e2f678864c) },
+    { Q_UINT64_C(0xc0cb28a98fcf3c7f), Q_UINT64_C(0x84576a1bb416a7de) },
+    { Q_UINT64_C(0xf0fdf2d3f3c30b9f), Q_UINT64_C(0x656d44a2a11c51d6) },
+    { Q_UINT64_C(0x969eb7c47859e743), Q_UINT64_C(0x9f644ae5a4b1b326) },
+    { Q_UINT64_C(0xbc4665b596706114), Q_UINT64_C(0x873d5d9f0dde1fef) },
+    { Q_UINT64_C(0xeb57ff22fc0c7959), Q_UINT64_C(0xa90cb506d155a7eb) },
+    { Q_UINT64_C(0x9316ff75dd87cbd8), Q_UINT64_C(0x09a7f12442d588f3) },
+    { Q_UINT64_C(0xb7dcbf5354e9bece), Q_UINT64_C(0x0c11ed6d538aeb30) },
+    { Q_UINT64_C(0xe5d3ef282a242e81), Q_UINT64_C(0x8f1668c8a86da5fb) },
+    { Q_UINT64_C(0x8fa475791a569d10), Q_UINT64_C(0xf96e017d694487bd) },
+    { Q_UINT64_C(0xb38d92d760ec4455), Q_UINT64_C(0x37c981dcc395a9ad) },
+    { Q_UINT64_C(0xe070f78d3927556a), Q_UINT64_C(0x85bbe253f47b1418) },
+    { Q_UINT64_C(0x8c469ab843b89562), Q_UINT64_C(0x93956d7478ccec8f) },
+    { Q_UINT64_C(0xaf58416654a6babb), Q_UINT64_C(0x387ac8d1970027b3) },
+    { Q_UINT64_C(0xdb2e51bfe9d0696a), Q_UINT64_C(0x06997b05fcc0319f) },
+    { Q_UINT64_C(0x88fcf317f22241e2), Q_UINT64_C(0x441fece3bdf81f04) },
+    { Q_UINT64_C(0xab3c2fddeeaad25a), Q_UINT64_C(0xd527e81cad7626c4) },
+    { Q_UINT64_C(0xd60b3bd56a5586f1), Q_UINT64_C(0x8a71e223d8d3b075) },
+    { Q_UINT64_C(0x85c7056562757456), Q_UINT64_C(0xf6872d5667844e4a) },
+    { Q_UINT64_C(0xa738c6bebb12d16c), Q_UINT64_C(0xb428f8ac016561dc) },
+    { Q_UINT64_C(0xd106f86e69d785c7), Q_UINT64_C(0xe13336d701beba53) },
+    { Q_UINT64_C(0x82a45b450226b39c), Q_UINT64_C(0xecc0024661173474) },
+    { Q_UINT64_C(0xa34d721642b06084), Q_UINT64_C(0x27f002d7f95d0191) },
+    { Q_UINT64_C(0xcc20ce9bd35c78a5), Q_UINT64_C(0x31ec038df7b441f5) },
+    { Q_UINT64_C(0xff290242c83396ce), Q_UINT64_C(0x7e67047175a15272) },
+    { Q_UINT64_C(0x9f79a169bd203e41), Q_UINT64_C(0x0f0062c6e984d387) },
+    { Q_UINT64_C(0xc75809c42c684dd1), Q_UINT64_C(0x52c07b78a3e60869) },
+    { Q_UINT64_C(0xf92e0c3537826145), Q_UINT64_C(0xa7709a56ccdf8a83) },
+    { Q_UINT64_C(0x9bbcc7a142b17ccb), Q_UINT64_C(0x88a66076400bb692) },
+    { Q_UINT64_C(0xc2abf989935ddbfe), Q_UINT64_C(0x6acff893d00ea436) },
+    { Q_UINT64_C(0xf356f7ebf83552fe), Q_UINT64_C(0x0583f6b8c4124d44) },
+    { Q_UINT64_C(0x98165af37b2153de), Q_UINT64_C(0xc3727a337a8b704b) },
+    { Q_UINT64_C(0xbe1bf1b059e9a8d6), Q_UINT64_C(0x744f18c0592e4c5d) },
+    { Q_UINT64_C(0xeda2ee1c7064130c), Q_UINT64_C(0x1162def06f79df74) },
+    { Q_UINT64_C(0x9485d4d1c63e8be7), Q_UINT64_C(0x8addcb5645ac2ba9) },
+    { Q_UINT64_C(0xb9a74a0637ce2ee1), Q_UINT64_C(0x6d953e2bd7173693) },
+    { Q_UINT64_C(0xe8111c87c5c1ba99), Q_UINT64_C(0xc8fa8db6ccdd0438) },
+    { Q_UINT64_C(0x910ab1d4db9914a0), Q_UINT64_C(0x1d9c9892400a22a3) },
+    { Q_UINT64_C(0xb54d5e4a127f59c8), Q_UINT64_C(0x2503beb6d00cab4c) },
+    { Q_UINT64_C(0xe2a0b5dc971f303a), Q_UINT64_C(0x2e44ae64840fd61e) },
+    { Q_UINT64_C(0x8da471a9de737e24), Q_UINT64_C(0x5ceaecfed289e5d3) },
+    { Q_UINT64_C(0xb10d8e1456105dad), Q_UINT64_C(0x7425a83e872c5f48) },
+    { Q_UINT64_C(0xdd50f1996b947518), Q_UINT64_C(0xd12f124e28f7771a) },
+    { Q_UINT64_C(0x8a5296ffe33cc92f), Q_UINT64_C(0x82bd6b70d99aaa70) },
+    { Q_UINT64_C(0xace73cbfdc0bfb7b), Q_UINT64_C(0x636cc64d1001550c) },
+    { Q_UINT64_C(0xd8210befd30efa5a), Q_UINT64_C(0x3c47f7e05401aa4f) },
+    { Q_UINT64_C(0x8714a775e3e95c78), Q_UINT64_C(0x65acfaec34810a72) },
+    { Q_UINT64_C(0xa8d9d1535ce3b396), Q_UINT64_C(0x7f1839a741a14d0e) },
+    { Q_UINT64_C(0xd31045a8341ca07c), Q_UINT64_C(0x1ede48111209a051) },
+    { Q_UINT64_C(0x83ea2b892091e44d), Q_UINT64_C(0x934aed0aab460433) },
+    { Q_UINT64_C(0xa4e4b66b68b65d60), Q_UINT64_C(0xf81da84d56178540) },
+    { Q_UINT64_C(0xce1de40642e3f4b9), Q_UINT64_C(0x36251260ab9d668f) },
+    { Q_UINT64_C(0x80d2ae83e9ce78f3), Q_UINT64_C(0xc1d72b7c6b42601a) },
+    { Q_UINT64_C(0xa1075a24e4421730), Q_UINT64_C(0xb24cf65b8612f820) },
+    { Q_UINT64_C(0xc94930ae1d529cfc), Q_UINT64_C(0xdee033f26797b628) },
+    { Q_UINT64_C(0xfb9b7cd9a4a7443c), Q_UINT64_C(0x169840ef017da3b2) },
+    { Q_UINT64_C(0x9d412e0806e88aa5), Q_UINT64_C(0x8e1f289560ee864f) },
+    { Q_UINT64_C(0xc491798a08a2ad4e), Q_UINT64_C(0xf1a6f2bab92a27e3) },
+    { Q_UINT64_C(0xf5b5d7ec8acb58a2), Q_UINT64_C(0xae10af696774b1dc) },
+    { Q_UINT64_C(0x9991a6f3d6bf1765), Q_UINT64_C(0xacca6da1e0a8ef2a) },
+    { Q_UINT64_C(0xbff610b0cc6edd3f), Q_UINT64_C(0x17fd090a58d32af4) },
+    { Q_UINT64_C(0xeff394dcff8a948e), Q_UINT64_C(0xddfc4b4cef07f5b1) },
+    { Q_UINT64_C(0x95f83d0a1fb69cd9), Q_UINT64_C(0x4abdaf101564f98f) },
+    { Q_UINT64_C(0xbb764c4ca7a4440f), Q_UINT64_C(0x9d6d1ad41abe37f2) },
+    { Q_UINT64_C(0xea53df5fd18d5513), Q_UINT64_C(0x84c86189216dc5ee) },
+    { Q_UINT64_C(0x92746b9be2f8552c), Q_UINT64_C(0x32fd3cf5b4e49bb5) },
+    { Q_UINT64_C(0xb7118682dbb66a77), Q_UINT64_C(0x3fbc8c33221dc2a2) },
+    { Q_UINT64_C(0xe4d5e82392a40515), Q_UINT64_C(0x0fabaf3feaa5334b) },
+    { Q_UINT64_C(0x8f05b1163ba6832d), Q_UINT64_C(0x29cb4d87f2a7400f) },
+    { Q_UINT64_C(0xb2c71d5bca9023f8), Q_UINT64_C(0x743e20e9ef511013) },
+    { Q_UINT64_C(0xdf78e4b2bd342cf6), Q_UINT64_C(0x914da9246b255417) },
+    { Q_UINT64_C(0x8bab8eefb6409c1a), Q_UINT64_C(0x1ad089b6c2f7548f) },
+    { Q_UINT64_C(0xae9672aba3d0c320), Q_UINT64_C(0xa184ac2473b529b2) },
+    { Q_UINT64_C(0xda3c0f568cc4f3e8), Q_UINT64_C(0xc9e5d72d90a2741f) },
+    { Q_UINT64_C(0x8865899617fb1871), Q_UINT64_C(0x7e2fa67c7a658893) },
+    { Q_UINT64_C(0xaa7eebfb9df9de8d), Q_UINT64_C(0xddbb901b98feeab8) },
+    { Q_UINT64_C(0xd51ea6fa85785631), Q_UINT64_C(0x552a74227f3ea566) },
+    { Q_UINT64_C(0x8533285c936b35de), Q_UINT64_C(0xd53a88958f872760) },
+    { Q_UINT64_C(0xa67ff273b8460356), Q_UINT64_C(0x8a892abaf368f138) },
+    { Q_UINT64_C(0xd01fef10a657842c), Q_UINT64_C(0x2d2b7569b0432d86) },
+    { Q_UINT64_C(0x8213f56a67f6b29b), Q_UINT64_C(0x9c3b29620e29fc74) },
+    { Q_UINT64_C(0xa298f2c501f45f42), Q_UINT64_C(0x8349f3ba91b47b90) },
+    { Q_UINT64_C(0xcb3f2f7642717713), Q_UINT64_C(0x241c70a936219a74) },
+    { Q_UINT64_C(0xfe0efb53d30dd4d7), Q_UINT64_C(0xed238cd383aa0111) },
+    { Q_UINT64_C(0x9ec95d1463e8a506), Q_UINT64_C(0xf4363804324a40ab) },
+    { Q_UINT64_C(0xc67bb4597ce2ce48), Q_UINT64_C(0xb143c6053edcd0d6) },
+    { Q_UINT64_C(0xf81aa16fdc1b81da), Q_UINT64_C(0xdd94b7868e94050b) },
+    { Q_UINT64_C(0x9b10a4e5e9913128), Q_UINT64_C(0xca7cf2b4191c8327) },
+    { Q_UINT64_C(0xc1d4ce1f63f57d72), Q_UINT64_C(0xfd1c2f611f63a3f1) },
+    { Q_UINT64_C(0xf24a01a73cf2dccf), Q_UINT64_C(0xbc633b39673c8ced) },
+    { Q_UINT64_C(0x976e41088617ca01), Q_UINT64_C(0xd5be0503e085d814) },
+    { Q_UINT64_C(0xbd49d14aa79dbc82), Q_UINT64_C(0x4b2d8644d8a74e19) },
+    { Q_UINT64_C(0xec9c459d51852ba2), Q_UINT64_C(0xddf8e7d60ed1219f) },
+    { Q_UINT64_C(0x93e1ab8252f33b45), Q_UINT64_C(0xcabb90e5c942b504) },
+    { Q_UINT64_C(0xb8da1662e7b00a17), Q_UINT64_C(0x3d6a751f3b936244) },
+    { Q_UINT64_C(0xe7109bfba19c0c9d), Q_UINT64_C(0x0cc512670a783ad5) },
+    { Q_UINT64_C(0x906a617d450187e2), Q_UINT64_C(0x27fb2b80668b24c6) },
+    { Q_UINT64_C(0xb484f9dc9641e9da), Q_UINT64_C(0xb1f9f660802dedf7) },
+    { Q_UINT64_C(0xe1a63853bbd26451), Q_UINT64_C(0x5e7873f8a0396974) },
+    { Q_UINT64_C(0x8d07e33455637eb2), Q_UINT64_C(0xdb0b487b6423e1e9) },
+    { Q_UINT64_C(0xb049dc016abc5e5f), Q_UINT64_C(0x91ce1a9a3d2cda63) },
+    { Q_UINT64_C(0xdc5c5301c56b75f7), Q_UINT64_C(0x7641a140cc7810fc) },
+    { Q_UINT64_C(0x89b9b3e11b6329ba), Q_UINT64_C(0xa9e904c87fcb0a9e) },
+    { Q_UINT64_C(0xac2820d9623bf429), Q_UINT64_C(0x546345fa9fbdcd45) },
+    { Q_UINT64_C(0xd732290fbacaf133), Q_UINT64_C(0xa97c177947ad4096) },
+    { Q_UINT64_C(0x867f59a9d4bed6c0), Q_UINT64_C(0x49ed8eabcccc485e) },
+    { Q_UINT64_C(0xa81f301449ee8c70), Q_UINT64_C(0x5c68f256bfff5a75) },
+    { Q_UINT64_C(0xd226fc195c6a2f8c), Q_UINT64_C(0x73832eec6fff3112) },
+    { Q_UINT64_C(0x83585d8fd9c25db7), Q_UINT64_C(0xc831fd53c5ff7eac) },
+    { Q_UINT64_C(0xa42e74f3d032f525), Q_UINT64_C(0xba3e7ca8b77f5e56) },
+    { Q_UINT64_C(0xcd3a1230c43fb26f), Q_UINT64_C(0x28ce1bd2e55f35ec) },
+    { Q_UINT64_C(0x80444b5e7aa7cf85), Q_UINT64_C(0x7980d163cf5b81b4) },
+    { Q_UINT64_C(0xa0555e361951c366), Q_UINT64_C(0xd7e105bcc3326220) },
+    { Q_UINT64_C(0xc86ab5c39fa63440), Q_UINT64_C(0x8dd9472bf3fefaa8) },
+    { Q_UINT64_C(0xfa856334878fc150), Q_UINT64_C(0xb14f98f6f0feb952) },
+    { Q_UINT64_C(0x9c935e00d4b9d8d2), Q_UINT64_C(0x6ed1bf9a569f33d4) },
+    { Q_UINT64_C(0xc3b8358109e84f07), Q_UINT64_C(0x0a862f80ec4700c9) },
+    { Q_UINT64_C(0xf4a642e14c6262c8), Q_UINT64_C(0xcd27bb612758c0fb) },
+    { Q_UINT64_C(0x98e7e9cccfbd7dbd), Q_UINT64_C(0x8038d51cb897789d) },
+    { Q_UINT64_C(0xbf21e44003acdd2c), Q_UINT64_C(0xe0470a63e6bd56c4) },
+    { Q_UINT64_C(0xeeea5d5004981478), Q_UINT64_C(0x1858ccfce06cac75) },
+    { Q_UINT64_C(0x95527a5202df0ccb), Q_UINT64_C(0x0f37801e0c43ebc9) },
+    { Q_UINT64_C(0xbaa718e68396cffd), Q_UINT64_C(0xd30560258f54e6bb) },
+    { Q_UINT64_C(0xe950df20247c83fd), Q_UINT64_C(0x47c6b82ef32a206a) },
+    { Q_UINT64_C(0x91d28b7416cdd27e), Q_UINT64_C(0x4cdc331d57fa5442) },
+    { Q_UINT64_C(0xb6472e511c81471d), Q_UINT64_C(0xe0133fe4adf8e953) },
+    { Q_UINT64_C(0xe3d8f9e563a198e5), Q_UINT64_C(0x58180fddd97723a7) },
+    { Q_UINT64_C(0x8e679c2f5e44ff8f), Q_UINT64_C(0x570f09eaa7ea7649) },
+    { Q_UINT64_C(0xb201833b35d63f73), Q_UINT64_C(0x2cd2cc6551e513db) },
+    { Q_UINT64_C(0xde81e40a034bcf4f), Q_UINT64_C(0xf8077f7ea65e58d2) },
+    { Q_UINT64_C(0x8b112e86420f6191), Q_UINT64_C(0xfb04afaf27faf783) },
+    { Q_UINT64_C(0xadd57a27d29339f6), Q_UINT64_C(0x79c5db9af1f9b564) },
+    { Q_UINT64_C(0xd94ad8b1c7380874), Q_UINT64_C(0x18375281ae7822bd) },
+    { Q_UINT64_C(0x87cec76f1c830548), Q_UINT64_C(0x8f2293910d0b15b6) },
+    { Q_UINT64_C(0xa9c2794ae3a3c69a), Q_UINT64_C(0xb2eb3875504ddb23) },
+    { Q_UINT64_C(0xd433179d9c8cb841), Q_UINT64_C(0x5fa60692a46151ec) },
+    { Q_UINT64_C(0x849feec281d7f328), Q_UINT64_C(0xdbc7c41ba6bcd334) },
+    { Q_UINT64_C(0xa5c7ea73224deff3), Q_UINT64_C(0x12b9b522906c0801) },
+    { Q_UINT64_C(0xcf39e50feae16bef), Q_UINT64_C(0xd768226b34870a01) },
+    { Q_UINT64_C(0x81842f29f2cce375), Q_UINT64_C(0xe6a1158300d46641) },
+    { Q_UINT64_C(0xa1e53af46f801c53), Q_UINT64_C(0x60495ae3c1097fd1) },
+    { Q_UINT64_C(0xca5e89b18b602368), Q_UINT64_C(0x385bb19cb14bdfc5) },
+    { Q_UINT64_C(0xfcf62c1dee382c42), Q_UINT64_C(0x46729e03dd9ed7b6) },
+    { Q_UINT64_C(0x9e19db92b4e31ba9), Q_UINT64_C(0x6c07a2c26a8346d2) },
+};
+
+// floor(log2(10^e)) for e in [-1233, 1232]
+constexpr int floorLog2Pow10(int e)
+{
+    return (e * 1741647) >> 19;
+}
+
+// floor(log10(2^e)) for e in [-1100, 1100]
+constexpr int floorLog10Pow2(int e)
+{
+    return (e * 315653) >> 20;
+}
+
+// floor(log10(3/4 * 2^e)) for e in [-1100, 1100]
+constexpr int floorLog10ThreeQuartersPow2(int e)
+{
+    return (e * 315653 - 131237) >> 20;
+}
+
+// Returns floor(g * cp / 2^128), with the lowest bit set if that division
+// is inexact ("round to odd"), which keeps enough information to round the
+// product correctly later on.
+inline quint64 roundToOdd(UInt128 g, quint64 cp)
+{
+#if defined(QT_SUPPORTS_INT128)
+    const quint128 x = quint128(g.lo) * cp;
+    const quint128 y = quint128(g.hi) * cp + quint64(x >> 64);
+    const quint64 y0 = quint64(y);
+    const quint64 y1 = quint64(y >> 64);
+#else
+    const auto mul = [](quint64 a, quint64 b, quint64 *high) {
+#  if defined(Q_CC_MSVC) && defined(Q_PROCESSOR_X86_64)
+        return _umul128(a, b, high);
+#  else
+        const quint64 a0 = quint32(a), a1 = a >> 32;
+        const quint64 b0 = quint32(b), b1 = b >> 32;
+        const quint64 p00 = a0 * b0, p01 = a0 * b1, p10 = a1 * b0, p11 = a1 * b1;
+        const quint64 middle = p10 + (p00 >> 32) + quint32(p01);
+        *high = p11 + (middle >> 32) + (p01 >> 32);
+        return (middle << 32) | quint32(p00);
+#  endif
+    };
+    quint64 x1;
+    mul(g.lo, cp, &x1);
+    quint64 y1;
+    quint64 y0 = mul(g.hi, cp, &y1);
+    y0 += x1;
+    y1 += y0 < x1;
+#endif
+    return y1 | (y0 > 1);
+}
+
+// Computes the shortest decimal significand and exponent of the positive,
+// finite double with the given IEEE significand and biased exponent bits.
+inline void toDecimal(quint64 ieeeSignificand, int ieeeExponent, quint64 *significand, int *exponent)
+{
+    constexpr int SignificandBits = 52;
+    constexpr int ExponentBias = 1023 + SignificandBits;
+    constexpr quint64 HiddenBit = quint64(1) << SignificandBits;
+
+    quint64 c;
+    int q;
+    if (ieeeExponent != 0) {
+        c = HiddenBit | ieeeSignificand;
+        q = ieeeExponent - ExponentBias;
+        // integers below 2^53 need no work
+        if (0 <= -q && -q <= SignificandBits && (c & ((quint64(1) << -q) - 1)) == 0) {
+            *significand = c >> -q;
+            *exponent = 0;
+            return;
+        }
+    } else {
+        c = ieeeSignificand;
+        q = 1 - ExponentBias;
+    }
+
+    const bool isEven = (c % 2) == 0;
+    // the gap to the next lower double is half as large at powers of two
+    const bool lowerBoundaryIsCloser = ieeeSignificand == 0 && ieeeExponent > 1;
+
+    // the double and the halfway points to its neighbours, times 4
+    const quint64 cbl = 4 * c - 2 + lowerBoundaryIsCloser;
+    const quint64 cb = 4 * c;
+    const quint64 cbr = 4 * c + 2;
+
+    const int k = lowerBoundaryIsCloser ? floorLog10ThreeQuartersPow2(q) : floorLog10Pow2(q);
+    const int h = q + floorLog2Pow10(-k) + 1;
+    Q_ASSERT(h >= 1 && h <= 4);
+    Q_ASSERT(-k >= MinPow10 && -k <= MaxPow10);
+    const UInt128 pow10 = pow10Significands[-k - MinPow10];
+
+    // the same values scaled by 10^-k, rounded to odd
+    const quint64 vbl = roundToOdd(pow10, cbl << h);
+    const quint64 vb = roundToOdd(pow10, cb << h);
+    const quint64 vbr = roundToOdd(pow10, cbr << h);
+
+    // the rounding interval, closed if the significand is even
+    const quint64 lower = vbl + !isEven;
+    const quint64 upper = vbr - !isEven;
+
+    // Try one digit less first: if exactly one of the two candidates
+    // around the double lies in the rounding interval, it's the shortest.
+    const quint64 s = vb / 4;
+    if (s >= 10) {
+        const quint64 sp = s / 10;
+        const bool upInside = lower <= 40 * sp;
+        const bool wpInside = 40 * sp + 40 <= upper;
+        if (upInside != wpInside) {
+            *significand = sp + wpInside;
+            *exponent = k + 1;
+            return;
+        }
+    }
+
+    const bool uInside = lower <= 4 * s;
+    const bool wInside = 4 * s + 4 <= upper;
+    if (uInside != wInside) {
+        *significand = s + wInside;
+        *exponent = k;
+        return;
+    }
+
+    // both are inside, take the closer one, or the even one on a tie
+    const quint64 mid = 4 * s + 2;
+    const bool roundUp = vb > mid || (vb == mid && (s & 1) != 0);
+    *significand = s + roundUp;
+    *exponent = k;
+}
+
+} // unnamed namespace
+
+/*
+    Writes the shortest decimal digits that read back as \a d into \a buf,
+    in the same format as libdouble-conversion's DoubleToAscii() in SHORTEST
+    mode: \a length digits without trailing zeros followed by a '\0', a
+    decimal point after \a decpt of them, and \a sign set for negative
+    numbers, including -0. \a d must be finite and \a buf must hold at least
+    18 characters.
+*/
+void qt_doubleToShortestAscii(double d, char *buf, qsizetype bufSize,
+                              bool &sign, int &length, int &decpt)
+{
+    Q_ASSERT(qt_is_finite(d));
+    Q_ASSERT(bufSize > std::numeric_limits<double>::max_digits10);
+    Q_UNUSED(bufSize);
+
+    quint64 bits;
+    memcpy(&bits, &d, sizeof(bits));
+    sign = (bits >> 63) != 0;
+    const quint64 ieeeSignificand = bits & ((quint64(1) << 52) - 1);
+    const int ieeeExponent = int((bits >> 52) & 0x7ff);
+
+    if (ieeeExponent == 0 && ieeeSignificand == 0) {
+        buf[0] = '0';
+        buf[1] = '\0';
+        length = 1;
+        decpt = 1;
+        return;
+    }
+
+    quint64 significand;
+    int exponent;
+    toDecimal(ieeeSignificand, ieeeExponent, &significand, &exponent);
+
+    // strip trailing zeros, eight at a time first
+    if (significand % 100000000 == 0) {
+        significand /= 100000000;
+        exponent += 8;
+    }
+    while (significand % 10 == 0) {
+        significand /= 10;
+        ++exponent;
+    }
+
+    // at most 17 digits; write them back to front, two at a time
+    static constexpr char digitPairs[] =
+        "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+        "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+        "8081828384858687888990919293949596979899";
+    static constexpr quint64 powersOf10[] = {
+        Q_UINT64_C(10), Q_UINT64_C(100), Q_UINT64_C(1000), Q_UINT64_C(10000), Q_UINT64_C(100000),
+        Q_UINT64_C(1000000), Q_UINT64_C(10000000), Q_UINT64_C(100000000),
+        Q_UINT64_C(1000000000), Q_UINT64_C(10000000000), Q_UINT64_C(100000000000),
+        Q_UINT64_C(1000000000000), Q_UINT64_C(10000000000000), Q_UINT64_C(100000000000000),
+        Q_UINT64_C(1000000000000000), Q_UINT64_C(10000000000000000)
+    };
+    int n = 1;
+    while (n < 17 && significand >= powersOf10[n - 1])
+        ++n;
+    char *p = buf + n;
+    while (significand >= 100) {
+        const char *pair = digitPairs + 2 * (significand % 100);
+        significand /= 100;
+        *--p = pair[1];
+        *--p = pair[0];
+    }
+    if (significand >= 10) {
+        const char *pair = digitPairs + 2 * significand;
+        *--p = pair[1];
+        *--p = pair[0];
+    } else {
+        *--p = char('0' + significand);
+    }
+    length = n;
+    buf[n] = '\0';
+    decpt = n + exponent;
+}
+
+QT_END_NAMESPACE
@@ -469,6 +469,561 @@ static void simdCompareAscii(const qchar8_t *&, const qchar8_t *, const char16_t
 }
 #endif
 
+#if defined(__SSE2__) && QT_COMPILER_SUPPORTS_HERE(SSE4_1) && QT_COMPILER_SUPPORTS_HERE(AVX2)
+// Multi-byte UTF-8 validation and transcoding.
+//
+// The validator is the "lookup" algorithm from John Keiser and Daniel Lemire,
+// "Validating UTF-8 In Less Than One Instruction Per Byte" (also used by
+// simdutf): three 16-entry table lookups on the high and low nibbles of each
+// byte and of the byte before it classify every two-byte window, and a
+// saturating subtraction checks the third and fourth bytes of the longer
+// sequences. Any error sets a bit in the result.
+//
+// The transcoders below only run on windows that the validator accepted, so
+// they don't need to repeat the checks that QUtf8Functions does on the scalar
+// path. Both fall back to the scalar code for errors, 4-byte sequences and
+// surrogate pairs, so the output is identical.
+namespace {
+enum : uchar {
+    Utf8TooShort     = 1 << 0,  // lead byte not followed by a continuation
+    Utf8TooLong      = 1 << 1,  // ASCII byte followed by a continuation
+    Utf8Overlong3    = 1 << 2,  // 3-byte sequence for U+0000-U+07FF
+    Utf8TooLarge     = 1 << 3,  // above U+10FFFF
+    Utf8Surrogate    = 1 << 4,  // U+D800-U+DFFF
+    Utf8Overlong2    = 1 << 5,  // 2-byte sequence for U+0000-U+007F
+    Utf8TooLarge1000 = 1 << 6,
+    Utf8Overlong4    = 1 << 6,  // 4-byte sequence for U+0000-U+FFFF
+    Utf8TwoConts     = 1 << 7,  // two continuations with no lead before
+    Utf8Carry        = Utf8TooShort | Utf8TooLong | Utf8TwoConts
+};
+
+// indexed by the high nibble of the previous byte
+alignas(16) const uchar utf8Byte1High[16] = {
+    // 0_______ (ASCII)
+    Utf8TooLong, Utf8TooLong, Utf8TooLong, Utf8TooLong,
+    Utf8TooLong, Utf8TooLong, Utf8TooLong, Utf8TooLong,
+    // 10______ (continuation)
+    Utf8TwoConts, Utf8TwoConts, Utf8TwoConts, Utf8TwoConts,
+    // 1100____ and 1101____ (2-byte lead)
+    Utf8TooShort | Utf8Overlong2,
+    Utf8TooShort,
+    // 1110____ (3-byte lead)
+    Utf8TooShort | Utf8Overlong3 | Utf8Surrogate,
+    // 1111____ (4-byte lead or invalid)
+    Utf8TooShort | Utf8TooLarge | Utf8TooLarge1000 | Utf8Overlong4
+};
+
+// indexed by the low nibble of the previous byte
+alignas(16) const uchar utf8Byte1Low[16] = {
+    Utf8Carry | Utf8Overlong3 | Utf8Overlong2 | Utf8Overlong4,    // ____0000
+    Utf8Carry | Utf8Overlong2,                                    // ____0001
+    Utf8Carry,                                                    // ____0010
+    Utf8Carry,                                                    // ____0011
+    Utf8Carry | Utf8TooLarge,                                     // ____0100
+    Utf8Carry | Utf8TooLarge | Utf8TooLarge1000,                  // ____0101
+    Utf8Carry | Utf8TooLarge | Utf8TooLarge1000,
+    Utf8Carry | Utf8TooLarge | Utf8TooLarge1000,
+    Utf8Carry | Utf8TooLarge | Utf8TooLarge1000,                  // ____1000
+    Utf8Carry | Utf8TooLarge | Utf8TooLarge1000,
+    Utf8Carry | Utf8TooLarge | Utf8TooLarge1000,
+    Utf8Carry | Utf8TooLarge | Utf8TooLarge1000,
+    Utf8Carry | Utf8TooLarge | Utf8TooLarge1000,
+    Utf8Carry | Utf8TooLarge | Utf8TooLarge1000 | Utf8Surrogate,  // ____1101
+    Utf8Carry | Utf8TooLarge | Utf8TooLarge1000,
+    Utf8Carry | Utf8TooLarge | Utf8TooLarge1000
+};
+
+// indexed by the high nibble of the current byte
+alignas(16) const uchar utf8Byte2High[16] = {
+    // ________ 0_______ (ASCII)
+    Utf8TooShort, Utf8TooShort, Utf8TooShort, Utf8TooShort,
+    Utf8TooShort, Utf8TooShort, Utf8TooShort, Utf8TooShort,
+    // ________ 1000____
+    Utf8TooLong | Utf8Overlong2 | Utf8TwoConts | Utf8Overlong3 | Utf8TooLarge1000 | Utf8Overlong4,
+    // ________ 1001____
+    Utf8TooLong | Utf8Overlong2 | Utf8TwoConts | Utf8Overlong3 | Utf8TooLarge,
+    // ________ 101_____
+    Utf8TooLong | Utf8Overlong2 | Utf8TwoConts | Utf8Surrogate | Utf8TooLarge,
+    Utf8TooLong | Utf8Overlong2 | Utf8TwoConts | Utf8Surrogate | Utf8TooLarge,
+    // ________ 11______ (lead)
+    Utf8TooShort, Utf8TooShort, Utf8TooShort, Utf8TooShort
+};
+
+// The last bytes of a block that start a sequence that can't be complete
+// inside it. Those are an error if the input ends there.
+alignas(32) const uchar utf8IncompleteMax[32] = {
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xf0 - 1, 0xe0 - 1, 0xc0 - 1
+};
+
+// For each 8-bit mask of 16-bit lanes, the PSHUFB control that packs the
+// selected lanes at the bottom of the register.
+struct Utf8ShuffleTable { alignas(16) uchar control[256][16]; };
+constexpr Utf8ShuffleTable makeUtf16CompactTable()
+{
+    Utf8ShuffleTable table = {};
+    for (uint mask = 0; mask < 256; ++mask) {
+        uint out = 0;
+        for (uint lane = 0; lane < 8; ++lane) {
+            if (mask & (1U << lane)) {
+                table.control[mask][out++] = uchar(2 * lane);
+                table.control[mask][out++] = uchar(2 * lane + 1);
+            }
+        }
+        while (out < 16)
+            table.control[mask][out++] = 0x80;
+    }
+    return table;
+}
+constexpr Utf8ShuffleTable utf16CompactTable = makeUtf16CompactTable();
+
+// For four characters whose UTF-8 encodings are stored one per 32-bit lane,
+// the PSHUFB control that packs the encodings together. The low nibble of
+// the index has the characters of at least two bytes, the high one those of
+// three; the packed length is 4 + qPopulationCount(index).
+constexpr Utf8ShuffleTable makeUtf8CompactTable()
+{
+    Utf8ShuffleTable table = {};
+    for (uint mask = 0; mask < 256; ++mask) {
+        uint out = 0;
+        for (uint lane = 0; lane < 4; ++lane) {
+            uint len = 1 + ((mask >> lane) & 1) + ((mask >> (lane + 4)) & 1);
+            for (uint i = 0; i < len; ++i)
+                table.control[mask][out++] = uchar(4 * lane + i);
+        }
+        while (out < 16)
+            table.control[mask][out++] = 0x80;
+    }
+    return table;
+}
+constexpr Utf8ShuffleTable utf8CompactTable = makeUtf8CompactTable();
+} // unnamed namespace
+
+static Q_ALWAYS_INLINE QT_FUNCTION_TARGET(SSE4_1)
+__m128i utf8CheckBlock(__m128i input, __m128i previous)
+{
+    const __m128i nibble = _mm_set1_epi8(0x0f);
+    const __m128i prev1 = _mm_alignr_epi8(input, previous, 16 - 1);
+    const __m128i prev2 = _mm_alignr_epi8(input, previous, 16 - 2);
+    const __m128i prev3 = _mm_alignr_epi8(input, previous, 16 - 3);
+
+    __m128i byte1High = _mm_and_si128(_mm_srli_epi16(prev1, 4), nibble);
+    __m128i byte1Low = _mm_and_si128(prev1, nibble);
+    __m128i byte2High = _mm_and_si128(_mm_srli_epi16(input, 4), nibble);
+    byte1High = _mm_shuffle_epi8(_mm_load_si128(reinterpret_cast<const __m128i *>(utf8Byte1High)), byte1High);
+    byte1Low = _mm_shuffle_epi8(_mm_load_si128(reinterpret_cast<const __m128i *>(utf8Byte1Low)), byte1Low);
+    byte2High = _mm_shuffle_epi8(_mm_load_si128(reinterpret_cast<const __m128i *>(utf8Byte2High)), byte2High);
+    const __m128i specialCases = _mm_and_si128(_mm_and_si128(byte1High, byte1Low), byte2High);
+
+    // the third and fourth bytes of 3- and 4-byte sequences must be continuations
+    const __m128i isThirdByte = _mm_subs_epu8(prev2, _mm_set1_epi8(char(0xe0 - 0x80)));
+    const __m128i isFourthByte = _mm_subs_epu8(prev3, _mm_set1_epi8(char(0xf0 - 0x80)));
+    const __m128i must23 = _mm_and_si128(_mm_or_si128(isThirdByte, isFourthByte), _mm_set1_epi8(char(0x80)));
+    return _mm_xor_si128(must23, specialCases);
+}
+
+static Q_ALWAYS_INLINE QT_FUNCTION_TARGET(AVX2)
+__m256i utf8CheckBlock(__m256i input, __m256i previous)
+{
+    const __m256i nibble = _mm256_set1_epi8(0x0f);
+    const __m256i shifted = _mm256_permute2x128_si256(previous, input, 0x21);
+    const __m256i prev1 = _mm256_alignr_epi8(input, shifted, 16 - 1);
+    const __m256i prev2 = _mm256_alignr_epi8(input, shifted, 16 - 2);
+    const __m256i prev3 = _mm256_alignr_epi8(input, shifted, 16 - 3);
+
+    __m256i byte1High = _mm256_and_si256(_mm256_srli_epi16(prev1, 4), nibble);
+    __m256i byte1Low = _mm256_and_si256(prev1, nibble);
+    __m256i byte2High = _mm256_and_si256(_mm256_srli_epi16(input, 4), nibble);
+    byte1High = _mm256_shuffle_epi8(_mm256_broadcastsi128_si256(
+            _mm_load_si128(reinterpret_cast<const __m128i *>(utf8Byte1High))), byte1High);
+    byte1Low = _mm256_shuffle_epi8(_mm256_broadcastsi128_si256(
+            _mm_load_si128(reinterpret_cast<const __m128i *>(utf8Byte1Low))), byte1Low);
+    byte2High = _mm256_shuffle_epi8(_mm256_broadcastsi128_si256(
+            _mm_load_si128(reinterpret_cast<const __m128i *>(utf8Byte2High))), byte2High);
+    const __m256i specialCases = _mm256_and_si256(_mm256_and_si256(byte1High, byte1Low), byte2High);
+
+    const __m256i isThirdByte = _mm256_subs_epu8(prev2, _mm256_set1_epi8(char(0xe0 - 0x80)));
+    const __m256i isFourthByte = _mm256_subs_epu8(prev3, _mm256_set1_epi8(char(0xf0 - 0x80)));
+    const __m256i must23 = _mm256_and_si256(_mm256_or_si256(isThirdByte, isFourthByte),
+                                            _mm256_set1_epi8(char(0x80)));
+    return _mm256_xor_si256(must23, specialCases);
+}
+
+static Q_ALWAYS_INLINE QT_FUNCTION_TARGET(SSE4_1)
+void utf8CheckNext(__m128i input, __m128i &previous, __m128i &error, __m128i &incomplete)
+{
+    if (_mm_movemask_epi8(input) == 0) {
+        // US-ASCII only, but the previous block may have been cut short
+        error = _mm_or_si128(error, incomplete);
+        incomplete = _mm_setzero_si128();
+    } else {
+        const __m128i incompleteMax = _mm_loadu_si128(reinterpret_cast<const __m128i *>(utf8IncompleteMax + 16));
+        error = _mm_or_si128(error, utf8CheckBlock(input, previous));
+        incomplete = _mm_subs_epu8(input, incompleteMax);
+    }
+    previous = input;
+}
+
+static Q_ALWAYS_INLINE QT_FUNCTION_TARGET(AVX2)
+void utf8CheckNext(__m256i input, __m256i &previous, __m256i &error, __m256i &incomplete)
+{
+    if (_mm256_movemask_epi8(input) == 0) {
+        error = _mm256_or_si256(error, incomplete);
+        incomplete = _mm256_setzero_si256();
+    } else {
+        const __m256i incompleteMax = _mm256_load_si256(reinterpret_cast<const __m256i *>(utf8IncompleteMax));
+        error = _mm256_or_si256(error, utf8CheckBlock(input, previous));
+        incomplete = _mm256_subs_epu8(input, incompleteMax);
+    }
+    previous = input;
+}
+
+static QT_FUNCTION_TARGET(SSE4_1)
+QUtf8::ValidUtf8Result simdValidateUtf8_sse4(const uchar *src, const uchar *end)
+{
+    __m128i previous = _mm_setzero_si128();
+    __m128i error = _mm_setzero_si128();
+    __m128i incomplete = _mm_setzero_si128();
+    __m128i highBits = _mm_setzero_si128();
+
+    for ( ; end - src >= 16; src += 16) {
+        const __m128i data = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src));
+        highBits = _mm_or_si128(highBits, data);
+        utf8CheckNext(data, previous, error, incomplete);
+        if (!_mm_testz_si128(error, error))
+            return { false, false };
+    }
+    if (src != end) {
+        alignas(16) uchar tail[16] = {};
+        memcpy(tail, src, end - src);
+        const __m128i data = _mm_load_si128(reinterpret_cast<const __m128i *>(tail));
+        highBits = _mm_or_si128(highBits, data);
+        utf8CheckNext(data, previous, error, incomplete);
+    }
+    error = _mm_or_si128(error, incomplete);
+    if (!_mm_testz_si128(error, error))
+        return { false, false };
+    return { true, _mm_movemask_epi8(highBits) == 0 };
+}
+
+static QT_FUNCTION_TARGET(AVX2)
+QUtf8::ValidUtf8Result simdValidateUtf8_avx2(const uchar *src, const uchar *end)
+{
+    __m256i previous = _mm256_setzero_si256();
+    __m256i error = _mm256_setzero_si256();
+    __m256i incomplete = _mm256_setzero_si256();
+    __m256i highBits = _mm256_setzero_si256();
+
+    for ( ; end - src >= 32; src += 32) {
+        const __m256i data = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src));
+        highBits = _mm256_or_si256(highBits, data);
+        utf8CheckNext(data, previous, error, incomplete);
+        if (!_mm256_testz_si256(error, error))
+            return { false, false };
+    }
+    if (src != end) {
+        alignas(32) uchar tail[32] = {};
+        memcpy(tail, src, end - src);
+        const __m256i data = _mm256_load_si256(reinterpret_cast<const __m256i *>(tail));
+        highBits = _mm256_or_si256(highBits, data);
+        utf8CheckNext(data, previous, error, incomplete);
+    }
+    error = _mm256_or_si256(error, incomplete);
+    if (!_mm256_testz_si256(error, error))
+        return { false, false };
+    return { true, _mm256_movemask_epi8(highBits) == 0 };
+}
+
+static bool simdValidateUtf8(QUtf8::ValidUtf8Result &result, const uchar *src, const uchar *end)
+{
+    if (qCpuHasFeature(AVX2))
+        result = simdValidateUtf8_avx2(src, end);
+    else if (qCpuHasFeature(SSE4_1))
+        result = simdValidateUtf8_sse4(src, end);
+    else
+        return false;
+    return true;
+}
+
+// Decodes the 1- to 3-byte UTF-8 sequences whose first, second and third
+// bytes are in the 16-bit lanes of \a b0, \a b1 and \a b2 to one UTF-16 code
+// unit per lane. The lanes of continuation bytes get garbage.
+static Q_ALWAYS_INLINE QT_FUNCTION_TARGET(SSE4_1)
+__m128i utf8DecodeLanes(__m128i b0, __m128i b1, __m128i b2)
+{
+    const __m128i low6 = _mm_set1_epi16(0x3f);
+    const __m128i isMulti = _mm_cmpgt_epi16(b0, _mm_set1_epi16(0xbf));
+    const __m128i isThree = _mm_cmpgt_epi16(b0, _mm_set1_epi16(0xdf));
+
+    // 110xxxxx 10yyyyyy -> 00000xxx xxyyyyyy
+    const __m128i cont1 = _mm_and_si128(b1, low6);
+    const __m128i two = _mm_or_si128(_mm_slli_epi16(_mm_and_si128(b0, _mm_set1_epi16(0x1f)), 6), cont1);
+
+    // 1110xxxx 10yyyyyy 10zzzzzz -> xxxxyyyy yyzzzzzz (the shift drops the 1110)
+    const __m128i three = _mm_or_si128(_mm_or_si128(_mm_slli_epi16(b0, 12), _mm_slli_epi16(cont1, 6)),
+                                       _mm_and_si128(b2, low6));
+
+    return _mm_blendv_epi8(_mm_blendv_epi8(b0, two, isMulti), three, isThree);
+}
+
+// Length of the validated sequence started by the lead byte \a b.
+static Q_ALWAYS_INLINE qptrdiff utf8SequenceLength(uchar b)
+{
+    return 1 + (b >= 0xc0) + (b >= 0xe0);
+}
+
+// Returns the mask of the positions in a 64-byte window that start a
+// sequence that we can decode here: that is, everything up to the first
+// 4-byte sequence (which needs a surrogate pair), but not a sequence that
+// continues past the window.
+static Q_ALWAYS_INLINE quint64 utf8DecodableLeads(const uchar *src, quint64 continuationMask, quint64 fourByteMask)
+{
+    quint64 leads = ~continuationMask;
+    if (fourByteMask)
+        return leads & ((Q_UINT64_C(1) << qCountTrailingZeroBits(fourByteMask)) - 1);
+
+    const uint last = 63 - qCountLeadingZeroBits(leads);
+    if (last + utf8SequenceLength(src[last]) > 64)
+        leads &= ~(Q_UINT64_C(1) << last);
+    return leads;
+}
+
+static Q_ALWAYS_INLINE QT_FUNCTION_TARGET(SSE4_1)
+void utf8StoreLanes(char16_t *&dst, __m128i decoded, uint leads)
+{
+    const __m128i control = _mm_load_si128(reinterpret_cast<const __m128i *>(utf16CompactTable.control[leads]));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(dst), _mm_shuffle_epi8(decoded, control));
+    dst += qPopulationCount(leads);
+}
+
+static QT_FUNCTION_TARGET(SSE4_1)
+void simdDecodeMultiByte_sse4(char16_t *&dst, const uchar *&nextMultiByte, const uchar *&src, const uchar *end)
+{
+    // Each step validates a 64-byte window and decodes the sequences that are
+    // complete inside it. The second and third bytes of the last lanes come
+    // from the 16 bytes after the window.
+    while (end - src >= 80) {
+        __m128i data[5];
+        for (int i = 0; i < 5; ++i)
+            data[i] = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src) + i);
+        if (!_mm_movemask_epi8(data[0]))
+            break;          // US-ASCII: simdDecodeAscii is faster
+
+        // src is always on a sequence boundary, so the window has no history
+        __m128i error = utf8CheckBlock(data[0], _mm_setzero_si128());
+        quint64 continuationMask = 0;
+        quint64 fourByteMask = 0;
+        for (int i = 0; i < 4; ++i) {
+            if (i)
+                error = _mm_or_si128(error, utf8CheckBlock(data[i], data[i - 1]));
+            const __m128i isContinuation = _mm_cmplt_epi8(data[i], _mm_set1_epi8(char(0xc0)));
+            const __m128i isFourByte = _mm_cmpeq_epi8(_mm_max_epu8(data[i], _mm_set1_epi8(char(0xf0))), data[i]);
+            continuationMask |= quint64(_mm_movemask_epi8(isContinuation)) << (16 * i);
+            fourByteMask |= quint64(_mm_movemask_epi8(isFourByte)) << (16 * i);
+        }
+        if (!_mm_testz_si128(error, error))
+            break;
+        const quint64 leads = utf8DecodableLeads(src, continuationMask, fourByteMask);
+        if (!leads)
+            break;
+
+        const __m128i zero = _mm_setzero_si128();
+        for (int i = 0; i < 4; ++i) {
+            const __m128i next1 = _mm_alignr_epi8(data[i + 1], data[i], 1);
+            const __m128i next2 = _mm_alignr_epi8(data[i + 1], data[i], 2);
+            const __m128i lo = utf8DecodeLanes(_mm_unpacklo_epi8(data[i], zero),
+                                               _mm_unpacklo_epi8(next1, zero),
+                                               _mm_unpacklo_epi8(next2, zero));
+            const __m128i hi = utf8DecodeLanes(_mm_unpackhi_epi8(data[i], zero),
+                                               _mm_unpackhi_epi8(next1, zero),
+                                               _mm_unpackhi_epi8(next2, zero));
+            utf8StoreLanes(dst, lo, uint(leads >> (16 * i)) & 0xff);
+            utf8StoreLanes(dst, hi, uint(leads >> (16 * i + 8)) & 0xff);
+        }
+
+        const uint last = 63 - qCountLeadingZeroBits(leads);
+        src += last + utf8SequenceLength(src[last]);
+    }
+
+    // don't come back until we've made some progress in the scalar code
+    nextMultiByte = src + qMin<qptrdiff>(16, end - src);
+}
+
+static QT_FUNCTION_TARGET(AVX2)
+void simdDecodeMultiByte_avx2(char16_t *&dst, const uchar *&nextMultiByte, const uchar *&src, const uchar *end)
+{
+    while (end - src >= 80) {
+        const __m256i data1 = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src));
+        const __m256i data2 = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src) + 1);
+        if (!(_mm256_movemask_epi8(data1) & 0xffff))
+            break;
+
+        const __m256i error = _mm256_or_si256(utf8CheckBlock(data1, _mm256_setzero_si256()),
+                                              utf8CheckBlock(data2, data1));
+        if (!_mm256_testz_si256(error, error))
+            break;
+
+        const __m256i minLead = _mm256_set1_epi8(char(0xc0));
+        const __m256i minFourByte = _mm256_set1_epi8(char(0xf0));
+        const __m256i isContinuation1 = _mm256_cmpgt_epi8(minLead, data1);
+        const __m256i isContinuation2 = _mm256_cmpgt_epi8(minLead, data2);
+        const __m256i isFourByte1 = _mm256_cmpeq_epi8(_mm256_max_epu8(data1, minFourByte), data1);
+        const __m256i isFourByte2 = _mm256_cmpeq_epi8(_mm256_max_epu8(data2, minFourByte), data2);
+        const quint64 continuationMask = quint64(uint(_mm256_movemask_epi8(isContinuation1)))
+                | quint64(uint(_mm256_movemask_epi8(isContinuation2))) << 32;
+        const quint64 fourByteMask = quint64(uint(_mm256_movemask_epi8(isFourByte1)))
+                | quint64(uint(_mm256_movemask_epi8(isFourByte2))) << 32;
+        const quint64 leads = utf8DecodableLeads(src, continuationMask, fourByteMask);
+        if (!leads)
+            break;
+
+        const __m256i low6 = _mm256_set1_epi16(0x3f);
+        for (int i = 0; i < 4; ++i) {
+            const uchar *ptr = src + 16 * i;
+            const __m256i b0 = _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i *>(ptr)));
+            const __m256i b1 = _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i *>(ptr + 1)));
+            const __m256i b2 = _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i *>(ptr + 2)));
+
+            const __m256i isMulti = _mm256_cmpgt_epi16(b0, _mm256_set1_epi16(0xbf));
+            const __m256i isThree = _mm256_cmpgt_epi16(b0, _mm256_set1_epi16(0xdf));
+            const __m256i cont1 = _mm256_and_si256(b1, low6);
+            const __m256i two = _mm256_or_si256(_mm256_slli_epi16(_mm256_and_si256(b0, _mm256_set1_epi16(0x1f)), 6),
+                                                cont1);
+            const __m256i three = _mm256_or_si256(_mm256_or_si256(_mm256_slli_epi16(b0, 12),
+                                                                  _mm256_slli_epi16(cont1, 6)),
+                                                  _mm256_and_si256(b2, low6));
+            const __m256i decoded = _mm256_blendv_epi8(_mm256_blendv_epi8(b0, two, isMulti), three, isThree);
+            utf8StoreLanes(dst, _mm256_castsi256_si128(decoded), uint(leads >> (16 * i)) & 0xff);
+            utf8StoreLanes(dst, _mm256_extracti128_si256(decoded, 1), uint(leads >> (16 * i + 8)) & 0xff);
+        }
+
+        const uint last = 63 - qCountLeadingZeroBits(leads);
+        src += last + utf8SequenceLength(src[last]);
+    }
+
+    nextMultiByte = src + qMin<qptrdiff>(16, end - src);
+}
+
+// Decodes runs of 1- to 3-byte UTF-8 sequences starting at \a src, which must
+// be on a sequence boundary, and stops before anything that the scalar code
+// needs to handle. Like simdDecodeAscii, it sets \a nextMultiByte to where it
+// is worth trying again. It always leaves at least 16 bytes of input behind.
+static inline void simdDecodeMultiByte(char16_t *&dst, const uchar *&nextMultiByte, const uchar *&src, const uchar *end)
+{
+    if (qCpuHasFeature(AVX2))
+        simdDecodeMultiByte_avx2(dst, nextMultiByte, src, end);
+    else if (qCpuHasFeature(SSE4_1))
+        simdDecodeMultiByte_sse4(dst, nextMultiByte, src, end);
+    else
+        nextMultiByte = end;
+}
+
+// Encodes the eight UTF-16 code units of \a data, none of which may be a
+// surrogate, and stores the result at \a dst. Writes up to 32 bytes.
+static Q_ALWAYS_INLINE QT_FUNCTION_TARGET(SSE4_1)
+void utf8EncodeLanes(uchar *&dst, __m128i data)
+{
+    const __m128i low6 = _mm_set1_epi16(0x3f);
+    const __m128i cont = _mm_set1_epi16(0x80);
+    const __m128i isMulti = _mm_cmpeq_epi16(_mm_max_epu16(data, _mm_set1_epi16(0x80)), data);
+    const __m128i isThree = _mm_cmpeq_epi16(_mm_max_epu16(data, _mm_set1_epi16(0x800)), data);
+
+    // first, second and third byte of each sequence
+    const __m128i first = _mm_blendv_epi8(
+            _mm_blendv_epi8(data, _mm_or_si128(_mm_srli_epi16(data, 6), _mm_set1_epi16(0xc0)), isMulti),
+            _mm_or_si128(_mm_srli_epi16(data, 12), _mm_set1_epi16(0xe0)), isThree);
+    const __m128i last = _mm_or_si128(_mm_and_si128(data, low6), cont);
+    const __m128i second = _mm_blendv_epi8(last,
+                                           _mm_or_si128(_mm_and_si128(_mm_srli_epi16(data, 6), low6), cont),
+                                           isThree);
+    const __m128i firstSecond = _mm_or_si128(first, _mm_slli_epi16(second, 8));
+    const __m128i words1 = _mm_unpacklo_epi16(firstSecond, last);
+    const __m128i words2 = _mm_unpackhi_epi16(firstSecond, last);
+
+    // bits 0-7: two or more bytes; bits 8-15: three bytes
+    const uint lengths = _mm_movemask_epi8(_mm_packs_epi16(isMulti, isThree));
+    const uint index1 = (lengths & 0x0f) | ((lengths >> 4) & 0xf0);
+    const uint index2 = ((lengths >> 4) & 0x0f) | ((lengths >> 8) & 0xf0);
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(dst),
+                     _mm_shuffle_epi8(words1, _mm_load_si128(reinterpret_cast<const __m128i *>(
+                                                  utf8CompactTable.control[index1]))));
+    dst += 4 + qPopulationCount(index1);
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(dst),
+                     _mm_shuffle_epi8(words2, _mm_load_si128(reinterpret_cast<const __m128i *>(
+                                                  utf8CompactTable.control[index2]))));
+    dst += 4 + qPopulationCount(index2);
+}
+
+static Q_ALWAYS_INLINE QT_FUNCTION_TARGET(SSE4_1)
+bool utf8HasSurrogates(__m128i data)
+{
+    const __m128i masked = _mm_and_si128(data, _mm_set1_epi16(short(0xf800)));
+    return _mm_movemask_epi8(_mm_cmpeq_epi16(masked, _mm_set1_epi16(short(0xd800))));
+}
+
+static QT_FUNCTION_TARGET(SSE4_1)
+void simdEncodeMultiByte_sse4(uchar *&dst, const char16_t *&nextMultiByte, const char16_t *&src, const char16_t *end)
+{
+    // the output buffer has room for three bytes per character, so keeping
+    // 8 characters back makes the 16-byte stores safe
+    for ( ; end - src >= 16; src += 8) {
+        const __m128i data = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src));
+        if (_mm_testz_si128(data, _mm_set1_epi16(short(0xff80))))
+            break;          // US-ASCII: simdEncodeAscii is faster
+        if (utf8HasSurrogates(data))
+            break;
+        utf8EncodeLanes(dst, data);
+    }
+    nextMultiByte = src + qMin<qptrdiff>(8, end - src);
+}
+
+static QT_FUNCTION_TARGET(AVX2)
+void simdEncodeMultiByte_avx2(uchar *&dst, const char16_t *&nextMultiByte, const char16_t *&src, const char16_t *end)
+{
+    for ( ; end - src >= 24; src += 16) {
+        const __m256i data = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src));
+        if (_mm256_testz_si256(data, _mm256_set1_epi16(short(0xff80))))
+            break;
+        const __m256i masked = _mm256_and_si256(data, _mm256_set1_epi16(short(0xf800)));
+        if (_mm256_movemask_epi8(_mm256_cmpeq_epi16(masked, _mm256_set1_epi16(short(0xd800)))))
+            break;
+        utf8EncodeLanes(dst, _mm256_castsi256_si128(data));
+        utf8EncodeLanes(dst, _mm256_extracti128_si256(data, 1));
+    }
+    simdEncodeMultiByte_sse4(dst, nextMultiByte, src, end);
+}
+
+// Encodes runs of BMP characters (no surrogate pairs) starting at \a src,
+// stopping at US-ASCII runs and at surrogates. Sets \a nextMultiByte to where
+// it is worth trying again and always leaves at least 8 characters behind.
+static inline void simdEncodeMultiByte(uchar *&dst, const char16_t *&nextMultiByte, const char16_t *&src, const char16_t *end)
+{
+    if (qCpuHasFeature(AVX2))
+        simdEncodeMultiByte_avx2(dst, nextMultiByte, src, end);
+    else if (qCpuHasFeature(SSE4_1))
+        simdEncodeMultiByte_sse4(dst, nextMultiByte, src, end);
+    else
+        nextMultiByte = end;
+}
+#else
+static bool simdValidateUtf8(QUtf8::ValidUtf8Result &, const uchar *, const uchar *)
+{
+    return false;
+}
+
+static inline void simdDecodeMultiByte(char16_t *&, const uchar *&nextMultiByte, const uchar *&, const uchar *end)
+{
+    nextMultiByte = end;
+}
+
+static inline void simdEncodeMultiByte(uchar *&, const char16_t *&nextMultiByte, const char16_t *&, const char16_t *end)
+{
+    nextMultiByte = end;
+}
+#endif
+
 enum { HeaderDone = 1 };
 
 QByteArray QUtf8::convertFromUnicode(QStringView in)
@@ -480,6 +1035,7 @@ QByteArray QUtf8::convertFromUnicode(QStringView in)
     uchar *dst = reinterpret_cast<uchar *>(const_cast<char *>(result.constData()));
     const char16_t *src = reinterpret_cast<const char16_t *>(in.data());
     const char16_t *const end = src + len;
+    const char16_t *nextMultiByte = src;
 
     while (src != end) {
         const char16_t *nextAscii = end;
@@ -487,6 +1043,9 @@ QByteArray QUtf8::convertFromUnicode(QStringView in)
             break;
 
         do {
+            if (src >= nextMultiByte)
+                simdEncodeMultiByte(dst, nextMultiByte, src, end);
+
             char16_t u = *src++;
             int res = QUtf8Functions::toUtf8<QUtf8BaseTraits>(u, dst, src, end);
             if (res < 0) {
@@ -547,12 +1106,16 @@ char *QUtf8::convertFromUnicode(char *out, QStringView in, QStringConverter::Sta
         }
     }
 
+    const char16_t *nextMultiByte = src;
     while (src != end) {
         const char16_t *nextAscii = end;
         if (simdEncodeAscii(cursor, nextAscii, src, end))
             break;
 
         do {
+            if (src >= nextMultiByte)
+                simdEncodeMultiByte(cursor, nextMultiByte, src, end);
+
             char16_t uc = *src++;
             int res = QUtf8Functions::toUtf8<QUtf8BaseTraits>(uc, cursor, src, end);
             if (Q_LIKELY(res >= 0))
@@ -641,6 +1204,7 @@ char16_t *QUtf8::convertToUnicode(char16_t *dst, QByteArrayView in) noexcept
 
     // attempt to do a full decoding in SIMD
     const uchar *nextAscii = end;
+    const uchar *nextMultiByte = src;
     if (!simdDecodeAscii(dst, nextAscii, src, end)) {
         // at least one non-ASCII entry
         // check if we failed to decode the UTF-8 BOM; if so, skip it
@@ -656,6 +1220,9 @@ char16_t *QUtf8::convertToUnicode(char16_t *dst, QByteArrayView in) noexcept
                 break;
 
             do {
+                if (src >= nextMultiByte)
+                    simdDecodeMultiByte(dst, nextMultiByte, src, end);
+
                 uchar b = *src++;
                 const qsizetype res = QUtf8Functions::fromUtf8<QUtf8BaseTraits>(b, dst, src, end);
                 if (res < 0) {
@@ -754,9 +1321,12 @@ char16_t *QUtf8::convertToUnicode(char16_t *dst, QByteArrayView in, QStringConve
     // main body, stateless decoding
     res = 0;
     const uchar *nextAscii = src;
+    const uchar *nextMultiByte = src;
     while (res >= 0 && src < end) {
         if (src >= nextAscii && simdDecodeAscii(dst, nextAscii, src, end))
             break;
+        if (src >= nextMultiByte)
+            simdDecodeMultiByte(dst, nextMultiByte, src, end);
 
         ch = *src++;
         res = QUtf8Functions::fromUtf8<QUtf8BaseTraits>(ch, dst, src, end);
@@ -803,6 +1373,10 @@ QUtf8::ValidUtf8Result QUtf8::isValidUtf8(QByteArrayView in)
     const uchar *nextAscii = src;
     bool isValidAscii = true;
 
+    ValidUtf8Result result;
+    if (simdValidateUtf8(result, src, end))
+        return result;
+
     while (src < end) {
         if (src >= nextAscii)
             src = simdFindNonAscii(src, end, nextAscii);
@@ -2505,6 +3079,130 @@ const char *QStringConverter::nameForEncoding(QStringConverter::Encoding e)
     return encodingInterfaces[int(e)].name;
 }
 
+// Returns the length of the longest prefix of an input of \a inputLength
+// units whose worst-case output, according to \a lengthFn, fits into \a space.
+static qsizetype maxInputForSpace(qsizetype (*lengthFn)(qsizetype), qsizetype inputLength,
+                                  qsizetype space)
+{
+    if (lengthFn(inputLength) <= space)
+        return inputLength;
+
+    // the length functions are monotonic
+    qsizetype fits = 0;
+    qsizetype doesNotFit = inputLength;
+    while (doesNotFit - fits > 1) {
+        const qsizetype mid = fits + (doesNotFit - fits) / 2;
+        if (lengthFn(mid) <= space)
+            fits = mid;
+        else
+            doesNotFit = mid;
+    }
+    return fits;
+}
+
+// Converts as much of \a in as is guaranteed to fit into \a out, in as many
+// steps as it takes. A stateless converter can't carry a partial character
+// from one step to the next, so it only converts \a in as a whole.
+template <typename OutChar, typename InView, typename ConvertFn>
+static QStringConverter::ConversionResult
+convertIntoBuffer(QSpan<OutChar> out, InView in, QStringConverter::State &state,
+                  qsizetype (*lengthFn)(qsizetype), ConvertFn convert)
+{
+    QStringConverter::ConversionResult result;
+    OutChar *const begin = out.data();
+    OutChar *dst = begin;
+    const bool stateless = state.flags & QStringConverter::Flag::Stateless;
+    while (result.consumed < in.size()) {
+        const qsizetype remaining = in.size() - result.consumed;
+        const qsizetype space = out.size() - (dst - begin);
+        const qsizetype chunk = maxInputForSpace(lengthFn, remaining, space);
+        if (chunk == 0 || (stateless && chunk != remaining))
+            break;
+        dst = convert(dst, in.sliced(result.consumed, chunk));
+        result.consumed += chunk;
+    }
+    result.written = dst - begin;
+    return result;
+}
+
+/*!
+    \class QStringConverter::ConversionResult
+    \inmodule QtCore
+    \since 6.9
+    \brief The result of QStringEncoder::encodeInto() and QStringDecoder::decodeInto().
+
+    \variable QStringConverter::ConversionResult::consumed
+    The number of input units (UTF-16 code units or bytes) that were consumed.
+
+    \variable QStringConverter::ConversionResult::written
+    The number of output units that were written to the buffer.
+*/
+
+/*!
+    \since 6.9
+
+    Encodes as much of \a in as fits into \a out and returns how much of \a in
+    was consumed and how much of \a out was written. This function never
+    allocates memory: the caller can reuse the same buffer for every call,
+    sending or flushing the data written and calling the function again with
+    the part of \a in that wasn't consumed yet.
+
+    The encoder only consumes input whose worst-case encoding (see
+    requiredSpace()) still fits into the space that is left in \a out, so it may
+    stop a few characters before the buffer is full. A UTF-16 surrogate pair
+    that straddles the end of the consumed input is kept in the encoder's state,
+    like it would be for appendToBuffer(). A stateless encoder (see
+    QStringConverter::Flag::Stateless) can't do that and only encodes \a in if
+    all of it fits.
+
+    \sa appendToBuffer(), QStringDecoder::decodeInto()
+*/
+QStringConverter::ConversionResult QStringEncoder::encodeInto(QSpan<char> out, QStringView in)
+{
+    if (!iface) {
+        state.invalidChars = 1;
+        return {};
+    }
+    return convertIntoBuffer(out, in, state, iface->fromUtf16Len, [this](char *dst, QStringView chunk) {
+        return iface->fromUtf16(dst, chunk, &state);
+    });
+}
+
+/*!
+    \since 6.9
+
+    Decodes as much of \a in as fits into \a out and returns how many bytes of
+    \a in were consumed and how many UTF-16 code units were written to \a out.
+    This function never allocates memory.
+
+    The decoder only consumes input whose worst-case decoding (see
+    requiredSpace()) still fits into the space that is left in \a out, so it may
+    stop a little before the buffer is full. A multi-byte sequence that
+    straddles the end of the consumed input is kept in the decoder's state and
+    completed by the next call. A stateless decoder (see
+    QStringConverter::Flag::Stateless) can't do that and only decodes \a in if
+    all of it fits.
+
+    \sa appendToBuffer(), QStringEncoder::encodeInto()
+*/
+QStringConverter::ConversionResult QStringDecoder::decodeInto(QSpan<char16_t> out, QByteArrayView in)
+{
+    if (!iface) {
+        state.invalidChars = 1;
+        return {};
+    }
+    return convertIntoBuffer(out, in, state, iface->toUtf16Len, [this](char16_t *dst, QByteArrayView chunk) {
+        QChar *end = iface->toUtf16(reinterpret_cast<QChar *>(dst), chunk, &state);
+        return reinterpret_cast<char16_t *>(end);
+    });
+}
+
+/*!
+    \fn QStringConverter::ConversionResult QStringDecoder::decodeInto(QSpan<QChar> out, QByteArrayView in)
+    \since 6.9
+    \overload
+*/
+
 /*!
     \class QStringEncoder
     \inmodule QtCore
@@ -14,6 +14,7 @@
     #include <QtCore/qstringconverter_base.h>
     #include <QtCore/qstring.h>
     #include <QtCore/qstringbuilder.h>
+    #include <QtCore/qspan.h>
 
     QT_BEGIN_NAMESPACE
 
@@ -62,6 +63,7 @@
             }
             return iface->fromUtf16(out, in, &state);
         }
+        Q_CORE_EXPORT ConversionResult encodeInto(QSpan<char> out, QStringView in);
     private:
         QByteArray encodeAsByteArray(QStringView in)
         {
@@ -126,6 +128,9 @@
         }
         char16_t *appendToBuffer(char16_t *out, QByteArrayView ba)
         { return reinterpret_cast<char16_t *>(appendToBuffer(reinterpret_cast<QChar *>(out), ba)); }
+        Q_CORE_EXPORT ConversionResult decodeInto(QSpan<char16_t> out, QByteArrayView in);
+        ConversionResult decodeInto(QSpan<QChar> out, QByteArrayView in)
+        { return decodeInto(QSpan<char16_t>(reinterpret_cast<char16_t *>(out.data()), out.size()), in); }
 
         Q_CORE_EXPORT static QStringDecoder decoderForHtml(QByteArrayView data);
 
@@ -159,6 +159,11 @@
         }
         bool hasError() const noexcept { return state.invalidChars != 0; }
 
+        struct ConversionResult {
+            qsizetype consumed = 0;
+            qsizetype written = 0;
+        };
+
         Q_CORE_EXPORT const char *name() const noexcept;
 
     #if QT_CORE_REMOVED_SINCE(6, 8)
@@ -3,9 +3,190 @@
 
 #include "qstringtokenizer.h"
 #include "qstringalgorithms.h"
+#include "qalgorithms.h"
+#include "private/qsimd_p.h"
+
+#include <string.h>
 
 QT_BEGIN_NAMESPACE
 
+static qsizetype scanChar_scalar(const char16_t *s, qsizetype i, qsizetype size, char16_t c,
+                                 qsizetype *positions, qsizetype maxCount) noexcept
+{
+    qsizetype count = 0;
+    for (; i < size && count < maxCount; ++i) {
+        if (s[i] == c)
+            positions[count++] = i;
+    }
+    return count;
+}
+
+static qsizetype scanString_scalar(const char16_t *s, qsizetype i, qsizetype size,
+                                   const char16_t *n, qsizetype ns,
+                                   qsizetype *positions, qsizetype maxCount) noexcept
+{
+    qsizetype count = 0;
+    while (i <= size - ns && count < maxCount) {
+        if (s[i] == n[0] && memcmp(s + i + 1, n + 1, (ns - 1) * sizeof(char16_t)) == 0) {
+            positions[count++] = i;
+            i += ns;
+        } else {
+            ++i;
+        }
+    }
+    return count;
+}
+
+#ifdef __SSE2__
+// Each character that matches sets two bits in the mask of
+// _mm_movemask_epi8() / _mm256_movemask_epi8(), so these loops clear two
+// bits per hit.
+
+static qsizetype scanChar_sse2(const char16_t *s, qsizetype i, qsizetype size, char16_t c,
+                               qsizetype *positions, qsizetype maxCount) noexcept
+{
+    qsizetype count = 0;
+    const __m128i needle = _mm_set1_epi16(short(c));
+    for (; i + 8 <= size; i += 8) {
+        const __m128i data = _mm_loadu_si128(reinterpret_cast<const __m128i *>(s + i));
+        uint mask = _mm_movemask_epi8(_mm_cmpeq_epi16(data, needle));
+        while (mask) {
+            positions[count++] = i + qCountTrailingZeroBits(mask) / 2;
+            if (count == maxCount)
+                return count;
+            mask &= mask - 1;
+            mask &= mask - 1;
+        }
+    }
+    return count + scanChar_scalar(s, i, size, c, positions + count, maxCount - count);
+}
+
+// Compares the first and the last character of the separator at eight
+// positions at once and only verifies the middle part of the candidates.
+static qsizetype scanString_sse2(const char16_t *s, qsizetype i, qsizetype size,
+                                 const char16_t *n, qsizetype ns,
+                                 qsizetype *positions, qsizetype maxCount) noexcept
+{
+    qsizetype count = 0;
+    qsizetype resume = i;   // the end of the last match; matches can't overlap it
+    const __m128i first = _mm_set1_epi16(short(n[0]));
+    const __m128i last = _mm_set1_epi16(short(n[ns - 1]));
+    while (i + ns - 1 + 8 <= size) {
+        const __m128i head = _mm_loadu_si128(reinterpret_cast<const __m128i *>(s + i));
+        const __m128i tail = _mm_loadu_si128(reinterpret_cast<const __m128i *>(s + i + ns - 1));
+        uint mask = _mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi16(head, first),
+                                                    _mm_cmpeq_epi16(tail, last)));
+        while (mask) {
+            const qsizetype pos = i + qCountTrailingZeroBits(mask) / 2;
+            mask &= mask - 1;
+            mask &= mask - 1;
+            if (pos < resume || memcmp(s + pos + 1, n + 1, (ns - 2) * sizeof(char16_t)) != 0)
+                continue;
+            positions[count++] = pos;
+            if (count == maxCount)
+                return count;
+            resume = pos + ns;
+        }
+        i = qMax(i + 8, resume);
+    }
+    return count + scanString_scalar(s, qMax(i, resume), size, n, ns,
+                                     positions + count, maxCount - count);
+}
+
+#  if QT_COMPILER_SUPPORTS_HERE(AVX2)
+static QT_FUNCTION_TARGET(AVX2)
+qsizetype scanChar_avx2(const char16_t *s, qsizetype i, qsizetype size, char16_t c,
+                        qsizetype *positions, qsizetype maxCount) noexcept
+{
+    qsizetype count = 0;
+    const __m256i needle = _mm256_set1_epi16(short(c));
+    for (; i + 16 <= size; i += 16) {
+        const __m256i data = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(s + i));
+        uint mask = _mm256_movemask_epi8(_mm256_cmpeq_epi16(data, needle));
+        while (mask) {
+            positions[count++] = i + qCountTrailingZeroBits(mask) / 2;
+            if (count == maxCount)
+                return count;
+            mask &= mask - 1;
+            mask &= mask - 1;
+        }
+    }
+    return count + scanChar_sse2(s, i, size, c, positions + count, maxCount - count);
+}
+
+static QT_FUNCTION_TARGET(AVX2)
+qsizetype scanString_avx2(const char16_t *s, qsizetype i, qsizetype size,
+                          const char16_t *n, qsizetype ns,
+                          qsizetype *positions, qsizetype maxCount) noexcept
+{
+    qsizetype count = 0;
+    qsizetype resume = i;
+    const __m256i first = _mm256_set1_epi16(short(n[0]));
+    const __m256i last = _mm256_set1_epi16(short(n[ns - 1]));
+    while (i + ns - 1 + 16 <= size) {
+        const __m256i head = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(s + i));
+        const __m256i tail = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(s + i + ns - 1));
+        uint mask = _mm256_movemask_epi8(_mm256_and_si256(_mm256_cmpeq_epi16(head, first),
+                                                          _mm256_cmpeq_epi16(tail, last)));
+        while (mask) {
+            const qsizetype pos = i + qCountTrailingZeroBits(mask) / 2;
+            mask &= mask - 1;
+            mask &= mask - 1;
+            if (pos < resume || memcmp(s + pos + 1, n + 1, (ns - 2) * sizeof(char16_t)) != 0)
+                continue;
+            positions[count++] = pos;
+            if (count == maxCount)
+                return count;
+            resume = pos + ns;
+        }
+        i = qMax(i + 16, resume);
+    }
+    return count + scanString_sse2(s, qMax(i, resume), size, n, ns,
+                                   positions + count, maxCount - count);
+}
+#  endif
+#endif // __SSE2__
+
+qsizetype QtPrivate::Tok::scanSeparators(QStringView haystack, qsizetype from, QChar separator,
+                                         qsizetype *positions, qsizetype maxCount) noexcept
+{
+    if (from >= haystack.size() || maxCount <= 0)
+        return 0;
+    const char16_t *s = haystack.utf16();
+    const char16_t c = separator.unicode();
+#if defined(__SSE2__) && QT_COMPILER_SUPPORTS_HERE(AVX2)
+    if (qCpuHasFeature(AVX2))
+        return scanChar_avx2(s, from, haystack.size(), c, positions, maxCount);
+#endif
+#ifdef __SSE2__
+    return scanChar_sse2(s, from, haystack.size(), c, positions, maxCount);
+#else
+    return scanChar_scalar(s, from, haystack.size(), c, positions, maxCount);
+#endif
+}
+
+qsizetype QtPrivate::Tok::scanSeparators(QStringView haystack, qsizetype from, QStringView separator,
+                                         qsizetype *positions, qsizetype maxCount) noexcept
+{
+    const qsizetype ns = separator.size();
+    Q_ASSERT(ns > 0);
+    if (ns == 1)
+        return scanSeparators(haystack, from, separator.front(), positions, maxCount);
+    if (from > haystack.size() - ns || maxCount <= 0)
+        return 0;
+    const char16_t *s = haystack.utf16();
+    const char16_t *n = separator.utf16();
+#if defined(__SSE2__) && QT_COMPILER_SUPPORTS_HERE(AVX2)
+    if (qCpuHasFeature(AVX2))
+        return scanString_avx2(s, from, haystack.size(), n, ns, positions, maxCount);
+#endif
+#ifdef __SSE2__
+    return scanString_sse2(s, from, haystack.size(), n, ns, positions, maxCount);
+#else
+    return scanString_scalar(s, from, haystack.size(), n, ns, positions, maxCount);
+#endif
+}
+
 /*!
     \class QStringTokenizer
     \inmodule QtCore
@@ -306,6 +487,33 @@ QT_BEGIN_NAMESPACE
     filled, and returned by value.
 */
 
+/*!
+    \fn template <typename Haystack, typename Needle> qsizetype QStringTokenizer<Haystack, Needle>::nextTokens(iterator &it, QSpan<value_type> out) const
+    \since 6.9
+
+    Writes up to \c{out.size()} tokens, starting with the one \a it points
+    to, into \a out, advances \a it past them and returns how many tokens
+    were written. A return value smaller than the size of \a out means that
+    \a it reached the end of the sequence.
+
+    This lets you process the tokens in batches without allocating memory,
+    and it finds the separators of a whole batch in one pass over the
+    haystack:
+
+    \code
+    auto tok = QStringTokenizer{line, u','};
+    QStringView fields[16];
+    auto it = tok.begin();
+    while (qsizetype n = tok.nextTokens(it, fields)) {
+        process(QSpan(fields).first(n));
+    }
+    \endcode
+
+    \a it must be an iterator of this tokenizer.
+
+    \sa begin(), toContainer()
+*/
+
 /*!
     \fn template <typename Haystack, typename Needle, typename...Flags> auto qTokenize(Haystack &&haystack, Needle &&needle, Flags...flags)
     \relates QStringTokenizer
@@ -6,6 +6,7 @@
 
     #include <QtCore/qnamespace.h>
     #include <QtCore/qcontainerfwd.h>
+    #include <QtCore/qspan.h>
     #include <iterator>
 
     QT_BEGIN_NAMESPACE
@@ -106,6 +107,8 @@
         [[nodiscard]] constexpr sentinel end() const noexcept { return {}; }
         [[nodiscard]] constexpr sentinel cend() const noexcept { return {}; }
 
+        [[nodiscard]] inline qsizetype nextTokens(iterator &it, QSpan<Haystack> out) const noexcept;
+
     private:
         Haystack m_haystack;
         Needle m_needle;
@@ -230,6 +233,38 @@
         //       : QStringTokenizerBase<QStringView, QStringView> (+ pinning)
         template <typename Haystack, typename Needle>
         using TokenizerBase = QStringTokenizerBase<ViewFor<Haystack>, ViewFor<Needle>>;
+
+        // Vectorized, case-sensitive scanners: store the positions of up to
+        // maxCount non-overlapping occurrences of the separator at or after
+        // from and return how many were found.
+        Q_CORE_EXPORT qsizetype scanSeparators(QStringView haystack, qsizetype from, QChar separator,
+                                               qsizetype *positions, qsizetype maxCount) noexcept;
+        Q_CORE_EXPORT qsizetype scanSeparators(QStringView haystack, qsizetype from, QStringView separator,
+                                               qsizetype *positions, qsizetype maxCount) noexcept;
+
+        // Finds the separators for QStringTokenizerBase. An empty separator
+        // matches at every position, so the search always moves on by at
+        // least one character.
+        template <typename Haystack, typename Needle>
+        qsizetype findSeparators(Haystack haystack, qsizetype from, Needle needle, Qt::CaseSensitivity cs,
+                                 qsizetype *positions, qsizetype maxCount) noexcept
+        {
+            const qsizetype ns = size(needle);
+            if constexpr (std::is_same<Haystack, QStringView>::value
+                          && (std::is_same<Needle, QChar>::value || std::is_same<Needle, QStringView>::value)) {
+                if (cs == Qt::CaseSensitive && ns != 0)
+                    return scanSeparators(haystack, from, needle, positions, maxCount);
+            }
+            qsizetype count = 0;
+            while (count < maxCount) {
+                const qsizetype pos = haystack.indexOf(needle, from, cs);
+                if (pos < 0)
+                    break;
+                positions[count++] = pos;
+                from = pos + (ns == 0 ? 1 : ns);
+            }
+            return count;
+        }
     } // namespace Tok
     } // namespace QtPrivate
 
@@ -271,6 +306,7 @@
         [[nodiscard]] iterator cbegin() const noexcept { return begin(); }
         [[nodiscard]] constexpr sentinel end() const noexcept { return {}; }
         [[nodiscard]] constexpr sentinel cend() const noexcept { return {}; }
+        [[nodiscard]] qsizetype nextTokens(iterator &it, QSpan<value_type> out) const noexcept;
     #endif
 
         constexpr explicit QStringTokenizer(Haystack haystack, Needle needle,
@@ -386,7 +422,9 @@
                 // already at end:
                 return {{}, false, state};
             }
-            state.end = m_haystack.indexOf(m_needle, state.start + state.extra, m_cs);
+            qsizetype pos;
+            state.end = QtPrivate::Tok::findSeparators(m_haystack, state.start + state.extra, m_needle,
+                                                       m_cs, &pos, 1) ? pos : -1;
             Haystack result;
             if (state.end >= 0) {
                 // token separator found => return intermediate element:
@@ -404,5 +442,37 @@
         }
     }
 
+    template <typename Haystack, typename Needle>
+    qsizetype QStringTokenizerBase<Haystack, Needle>::nextTokens(iterator &it, QSpan<Haystack> out) const noexcept
+    {
+        Q_ASSERT(!it.current.ok || it.tokenizer == this);
+        const auto ns = QtPrivate::Tok::size(m_needle);
+        qsizetype positions[32];
+        qsizetype n = 0;
+        while (n < out.size() && it.current.ok) {
+            out[n++] = it.current.value;
+            tokenizer_state state = it.current.state;
+            if (state.end >= 0 && n < out.size()) {
+                // the token ended at a separator, so look for the following
+                // separators in one go instead of one next() call per token:
+                const qsizetype room = out.size() - n;
+                const qsizetype maxCount = room < qsizetype(std::size(positions)) ? room : qsizetype(std::size(positions));
+                const qsizetype found = QtPrivate::Tok::findSeparators(m_haystack, state.start + state.extra,
+                                                                       m_needle, m_cs, positions, maxCount);
+                for (qsizetype i = 0; i < found; ++i) {
+                    const Haystack token = m_haystack.sliced(state.start, positions[i] - state.start);
+                    state.end = positions[i];
+                    state.start = state.end + ns;
+                    state.extra = (ns == 0 ? 1 : 0);
+                    if ((m_sb & Qt::SkipEmptyParts) && token.isEmpty())
+                        continue;
+                    out[n++] = token;
+                }
+            }
+            it.current = next(state);
+        }
+        return n;
+    }
+
     QT_END_NAMESPACE
 #endif /* QSTRINGTOKENIZER_H */
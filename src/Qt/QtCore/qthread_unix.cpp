@@ -56,6 +56,10 @@
 #include <sys/prctl.h>
 #endif
 
+#if defined(Q_OS_LINUX)
+#include <sys/syscall.h>
+#endif
+
 #if defined(Q_OS_LINUX) && !defined(SCHED_IDLE)
 // from linux/sched.h
 # define SCHED_IDLE    5
@@ -557,6 +561,159 @@ void QThread::yieldCurrentThread()
     sched_yield();
 }
 
+#if defined(Q_OS_LINUX)
+// The CPUs the process may run on, as far as the main thread is concerned;
+// the calling thread may already have been pinned to fewer.
+static bool processCpuSet(QVarLengthArray<cpu_set_t, 1> *cpuset)
+{
+    for (qsizetype size = 1; size <= 4; size *= 2) {
+        cpuset->resize(size);
+        if (sched_getaffinity(getpid(), sizeof(cpu_set_t) * size, cpuset->data()) == 0)
+            return true;
+    }
+    return false;
+}
+
+// Reads a small sysfs file into buffer, which is null-terminated
+static bool readSysFile(const char *path, char (&buffer)[4096])
+{
+    const int fd = qt_safe_open(path, O_RDONLY);
+    if (fd < 0)
+        return false;
+    const qint64 n = qt_safe_read(fd, buffer, sizeof(buffer) - 1);
+    qt_safe_close(fd);
+    if (n <= 0)
+        return false;
+    buffer[n] = '\0';
+    return true;
+}
+
+// Parses the kernel's list format, like "0-7,16-23"
+static QList<int> parseCpuList(const char *list)
+{
+    QList<int> result;
+    while (*list) {
+        char *end;
+        const long first = strtol(list, &end, 10);
+        if (end == list)
+            break;
+        long last = first;
+        if (*end == '-') {
+            list = end + 1;
+            last = strtol(list, &end, 10);
+            if (end == list)
+                break;
+        }
+        if (first < 0 || last < first || last >= 65536)
+            break;
+        for (long i = first; i <= last; ++i)
+            result.append(int(i));
+        list = end;
+        if (*list != ',')
+            break;
+        ++list;
+    }
+    return result;
+}
+#endif // Q_OS_LINUX
+
+/*!
+    \internal
+
+    Restricts the calling thread to the CPUs in \a cpus, or lets it run on
+    all CPUs available to the process if \a cpus is empty. Returns \c false
+    if that is not supported or failed.
+*/
+bool QThreadPrivate::setCurrentThreadAffinity(const QList<int> &cpus)
+{
+#if defined(Q_OS_LINUX)
+    QVarLengthArray<cpu_set_t, 1> cpuset;
+    if (cpus.isEmpty()) {
+        if (!processCpuSet(&cpuset))
+            return false;
+    } else {
+        const int maxCpu = *std::max_element(cpus.cbegin(), cpus.cend());
+        if (maxCpu < 0)
+            return false;
+        cpuset.resize(maxCpu / CPU_SETSIZE + 1);
+        const size_t setsize = sizeof(cpu_set_t) * cpuset.size();
+        CPU_ZERO_S(setsize, cpuset.data());
+        for (int cpu : cpus) {
+            if (cpu >= 0)
+                CPU_SET_S(cpu, setsize, cpuset.data());
+        }
+    }
+    return sched_setaffinity(0, sizeof(cpu_set_t) * cpuset.size(), cpuset.data()) == 0;
+#else
+    Q_UNUSED(cpus);
+    return false;
+#endif
+}
+
+/*!
+    \internal
+
+    Returns the CPUs of each NUMA node that the process may run on, indexed
+    by node number, as read from /sys/devices/system/node at the first call.
+    Returns an empty list if the topology is unknown.
+*/
+QList<QList<int>> QThreadPrivate::numaNodes()
+{
+#if defined(Q_OS_LINUX)
+    static const QList<QList<int>> nodes = [] {
+        QList<QList<int>> nodes;
+        char buffer[4096];
+        if (!readSysFile("/sys/devices/system/node/online", buffer))
+            return nodes;
+        const QList<int> online = parseCpuList(buffer);
+
+        QVarLengthArray<cpu_set_t, 1> allowed;
+        const bool haveAllowed = processCpuSet(&allowed);
+        const size_t setsize = sizeof(cpu_set_t) * allowed.size();
+        for (int node : online) {
+            char path[64];
+            snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpulist", node);
+            if (!readSysFile(path, buffer))
+                continue;
+            QList<int> cpus = parseCpuList(buffer);
+            if (haveAllowed) {
+                cpus.removeIf([&](int cpu) {
+                    return size_t(cpu) >= setsize * 8 || !CPU_ISSET_S(cpu, setsize, allowed.data());
+                });
+            }
+            if (nodes.size() <= node)
+                nodes.resize(node + 1);
+            nodes[node] = std::move(cpus);
+        }
+        return nodes;
+    }();
+    return nodes;
+#else
+    return {};
+#endif
+}
+
+/*!
+    \internal
+
+    Returns the NUMA node of the memory page that contains \a address, or -1
+    if that cannot be determined. A page that has not been touched yet is
+    allocated by this call.
+*/
+int QThreadPrivate::numaNodeOfAddress(const void *address)
+{
+#if defined(Q_OS_LINUX) && defined(SYS_get_mempolicy)
+    // MPOL_F_NODE | MPOL_F_ADDR from <linux/mempolicy.h>
+    constexpr unsigned long flags = 1 | 2;
+    int node = -1;
+    if (syscall(SYS_get_mempolicy, &node, nullptr, 0UL, address, flags) == 0)
+        return node;
+#else
+    Q_UNUSED(address);
+#endif
+    return -1;
+}
+
 #endif // QT_CONFIG(thread)
 
 static void qt_nanosleep(timespec amount)
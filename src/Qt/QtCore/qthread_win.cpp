@@ -347,6 +347,55 @@ void QThread::yieldCurrentThread()
     SwitchToThread();
 }
 
+// Only the first processor group is supported
+bool QThreadPrivate::setCurrentThreadAffinity(const QList<int> &cpus)
+{
+    DWORD_PTR mask = 0;
+    if (cpus.isEmpty()) {
+        DWORD_PTR systemMask;
+        if (!GetProcessAffinityMask(GetCurrentProcess(), &mask, &systemMask))
+            return false;
+    } else {
+        for (int cpu : cpus) {
+            if (cpu >= 0 && cpu < int(sizeof(mask) * 8))
+                mask |= DWORD_PTR(1) << cpu;
+        }
+    }
+    return mask && SetThreadAffinityMask(GetCurrentThread(), mask) != 0;
+}
+
+QList<QList<int>> QThreadPrivate::numaNodes()
+{
+    static const QList<QList<int>> nodes = [] {
+        QList<QList<int>> nodes;
+        ULONG highest;
+        DWORD_PTR processMask, systemMask;
+        if (!GetNumaHighestNodeNumber(&highest) || highest > 255
+                || !GetProcessAffinityMask(GetCurrentProcess(), &processMask, &systemMask)) {
+            return nodes;
+        }
+        nodes.resize(highest + 1);
+        for (ULONG node = 0; node <= highest; ++node) {
+            ULONGLONG mask;
+            if (!GetNumaNodeProcessorMask(UCHAR(node), &mask))
+                continue;
+            mask &= processMask;
+            for (int cpu = 0; cpu < int(sizeof(mask) * 8); ++cpu) {
+                if (mask & (ULONGLONG(1) << cpu))
+                    nodes[node].append(cpu);
+            }
+        }
+        return nodes;
+    }();
+    return nodes;
+}
+
+int QThreadPrivate::numaNodeOfAddress(const void *address)
+{
+    Q_UNUSED(address);
+    return -1;
+}
+
 #endif // QT_CONFIG(thread)
 
 void QThread::sleep(std::chrono::nanoseconds nsecs)
@@ -5,6 +5,8 @@
 #include "qthreadpool_p.h"
 #include "qdeadlinetimer.h"
 #include "qcoreapplication.h"
+#include "qvarlengtharray.h"
+#include <private/qthread_p.h>
 
 #include <QtCore/qpointer.h>
 
@@ -27,13 +29,25 @@ class QThreadPoolThread : public QThread
 public:
     QThreadPoolThread(QThreadPoolPrivate *manager);
     void run() override;
+    void runRunnable(QRunnable *r);
+    QRunnable *nextTask();
     void registerThreadInactive();
 
     QWaitCondition runnableReady;
     QThreadPoolPrivate *manager;
     QRunnable *runnable;
+
+    // work-stealing mode
+    QWorkStealingDeque *deque = nullptr;    // set while running tasks without the lock
+    int dequeSlot = -1;
+    quint32 stealSeed;
+
+    int affinityGeneration = 0;     // of the CPU affinity this thread runs with
 };
 
+// The pool thread the calling thread is, if any
+Q_CONSTINIT static thread_local QThreadPoolThread *currentPoolThread = nullptr;
+
 /*
     QThreadPool private class.
 */
@@ -43,7 +57,7 @@ public:
     \internal
 */
 QThreadPoolThread::QThreadPoolThread(QThreadPoolPrivate *manager)
-    :manager(manager), runnable(nullptr)
+    :manager(manager), runnable(nullptr), stealSeed(quint32(quintptr(this) >> 4) | 1)
 {
     setStackSize(manager->stackSize);
 }
@@ -53,53 +67,56 @@ QThreadPoolThread::QThreadPoolThread(QThreadPoolPrivate *manager)
 */
 void QThreadPoolThread::run()
 {
+    currentPoolThread = this;
     QMutexLocker locker(&manager->mutex);
+    affinityGeneration = 0;     // a (re)started thread inherits its creator's
     for(;;) {
         QRunnable *r = runnable;
         runnable = nullptr;
 
-        do {
-            if (r) {
-                // If autoDelete() is false, r might already be deleted after run(), so check status now.
-                const bool del = r->autoDelete();
+        if (affinityGeneration != manager->affinityGeneration) {
+            affinityGeneration = manager->affinityGeneration;
+            QThreadPrivate::setCurrentThreadAffinity(manager->cpuAffinity);
+        }
 
-                // run the task
-                locker.unlock();
-#ifndef QT_NO_EXCEPTIONS
-                try {
-#endif
-                    r->run();
-#ifndef QT_NO_EXCEPTIONS
-                } catch (...) {
-                    qWarning("Qt Concurrent has caught an exception thrown from a worker thread.\n"
-                             "This is not supported, exceptions thrown in worker threads must be\n"
-                             "caught before control returns to Qt Concurrent.");
-                    registerThreadInactive();
-                    throw;
+        if (manager->stealing && manager->stealing->enabled.load(std::memory_order_relaxed)) {
+            if (dequeSlot < 0)
+                dequeSlot = manager->claimDeque();
+            if (dequeSlot >= 0)
+                deque = manager->stealing->deques[dequeSlot].load(std::memory_order_relaxed);
+
+            // run tasks from our own deque, the queue and the other threads'
+            // deques until all of them are empty
+            locker.unlock();
+            do {
+                if (r)
+                    runRunnable(r);
+            } while ((r = nextTask()));
+            deque = nullptr;
+            locker.relock();
+
+            // a task may have been queued after we last looked
+            if (!manager->tooManyThreadsActive() && (runnable = manager->takeQueuedTask()))
+                continue;
+        } else {
+            do {
+                if (r) {
+                    locker.unlock();
+                    runRunnable(r);
+                    locker.relock();
                 }
-#endif
-
-                if (del)
-                    delete r;
-                locker.relock();
-            }
 
-            // if too many threads are active, stop working in this one
-            if (manager->tooManyThreadsActive())
-                break;
-
-            // all work is done, time to wait for more
-            if (manager->queue.isEmpty())
-                break;
+                // if too many threads are active, stop working in this one
+                if (manager->tooManyThreadsActive())
+                    break;
 
-            QueuePage *page = manager->queue.constFirst();
-            r = page->pop();
+                // all work is done, time to wait for more
+                if (manager->queue.isEmpty())
+                    break;
 
-            if (page->isFinished()) {
-                manager->queue.removeFirst();
-                delete page;
-            }
-        } while (true);
+                r = manager->takeQueuedTask();
+            } while (true);
+        }
 
         // this thread is about to be deleted, do not wait or expire
         if (!manager->allThreads.contains(this)) {
@@ -114,6 +131,17 @@ void QThreadPoolThread::run()
             return;
         }
         manager->waitingThreads.enqueue(this);
+        if (manager->stealing && manager->stealing->enabled.load(std::memory_order_relaxed)) {
+            // Pairs with the fence in tryPushLocal(): either the pushing
+            // thread sees that we are about to wait and wakes us, or we see
+            // its task here.
+            manager->stealing->needMoreWorkers.store(true, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (manager->hasStealableTasks()) {
+                manager->waitingThreads.removeOne(this);
+                continue;
+            }
+        }
         registerThreadInactive();
         // wait for work, exiting after the expiry timeout is reached
         runnableReady.wait(locker.mutex(), QDeadlineTimer(manager->expiryTimeout));
@@ -130,6 +158,61 @@ void QThreadPoolThread::run()
     }
 }
 
+/*
+    \internal
+
+    Runs \a r without holding the lock.
+*/
+void QThreadPoolThread::runRunnable(QRunnable *r)
+{
+    // If autoDelete() is false, r might already be deleted after run(), so check status now.
+    const bool del = r->autoDelete();
+
+    // run the task
+#ifndef QT_NO_EXCEPTIONS
+    try {
+#endif
+        r->run();
+#ifndef QT_NO_EXCEPTIONS
+    } catch (...) {
+        qWarning("Qt Concurrent has caught an exception thrown from a worker thread.\n"
+                 "This is not supported, exceptions thrown in worker threads must be\n"
+                 "caught before control returns to Qt Concurrent.");
+        registerThreadInactive();
+        throw;
+    }
+#endif
+
+    if (del)
+        delete r;
+}
+
+/*
+    \internal
+
+    Returns the next task for a thread in work-stealing mode, or nullptr if
+    there is none: the most recently pushed task of our own deque, else the
+    first one of the queue, else the oldest one of another thread's deque.
+    If too many threads are active, only our own deque counts, as this
+    thread is going to stop working. Called without holding the lock.
+*/
+QRunnable *QThreadPoolThread::nextTask()
+{
+    if (deque) {
+        if (QRunnable *r = deque->take())
+            return r;
+    }
+    QMutexLocker locker(&manager->mutex);
+    if (manager->tooManyThreadsActive())
+        return nullptr;
+    if (manager->stealing->queueHint.load(std::memory_order_relaxed)) {
+        if (QRunnable *r = manager->takeQueuedTask())
+            return r;
+    }
+    locker.unlock();
+    return manager->stealTask(this);
+}
+
 void QThreadPoolThread::registerThreadInactive()
 {
     if (--manager->activeThreads == 0)
@@ -164,19 +247,7 @@ bool QThreadPoolPrivate::tryStart(QRunnable *task)
     }
 
     if (!expiredThreads.isEmpty()) {
-        // restart an expired thread
-        QThreadPoolThread *thread = expiredThreads.dequeue();
-        Q_ASSERT(thread->runnable == nullptr);
-
-        ++activeThreads;
-
-        thread->runnable = task;
-
-        // Ensure that the thread has actually finished, otherwise the following
-        // start() has no effect.
-        thread->wait();
-        Q_ASSERT(thread->isFinished());
-        thread->start(threadPriority);
+        restartExpiredThread(task);
         return true;
     }
 
@@ -196,11 +267,38 @@ void QThreadPoolPrivate::enqueueTask(QRunnable *runnable, int priority)
     for (QueuePage *page : std::as_const(queue)) {
         if (page->priority() == priority && !page->isFull()) {
             page->push(runnable);
+            if (stealing)
+                stealing->queueHint.store(true, std::memory_order_relaxed);
             return;
         }
     }
     auto it = std::upper_bound(queue.constBegin(), queue.constEnd(), priority, comparePriority);
     queue.insert(std::distance(queue.constBegin(), it), new QueuePage(runnable, priority));
+    if (stealing)
+        stealing->queueHint.store(true, std::memory_order_relaxed);
+}
+
+/*!
+    \internal
+
+    Removes the first runnable from the queue and returns it, or returns
+    nullptr if the queue is empty. Must be called with the lock held.
+*/
+QRunnable *QThreadPoolPrivate::takeQueuedTask()
+{
+    QRunnable *runnable = nullptr;
+    if (!queue.isEmpty()) {
+        QueuePage *page = queue.constFirst();
+        runnable = page->pop();
+
+        if (page->isFinished()) {
+            queue.removeFirst();
+            delete page;
+        }
+    }
+    if (stealing && queue.isEmpty())
+        stealing->queueHint.store(false, std::memory_order_relaxed);
+    return runnable;
 }
 
 int QThreadPoolPrivate::activeThreadCount() const
@@ -226,6 +324,9 @@ void QThreadPoolPrivate::tryToStartMoreThreads()
             delete page;
         }
     }
+    if (stealing && queue.isEmpty())
+        stealing->queueHint.store(false, std::memory_order_relaxed);
+    updateWorkStealingHints();
 }
 
 bool QThreadPoolPrivate::areAllThreadsActive() const
@@ -245,7 +346,7 @@ bool QThreadPoolPrivate::tooManyThreadsActive() const
 */
 void QThreadPoolPrivate::startThread(QRunnable *runnable)
 {
-    Q_ASSERT(runnable != nullptr);
+    Q_ASSERT(runnable != nullptr || stealing); // without a task, the thread has to steal one
     auto thread = std::make_unique<QThreadPoolThread>(this);
     if (objectName.isEmpty())
         objectName = u"Thread (pooled)"_s;
@@ -258,6 +359,166 @@ void QThreadPoolPrivate::startThread(QRunnable *runnable)
     thread.release()->start(threadPriority);
 }
 
+/*!
+    \internal
+
+    Restarts the least recently expired thread with \a runnable.
+*/
+void QThreadPoolPrivate::restartExpiredThread(QRunnable *runnable)
+{
+    QThreadPoolThread *thread = expiredThreads.dequeue();
+    Q_ASSERT(thread->runnable == nullptr);
+
+    ++activeThreads;
+
+    thread->runnable = runnable;
+
+    // Ensure that the thread has actually finished, otherwise the following
+    // start() has no effect.
+    thread->wait();
+    Q_ASSERT(thread->isFinished());
+    thread->start(threadPriority);
+}
+
+/*!
+    \internal
+
+    Pushes \a runnable onto the calling thread's deque if the calling thread
+    is one of ours in work-stealing mode, and wakes up or starts another
+    thread to steal it if there is capacity for one. Returns \c false if the
+    runnable needs to be queued instead.
+
+    Runnables that are not auto-deleting always go to the queue: their
+    owners may take them back with QThreadPool::tryTake(), which only
+    searches the queue.
+*/
+bool QThreadPoolPrivate::tryPushLocal(QRunnable *runnable)
+{
+    QThreadPoolThread *self = currentPoolThread;
+    if (!self || self->manager != this || !self->deque || !runnable->autoDelete())
+        return false;
+    if (!stealing->enabled.load(std::memory_order_relaxed) || !self->deque->push(runnable))
+        return false;
+
+    // Pairs with the fence in QThreadPoolThread::run(), see there
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (stealing->needMoreWorkers.load(std::memory_order_relaxed)) {
+        QMutexLocker locker(&mutex);
+        wakeIdleThread();
+    }
+    return true;
+}
+
+/*!
+    \internal
+
+    Steals a task from the deque of a thread other than \a thief, trying the
+    deques in an order that differs from thief to thief. Returns nullptr if
+    all deques are empty.
+*/
+QRunnable *QThreadPoolPrivate::stealTask(QThreadPoolThread *thief)
+{
+    const int count = stealing->dequeCount.load(std::memory_order_acquire);
+    if (count == 0)
+        return nullptr;
+
+    // xorshift32
+    quint32 &seed = thief->stealSeed;
+    seed ^= seed << 13;
+    seed ^= seed >> 17;
+    seed ^= seed << 5;
+    const int start = int(seed % quint32(count));
+
+    bool lostRace;
+    do {
+        lostRace = false;
+        for (int i = 0; i < count; ++i) {
+            int slot = start + i;
+            if (slot >= count)
+                slot -= count;
+            QWorkStealingDeque *victim = stealing->deques[slot].load(std::memory_order_acquire);
+            if (victim == thief->deque)
+                continue;
+            if (QRunnable *r = victim->steal(&lostRace))
+                return r;
+        }
+    } while (lostRace);
+    return nullptr;
+}
+
+/*!
+    \internal
+
+    Returns \c true if any thread's deque holds a task.
+*/
+bool QThreadPoolPrivate::hasStealableTasks() const
+{
+    const int count = stealing->dequeCount.load(std::memory_order_acquire);
+    for (int i = 0; i < count; ++i) {
+        if (!stealing->deques[i].load(std::memory_order_acquire)->isEmpty())
+            return true;
+    }
+    return false;
+}
+
+/*!
+    \internal
+
+    Hands out a deque that no thread owns, creating it if necessary. Returns
+    its slot, or -1 if QThreadPoolStealingState::MaxThreads threads already
+    own one. Must be called with the lock held.
+*/
+int QThreadPoolPrivate::claimDeque()
+{
+    const int count = stealing->dequeCount.load(std::memory_order_relaxed);
+    for (int i = 0; i < count; ++i) {
+        if (!stealing->claimed[i]) {
+            stealing->claimed[i] = true;
+            return i;
+        }
+    }
+    if (count == QThreadPoolStealingState::MaxThreads)
+        return -1;
+
+    stealing->deques[count].store(new QWorkStealingDeque, std::memory_order_release);
+    stealing->claimed[count] = true;
+    stealing->dequeCount.store(count + 1, std::memory_order_release);
+    return count;
+}
+
+/*!
+    \internal
+
+    Wakes up a waiting thread, or restarts or starts one if we are below the
+    maximum thread count, so that it can steal a task that was pushed onto a
+    deque. Must be called with the lock held.
+*/
+void QThreadPoolPrivate::wakeIdleThread()
+{
+    // if all threads are active, each one looks for work before it waits
+    if (!waitingThreads.isEmpty())
+        waitingThreads.takeFirst()->runnableReady.wakeOne();
+    else if (!areAllThreadsActive() && !expiredThreads.isEmpty())
+        restartExpiredThread();
+    else if (!areAllThreadsActive())
+        startThread();
+    updateWorkStealingHints();
+}
+
+/*!
+    \internal
+
+    Tells threads pushing onto their deques whether there is a thread to
+    wake up or start. Must be called with the lock held.
+*/
+void QThreadPoolPrivate::updateWorkStealingHints()
+{
+    if (!stealing)
+        return;
+    const bool needMoreWorkers = !waitingThreads.isEmpty() || !areAllThreadsActive();
+    stealing->needMoreWorkers.store(needMoreWorkers, std::memory_order_relaxed);
+}
+
 /*!
     \internal
 
@@ -274,15 +535,23 @@ void QThreadPoolPrivate::reset()
 
     mutex.unlock();
 
+    QVarLengthArray<int, 16> dequeSlots;
     for (QThreadPoolThread *thread : std::as_const(allThreadsCopy)) {
         if (thread->isRunning()) {
             thread->runnableReady.wakeAll();
             thread->wait();
         }
+        if (thread->dequeSlot >= 0)
+            dequeSlots.append(thread->dequeSlot);
         delete thread;
     }
 
     mutex.lock();
+
+    // the deques are empty, as their threads were done
+    for (int slot : std::as_const(dequeSlots))
+        stealing->claimed[slot] = false;
+    updateWorkStealingHints();
 }
 
 /*!
@@ -321,6 +590,26 @@ void QThreadPoolPrivate::clear()
         }
         delete page;
     }
+    if (!stealing)
+        return;
+    stealing->queueHint.store(false, std::memory_order_relaxed);
+
+    // steal everything the threads have not started yet
+    const int count = stealing->dequeCount.load(std::memory_order_acquire);
+    for (int i = 0; i < count; ++i) {
+        QWorkStealingDeque *deque = stealing->deques[i].load(std::memory_order_acquire);
+        for (;;) {
+            bool lostRace = false;
+            QRunnable *r = deque->steal(&lostRace);
+            if (!r && !lostRace)
+                break;
+            if (r && r->autoDelete()) {
+                locker.unlock();
+                delete r;
+                locker.relock();
+            }
+        }
+    }
 }
 
 /*!
@@ -331,6 +620,10 @@ void QThreadPoolPrivate::clear()
     is transferred to the caller (even when \c{runnable->autoDelete() == true}).
     Otherwise returns \c false.
 
+    \note In work-stealing mode, auto-deleting runnables that pool threads
+    have pushed onto their own deques are not in the queue and cannot be
+    taken. Runnables that are not auto-deleting always go to the queue.
+
     \note If \c{runnable->autoDelete() == true}, this function may remove the wrong
     runnable. This is known as the \l{https://en.wikipedia.org/wiki/ABA_problem}{ABA problem}:
     the original \a runnable may already have executed and has since been deleted.
@@ -428,6 +721,23 @@ void QThreadPoolPrivate::stealAndRunRunnable(QRunnable *runnable)
     implementing time-consuming operations that are not visible to the
     QThreadPool.
 
+    \section1 Work Stealing
+
+    By default, all runnables go through one queue that is protected by a
+    mutex. When runnables themselves start many small runnables, as
+    divide-and-conquer algorithms do, that mutex can become the bottleneck.
+    After setWorkStealingEnabled(true), each pool thread keeps a deque of
+    its own: runnables that a pool thread starts with the default priority
+    are pushed onto its deque without taking the lock, and the thread runs
+    them most recent first. Threads that run out of work steal the oldest
+    runnables from the other threads' deques.
+
+    Runnables started with a non-default priority or from a thread that
+    does not belong to the pool still go through the shared queue, and so
+    do runnables that are not auto-deleting, so that tryTake() can find
+    them. A thread prefers the runnables on its own deque to those in the
+    queue, so priorities only order runnables within the queue.
+
     Note that QThreadPool is a low-level class for managing threads, see
     the Qt Concurrent module for higher level alternatives.
 
@@ -474,6 +784,122 @@ QThreadPool *QThreadPool::globalInstance()
     return theInstance;
 }
 
+/*!
+    \since 6.9
+
+    Returns a thread pool whose threads run on the CPUs of NUMA node \a node
+    only, creating it on the first call. Its maxThreadCount() is the number of
+    those CPUs that the process may use. Returns globalInstance() if \a node
+    is not a NUMA node with such CPUs, for example -1.
+
+    Threads that work on the same memory over and over run faster on the node
+    that the memory is on, and memory that they allocate and touch first ends
+    up on that node, too. To run a task where its data is:
+
+    \snippet code/src_corelib_concurrent_qthreadpool.cpp 1
+
+    The topology is read once. NUMA nodes are currently only detected on Linux
+    and Windows.
+
+    Like globalInstance(), these pools are waited for and deleted when the
+    QCoreApplication is destroyed. From then on, this function returns
+    globalInstance() instead of creating a pool.
+
+    \sa numaNodeForAddress(), numaNodeCount(), setCpuAffinity()
+*/
+QThreadPool *QThreadPool::numaNodeInstance(int node)
+{
+    const QList<QList<int>> nodes = QThreadPrivate::numaNodes();
+    if (node < 0 || node >= nodes.size() || nodes.at(node).isEmpty())
+        return globalInstance();
+
+    QList<QPointer<QThreadPool>> &instances = QThreadPoolPrivate::numaNodeInstanceList();
+    const QMutexLocker locker(&QThreadPoolPrivate::numaNodeInstanceMutex);
+    if (instances.size() < nodes.size())
+        instances.resize(nodes.size());
+    QPointer<QThreadPool> &instance = instances[node];
+    if (instance.isNull()) {
+        if (QCoreApplication::closingDown())
+            return globalInstance();
+        instance = new QThreadPool();
+        instance->setMaxThreadCount(int(nodes.at(node).size()));
+        instance->setCpuAffinity(nodes.at(node));
+    }
+    return instance;
+}
+
+/*!
+    \since 6.9
+
+    Returns the number of NUMA nodes, or 0 if the topology is unknown. Node
+    numbers run from 0 to numaNodeCount() - 1; nodes that are offline, or
+    whose CPUs the process may not use, have no CPUs.
+
+    \sa numaNodeCpus(), numaNodeInstance()
+*/
+int QThreadPool::numaNodeCount()
+{
+    return int(QThreadPrivate::numaNodes().size());
+}
+
+/*!
+    \since 6.9
+
+    Returns the CPUs of NUMA node \a node that the process may use.
+
+    \sa numaNodeCount(), setCpuAffinity()
+*/
+QList<int> QThreadPool::numaNodeCpus(int node)
+{
+    return QThreadPrivate::numaNodes().value(node);
+}
+
+/*!
+    \since 6.9
+
+    Returns the NUMA node of the memory at \a address, or -1 if it is not
+    known. The memory page is allocated if it was not yet touched.
+
+    Only implemented on Linux.
+
+    \sa numaNodeInstance()
+*/
+int QThreadPool::numaNodeForAddress(const void *address)
+{
+    return QThreadPrivate::numaNodeOfAddress(address);
+}
+
+/*!
+    \internal
+
+    The pools created by QThreadPool::numaNodeInstance(), indexed by node.
+    Guarded by numaNodeInstanceMutex.
+*/
+QList<QPointer<QThreadPool>> &QThreadPoolPrivate::numaNodeInstanceList()
+{
+    static QList<QPointer<QThreadPool>> instances;
+    return instances;
+}
+
+Q_CONSTINIT QBasicMutex QThreadPoolPrivate::numaNodeInstanceMutex;
+
+/*!
+    \internal
+
+    Returns the pools that QThreadPool::numaNodeInstance() has created and
+    that still exist, so that QCoreApplication can stop them on exit.
+*/
+QList<QThreadPool *> QThreadPoolPrivate::numaNodeInstances()
+{
+    const QMutexLocker locker(&numaNodeInstanceMutex);
+    QList<QThreadPool *> result;
+    for (const QPointer<QThreadPool> &instance : std::as_const(numaNodeInstanceList())) {
+        if (instance)
+            result.append(instance.data());
+    }
+    return result;
+}
+
 /*!
     Returns the QThreadPool instance for Qt Gui.
     \internal
@@ -510,6 +936,10 @@ QThreadPool *QThreadPoolPrivate::qtGuiInstance()
     ownership of \a runnable remains with the caller. Note that
     changing the auto-deletion on \a runnable after calling this
     functions results in undefined behavior.
+
+    In \l{Work Stealing}{work-stealing mode}, a pool thread that calls this
+    function with the default \a priority pushes \a runnable onto its own
+    deque instead, unless \a runnable is not auto-deleting.
 */
 void QThreadPool::start(QRunnable *runnable, int priority)
 {
@@ -517,6 +947,9 @@ void QThreadPool::start(QRunnable *runnable, int priority)
         return;
 
     Q_D(QThreadPool);
+    if (priority == 0 && d->tryPushLocal(runnable))
+        return;
+
     QMutexLocker locker(&d->mutex);
 
     if (!d->tryStart(runnable))
@@ -745,6 +1178,93 @@ QThread::Priority QThreadPool::threadPriority() const
     return d->threadPriority;
 }
 
+/*!
+    \since 6.9
+
+    Enables work-stealing mode if \a enabled is \c true, or disables it
+    otherwise. Work-stealing mode is disabled by default.
+
+    While it is enabled, auto-deleting runnables that a pool thread starts
+    with the default priority go onto a deque owned by that thread instead of
+    the shared queue, and idle threads steal from the other threads' deques.
+    Runnables that are not auto-deleting still go to the queue, so that
+    tryTake() can find them. At most 256 threads of a pool get a deque; any
+    others only take runnables from the queue and steal.
+
+    Disabling the mode does not move runnables that are already on a deque;
+    their threads still run them.
+
+    \sa isWorkStealingEnabled(), start()
+*/
+void QThreadPool::setWorkStealingEnabled(bool enabled)
+{
+    Q_D(QThreadPool);
+    QMutexLocker locker(&d->mutex);
+    if (!d->stealing) {
+        if (!enabled)
+            return;
+        d->stealing = std::make_unique<QThreadPoolStealingState>();
+        d->stealing->queueHint.store(!d->queue.isEmpty(), std::memory_order_relaxed);
+    }
+    d->stealing->enabled.store(enabled, std::memory_order_relaxed);
+    d->updateWorkStealingHints();
+}
+
+/*!
+    \since 6.9
+
+    Returns \c true if work-stealing mode is enabled.
+
+    \sa setWorkStealingEnabled()
+*/
+bool QThreadPool::isWorkStealingEnabled() const
+{
+    Q_D(const QThreadPool);
+    QMutexLocker locker(&d->mutex);
+    return d->stealing && d->stealing->enabled.load(std::memory_order_relaxed);
+}
+
+/*!
+    \since 6.9
+
+    Restricts the threads of this pool to the CPUs in \a cpus, numbered as
+    by the operating system. An empty list lets them run on all CPUs that
+    the process may use. A thread applies a new setting the next time it
+    picks up a runnable.
+
+    Keeping a pool on the CPUs of one NUMA node avoids cross-node migrations
+    and remote memory accesses; numaNodeInstance() does that for you.
+
+    By default, the pool does not change the affinity of its threads, and
+    they inherit it from the thread that started them. This is only
+    supported on Linux and, for the first 64 CPUs, on Windows; elsewhere,
+    the setting has no effect.
+
+    \sa cpuAffinity(), numaNodeCpus()
+*/
+void QThreadPool::setCpuAffinity(const QList<int> &cpus)
+{
+    Q_D(QThreadPool);
+    QMutexLocker locker(&d->mutex);
+    d->cpuAffinity = cpus;
+    ++d->affinityGeneration;
+}
+
+/*!
+    \since 6.9
+
+    Returns the CPUs that the threads of this pool are restricted to, or an
+    empty list if they are not restricted.
+
+    \sa setCpuAffinity()
+*/
+QList<int> QThreadPool::cpuAffinity() const
+{
+    Q_D(const QThreadPool);
+    QMutexLocker locker(&d->mutex);
+    return d->cpuAffinity;
+}
+
 /*!
     Releases a thread previously reserved by a call to reserveThread().
 
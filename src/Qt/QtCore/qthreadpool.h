@@ -7,6 +7,7 @@
 #include <QtCore/qglobal.h>
 #include <QtCore/qthread.h>
 #include <QtCore/qrunnable.h>
+#include <QtCore/qlist.h>
 
 #if QT_CORE_REMOVED_SINCE(6, 6)
 #include <functional>
@@ -33,6 +34,11 @@ public:
     ~QThreadPool();
 
     static QThreadPool *globalInstance();
+    static QThreadPool *numaNodeInstance(int node);
+
+    static int numaNodeCount();
+    static QList<int> numaNodeCpus(int node);
+    static int numaNodeForAddress(const void *address);
 
     void start(QRunnable *runnable, int priority = 0);
     bool tryStart(QRunnable *runnable);
@@ -68,6 +74,12 @@ public:
     void setThreadPriority(QThread::Priority priority);
     QThread::Priority threadPriority() const;
 
+    void setWorkStealingEnabled(bool enabled);
+    bool isWorkStealingEnabled() const;
+
+    void setCpuAffinity(const QList<int> &cpus);
+    QList<int> cpuAffinity() const;
+
     void reserveThread();
     void releaseThread();
 
@@ -36,6 +36,64 @@
         int isAsciiPrintable(char32_t ch) noexcept;
 
         int qt_lencmp(qsizetype lhs, qsizetype rhs) noexcept;
+
+        // Tables of all two-digit strings, "00" to "99" and "00" to "ff", so
+        // that numbers can be converted to text two digits per division.
+        struct DigitPairTables
+        {
+            char decimal[2 * 100];
+            char hex[2 * 256];
+        };
+
+        constexpr DigitPairTables makeDigitPairTables() noexcept
+        {
+            DigitPairTables tables = {};
+            for (int i = 0; i < 100; ++i) {
+                tables.decimal[2 * i] = char('0' + i / 10);
+                tables.decimal[2 * i + 1] = char('0' + i % 10);
+            }
+            for (int i = 0; i < 256; ++i) {
+                tables.hex[2 * i] = "0123456789abcdef"[i >> 4];
+                tables.hex[2 * i + 1] = "0123456789abcdef"[i & 0xF];
+            }
+            return tables;
+        }
+
+        inline constexpr DigitPairTables digitPairTables = makeDigitPairTables();
+
+        // Writes the decimal digits of number backwards into the buffer ending
+        // at p and leaves p pointing at the first digit.
+        template <typename Char>
+        inline void ulltoDecimal(quint64 number, Char *&p) noexcept
+        {
+            while (number >= 100) {
+                const unsigned pair = unsigned(number % 100) * 2;
+                number /= 100;
+                *--p = Char(digitPairTables.decimal[pair + 1]);
+                *--p = Char(digitPairTables.decimal[pair]);
+            }
+            if (number >= 10) {
+                *--p = Char(digitPairTables.decimal[number * 2 + 1]);
+                *--p = Char(digitPairTables.decimal[number * 2]);
+            } else {
+                *--p = Char('0' + number);
+            }
+        }
+
+        // As ulltoDecimal(), for lower-case hexadecimal digits.
+        template <typename Char>
+        inline void ulltoHex(quint64 number, Char *&p) noexcept
+        {
+            while (number > 0xFF) {
+                const unsigned pair = unsigned(number & 0xFF) * 2;
+                number >>= 8;
+                *--p = Char(digitPairTables.hex[pair + 1]);
+                *--p = Char(digitPairTables.hex[pair]);
+            }
+            *--p = Char(digitPairTables.hex[number * 2 + 1]);
+            if (number > 0xF)
+                *--p = Char(digitPairTables.hex[number * 2]);
+        }
     } // namespace QtMiscUtils
 
 #endif // QTMISCUTILS_H
@@ -14,6 +14,7 @@
 #include <QtCore/qalgorithms.h>
 #include <QtCore/qcontainertools_impl.h>
 #include <QtCore/qhashfunctions.h>
+#include <QtCore/qmonotonicarena.h>
 #include <QtCore/qttypetraits.h>
 
 #include <algorithm>
@@ -199,8 +200,9 @@ public:
         return qHashRange(begin(), end(), seed);
     }
 protected:
-    void growBy(qsizetype prealloc, void *array, qsizetype increment)
-    { reallocate_impl(prealloc, array, size(), (std::max)(size() * 2, size() + increment)); }
+    void growBy(qsizetype prealloc, void *array, qsizetype increment,
+                QMonotonicArena *arena = nullptr)
+    { reallocate_impl(prealloc, array, size(), (std::max)(size() * 2, size() + increment), arena); }
     template <typename...Args>
     reference emplace_back_impl(qsizetype prealloc, void *array, Args&&...args)
     {
@@ -213,7 +215,8 @@ protected:
     template <typename...Args>
     iterator emplace_impl(qsizetype prealloc, void *array, const_iterator pos, Args&&...arg);
 
-    iterator insert_impl(qsizetype prealloc, void *array, const_iterator pos, qsizetype n, const T &t);
+    iterator insert_impl(qsizetype prealloc, void *array, const_iterator pos, qsizetype n, const T &t,
+                         QMonotonicArena *arena = nullptr);
 
     template <typename S>
     bool equal(const QVLABase<S> &other) const
@@ -226,23 +229,28 @@ protected:
         return std::lexicographical_compare(begin(), end(), other.begin(), other.end());
     }
 
-    void append_impl(qsizetype prealloc, void *array, const T *buf, qsizetype n);
-    void reallocate_impl(qsizetype prealloc, void *array, qsizetype size, qsizetype alloc);
-    void resize_impl(qsizetype prealloc, void *array, qsizetype sz, const T &v)
+    // The optional arena supplies the memory beyond the preallocated buffer
+    // instead of malloc(); an array must stick to the same one throughout.
+    void append_impl(qsizetype prealloc, void *array, const T *buf, qsizetype n,
+                     QMonotonicArena *arena = nullptr);
+    void reallocate_impl(qsizetype prealloc, void *array, qsizetype size, qsizetype alloc,
+                         QMonotonicArena *arena = nullptr);
+    void resize_impl(qsizetype prealloc, void *array, qsizetype sz, const T &v,
+                     QMonotonicArena *arena = nullptr)
     {
         if (QtPrivate::q_points_into_range(&v, begin(), end())) {
-            resize_impl(prealloc, array, sz, T(v));
+            resize_impl(prealloc, array, sz, T(v), arena);
             return;
         }
-        reallocate_impl(prealloc, array, sz, qMax(sz, capacity()));
+        reallocate_impl(prealloc, array, sz, qMax(sz, capacity()), arena);
         while (size() < sz) {
             q20::construct_at(data() + size(), v);
             ++s;
         }
     }
-    void resize_impl(qsizetype prealloc, void *array, qsizetype sz)
+    void resize_impl(qsizetype prealloc, void *array, qsizetype sz, QMonotonicArena *arena = nullptr)
     {
-        reallocate_impl(prealloc, array, sz, qMax(sz, capacity()));
+        reallocate_impl(prealloc, array, sz, qMax(sz, capacity()), arena);
         if constexpr (QTypeInfo<T>::isComplex) {
             // call default constructor for new objects (which can throw)
             while (size() < sz) {
@@ -756,7 +764,8 @@ Q_INLINE_TEMPLATE bool QVLABase<T>::contains(const AT &t) const
 }
 
 template <class T>
-Q_OUTOFLINE_TEMPLATE void QVLABase<T>::append_impl(qsizetype prealloc, void *array, const T *abuf, qsizetype increment)
+Q_OUTOFLINE_TEMPLATE void QVLABase<T>::append_impl(qsizetype prealloc, void *array, const T *abuf, qsizetype increment,
+                                                   QMonotonicArena *arena)
 {
     Q_ASSERT(abuf || increment == 0);
     if (increment <= 0)
@@ -765,7 +774,7 @@ Q_OUTOFLINE_TEMPLATE void QVLABase<T>::append_impl(qsizetype prealloc, void *arr
     const qsizetype asize = size() + increment;
 
     if (asize >= capacity())
-        growBy(prealloc, array, increment);
+        growBy(prealloc, array, increment, arena);
 
     if constexpr (QTypeInfo<T>::isComplex)
         std::uninitialized_copy_n(abuf, increment, end());
@@ -831,25 +840,52 @@ Q_OUTOFLINE_TEMPLATE void QVLABase<T>::assign_impl(qsizetype prealloc, void *arr
 }
 
 template <class T>
-Q_OUTOFLINE_TEMPLATE void QVLABase<T>::reallocate_impl(qsizetype prealloc, void *array, qsizetype asize, qsizetype aalloc)
+Q_OUTOFLINE_TEMPLATE void QVLABase<T>::reallocate_impl(qsizetype prealloc, void *array, qsizetype asize, qsizetype aalloc,
+                                                       QMonotonicArena *arena)
 {
     Q_ASSERT(aalloc >= asize);
     Q_ASSERT(data());
     T *oldPtr = data();
     qsizetype osize = size();
+    const qsizetype oldAlloc = capacity();
 
     const qsizetype copySize = qMin(asize, osize);
     Q_ASSERT(copySize >= 0);
 
-    if (aalloc != capacity()) {
+    const bool onHeap = oldPtr != reinterpret_cast<T *>(array);
+    if (aalloc == capacity()) {
+        // nothing to reallocate
+    } else if (arena && onHeap && aalloc > prealloc
+               && arena->resize(oldPtr, aalloc * qsizetype(sizeof(T)))) {
+        // the block was the arena's most recent allocation and grew or shrank in place
+        a = aalloc;
+    } else if (QTypeInfo<T>::isRelocatable && !arena && onHeap && aalloc > prealloc) {
+        // realloc() can often extend the block in place, and otherwise moves
+        // the (relocatable) elements with memcpy, so there is nothing to relocate here
+        if constexpr (QTypeInfo<T>::isComplex) {
+            if (osize > asize)
+                std::destroy(oldPtr + asize, oldPtr + osize);
+        }
+        s = copySize;
+        void *newPtr = realloc(static_cast<void *>(oldPtr), aalloc * sizeof(T));
+        Q_CHECK_PTR(newPtr); // could throw, the old block is still valid then
+        ptr = newPtr;
+        a = aalloc;
+        return;
+    } else {
         QVLABaseBase::malloced_ptr guard;
         void *newPtr;
         qsizetype newA;
         if (aalloc > prealloc) {
-            newPtr = malloc(aalloc * sizeof(T));
-            guard.reset(newPtr);
-            Q_CHECK_PTR(newPtr); // could throw
-            // by design: in case of QT_NO_EXCEPTIONS malloc must not fail or it crashes here
+            if (arena) {
+                // if the relocation throws, the block just stays unused in the arena
+                newPtr = arena->allocate(aalloc * qsizetype(sizeof(T)), alignof(T));
+            } else {
+                newPtr = malloc(aalloc * sizeof(T));
+                guard.reset(newPtr);
+                Q_CHECK_PTR(newPtr); // could throw
+                // by design: in case of QT_NO_EXCEPTIONS malloc must not fail or it crashes here
+            }
             newA = aalloc;
         } else {
             newPtr = array;
@@ -870,8 +906,12 @@ Q_OUTOFLINE_TEMPLATE void QVLABase<T>::reallocate_impl(qsizetype prealloc, void
             std::destroy(oldPtr + asize, oldPtr + osize);
     }
 
-    if (oldPtr != reinterpret_cast<T *>(array) && oldPtr != data())
-        free(oldPtr);
+    if (onHeap && oldPtr != data()) {
+        if (arena)
+            arena->deallocate(oldPtr, oldAlloc * qsizetype(sizeof(T)));
+        else
+            free(oldPtr);
+    }
 }
 
 template <class T>
@@ -948,12 +988,13 @@ Q_OUTOFLINE_TEMPLATE auto QVLABase<T>::emplace_impl(qsizetype prealloc, void *ar
 }
 
 template <class T>
-Q_OUTOFLINE_TEMPLATE auto QVLABase<T>::insert_impl(qsizetype prealloc, void *array, const_iterator before, qsizetype n, const T &t) -> iterator
+Q_OUTOFLINE_TEMPLATE auto QVLABase<T>::insert_impl(qsizetype prealloc, void *array, const_iterator before, qsizetype n, const T &t,
+                                                   QMonotonicArena *arena) -> iterator
 {
     Q_ASSERT_X(isValidIterator(before), "QVarLengthArray::insert", "The specified const_iterator argument 'before' is invalid");
 
     const qsizetype offset = qsizetype(before - cbegin());
-    resize_impl(prealloc, array, size() + n, t);
+    resize_impl(prealloc, array, size() + n, t, arena);
     const auto b = begin() + offset;
     const auto e = end();
     QtPrivate::q_rotate(b, e - n, e);
@@ -1027,6 +1068,216 @@ qsizetype erase_if(QVarLengthArray<T, Prealloc> &array, Predicate pred)
     return array.removeIf(pred);
 }
 
+// A QVarLengthArray whose elements overflow from the preallocated buffer
+// into a QMonotonicArena rather than into malloc()ed memory, for scratch
+// arrays that all die together. The arena must outlive the array. Without
+// an arena, it allocates from the heap just like QVarLengthArray.
+template <class T, qsizetype Prealloc = QVarLengthArrayDefaultPrealloc>
+class QArenaVarLengthArray
+    : public QVLAStorage<sizeof(T), alignof(T), Prealloc>,
+      public QVLABase<T>
+{
+    using Base = QVLABase<T>;
+    static_assert(Prealloc > 0, "QArenaVarLengthArray Prealloc must be greater than 0.");
+    static_assert(std::is_nothrow_destructible_v<T>, "Types with throwing destructors are not supported in Qt containers.");
+
+    template <typename InputIterator>
+    using if_input_iterator = QtPrivate::IfIsInputIterator<InputIterator>;
+public:
+    static constexpr qsizetype PreallocatedSize = Prealloc;
+
+    using size_type = typename Base::size_type;
+    using value_type = typename Base::value_type;
+    using pointer = typename Base::pointer;
+    using const_pointer = typename Base::const_pointer;
+    using reference = typename Base::reference;
+    using const_reference = typename Base::const_reference;
+    using difference_type = typename Base::difference_type;
+
+    using iterator = typename Base::iterator;
+    using const_iterator = typename Base::const_iterator;
+    using reverse_iterator = typename Base::reverse_iterator;
+    using const_reverse_iterator = typename Base::const_reverse_iterator;
+
+    explicit QArenaVarLengthArray(QMonotonicArena *arena = nullptr) noexcept
+        : m_arena(arena)
+    {
+        this->a = Prealloc;
+        this->s = 0;
+        this->ptr = this->array;
+    }
+
+    QArenaVarLengthArray(std::initializer_list<T> args, QMonotonicArena *arena = nullptr)
+        : QArenaVarLengthArray(args.begin(), args.end(), arena)
+    {
+    }
+
+    template <typename InputIterator, if_input_iterator<InputIterator> = true>
+    QArenaVarLengthArray(InputIterator first, InputIterator last, QMonotonicArena *arena = nullptr)
+        : QArenaVarLengthArray(arena)
+    {
+        QtPrivate::reserveIfForwardIterator(this, first, last);
+        std::copy(first, last, std::back_inserter(*this));
+    }
+
+    QArenaVarLengthArray(const QArenaVarLengthArray &other)
+        : QArenaVarLengthArray(other.m_arena)
+    {
+        append(other.constData(), other.size());
+    }
+
+    QArenaVarLengthArray(QArenaVarLengthArray &&other)
+            noexcept(std::is_nothrow_move_constructible_v<T>)
+        : QArenaVarLengthArray(other.m_arena)
+    {
+        stealFrom(other);
+    }
+
+    ~QArenaVarLengthArray()
+    {
+        if constexpr (QTypeInfo<T>::isComplex)
+            std::destroy_n(data(), this->size());
+        releaseHeap();
+    }
+
+    QArenaVarLengthArray &operator=(const QArenaVarLengthArray &other)
+    {
+        if (this != &other) {
+            this->clear();
+            append(other.constData(), other.size());
+        }
+        return *this;
+    }
+
+    QArenaVarLengthArray &operator=(QArenaVarLengthArray &&other)
+    {
+        // only required to be safe for self-move-assignment in the moved-from (empty) state
+        this->clear();
+        if (m_arena == other.m_arena) {
+            releaseHeap();
+            this->a = Prealloc;
+            this->ptr = this->array;
+            stealFrom(other);
+        } else {
+            // the other array's heap block belongs to another arena (or the
+            // heap) and can't be adopted, so relocate the elements instead
+            reserve(other.size());
+            QtPrivate::q_uninitialized_relocate_n(other.data(), other.size(), data());
+            this->s = std::exchange(other.s, 0);
+        }
+        return *this;
+    }
+
+    QArenaVarLengthArray &operator=(std::initializer_list<T> list)
+    {
+        this->clear();
+        reserve(qsizetype(list.size()));
+        for (const T &t : list)
+            append(t);
+        return *this;
+    }
+
+    QMonotonicArena *arena() const noexcept { return m_arena; }
+
+    using Base::data;
+    const T *constData() const { return data(); }
+    bool isEmpty() const { return this->empty(); }
+
+    void reserve(qsizetype sz)
+    {
+        if (sz > this->capacity())
+            Base::reallocate_impl(Prealloc, this->array, this->size(), sz, m_arena);
+    }
+    void squeeze()
+    { Base::reallocate_impl(Prealloc, this->array, this->size(), this->size(), m_arena); }
+    void shrink_to_fit() { squeeze(); }
+
+    void resize(qsizetype sz) { Base::resize_impl(Prealloc, this->array, sz, m_arena); }
+    void resize(qsizetype sz, const T &v) { Base::resize_impl(Prealloc, this->array, sz, v, m_arena); }
+
+    template <typename...Args>
+    T &emplace_back(Args &&...args)
+    {
+        if (this->size() == this->capacity())
+            Base::growBy(Prealloc, this->array, 1, m_arena);
+        T &r = *q20::construct_at(this->end(), std::forward<Args>(args)...);
+        ++this->s;
+        return r;
+    }
+    template <typename...Args>
+    iterator emplace(const_iterator pos, Args &&...args)
+    {
+        Q_ASSERT_X(this->isValidIterator(pos), "QArenaVarLengthArray::insert", "The specified const_iterator argument 'pos' is invalid");
+        const qsizetype offset = qsizetype(pos - this->cbegin());
+        emplace_back(std::forward<Args>(args)...);
+        const auto b = this->begin() + offset;
+        const auto e = this->end();
+        QtPrivate::q_rotate(b, e - 1, e);
+        return b;
+    }
+
+    void append(const T &t)
+    {
+        if (this->size() == this->capacity())
+            emplace_back(T(t));
+        else
+            emplace_back(t);
+    }
+    void append(T &&t) { emplace_back(std::move(t)); }
+    void append(const T *buf, qsizetype sz)
+    { Base::append_impl(Prealloc, this->array, buf, sz, m_arena); }
+    void push_back(const T &t) { append(t); }
+    void push_back(T &&t) { append(std::move(t)); }
+    QArenaVarLengthArray &operator<<(const T &t) { append(t); return *this; }
+    QArenaVarLengthArray &operator<<(T &&t) { append(std::move(t)); return *this; }
+    QArenaVarLengthArray &operator+=(const T &t) { append(t); return *this; }
+    QArenaVarLengthArray &operator+=(T &&t) { append(std::move(t)); return *this; }
+
+    iterator insert(const_iterator before, qsizetype n, const T &x)
+    { return Base::insert_impl(Prealloc, this->array, before, n, x, m_arena); }
+    iterator insert(const_iterator before, const T &x) { return insert(before, 1, x); }
+    iterator insert(const_iterator before, T &&x) { return emplace(before, std::move(x)); }
+
+    void removeLast() { Base::pop_back(); }
+
+    friend bool operator==(const QArenaVarLengthArray &l, const QArenaVarLengthArray &r)
+    { return l.equal(r); }
+    friend bool operator!=(const QArenaVarLengthArray &l, const QArenaVarLengthArray &r)
+    { return !l.equal(r); }
+
+private:
+    void releaseHeap() noexcept
+    {
+        if (data() == reinterpret_cast<T *>(this->array))
+            return;
+        if (m_arena)
+            m_arena->deallocate(data(), this->capacity() * qsizetype(sizeof(T)));
+        else
+            free(data());
+    }
+
+    // Expects this array to be empty and on its inline buffer, and both
+    // arrays to allocate from the same arena.
+    void stealFrom(QArenaVarLengthArray &other) noexcept(std::is_nothrow_move_constructible_v<T>)
+    {
+        Q_ASSERT(m_arena == other.m_arena);
+        const auto otherInlineStorage = reinterpret_cast<T *>(other.array);
+        if (other.data() == otherInlineStorage) {
+            QtPrivate::q_uninitialized_relocate_n(otherInlineStorage, other.size(), data());
+        } else {
+            // heap (or arena) block - we just steal the memory
+            this->a = other.a;
+            this->ptr = other.ptr;
+        }
+        this->s = other.s;
+        other.a = Prealloc;
+        other.s = 0;
+        other.ptr = otherInlineStorage;
+    }
+
+    QMonotonicArena *m_arena;
+};
+
 QT_END_NAMESPACE
 
 #endif // QVARLENGTHARRAY_H
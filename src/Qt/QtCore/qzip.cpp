@@ -8,8 +8,18 @@
 #include <qendian.h>
 #include <qdebug.h>
 #include <qdir.h>
+#include <qmutex.h>
+#if QT_CONFIG(thread)
+#include <qrunnable.h>
+#include <qsemaphore.h>
+#include <qthreadpool.h>
+#endif
 
+#include <cmath>
 #include <memory>
+#if QT_CONFIG(thread)
+#include <deque>
+#endif
 
 #include <zlib.h>
 
@@ -25,6 +35,8 @@
 
 QT_BEGIN_NAMESPACE
 
+using namespace Qt::StringLiterals;
+
 static inline uint readUInt(const uchar *data)
 {
     return (data[0]) + (data[1]<<8) + (data[2]<<16) + (data[3]<<24);
@@ -478,9 +490,26 @@ public:
     {
     }
 
+    // Where the data of an entry is, and how to decode it
+    struct EntryData
+    {
+        qint64 offset = 0;
+        qint64 compressedSize = 0;
+        qint64 uncompressedSize = 0;
+        uint crc = 0;
+        int compressionMethod = 0;
+    };
+
     void scanFiles();
+    int indexOf(const QString &fileName) const;
+    bool locateEntry(int index, EntryData *entry);
+    qint64 readAt(qint64 pos, char *data, qint64 maxSize);
+    QByteArray readEntry(int index);
+    bool extractFile(int index, const QString &absPath, QFile::Permissions permissions);
+    bool extractAll(const QString &destinationDir, QThreadPool *pool);
 
     QZipReader::Status status;
+    QMutex deviceMutex; // serializes seek + read on device
 };
 
 class QZipWriterPrivate : public QZipPrivate
@@ -500,7 +529,37 @@ public:
 
     enum EntryType { Directory, File, Symlink };
 
+    // An entry with its header filled in and its data compressed, ready to
+    // be written at the end of the archive
+    struct PreparedEntry
+    {
+        FileHeader header;
+        QByteArray data;
+    };
+
     void addEntry(EntryType type, const QString &fileName, const QByteArray &contents);
+    static PreparedEntry prepareEntry(EntryType type, const QString &fileName, const QByteArray &contents,
+                                      QFile::Permissions permissions, QZipWriter::CompressionPolicy policy);
+    void writeEntry(PreparedEntry &entry);
+
+#if QT_CONFIG(thread)
+    // An entry that is being prepared on the thread pool; entries are
+    // written in the order they were added, as soon as they are ready
+    struct PendingEntry
+    {
+        std::unique_ptr<QRunnable> job;
+        PreparedEntry entry;
+        QSemaphore ready;
+    };
+
+    void writeOldestPending();
+    void flushPending();
+
+    QThreadPool *threadPool = nullptr;
+    std::deque<std::unique_ptr<PendingEntry>> pending;
+#else
+    void flushPending() {}
+#endif
 };
 
 static LocalFileHeader toLocalHeader(const CentralFileHeader &ch)
@@ -608,39 +667,397 @@ void QZipReaderPrivate::scanFiles()
     }
 }
 
-void QZipWriterPrivate::addEntry(EntryType type, const QString &fileName, const QByteArray &contents/*, QFile::Permissions permissions, QZip::Method m*/)
+int QZipReaderPrivate::indexOf(const QString &fileName) const
 {
-#ifndef NDEBUG
-    static const char *const entryTypes[] = {
-        "directory",
-        "file     ",
-        "symlink  " };
-    ZDEBUG() << "adding" << entryTypes[type] <<":" << fileName.toUtf8().data() << (type == 2 ? QByteArray(" -> " + contents).constData() : "");
+    for (int i = 0; i < fileHeaders.size(); ++i) {
+        if (QString::fromLocal8Bit(fileHeaders.at(i).file_name) == fileName)
+            return i;
+    }
+    return -1;
+}
+
+bool QZipReaderPrivate::locateEntry(int index, EntryData *entry)
+{
+    const FileHeader &header = fileHeaders.at(index);
+
+    ushort version_needed = readUShort(header.h.version_needed);
+    if (version_needed > ZIP_VERSION) {
+        qWarning("QZip: .ZIP specification version %d implementationis needed to extract the data.", version_needed);
+        return false;
+    }
+
+    ushort general_purpose_bits = readUShort(header.h.general_purpose_bits);
+    if ((general_purpose_bits & Encrypted) != 0) {
+        qWarning("QZip: Unsupported encryption method is needed to extract the data.");
+        return false;
+    }
+
+    const qint64 start = readUInt(header.h.offset_local_header);
+    LocalFileHeader lh;
+    if (readAt(start, (char *)&lh, sizeof(LocalFileHeader)) != qint64(sizeof(LocalFileHeader))) {
+        qWarning("QZip: Failed to read the local header of entry %d", index);
+        return false;
+    }
+    const uint skip = readUShort(lh.file_name_length) + readUShort(lh.extra_field_length);
+
+    entry->offset = start + qint64(sizeof(LocalFileHeader)) + skip;
+    entry->compressedSize = readUInt(header.h.compressed_size);
+    entry->uncompressedSize = readUInt(header.h.uncompressed_size);
+    entry->crc = readUInt(header.h.crc_32);
+    entry->compressionMethod = readUShort(lh.compression_method);
+    if (entry->compressionMethod != CompressionMethodStored
+            && entry->compressionMethod != CompressionMethodDeflated) {
+        qWarning("QZip: Unsupported compression method %d is needed to extract the data.", entry->compressionMethod);
+        return false;
+    }
+    return true;
+}
+
+qint64 QZipReaderPrivate::readAt(qint64 pos, char *data, qint64 maxSize)
+{
+    QMutexLocker locker(&deviceMutex);
+    if (!device->seek(pos))
+        return -1;
+    return device->read(data, maxSize);
+}
+
+/*
+    Sequential device that decompresses a single entry of the archive on the
+    fly. It reads the compressed data in chunks of InputChunkSize bytes, so
+    its memory use doesn't depend on the size of the entry, and checks the
+    CRC-32 of the data once the end of the entry is reached.
+
+    Reads from the archive go through QZipReaderPrivate::readAt(), so several
+    entry devices can be read from different threads at the same time.
+*/
+class QZipEntryDevice : public QIODevice
+{
+public:
+    enum { InputChunkSize = 64 * 1024 };
+
+    QZipEntryDevice(QZipReaderPrivate *zip, const QZipReaderPrivate::EntryData &entry)
+        : zip(zip), entry(entry)
+    {
+    }
+
+    ~QZipEntryDevice() override
+    {
+        close();
+    }
+
+    bool open(OpenMode mode) override;
+    void close() override;
+    bool isSequential() const override { return true; }
+    bool hasError() const { return error; }
+    qint64 size() const override { return entry.uncompressedSize; }
+    qint64 bytesAvailable() const override
+    {
+        const qint64 left = finished ? 0 : qMax(entry.uncompressedSize - produced, qint64(0));
+        return left + QIODevice::bytesAvailable();
+    }
+
+protected:
+    qint64 readData(char *data, qint64 maxSize) override;
+    qint64 writeData(const char *, qint64) override { return -1; }
+
+private:
+    qint64 fail(const QString &message)
+    {
+        setErrorString(message);
+        finished = true;
+        error = true;
+        return -1;
+    }
+
+    QZipReaderPrivate *zip;
+    QZipReaderPrivate::EntryData entry;
+    z_stream stream = {};
+    QByteArray input;
+    qint64 inputPos = 0;
+    qint64 inputLeft = 0;
+    qint64 produced = 0;
+    uLong crc = 0;
+    bool streamInitialized = false;
+    bool finished = false;
+    bool error = false;
+};
+
+bool QZipEntryDevice::open(OpenMode mode)
+{
+    if ((mode & (WriteOnly | Append)) != 0) {
+        setErrorString(u"QZip: entries can only be opened for reading"_s);
+        return false;
+    }
+
+    inputPos = entry.offset;
+    inputLeft = entry.compressedSize;
+    produced = 0;
+    crc = crc32(0, nullptr, 0);
+    finished = false;
+    error = false;
+    if (entry.compressionMethod == CompressionMethodDeflated) {
+        input.resize(InputChunkSize);
+        stream = {};
+        if (inflateInit2(&stream, -MAX_WBITS) != Z_OK) {
+            setErrorString(u"QZip: Not enough memory"_s);
+            return false;
+        }
+        streamInitialized = true;
+    }
+    return QIODevice::open(mode | Unbuffered);
+}
+
+void QZipEntryDevice::close()
+{
+    if (streamInitialized) {
+        inflateEnd(&stream);
+        streamInitialized = false;
+    }
+    QIODevice::close();
+}
+
+qint64 QZipEntryDevice::readData(char *data, qint64 maxSize)
+{
+    if (finished)
+        return -1;
+
+    qint64 done = 0;
+    if (entry.compressionMethod == CompressionMethodStored) {
+        const qint64 read = zip->readAt(inputPos, data, qMin(maxSize, inputLeft));
+        if (read < 0 || (read == 0 && maxSize > 0 && inputLeft > 0))
+            return fail(u"QZip: Failed to read the entry data"_s);
+        inputPos += read;
+        inputLeft -= read;
+        done = read;
+        finished = inputLeft == 0;
+    } else {
+        while (done < maxSize) {
+            if (stream.avail_in == 0 && inputLeft > 0) {
+                const qint64 read = zip->readAt(inputPos, input.data(), qMin(inputLeft, qint64(input.size())));
+                if (read <= 0)
+                    return fail(u"QZip: Failed to read the entry data"_s);
+                inputPos += read;
+                inputLeft -= read;
+                stream.next_in = reinterpret_cast<Bytef *>(input.data());
+                stream.avail_in = uInt(read);
+            }
+
+            const uInt space = uInt(qMin(maxSize - done, qint64(1) << 30));
+            stream.next_out = reinterpret_cast<Bytef *>(data + done);
+            stream.avail_out = space;
+            const int res = inflate(&stream, Z_NO_FLUSH);
+            done += space - stream.avail_out;
+            if (res == Z_STREAM_END) {
+                finished = true;
+                break;
+            }
+            if (res == Z_MEM_ERROR)
+                return fail(u"QZip: Z_MEM_ERROR: Not enough memory"_s);
+            if (res != Z_OK && !(res == Z_BUF_ERROR && stream.avail_in == 0 && inputLeft > 0))
+                return fail(u"QZip: Z_DATA_ERROR: Input data is corrupted"_s);
+        }
+    }
+
+    crc = crc32_z(crc, reinterpret_cast<const Bytef *>(data), z_size_t(done));
+    produced += done;
+    if (finished && crc != entry.crc)
+        return fail(u"QZip: CRC-32 mismatch: Input data is corrupted"_s);
+    return done;
+}
+
+QByteArray QZipReaderPrivate::readEntry(int index)
+{
+    EntryData entry;
+    if (!locateEntry(index, &entry))
+        return QByteArray();
+    QZipEntryDevice dev(this, entry);
+    if (!dev.open(QIODevice::ReadOnly))
+        return QByteArray();
+    return dev.readAll();
+}
+
+bool QZipReaderPrivate::extractFile(int index, const QString &absPath, QFile::Permissions permissions)
+{
+    EntryData entry;
+    if (!locateEntry(index, &entry))
+        return false;
+    QZipEntryDevice dev(this, entry);
+    if (!dev.open(QIODevice::ReadOnly)) {
+        qWarning("%ls", qUtf16Printable(dev.errorString()));
+        return false;
+    }
+
+    QFile f(absPath);
+    if (!f.open(QIODevice::WriteOnly))
+        return false;
+
+    QByteArray buffer(QZipEntryDevice::InputChunkSize, Qt::Uninitialized);
+    qint64 read;
+    while ((read = dev.read(buffer.data(), buffer.size())) > 0) {
+        if (f.write(buffer.constData(), read) != read) {
+            f.remove();
+            return false;
+        }
+    }
+    if (dev.hasError()) {
+        // don't leave a truncated file behind
+        qWarning("%ls", qUtf16Printable(dev.errorString()));
+        f.remove();
+        return false;
+    }
+    f.setPermissions(permissions);
+    f.close();
+    return true;
+}
+
+bool QZipReaderPrivate::extractAll(const QString &destinationDir, QThreadPool *pool)
+{
+    scanFiles();
+    QDir baseDir(destinationDir);
+
+    // create directories first
+    QList<QZipReader::FileInfo> allFiles;
+    allFiles.reserve(fileHeaders.size());
+    for (int i = 0; i < fileHeaders.size(); ++i)
+        allFiles.append(fillFileInfo(i));
+    bool foundDirs = false;
+    bool hasDirs = false;
+    for (const QZipReader::FileInfo &fi : std::as_const(allFiles)) {
+        const QString absPath = destinationDir + QDir::separator() + fi.filePath;
+        if (fi.isDir) {
+            foundDirs = true;
+            if (!baseDir.mkpath(fi.filePath))
+                return false;
+            if (!QFile::setPermissions(absPath, fi.permissions))
+                return false;
+        } else if (!hasDirs && fi.filePath.contains(u"/")) {
+            // filePath does not have leading or trailing '/', so if we find
+            // one, than the file path contains directories.
+            hasDirs = true;
+        }
+    }
+
+    // Some zip archives can be broken in the sense that they do not report
+    // separate entries for directories, only for files. In this case we
+    // need to recreate directory structure based on the file paths.
+    if (hasDirs && !foundDirs) {
+        for (const QZipReader::FileInfo &fi : std::as_const(allFiles)) {
+            const auto dirPath = fi.filePath.left(fi.filePath.lastIndexOf(u"/"));
+            if (!baseDir.mkpath(dirPath))
+                return false;
+            // We will leave the directory permissions default in this case,
+            // because setting dir permissions based on file is incorrect
+        }
+    }
+
+    // set up symlinks
+    QList<int> files;
+    for (int i = 0; i < allFiles.size(); ++i) {
+        const QZipReader::FileInfo &fi = allFiles.at(i);
+        const QString absPath = destinationDir + QDir::separator() + fi.filePath;
+        if (fi.isSymLink) {
+            QString destination = QFile::decodeName(readEntry(i));
+            if (destination.isEmpty())
+                return false;
+            QFileInfo linkFi(absPath);
+            if (!QFile::exists(linkFi.absolutePath()))
+                QDir::root().mkpath(linkFi.absolutePath());
+            if (!QFile::link(destination, absPath))
+                return false;
+            /* cannot change permission of links
+            if (!QFile::setPermissions(absPath, fi.permissions))
+                return false;
+            */
+        } else if (fi.isFile) {
+            files.append(i);
+        }
+    }
+
+    auto extractFiles = [&](QAtomicInt *next, QAtomicInt *failed) {
+        int i;
+        while (!failed->loadRelaxed() && (i = next->fetchAndAddRelaxed(1)) < files.size()) {
+            const QZipReader::FileInfo &fi = allFiles.at(files.at(i));
+            const QString absPath = destinationDir + QDir::separator() + fi.filePath;
+            if (!extractFile(files.at(i), absPath, fi.permissions))
+                failed->storeRelaxed(1);
+        }
+    };
+
+    QAtomicInt next = 0;
+    QAtomicInt failed = 0;
+#if QT_CONFIG(thread)
+    if (pool && files.size() > 1) {
+        // The calling thread extracts files too, so only start the workers
+        // that get a thread right away; this way we can't deadlock when the
+        // pool is busy or when we're running on one of its threads.
+        QSemaphore done;
+        const int maxWorkers = qMin(pool->maxThreadCount(), int(files.size())) - 1;
+        int workers = 0;
+        while (workers < maxWorkers && pool->tryStart([&] {
+                    extractFiles(&next, &failed);
+                    done.release();
+                })) {
+            ++workers;
+        }
+        extractFiles(&next, &failed);
+        done.acquire(workers);
+        return !failed.loadRelaxed();
+    }
+#else
+    Q_UNUSED(pool);
 #endif
+    extractFiles(&next, &failed);
+    return !failed.loadRelaxed();
+}
 
-    if (! (device->isOpen() || device->open(QIODevice::WriteOnly))) {
-        status = QZipWriter::FileOpenError;
-        return;
+// Estimates from the byte distribution of the first few KB of \a contents
+// whether deflate would gain anything; data that is already compressed or
+// encrypted looks uniformly random, at close to 8 bits of entropy per byte.
+static bool looksIncompressible(const QByteArray &contents)
+{
+    constexpr qsizetype ProbeSize = 4096;
+    const qsizetype n = qMin(contents.size(), ProbeSize);
+    if (n < 1024) // too little data to tell
+        return false;
+
+    uint counts[256] = {};
+    const uchar *data = reinterpret_cast<const uchar *>(contents.constData());
+    for (qsizetype i = 0; i < n; ++i)
+        ++counts[data[i]];
+
+    double entropy = 0;
+    for (uint count : counts) {
+        if (count) {
+            const double p = double(count) / n;
+            entropy -= p * std::log2(p);
+        }
     }
-    device->seek(start_of_directory);
+    return entropy > 7.6;
+}
 
-    // don't compress small files
-    QZipWriter::CompressionPolicy compression = compressionPolicy;
-    if (compressionPolicy == QZipWriter::AutoCompress) {
-        if (contents.size() < 64)
+QZipWriterPrivate::PreparedEntry
+QZipWriterPrivate::prepareEntry(EntryType type, const QString &fileName, const QByteArray &contents,
+                                QFile::Permissions permissions, QZipWriter::CompressionPolicy policy)
+{
+    // don't compress small files or data that looks compressed already
+    QZipWriter::CompressionPolicy compression = policy;
+    if (policy == QZipWriter::AutoCompress) {
+        if (contents.size() < 64 || looksIncompressible(contents))
             compression = QZipWriter::NeverCompress;
         else
             compression = QZipWriter::AlwaysCompress;
     }
 
-    FileHeader header;
+    PreparedEntry entry;
+    FileHeader &header = entry.header;
     memset(&header.h, 0, sizeof(CentralFileHeader));
     writeUInt(header.h.signature, 0x02014b50);
 
     writeUShort(header.h.version_needed, ZIP_VERSION);
     writeUInt(header.h.uncompressed_size, contents.size());
     writeMSDosDate(header.h.last_mod_file, QDateTime::currentDateTime());
-    QByteArray data = contents;
+    QByteArray &data = entry.data;
+    data = contents;
     if (compression == QZipWriter::AlwaysCompress) {
         writeUShort(header.h.compression_method, CompressionMethodDeflated);
 
@@ -665,8 +1082,14 @@ void QZipWriterPrivate::addEntry(EntryType type, const QString &fileName, const
                 break;
             }
         } while (res == Z_BUF_ERROR);
+
+        // the probe can't catch everything, so store the original if
+        // compressing didn't pay off after all
+        if (policy == QZipWriter::AutoCompress && data.size() >= contents.size()) {
+            writeUShort(header.h.compression_method, CompressionMethodStored);
+            data = contents;
+        }
     }
-// TODO add a check if data.length() > contents.length().  Then try to store the original and revert the compression method to be uncompressed
     writeUInt(header.h.compressed_size, data.size());
     uint crc_32 = ::crc32(0, nullptr, 0);
     crc_32 = ::crc32(crc_32, (const uchar *)contents.constData(), contents.size());
@@ -708,19 +1131,85 @@ void QZipWriterPrivate::addEntry(EntryType type, const QString &fileName, const
         break;
     }
     writeUInt(header.h.external_file_attributes, mode << 16);
-    writeUInt(header.h.offset_local_header, start_of_directory);
+    return entry;
+}
 
+void QZipWriterPrivate::writeEntry(PreparedEntry &entry)
+{
+    FileHeader &header = entry.header;
+    device->seek(start_of_directory);
+    writeUInt(header.h.offset_local_header, start_of_directory);
 
     fileHeaders.append(header);
 
     LocalFileHeader h = toLocalHeader(header.h);
     device->write((const char *)&h, sizeof(LocalFileHeader));
     device->write(header.file_name);
-    device->write(data);
+    device->write(entry.data);
     start_of_directory = device->pos();
     dirtyFileTree = true;
 }
 
+void QZipWriterPrivate::addEntry(EntryType type, const QString &fileName, const QByteArray &contents/*, QFile::Permissions permissions, QZip::Method m*/)
+{
+#ifndef NDEBUG
+    static const char *const entryTypes[] = {
+        "directory",
+        "file     ",
+        "symlink  " };
+    ZDEBUG() << "adding" << entryTypes[type] <<":" << fileName.toUtf8().data() << (type == 2 ? QByteArray(" -> " + contents).constData() : "");
+#endif
+
+    if (! (device->isOpen() || device->open(QIODevice::WriteOnly))) {
+        status = QZipWriter::FileOpenError;
+        return;
+    }
+
+#if QT_CONFIG(thread)
+    if (threadPool) {
+        auto p = std::make_unique<PendingEntry>();
+        PendingEntry *pendingEntry = p.get();
+        const QFile::Permissions perms = permissions;
+        const QZipWriter::CompressionPolicy policy = compressionPolicy;
+        p->job.reset(QRunnable::create([=] {
+            pendingEntry->entry = prepareEntry(type, fileName, contents, perms, policy);
+            pendingEntry->ready.release();
+        }));
+        p->job->setAutoDelete(false);
+        threadPool->start(p->job.get());
+        pending.push_back(std::move(p));
+
+        // bound the memory held by entries in flight
+        const size_t maxPending = 2 * size_t(qMax(threadPool->maxThreadCount(), 1));
+        while (pending.size() > maxPending)
+            writeOldestPending();
+        return;
+    }
+#endif
+
+    PreparedEntry entry = prepareEntry(type, fileName, contents, permissions, compressionPolicy);
+    writeEntry(entry);
+}
+
+#if QT_CONFIG(thread)
+void QZipWriterPrivate::writeOldestPending()
+{
+    PendingEntry *p = pending.front().get();
+    // if no thread picked the job up yet, run it here rather than wait
+    if (threadPool->tryTake(p->job.get()))
+        p->job->run();
+    p->ready.acquire();
+    writeEntry(p->entry);
+    pending.pop_front();
+}
+
+void QZipWriterPrivate::flushPending()
+{
+    while (!pending.empty())
+        writeOldestPending();
+}
+#endif
+
 //////////////////////////////  Reader
 
 /*!
@@ -775,8 +1264,8 @@ void QZipWriterPrivate::addEntry(EntryType type, const QString &fileName, const
     QZipReader can be used to read a zip archive either from a file or from any
     device. An in-memory QBuffer for instance.  The reader can be used to read
     which files are in the archive using fileInfoList() and entryInfoAt() but
-    also to extract individual files using fileData() or even to extract all
-    files in the archive using extractAll()
+    also to extract individual files using fileData() or openEntry() or even
+    to extract all files in the archive using extractAll()
 */
 
 /*!
@@ -899,157 +1388,133 @@ QZipReader::FileInfo QZipReader::entryInfoAt(int index) const
 QByteArray QZipReader::fileData(const QString &fileName) const
 {
     d->scanFiles();
-    int i;
-    for (i = 0; i < d->fileHeaders.size(); ++i) {
-        if (QString::fromLocal8Bit(d->fileHeaders.at(i).file_name) == fileName)
-            break;
-    }
-    if (i == d->fileHeaders.size())
+    const int i = d->indexOf(fileName);
+    if (i < 0)
         return QByteArray();
 
-    FileHeader header = d->fileHeaders.at(i);
-
-    ushort version_needed = readUShort(header.h.version_needed);
-    if (version_needed > ZIP_VERSION) {
-        qWarning("QZip: .ZIP specification version %d implementationis needed to extract the data.", version_needed);
+    QZipReaderPrivate::EntryData entry;
+    if (!d->locateEntry(i, &entry))
         return QByteArray();
-    }
-
-    ushort general_purpose_bits = readUShort(header.h.general_purpose_bits);
-    int compressed_size = readUInt(header.h.compressed_size);
-    int uncompressed_size = readUInt(header.h.uncompressed_size);
-    int start = readUInt(header.h.offset_local_header);
-    //qDebug("uncompressing file %d: local header at %d", i, start);
 
-    d->device->seek(start);
-    LocalFileHeader lh;
-    d->device->read((char *)&lh, sizeof(LocalFileHeader));
-    uint skip = readUShort(lh.file_name_length) + readUShort(lh.extra_field_length);
-    d->device->seek(d->device->pos() + skip);
-
-    int compression_method = readUShort(lh.compression_method);
+    int compressed_size = int(entry.compressedSize);
+    int uncompressed_size = int(entry.uncompressedSize);
     //qDebug("file=%s: compressed_size=%d, uncompressed_size=%d", fileName.toLocal8Bit().data(), compressed_size, uncompressed_size);
 
-    if ((general_purpose_bits & Encrypted) != 0) {
-        qWarning("QZip: Unsupported encryption method is needed to extract the data.");
-        return QByteArray();
-    }
-
-    //qDebug("file at %lld", d->device->pos());
-    QByteArray compressed = d->device->read(compressed_size);
-    if (compression_method == CompressionMethodStored) {
+    QByteArray compressed(compressed_size, Qt::Uninitialized);
+    const qint64 read = d->readAt(entry.offset, compressed.data(), compressed_size);
+    compressed.truncate(read < 0 ? 0 : int(read));
+    if (entry.compressionMethod == CompressionMethodStored) {
         // no compression
         compressed.truncate(uncompressed_size);
         return compressed;
-    } else if (compression_method == CompressionMethodDeflated) {
-        // Deflate
-        //qDebug("compressed=%d", compressed.size());
-        compressed.truncate(compressed_size);
-        QByteArray baunzip;
-        ulong len = qMax(uncompressed_size,  1);
-        int res;
-        do {
-            baunzip.resize(len);
-            res = inflate((uchar*)baunzip.data(), &len,
-                          (const uchar*)compressed.constData(), compressed_size);
-
-            switch (res) {
-            case Z_OK:
-                if ((int)len != baunzip.size())
-                    baunzip.resize(len);
-                break;
-            case Z_MEM_ERROR:
-                qWarning("QZip: Z_MEM_ERROR: Not enough memory");
-                break;
-            case Z_BUF_ERROR:
-                len *= 2;
-                break;
-            case Z_DATA_ERROR:
-                qWarning("QZip: Z_DATA_ERROR: Input data is corrupted");
-                break;
-            }
-        } while (res == Z_BUF_ERROR);
-        return baunzip;
     }
 
-    qWarning("QZip: Unsupported compression method %d is needed to extract the data.", compression_method);
-    return QByteArray();
+    // Deflate
+    //qDebug("compressed=%d", compressed.size());
+    QByteArray baunzip;
+    ulong len = qMax(uncompressed_size,  1);
+    int res;
+    do {
+        baunzip.resize(len);
+        res = inflate((uchar*)baunzip.data(), &len,
+                      (const uchar*)compressed.constData(), compressed.size());
+
+        switch (res) {
+        case Z_OK:
+            if ((int)len != baunzip.size())
+                baunzip.resize(len);
+            break;
+        case Z_MEM_ERROR:
+            qWarning("QZip: Z_MEM_ERROR: Not enough memory");
+            break;
+        case Z_BUF_ERROR:
+            len *= 2;
+            break;
+        case Z_DATA_ERROR:
+            qWarning("QZip: Z_DATA_ERROR: Input data is corrupted");
+            break;
+        }
+    } while (res == Z_BUF_ERROR);
+    return baunzip;
 }
 
 /*!
-    Extracts the full contents of the zip file into \a destinationDir on
-    the local filesystem.
-    In case writing or linking a file fails, the extraction will be aborted.
+    \since 6.9
+
+    Opens the entry called \a fileName for reading and returns a sequential
+    device that decompresses its contents on the fly, or \nullptr if there is
+    no such entry or it can't be extracted.
+
+    Unlike fileData(), the device only holds a small, fixed amount of the
+    entry in memory at a time, which makes it suitable for large entries. It
+    reports an error once the end of the entry is reached and the data does
+    not match the checksum stored in the archive.
+
+    The device reads from the archive's device(), so it must not outlive this
+    QZipReader. Devices for different entries can be read from different
+    threads at the same time.
+
+    \sa fileData()
 */
-bool QZipReader::extractAll(const QString &destinationDir) const
+std::unique_ptr<QIODevice> QZipReader::openEntry(const QString &fileName) const
 {
-    QDir baseDir(destinationDir);
+    d->scanFiles();
+    return openEntry(d->indexOf(fileName));
+}
 
-    // create directories first
-    const QList<FileInfo> allFiles = fileInfoList();
-    bool foundDirs = false;
-    bool hasDirs = false;
-    for (const FileInfo &fi : allFiles) {
-        const QString absPath = destinationDir + QDir::separator() + fi.filePath;
-        if (fi.isDir) {
-            foundDirs = true;
-            if (!baseDir.mkpath(fi.filePath))
-                return false;
-            if (!QFile::setPermissions(absPath, fi.permissions))
-                return false;
-        } else if (!hasDirs && fi.filePath.contains(u"/")) {
-            // filePath does not have leading or trailing '/', so if we find
-            // one, than the file path contains directories.
-            hasDirs = true;
-        }
-    }
+/*!
+    \since 6.9
+    \overload
 
-    // Some zip archives can be broken in the sense that they do not report
-    // separate entries for directories, only for files. In this case we
-    // need to recreate directory structure based on the file paths.
-    if (hasDirs && !foundDirs) {
-        for (const FileInfo &fi : allFiles) {
-            const auto dirPath = fi.filePath.left(fi.filePath.lastIndexOf(u"/"));
-            if (!baseDir.mkpath(dirPath))
-                return false;
-            // We will leave the directory permissions default in this case,
-            // because setting dir permissions based on file is incorrect
-        }
-    }
+    Opens the entry at \a index in the directory listing of the archive.
 
-    // set up symlinks
-    for (const FileInfo &fi : allFiles) {
-        const QString absPath = destinationDir + QDir::separator() + fi.filePath;
-        if (fi.isSymLink) {
-            QString destination = QFile::decodeName(fileData(fi.filePath));
-            if (destination.isEmpty())
-                return false;
-            QFileInfo linkFi(absPath);
-            if (!QFile::exists(linkFi.absolutePath()))
-                QDir::root().mkpath(linkFi.absolutePath());
-            if (!QFile::link(destination, absPath))
-                return false;
-            /* cannot change permission of links
-            if (!QFile::setPermissions(absPath, fi.permissions))
-                return false;
-            */
-        }
-    }
+    \sa entryInfoAt()
+*/
+std::unique_ptr<QIODevice> QZipReader::openEntry(int index) const
+{
+    d->scanFiles();
+    QZipReaderPrivate::EntryData entry;
+    if (index < 0 || index >= d->fileHeaders.size() || !d->locateEntry(index, &entry))
+        return nullptr;
+    auto dev = std::make_unique<QZipEntryDevice>(d, entry);
+    if (!dev->open(QIODevice::ReadOnly))
+        return nullptr;
+    return dev;
+}
 
-    for (const FileInfo &fi : allFiles) {
-        const QString absPath = destinationDir + QDir::separator() + fi.filePath;
-        if (fi.isFile) {
-            QFile f(absPath);
-            if (!f.open(QIODevice::WriteOnly))
-                return false;
-            f.write(fileData(fi.filePath));
-            f.setPermissions(fi.permissions);
-            f.close();
-        }
-    }
+/*!
+    Extracts the full contents of the zip file into \a destinationDir on
+    the local filesystem.
+    In case writing or linking a file fails, the extraction will be aborted.
+    This includes entries that cannot be decompressed or whose checksum does
+    not match; the partially written file is removed, and \c false is
+    returned.
+*/
+bool QZipReader::extractAll(const QString &destinationDir) const
+{
+    return d->extractAll(destinationDir, nullptr);
+}
 
-    return true;
+#if QT_CONFIG(thread)
+/*!
+    \since 6.9
+    \overload
+
+    Extracts the full contents of the zip file into \a destinationDir,
+    decompressing and writing the files in parallel on the threads of
+    \a pool, or of QThreadPool::globalInstance() if \a pool is \nullptr.
+    The calling thread takes part in the extraction, and the function
+    returns once all files have been written.
+
+    Directories and symbolic links are created first, on the calling thread.
+    Each file is streamed to disk as in openEntry(), so the memory used does
+    not depend on the size of the entries.
+*/
+bool QZipReader::extractAll(const QString &destinationDir, QThreadPool *pool) const
+{
+    return d->extractAll(destinationDir, pool ? pool : QThreadPool::globalInstance());
 }
+#endif
 
 /*!
     \enum QZipReader::Status
@@ -1193,6 +1658,9 @@ QZipWriter::Status QZipWriter::status() const
     \value AlwaysCompress   A file that is added is compressed.
     \value NeverCompress    A file that is added will be stored without changes.
     \value AutoCompress     A file that is added will be compressed only if that will give a smaller file.
+                            Small files, and files whose first few kilobytes look
+                            like already compressed data, are stored without
+                            trying to compress them.
 */
 
 /*!
@@ -1242,6 +1710,47 @@ QFile::Permissions QZipWriter::creationPermissions() const
     return d->permissions;
 }
 
+#if QT_CONFIG(thread)
+/*!
+    \since 6.9
+
+    Sets the thread pool used to compress newly added entries to \a pool.
+
+    With a thread pool set, addFile() and the other functions adding entries
+    return as soon as the entry is queued for compression on \a pool, so
+    several entries are compressed at the same time. The entries are still
+    written to the archive in the order they were added, as soon as they
+    are ready. Only a few entries per pool thread are kept in flight; adding
+    further entries waits for the oldest one to be written.
+
+    Pass \nullptr to compress entries on the calling thread again, which is
+    the default. Entries still in flight are written before the pool is
+    changed, and close() writes all of them before the central directory.
+
+    \sa threadPool()
+*/
+void QZipWriter::setThreadPool(QThreadPool *pool)
+{
+    if (pool == d->threadPool)
+        return;
+    d->flushPending();
+    d->threadPool = pool;
+}
+
+/*!
+    \since 6.9
+
+    Returns the thread pool used to compress newly added entries, or
+    \nullptr if they are compressed on the calling thread.
+
+    \sa setThreadPool()
+*/
+QThreadPool *QZipWriter::threadPool() const
+{
+    return d->threadPool;
+}
+#endif
+
 /*!
     Add a file to the archive with \a data as the file contents.
     The file will be stored in the archive using the \a fileName which
@@ -1311,6 +1820,7 @@ void QZipWriter::addSymLink(const QString &fileName, const QString &destination)
 */
 void QZipWriter::close()
 {
+    d->flushPending();
     if (!(d->device->openMode() & QIODevice::WriteOnly)) {
         d->device->close();
         return;
@@ -14,3 +14,10 @@ HelloWorldTask *hello = new HelloWorldTask();
 // QThreadPool takes ownership and deletes 'hello' automatically
 QThreadPool::globalInstance()->start(hello);
 //! [0]
+
+//! [1]
+const int node = QThreadPool::numaNodeForAddress(matrix.constData());
+QThreadPool::numaNodeInstance(node)->start([&matrix] {
+    invertInPlace(matrix);
+});
+//! [1]
@@ -0,0 +1,10 @@
+// Copyright (C) 2025 The Qt Company Ltd.
+// SPDX-License-Identifier: LicenseRef-Qt-Commercial OR BSD-3-Clause
+
+//! [0]
+QBTreeMap<int, int> map{{1, 1}};
+QMultiBTreeMap<int, int> source{{5, 1}, {5, 2}, {0, 7}, {0, 8}};
+map.merge(std::move(source));
+// map contains 0:7 1:1 5:1, like std::map::merge(); the entries whose
+// key was already taken stay behind: source contains 0:8 5:2
+//! [0]
@@ -21,3 +21,16 @@ cache.insert(INT_MAX, 1); // cache contains one value and has valid indexes, INT
 cache.append(2); // cache contains two values but does not have valid indexes.
 cache.normalizeIndexes(); // cache has two values, 1 and 2.  New first index will be in the range of 0 to capacity().
 //! [1]
+
+//! [2]
+QContiguousCache<double> window(1024, 64);
+...
+window.append(QSpan<const double>(samples));
+
+double sum = 0;
+const auto [older, newer] = window.constSegments();
+for (double x : older)
+    sum += x;
+for (double x : newer)
+    sum += x;
+//! [2]
@@ -57,6 +57,119 @@
 #  define MOD63(a) a %= BASE
 #endif
 
+/* =========================================================================
+ * Vectorized Adler-32 for x86-64, selected at run time. Each step takes 32
+ * bytes: their sum is added to the first sum with _mm_sad_epu8(), and their
+ * sum weighted by 32..1 is added to the second sum with _mm_maddubs_epi16().
+ * The second sum also grows by 32 times the first sum before the step, which
+ * is accumulated separately and added at the end of each block. Blocks have
+ * at most NMAX bytes, so that none of the 32-bit lanes overflows before the
+ * modulo operation.
+ */
+#ifdef Z_X86_SIMD
+
+#include <immintrin.h>
+
+local Z_TARGET("ssse3") unsigned hsum_epi32(__m128i v) {
+    v = _mm_add_epi32(v, _mm_shuffle_epi32(v, _MM_SHUFFLE(1, 0, 3, 2)));
+    v = _mm_add_epi32(v, _mm_shuffle_epi32(v, _MM_SHUFFLE(2, 3, 0, 1)));
+    return (unsigned)_mm_cvtsi128_si32(v);
+}
+
+local Z_TARGET("ssse3")
+uLong adler32_ssse3(unsigned long adler, unsigned long sum2, const Bytef *buf,
+                    z_size_t len) {
+    const __m128i taps1 = _mm_setr_epi8(32, 31, 30, 29, 28, 27, 26, 25,
+                                        24, 23, 22, 21, 20, 19, 18, 17);
+    const __m128i taps2 = _mm_setr_epi8(16, 15, 14, 13, 12, 11, 10, 9,
+                                        8, 7, 6, 5, 4, 3, 2, 1);
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i ones = _mm_set1_epi16(1);
+
+    while (len >= 32) {
+        z_size_t n = (len < NMAX ? len : NMAX) / 32;
+        __m128i v_ps = _mm_cvtsi32_si128((int)(adler * n));
+        __m128i v_s2 = _mm_cvtsi32_si128((int)sum2);
+        __m128i v_s1 = zero;
+        len -= n * 32;
+        do {
+            __m128i bytes1 = _mm_loadu_si128((const __m128i *)buf);
+            __m128i bytes2 = _mm_loadu_si128((const __m128i *)(buf + 16));
+            v_ps = _mm_add_epi32(v_ps, v_s1);
+            v_s1 = _mm_add_epi32(v_s1, _mm_sad_epu8(bytes1, zero));
+            v_s1 = _mm_add_epi32(v_s1, _mm_sad_epu8(bytes2, zero));
+            v_s2 = _mm_add_epi32(v_s2, _mm_madd_epi16(
+                       _mm_maddubs_epi16(bytes1, taps1), ones));
+            v_s2 = _mm_add_epi32(v_s2, _mm_madd_epi16(
+                       _mm_maddubs_epi16(bytes2, taps2), ones));
+            buf += 32;
+        } while (--n);
+        v_s2 = _mm_add_epi32(v_s2, _mm_slli_epi32(v_ps, 5));
+        adler += hsum_epi32(v_s1);
+        sum2 = hsum_epi32(v_s2);
+        MOD(adler);
+        MOD(sum2);
+    }
+
+    /* do the remaining bytes, less than 32 */
+    if (len) {
+        while (len--) {
+            adler += *buf++;
+            sum2 += adler;
+        }
+        MOD(adler);
+        MOD(sum2);
+    }
+    return adler | (sum2 << 16);
+}
+
+local Z_TARGET("avx2")
+uLong adler32_avx2(unsigned long adler, unsigned long sum2, const Bytef *buf,
+                   z_size_t len) {
+    const __m256i taps = _mm256_setr_epi8(32, 31, 30, 29, 28, 27, 26, 25,
+                                          24, 23, 22, 21, 20, 19, 18, 17,
+                                          16, 15, 14, 13, 12, 11, 10, 9,
+                                          8, 7, 6, 5, 4, 3, 2, 1);
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i ones = _mm256_set1_epi16(1);
+
+    while (len >= 32) {
+        z_size_t n = (len < NMAX ? len : NMAX) / 32;
+        __m256i v_ps = _mm256_setr_epi32((int)(adler * n), 0, 0, 0, 0, 0, 0, 0);
+        __m256i v_s2 = _mm256_setr_epi32((int)sum2, 0, 0, 0, 0, 0, 0, 0);
+        __m256i v_s1 = zero;
+        len -= n * 32;
+        do {
+            __m256i bytes = _mm256_loadu_si256((const __m256i *)buf);
+            v_ps = _mm256_add_epi32(v_ps, v_s1);
+            v_s1 = _mm256_add_epi32(v_s1, _mm256_sad_epu8(bytes, zero));
+            v_s2 = _mm256_add_epi32(v_s2, _mm256_madd_epi16(
+                       _mm256_maddubs_epi16(bytes, taps), ones));
+            buf += 32;
+        } while (--n);
+        v_s2 = _mm256_add_epi32(v_s2, _mm256_slli_epi32(v_ps, 5));
+        adler += hsum_epi32(_mm_add_epi32(_mm256_castsi256_si128(v_s1),
+                                          _mm256_extracti128_si256(v_s1, 1)));
+        sum2 = hsum_epi32(_mm_add_epi32(_mm256_castsi256_si128(v_s2),
+                                        _mm256_extracti128_si256(v_s2, 1)));
+        MOD(adler);
+        MOD(sum2);
+    }
+
+    /* do the remaining bytes, less than 32 */
+    if (len) {
+        while (len--) {
+            adler += *buf++;
+            sum2 += adler;
+        }
+        MOD(adler);
+        MOD(sum2);
+    }
+    return adler | (sum2 << 16);
+}
+
+#endif /* Z_X86_SIMD */
+
 /* ========================================================================= */
 uLong ZEXPORT adler32_z(uLong adler, const Bytef *buf, z_size_t len) {
     unsigned long sum2;
@@ -93,6 +206,16 @@ uLong ZEXPORT adler32_z(uLong adler, const Bytef *buf, z_size_t len) {
         return adler | (sum2 << 16);
     }
 
+#ifdef Z_X86_SIMD
+    if (len >= 64) {
+        int features = z_x86_cpu_features();
+        if (features & Z_X86_AVX2)
+            return adler32_avx2(adler, sum2, buf, len);
+        if (features & Z_X86_SSSE3)
+            return adler32_ssse3(adler, sum2, buf, len);
+    }
+#endif
+
     /* do length NMAX blocks -- requires just one modulo operation */
     while (len >= NMAX) {
         len -= NMAX;
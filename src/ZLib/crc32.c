@@ -666,6 +666,174 @@ unsigned long ZEXPORT crc32_z(unsigned long crc, const unsigned char FAR *buf,
 
 #else
 
+/* =========================================================================
+ * Use carry-less multiplication on x86-64 processors that support it, which
+ * is selected at run time. This folds 64 (PCLMULQDQ) or 128 (VPCLMULQDQ)
+ * bytes per iteration into four independent accumulators, as described in
+ * "Fast CRC Computation for Generic Polynomials Using PCLMULQDQ Instruction"
+ * (Gopal et al., Intel, 2009), and then reduces them to the 32-bit CRC with
+ * a Barrett reduction. The fold constants are x^(d+32) mod p and x^(d-32)
+ * mod p for a fold distance of d bits, bit-reflected and shifted left by one.
+ */
+#ifdef Z_X86_SIMD
+
+#include <immintrin.h>
+
+/*
+  Fold the 16-byte blocks of buf[0..len-1] into x, and return the CRC of the
+  data that x represents. len must be a multiple of 16.
+ */
+local Z_TARGET("sse4.1,pclmul")
+z_crc_t crc32_fold_final(__m128i x, const unsigned char FAR *buf,
+                         z_size_t len) {
+    const __m128i k128 = _mm_set_epi64x(0x00ccaa009e, 0x01751997d0);
+    const __m128i k64 = _mm_set_epi64x(0, 0x0163cd6124);
+    const __m128i poly = _mm_set_epi64x(0x01f7011641, 0x01db710641);
+    const __m128i mask32 = _mm_setr_epi32(~0, 0, ~0, 0);
+    __m128i t;
+
+    while (len >= 16) {
+        t = _mm_clmulepi64_si128(x, k128, 0x00);
+        x = _mm_clmulepi64_si128(x, k128, 0x11);
+        x = _mm_xor_si128(_mm_xor_si128(x, t),
+                          _mm_loadu_si128((const __m128i *)buf));
+        buf += 16;
+        len -= 16;
+    }
+
+    /* Fold 128 to 64 bits. */
+    t = _mm_clmulepi64_si128(x, k128, 0x10);
+    x = _mm_xor_si128(_mm_srli_si128(x, 8), t);
+    t = _mm_srli_si128(x, 4);
+    x = _mm_clmulepi64_si128(_mm_and_si128(x, mask32), k64, 0x00);
+    x = _mm_xor_si128(x, t);
+
+    /* Barrett reduction to 32 bits. */
+    t = _mm_clmulepi64_si128(_mm_and_si128(x, mask32), poly, 0x10);
+    t = _mm_clmulepi64_si128(_mm_and_si128(t, mask32), poly, 0x00);
+    x = _mm_xor_si128(x, t);
+    return (z_crc_t)_mm_extract_epi32(x, 1);
+}
+
+/*
+  Return the CRC of buf[0..len-1] continuing from the pre-conditioned crc,
+  without post-conditioning. len must be a multiple of 16 and at least 64.
+ */
+local Z_TARGET("sse4.1,pclmul")
+z_crc_t crc32_pclmul(z_crc_t crc, const unsigned char FAR *buf, z_size_t len) {
+    const __m128i k512 = _mm_set_epi64x(0x01c6e41596, 0x0154442bd4);
+    const __m128i k128 = _mm_set_epi64x(0x00ccaa009e, 0x01751997d0);
+    __m128i x0, x1, x2, x3, t0, t1, t2, t3;
+
+    x0 = _mm_loadu_si128((const __m128i *)buf);
+    x1 = _mm_loadu_si128((const __m128i *)(buf + 16));
+    x2 = _mm_loadu_si128((const __m128i *)(buf + 32));
+    x3 = _mm_loadu_si128((const __m128i *)(buf + 48));
+    x0 = _mm_xor_si128(x0, _mm_cvtsi32_si128((int)crc));
+    buf += 64;
+    len -= 64;
+
+    while (len >= 64) {
+        t0 = _mm_clmulepi64_si128(x0, k512, 0x00);
+        t1 = _mm_clmulepi64_si128(x1, k512, 0x00);
+        t2 = _mm_clmulepi64_si128(x2, k512, 0x00);
+        t3 = _mm_clmulepi64_si128(x3, k512, 0x00);
+        x0 = _mm_clmulepi64_si128(x0, k512, 0x11);
+        x1 = _mm_clmulepi64_si128(x1, k512, 0x11);
+        x2 = _mm_clmulepi64_si128(x2, k512, 0x11);
+        x3 = _mm_clmulepi64_si128(x3, k512, 0x11);
+        x0 = _mm_xor_si128(_mm_xor_si128(x0, t0),
+                           _mm_loadu_si128((const __m128i *)buf));
+        x1 = _mm_xor_si128(_mm_xor_si128(x1, t1),
+                           _mm_loadu_si128((const __m128i *)(buf + 16)));
+        x2 = _mm_xor_si128(_mm_xor_si128(x2, t2),
+                           _mm_loadu_si128((const __m128i *)(buf + 32)));
+        x3 = _mm_xor_si128(_mm_xor_si128(x3, t3),
+                           _mm_loadu_si128((const __m128i *)(buf + 48)));
+        buf += 64;
+        len -= 64;
+    }
+
+    /* Fold the four accumulators into one. */
+    t0 = _mm_clmulepi64_si128(x0, k128, 0x00);
+    x0 = _mm_clmulepi64_si128(x0, k128, 0x11);
+    x0 = _mm_xor_si128(_mm_xor_si128(x0, t0), x1);
+    t0 = _mm_clmulepi64_si128(x0, k128, 0x00);
+    x0 = _mm_clmulepi64_si128(x0, k128, 0x11);
+    x0 = _mm_xor_si128(_mm_xor_si128(x0, t0), x2);
+    t0 = _mm_clmulepi64_si128(x0, k128, 0x00);
+    x0 = _mm_clmulepi64_si128(x0, k128, 0x11);
+    x0 = _mm_xor_si128(_mm_xor_si128(x0, t0), x3);
+
+    return crc32_fold_final(x0, buf, len);
+}
+
+/*
+  Same as crc32_pclmul(), but with 256-bit accumulators. len must be a
+  multiple of 16 and at least 128.
+ */
+local Z_TARGET("avx2,pclmul,vpclmulqdq")
+z_crc_t crc32_vpclmul(z_crc_t crc, const unsigned char FAR *buf,
+                      z_size_t len) {
+    const __m256i k1024 = _mm256_set_epi64x(0x014a7fe880, 0x01e88ef372,
+                                            0x014a7fe880, 0x01e88ef372);
+    const __m256i k256 = _mm256_set_epi64x(0x015a546366, 0x00f1da05aa,
+                                           0x015a546366, 0x00f1da05aa);
+    const __m128i k128 = _mm_set_epi64x(0x00ccaa009e, 0x01751997d0);
+    __m256i y0, y1, y2, y3, t0, t1, t2, t3;
+    __m128i x, t;
+
+    y0 = _mm256_loadu_si256((const __m256i *)buf);
+    y1 = _mm256_loadu_si256((const __m256i *)(buf + 32));
+    y2 = _mm256_loadu_si256((const __m256i *)(buf + 64));
+    y3 = _mm256_loadu_si256((const __m256i *)(buf + 96));
+    y0 = _mm256_xor_si256(y0, _mm256_setr_epi32((int)crc, 0, 0, 0, 0, 0, 0, 0));
+    buf += 128;
+    len -= 128;
+
+    while (len >= 128) {
+        t0 = _mm256_clmulepi64_epi128(y0, k1024, 0x00);
+        t1 = _mm256_clmulepi64_epi128(y1, k1024, 0x00);
+        t2 = _mm256_clmulepi64_epi128(y2, k1024, 0x00);
+        t3 = _mm256_clmulepi64_epi128(y3, k1024, 0x00);
+        y0 = _mm256_clmulepi64_epi128(y0, k1024, 0x11);
+        y1 = _mm256_clmulepi64_epi128(y1, k1024, 0x11);
+        y2 = _mm256_clmulepi64_epi128(y2, k1024, 0x11);
+        y3 = _mm256_clmulepi64_epi128(y3, k1024, 0x11);
+        y0 = _mm256_xor_si256(_mm256_xor_si256(y0, t0),
+                              _mm256_loadu_si256((const __m256i *)buf));
+        y1 = _mm256_xor_si256(_mm256_xor_si256(y1, t1),
+                              _mm256_loadu_si256((const __m256i *)(buf + 32)));
+        y2 = _mm256_xor_si256(_mm256_xor_si256(y2, t2),
+                              _mm256_loadu_si256((const __m256i *)(buf + 64)));
+        y3 = _mm256_xor_si256(_mm256_xor_si256(y3, t3),
+                              _mm256_loadu_si256((const __m256i *)(buf + 96)));
+        buf += 128;
+        len -= 128;
+    }
+
+    /* Fold the four accumulators into one. */
+    t0 = _mm256_clmulepi64_epi128(y0, k256, 0x00);
+    y0 = _mm256_clmulepi64_epi128(y0, k256, 0x11);
+    y0 = _mm256_xor_si256(_mm256_xor_si256(y0, t0), y1);
+    t0 = _mm256_clmulepi64_epi128(y0, k256, 0x00);
+    y0 = _mm256_clmulepi64_epi128(y0, k256, 0x11);
+    y0 = _mm256_xor_si256(_mm256_xor_si256(y0, t0), y2);
+    t0 = _mm256_clmulepi64_epi128(y0, k256, 0x00);
+    y0 = _mm256_clmulepi64_epi128(y0, k256, 0x11);
+    y0 = _mm256_xor_si256(_mm256_xor_si256(y0, t0), y3);
+
+    /* Fold the lower half of the accumulator into the upper half. */
+    x = _mm256_castsi256_si128(y0);
+    t = _mm_clmulepi64_si128(x, k128, 0x00);
+    x = _mm_clmulepi64_si128(x, k128, 0x11);
+    x = _mm_xor_si128(_mm_xor_si128(x, t), _mm256_extracti128_si256(y0, 1));
+
+    return crc32_fold_final(x, buf, len);
+}
+
+#endif /* Z_X86_SIMD */
+
 #ifdef W
 
 /*
@@ -703,6 +871,26 @@ unsigned long ZEXPORT crc32_z(unsigned long crc, const unsigned char FAR *buf,
     /* Pre-condition the CRC */
     crc = (~crc) & 0xffffffff;
 
+#ifdef Z_X86_SIMD
+    /* Fold as many 16-byte blocks as possible with carry-less multiplication,
+       leaving the remaining bytes to the code below. */
+    if (len >= 64) {
+        int features = z_x86_cpu_features();
+        z_size_t blocks = len & ~(z_size_t)15;
+        const int pclmul = Z_X86_SSE41 | Z_X86_PCLMUL;
+
+        if ((features & (pclmul | Z_X86_VPCLMUL)) == (pclmul | Z_X86_VPCLMUL) &&
+            len >= 256)
+            crc = crc32_vpclmul((z_crc_t)crc, buf, blocks);
+        else if ((features & pclmul) == pclmul)
+            crc = crc32_pclmul((z_crc_t)crc, buf, blocks);
+        else
+            blocks = 0;
+        buf += blocks;
+        len -= blocks;
+    }
+#endif
+
 #ifdef W
 
     /* If provided enough bytes, do a braided CRC calculation. */
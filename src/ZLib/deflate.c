@@ -51,6 +51,18 @@
 
 #include "deflate.h"
 
+#if defined(__AVX2__)
+#  include <immintrin.h>
+#  define DEFLATE_COMPARE_AVX2
+#elif defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64) || \
+      (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#  include <emmintrin.h>
+#  define DEFLATE_COMPARE_SSE2
+#endif
+#if defined(_MSC_VER) && !defined(__clang__)
+#  include <intrin.h>
+#endif
+
 const char deflate_copyright[] =
    " deflate 1.3.1 Copyright 1995-2024 Jean-loup Gailly and Mark Adler ";
 /*
@@ -73,6 +85,7 @@ typedef block_state (*compress_func)(deflate_state *s, int flush);
 local block_state deflate_stored(deflate_state *s, int flush);
 local block_state deflate_fast(deflate_state *s, int flush);
 #ifndef FASTEST
+local block_state deflate_quick(deflate_state *s, int flush);
 local block_state deflate_slow(deflate_state *s, int flush);
 #endif
 local block_state deflate_rle(deflate_state *s, int flush);
@@ -125,20 +138,26 @@ local const config configuration_table[10] = {
 #endif
 
 /* Note: the deflate() code requires max_lazy >= MIN_MATCH and max_chain >= 4
- * For deflate_fast() (levels <= 3) good is ignored and lazy has a different
- * meaning.
+ * For deflate_fast() (levels 1 to 3) good is ignored and lazy has a different
+ * meaning. deflate_quick() (the Z_QUICK strategy) ignores them all.
  */
 
 /* rank Z_BLOCK between Z_NO_FLUSH and Z_PARTIAL_FLUSH */
 #define RANK(f) (((f) * 2) - ((f) > 4 ? 9 : 0))
 
 /* ===========================================================================
- * Update a hash value with the given input byte
- * IN  assertion: all calls to UPDATE_HASH are made with consecutive input
- *    characters, so that a running hash key can be computed from the previous
- *    key instead of complete recalculation each time.
+ * Compute the hash key of the MIN_MATCH bytes at window[str]. This is a
+ * multiplicative (Fibonacci) hash of the three bytes, which spreads the keys
+ * over the table much better than a running shift-and-xor hash, so the hash
+ * chains contain fewer strings that can't match. Since the key no longer
+ * depends on the previous one, strings can be inserted in any order, but
+ * equal keys no longer imply an equal third byte.
  */
-#define UPDATE_HASH(s,h,c) (h = (((h) << s->hash_shift) ^ (c)) & s->hash_mask)
+#define HASH_STRING(s, str) \
+   ((uInt)(((((ulg)(s)->window[(str)] | \
+              ((ulg)(s)->window[(str) + 1] << 8) | \
+              ((ulg)(s)->window[(str) + 2] << 16)) * 2654435761UL) & 0xffffffffUL) >> \
+           (32 - (s)->hash_bits)))
 
 
 /* ===========================================================================
@@ -147,18 +166,17 @@ local const config configuration_table[10] = {
  * the previous length of the hash chain.
  * If this file is compiled with -DFASTEST, the compression level is forced
  * to 1, and no hash chains are maintained.
- * IN  assertion: all calls to INSERT_STRING are made with consecutive input
- *    characters and the first MIN_MATCH bytes of str are valid (except for
- *    the last MIN_MATCH-1 bytes of the input file).
+ * IN  assertion: the first MIN_MATCH bytes of str are valid (except for the
+ *    last MIN_MATCH-1 bytes of the input file).
  */
 #ifdef FASTEST
 #define INSERT_STRING(s, str, match_head) \
-   (UPDATE_HASH(s, s->ins_h, s->window[(str) + (MIN_MATCH-1)]), \
+   (s->ins_h = HASH_STRING(s, str), \
     match_head = s->head[s->ins_h], \
     s->head[s->ins_h] = (Pos)(str))
 #else
 #define INSERT_STRING(s, str, match_head) \
-   (UPDATE_HASH(s, s->ins_h, s->window[(str) + (MIN_MATCH-1)]), \
+   (s->ins_h = HASH_STRING(s, str), \
     match_head = s->prev[(str) & s->w_mask] = s->head[s->ins_h], \
     s->head[s->ins_h] = (Pos)(str))
 #endif
@@ -310,16 +328,13 @@ local void fill_window(deflate_state *s) {
         n = read_buf(s->strm, s->window + s->strstart + s->lookahead, more);
         s->lookahead += n;
 
-        /* Initialize the hash value now that we have some input: */
+        /* Insert the strings left over from the previous call now that we
+         * have enough input to hash them:
+         */
         if (s->lookahead + s->insert >= MIN_MATCH) {
             uInt str = s->strstart - s->insert;
-            s->ins_h = s->window[str];
-            UPDATE_HASH(s, s->ins_h, s->window[str + 1]);
-#if MIN_MATCH != 3
-            Call UPDATE_HASH() MIN_MATCH-3 more times
-#endif
             while (s->insert) {
-                UPDATE_HASH(s, s->ins_h, s->window[str + MIN_MATCH-1]);
+                s->ins_h = HASH_STRING(s, str);
 #ifndef FASTEST
                 s->prev[str & s->w_mask] = s->head[s->ins_h];
 #endif
@@ -330,10 +345,6 @@ local void fill_window(deflate_state *s) {
                     break;
             }
         }
-        /* If the whole input has less than MIN_MATCH bytes, ins_h is garbage,
-         * but this is not important since only literal bytes will be emitted.
-         */
-
     } while (s->lookahead < MIN_LOOKAHEAD && s->strm->avail_in != 0);
 
     /* If the WIN_INIT bytes after the end of the current data have never been
@@ -432,7 +443,7 @@ int ZEXPORT deflateInit2_(z_streamp strm, int level, int method,
 #endif
     if (memLevel < 1 || memLevel > MAX_MEM_LEVEL || method != Z_DEFLATED ||
         windowBits < 8 || windowBits > 15 || level < 0 || level > 9 ||
-        strategy < 0 || strategy > Z_FIXED || (windowBits == 8 && wrap != 1)) {
+        strategy < 0 || strategy > Z_QUICK || (windowBits == 8 && wrap != 1)) {
         return Z_STREAM_ERROR;
     }
     if (windowBits == 8) windowBits = 9;  /* until 256-byte window bug fixed */
@@ -451,7 +462,6 @@ int ZEXPORT deflateInit2_(z_streamp strm, int level, int method,
     s->hash_bits = (uInt)memLevel + 7;
     s->hash_size = 1 << s->hash_bits;
     s->hash_mask = s->hash_size - 1;
-    s->hash_shift =  ((s->hash_bits + MIN_MATCH-1) / MIN_MATCH);
 
     s->window = (Bytef *) ZALLOC(strm, s->w_size, 2*sizeof(Byte));
     s->prev   = (Posf *)  ZALLOC(strm, s->w_size, sizeof(Pos));
@@ -596,7 +606,7 @@ int ZEXPORT deflateSetDictionary(z_streamp strm, const Bytef *dictionary,
         str = s->strstart;
         n = s->lookahead - (MIN_MATCH-1);
         do {
-            UPDATE_HASH(s, s->ins_h, s->window[str + MIN_MATCH-1]);
+            s->ins_h = HASH_STRING(s, str);
 #ifndef FASTEST
             s->prev[str & s->w_mask] = s->head[s->ins_h];
 #endif
@@ -768,7 +778,7 @@ int ZEXPORT deflateParams(z_streamp strm, int level, int strategy) {
 #else
     if (level == Z_DEFAULT_COMPRESSION) level = 6;
 #endif
-    if (level < 0 || level > 9 || strategy < 0 || strategy > Z_FIXED) {
+    if (level < 0 || level > 9 || strategy < 0 || strategy > Z_QUICK) {
         return Z_STREAM_ERROR;
     }
     func = configuration_table[s->level].func;
@@ -1189,6 +1199,9 @@ int ZEXPORT deflate(z_streamp strm, int flush) {
         bstate = s->level == 0 ? deflate_stored(s, flush) :
                  s->strategy == Z_HUFFMAN_ONLY ? deflate_huff(s, flush) :
                  s->strategy == Z_RLE ? deflate_rle(s, flush) :
+#ifndef FASTEST
+                 s->strategy == Z_QUICK ? deflate_quick(s, flush) :
+#endif
                  (*(configuration_table[s->level].func))(s, flush);
 
         if (bstate == finish_started || bstate == finish_done) {
@@ -1342,6 +1355,67 @@ int ZEXPORT deflateCopy(z_streamp dest, z_streamp source) {
 #endif /* MAXSEG_64K */
 }
 
+/* ===========================================================================
+ * Return the index of the lowest set bit of x, which must not be zero.
+ */
+#if defined(DEFLATE_COMPARE_AVX2) || defined(DEFLATE_COMPARE_SSE2)
+local unsigned lowest_bit(unsigned x) {
+#  if defined(_MSC_VER) && !defined(__clang__)
+    unsigned long index;
+    _BitScanForward(&index, x);
+    return (unsigned)index;
+#  else
+    return (unsigned)__builtin_ctz(x);
+#  endif
+}
+#endif
+
+/* ===========================================================================
+ * Return the number of leading bytes, at most 256, that are equal in the
+ * strings at src0 and src1. Both strings must have 256 readable bytes. The
+ * bytes are compared 32 (AVX2), 16 (SSE2) or 8 (64-bit little-endian
+ * targets) at a time instead of one by one.
+ */
+local unsigned compare256(const Bytef *src0, const Bytef *src1) {
+    unsigned len = 0;
+#if defined(DEFLATE_COMPARE_AVX2)
+    do {
+        __m256i a = _mm256_loadu_si256((const __m256i *)(src0 + len));
+        __m256i b = _mm256_loadu_si256((const __m256i *)(src1 + len));
+        unsigned mask = (unsigned)_mm256_movemask_epi8(_mm256_cmpeq_epi8(a, b));
+        if (mask != 0xffffffffU)
+            return len + lowest_bit(~mask);
+        len += 32;
+    } while (len < 256);
+#elif defined(DEFLATE_COMPARE_SSE2)
+    do {
+        __m128i a = _mm_loadu_si128((const __m128i *)(src0 + len));
+        __m128i b = _mm_loadu_si128((const __m128i *)(src1 + len));
+        unsigned mask = (unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(a, b));
+        if (mask != 0xffff)
+            return len + lowest_bit(~mask & 0xffff);
+        len += 16;
+    } while (len < 256);
+#elif (defined(__GNUC__) || defined(__clang__)) && defined(__SIZEOF_LONG_LONG__) && \
+      __SIZEOF_LONG_LONG__ == 8 && defined(__BYTE_ORDER__) && \
+      __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    do {
+        unsigned long long a, b;
+        zmemcpy(&a, src0 + len, sizeof(a));
+        zmemcpy(&b, src1 + len, sizeof(b));
+        if (a != b)
+            return len + (unsigned)__builtin_ctzll(a ^ b) / 8;
+        len += 8;
+    } while (len < 256);
+#else
+    do {
+        if (src0[len] != src1[len])
+            return len;
+    } while (++len < 256);
+#endif
+    return 256;
+}
+
 #ifndef FASTEST
 /* ===========================================================================
  * Set match_start to the longest match starting at the given string and
@@ -1366,23 +1440,9 @@ local uInt longest_match(deflate_state *s, IPos cur_match) {
      */
     Posf *prev = s->prev;
     uInt wmask = s->w_mask;
-
-#ifdef UNALIGNED_OK
-    /* Compare two bytes at a time. Note: this is not always beneficial.
-     * Try with and without -DUNALIGNED_OK to check.
-     */
-    register Bytef *strend = s->window + s->strstart + MAX_MATCH - 1;
-    register ush scan_start = *(ushf*)scan;
-    register ush scan_end   = *(ushf*)(scan + best_len - 1);
-#else
-    register Bytef *strend = s->window + s->strstart + MAX_MATCH;
     register Byte scan_end1  = scan[best_len - 1];
     register Byte scan_end   = scan[best_len];
-#endif
 
-    /* The code is optimized for HASH_BITS >= 8 and MAX_MATCH-2 multiple of 16.
-     * It is easy to get rid of this optimization if necessary.
-     */
     Assert(s->hash_bits >= 8 && MAX_MATCH == 258, "Code too clever");
 
     /* Do not waste too much time if we already have a good match: */
@@ -1409,84 +1469,23 @@ local uInt longest_match(deflate_state *s, IPos cur_match) {
          * However the length of the match is limited to the lookahead, so
          * the output of deflate is not affected by the uninitialized values.
          */
-#if (defined(UNALIGNED_OK) && MAX_MATCH == 258)
-        /* This code assumes sizeof(unsigned short) == 2. Do not use
-         * UNALIGNED_OK if your compiler uses a different size.
-         */
-        if (*(ushf*)(match + best_len - 1) != scan_end ||
-            *(ushf*)match != scan_start) continue;
-
-        /* It is not necessary to compare scan[2] and match[2] since they are
-         * always equal when the other bytes match, given that the hash keys
-         * are equal and that HASH_BITS >= 8. Compare 2 bytes at a time at
-         * strstart + 3, + 5, up to strstart + 257. We check for insufficient
-         * lookahead only every 4th comparison; the 128th check will be made
-         * at strstart + 257. If MAX_MATCH-2 is not a multiple of 8, it is
-         * necessary to put more guard bytes at the end of the window, or
-         * to check more often for insufficient lookahead.
-         */
-        Assert(scan[2] == match[2], "scan[2]?");
-        scan++, match++;
-        do {
-        } while (*(ushf*)(scan += 2) == *(ushf*)(match += 2) &&
-                 *(ushf*)(scan += 2) == *(ushf*)(match += 2) &&
-                 *(ushf*)(scan += 2) == *(ushf*)(match += 2) &&
-                 *(ushf*)(scan += 2) == *(ushf*)(match += 2) &&
-                 scan < strend);
-        /* The funny "do {}" generates better code on most compilers */
-
-        /* Here, scan <= window + strstart + 257 */
-        Assert(scan <= s->window + (unsigned)(s->window_size - 1),
-               "wild scan");
-        if (*scan == *match) scan++;
-
-        len = (MAX_MATCH - 1) - (int)(strend - scan);
-        scan = strend - (MAX_MATCH-1);
-
-#else /* UNALIGNED_OK */
-
         if (match[best_len]     != scan_end  ||
             match[best_len - 1] != scan_end1 ||
-            *match              != *scan     ||
-            *++match            != scan[1])      continue;
-
-        /* The check at best_len - 1 can be removed because it will be made
-         * again later. (This heuristic is not always a win.)
-         * It is not necessary to compare scan[2] and match[2] since they
-         * are always equal when the other bytes match, given that
-         * the hash keys are equal and that HASH_BITS >= 8.
-         */
-        scan += 2, match++;
-        Assert(*scan == *match, "match[2]?");
+            match[0]            != scan[0]   ||
+            match[1]            != scan[1])      continue;
 
-        /* We check for insufficient lookahead only every 8th comparison;
-         * the 256th check will be made at strstart + 258.
+        /* The hash keys being equal doesn't imply that scan[2] and match[2]
+         * are, so compare from there on. compare256() reads at most up to
+         * strstart + 258, which is within the window.
          */
-        do {
-        } while (*++scan == *++match && *++scan == *++match &&
-                 *++scan == *++match && *++scan == *++match &&
-                 *++scan == *++match && *++scan == *++match &&
-                 *++scan == *++match && *++scan == *++match &&
-                 scan < strend);
-
-        Assert(scan <= s->window + (unsigned)(s->window_size - 1),
-               "wild scan");
-
-        len = MAX_MATCH - (int)(strend - scan);
-        scan = strend - MAX_MATCH;
-
-#endif /* UNALIGNED_OK */
+        len = 2 + (int)compare256(scan + 2, match + 2);
 
         if (len > best_len) {
             s->match_start = cur_match;
             best_len = len;
             if (len >= nice_match) break;
-#ifdef UNALIGNED_OK
-            scan_end = *(ushf*)(scan + best_len - 1);
-#else
             scan_end1  = scan[best_len - 1];
             scan_end   = scan[best_len];
-#endif
         }
     } while ((cur_match = prev[cur_match & wmask]) > limit
              && --chain_length != 0);
@@ -1504,11 +1503,7 @@ local uInt longest_match(deflate_state *s, IPos cur_match) {
     register Bytef *scan = s->window + s->strstart; /* current string */
     register Bytef *match;                       /* matched string */
     register int len;                           /* length of current match */
-    register Bytef *strend = s->window + s->strstart + MAX_MATCH;
 
-    /* The code is optimized for HASH_BITS >= 8 and MAX_MATCH-2 multiple of 16.
-     * It is easy to get rid of this optimization if necessary.
-     */
     Assert(s->hash_bits >= 8 && MAX_MATCH == 258, "Code too clever");
 
     Assert((ulg)s->strstart <= s->window_size - MIN_LOOKAHEAD,
@@ -1522,28 +1517,10 @@ local uInt longest_match(deflate_state *s, IPos cur_match) {
      */
     if (match[0] != scan[0] || match[1] != scan[1]) return MIN_MATCH-1;
 
-    /* The check at best_len - 1 can be removed because it will be made
-     * again later. (This heuristic is not always a win.)
-     * It is not necessary to compare scan[2] and match[2] since they
-     * are always equal when the other bytes match, given that
-     * the hash keys are equal and that HASH_BITS >= 8.
-     */
-    scan += 2, match += 2;
-    Assert(*scan == *match, "match[2]?");
-
-    /* We check for insufficient lookahead only every 8th comparison;
-     * the 256th check will be made at strstart + 258.
+    /* The hash keys being equal doesn't imply that scan[2] and match[2] are,
+     * so compare from there on.
      */
-    do {
-    } while (*++scan == *++match && *++scan == *++match &&
-             *++scan == *++match && *++scan == *++match &&
-             *++scan == *++match && *++scan == *++match &&
-             *++scan == *++match && *++scan == *++match &&
-             scan < strend);
-
-    Assert(scan <= s->window + (unsigned)(s->window_size - 1), "wild scan");
-
-    len = MAX_MATCH - (int)(strend - scan);
+    len = 2 + (int)compare256(scan + 2, match + 2);
 
     if (len < MIN_MATCH) return MIN_MATCH - 1;
 
@@ -1880,14 +1857,6 @@ local block_state deflate_fast(deflate_state *s, int flush) {
             {
                 s->strstart += s->match_length;
                 s->match_length = 0;
-                s->ins_h = s->window[s->strstart];
-                UPDATE_HASH(s, s->ins_h, s->window[s->strstart + 1]);
-#if MIN_MATCH != 3
-                Call UPDATE_HASH() MIN_MATCH-3 more times
-#endif
-                /* If lookahead < MIN_MATCH, ins_h is garbage, but it does not
-                 * matter since it will be recomputed at next deflate call.
-                 */
             }
         } else {
             /* No match, output a literal byte */
@@ -1910,7 +1879,79 @@ local block_state deflate_fast(deflate_state *s, int flush) {
 
 #ifndef FASTEST
 /* ===========================================================================
- * Same as above, but achieves better compression. We use a lazy
+ * Compress as much as possible from the input stream, return the current
+ * block state.
+ * This is the Z_QUICK strategy, modeled on zlib-ng's deflate_quick(): it
+ * only tries the most recent string with the same hash key instead of
+ * walking the hash chain, never defers a match, and does not insert the
+ * strings inside a match in the dictionary. That makes it faster than level 1
+ * on data with few long matches, such as source text, but it compresses
+ * highly repetitive data far worse, so it has to be asked for. It still emits
+ * the same kind of blocks as the other strategies, at any nonzero level.
+ */
+local block_state deflate_quick(deflate_state *s, int flush) {
+    IPos hash_head;       /* most recent string with the same hash key */
+    int bflush;           /* set if current block must be flushed */
+    uInt match_len;       /* length of the match at hash_head */
+
+    for (;;) {
+        /* Make sure that we always have enough lookahead, except
+         * at the end of the input file. We need MAX_MATCH bytes
+         * for the next match, plus MIN_MATCH bytes to insert the
+         * string following the next match.
+         */
+        if (s->lookahead < MIN_LOOKAHEAD) {
+            fill_window(s);
+            if (s->lookahead < MIN_LOOKAHEAD && flush == Z_NO_FLUSH) {
+                return need_more;
+            }
+            if (s->lookahead == 0) break; /* flush the current block */
+        }
+
+        if (s->lookahead >= MIN_MATCH) {
+            INSERT_STRING(s, s->strstart, hash_head);
+
+            /* As in deflate_fast(), matches with the string of window index
+             * 0 are not considered.
+             */
+            if (hash_head != NIL && s->strstart - hash_head <= MAX_DIST(s)) {
+                Bytef *scan = s->window + s->strstart;
+                Bytef *match = s->window + hash_head;
+                if (scan[0] == match[0] && scan[1] == match[1]) {
+                    match_len = 2 + compare256(scan + 2, match + 2);
+                    if (match_len > s->lookahead) match_len = s->lookahead;
+                    if (match_len >= MIN_MATCH) {
+                        check_match(s, s->strstart, hash_head, match_len);
+                        _tr_tally_dist(s, s->strstart - hash_head,
+                                       match_len - MIN_MATCH, bflush);
+                        s->lookahead -= match_len;
+                        s->strstart += match_len;
+                        if (bflush) FLUSH_BLOCK(s, 0);
+                        continue;
+                    }
+                }
+            }
+        }
+
+        /* No match, output a literal byte */
+        Tracevv((stderr,"%c", s->window[s->strstart]));
+        _tr_tally_lit(s, s->window[s->strstart], bflush);
+        s->lookahead--;
+        s->strstart++;
+        if (bflush) FLUSH_BLOCK(s, 0);
+    }
+    s->insert = s->strstart < MIN_MATCH-1 ? s->strstart : MIN_MATCH-1;
+    if (flush == Z_FINISH) {
+        FLUSH_BLOCK(s, 1);
+        return finish_done;
+    }
+    if (s->sym_next)
+        FLUSH_BLOCK(s, 0);
+    return block_done;
+}
+
+/* ===========================================================================
+ * Same as deflate_fast(), but achieves better compression. We use a lazy
  * evaluation for matches: a match is finally adopted only if there is
  * no better match at the next window position.
  */
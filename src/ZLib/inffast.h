@@ -8,4 +8,23 @@
    subject to change. Applications should only use zlib.h.
  */
 
+/* inflate_fast() refills its bit buffer 64 bits at a time and copies matches
+   in chunks of up to 32 bytes on little-endian targets with a 64-bit type.
+   Those chunk copies may write up to 31 bytes past the end of a match.
+   AArch64 can be big-endian (aarch64_be), so it is only covered by the
+   byte order test; MSVC's ARM64 target is always little-endian. */
+#if defined(Z_U8) && !defined(ASMINF) && \
+    (defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || \
+     defined(_M_IX86) || defined(_M_ARM64) || \
+     (defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__))
+#  define INFLATE_FAST_WIDE
+#  define INFLATE_FAST_MIN_HAVE 8
+#  define INFLATE_FAST_MIN_LEFT (258 + 31)
+#else
+#  define INFLATE_FAST_MIN_HAVE 6
+#  define INFLATE_FAST_MIN_LEFT 258
+#endif
+
+/* inflate_fast() must only be called with at least INFLATE_FAST_MIN_HAVE
+   bytes of input and INFLATE_FAST_MIN_LEFT bytes of output available */
 void ZLIB_INTERNAL inflate_fast(z_streamp strm, unsigned start);
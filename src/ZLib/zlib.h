@@ -201,6 +201,7 @@ typedef gz_header FAR *gz_headerp;
 #define Z_HUFFMAN_ONLY        2
 #define Z_RLE                 3
 #define Z_FIXED               4
+#define Z_QUICK               5
 #define Z_DEFAULT_STRATEGY    0
 /* compression strategy; see deflateInit2() below for details */
 
@@ -602,7 +603,11 @@ ZEXTERN int ZEXPORT deflateInit2(z_streamp strm,
    strategy parameter only affects the compression ratio but not the
    correctness of the compressed output even if it is not set appropriately.
    Z_FIXED prevents the use of dynamic Huffman codes, allowing for a simpler
-   decoder for special applications.
+   decoder for special applications.  Z_QUICK (an extension of this copy of
+   zlib) trades compression for speed beyond level 1: it makes one match
+   attempt per position and does not index the strings inside matches, which
+   is faster on text-like data but much worse on highly repetitive data.  With
+   Z_QUICK, the level is ignored except for level 0, which still stores.
 
      deflateInit2 returns Z_OK if success, Z_MEM_ERROR if there was not enough
    memory, Z_STREAM_ERROR if any parameter is invalid (such as an invalid
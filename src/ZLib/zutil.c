@@ -125,6 +125,72 @@ void ZLIB_INTERNAL z_error(char *m) {
 }
 #endif
 
+#ifdef Z_X86_SIMD
+#  if defined(_MSC_VER) && !defined(__clang__)
+#    include <intrin.h>
+#  else
+#    include <cpuid.h>
+#  endif
+
+local void z_cpuid(unsigned leaf, unsigned subleaf, unsigned regs[4]) {
+#  if defined(_MSC_VER) && !defined(__clang__)
+    __cpuidex((int *)regs, (int)leaf, (int)subleaf);
+#  else
+    __cpuid_count(leaf, subleaf, regs[0], regs[1], regs[2], regs[3]);
+#  endif
+}
+
+/* Return the register state the operating system saves on context switches */
+local unsigned z_xgetbv0(void) {
+#  if defined(_MSC_VER) && !defined(__clang__)
+    return (unsigned)_xgetbv(0);
+#  else
+    unsigned eax, edx;
+    __asm__ volatile(".byte 0x0f, 0x01, 0xd0" : "=a"(eax), "=d"(edx) : "c"(0));
+    return eax;
+#  endif
+}
+
+/* Return the Z_X86_* flags of the instruction set extensions that both the
+ * processor and the operating system support. The flags are determined on
+ * the first call. Concurrent first calls are harmless, since they all store
+ * the same value.
+ */
+int ZLIB_INTERNAL z_x86_cpu_features(void) {
+    static volatile int cached = -1;
+    unsigned regs[4];
+    unsigned max_leaf;
+    int features;
+
+    features = cached;
+    if (features >= 0)
+        return features;
+
+    features = 0;
+    z_cpuid(0, 0, regs);
+    max_leaf = regs[0];
+    z_cpuid(1, 0, regs);
+    if (regs[2] & (1U << 9))
+        features |= Z_X86_SSSE3;
+    if (regs[2] & (1U << 19))
+        features |= Z_X86_SSE41;
+    if (regs[2] & (1U << 1))
+        features |= Z_X86_PCLMUL;
+    /* AVX2 also needs OSXSAVE, AVX and the OS saving the YMM registers */
+    if ((regs[2] & (1U << 27)) && (regs[2] & (1U << 28)) &&
+        (z_xgetbv0() & 6) == 6 && max_leaf >= 7) {
+        z_cpuid(7, 0, regs);
+        if (regs[1] & (1U << 5)) {
+            features |= Z_X86_AVX2;
+            if (regs[2] & (1U << 10))
+                features |= Z_X86_VPCLMUL;
+        }
+    }
+    cached = features;
+    return features;
+}
+#endif
+
 /* exported to allow conversion of error code to string for compress() and
  * uncompress()
  */
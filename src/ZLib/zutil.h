@@ -253,6 +253,26 @@ extern z_const char * const z_errmsg[10]; /* indexed by 2-zlib_error */
 #define ZFREE(strm, addr)  (*((strm)->zfree))((strm)->opaque, (voidpf)(addr))
 #define TRY_FREE(s, p) {if (p) ZFREE(s, p);}
 
+/* SIMD code paths for x86-64 that are selected at run time, depending on
+   the flags returned by z_x86_cpu_features() */
+#if (defined(__x86_64__) || defined(_M_X64)) && !defined(_M_ARM64EC) && \
+    ((defined(__clang__) && __clang_major__ >= 6) || \
+     (!defined(__clang__) && defined(__GNUC__) && __GNUC__ >= 8) || \
+     (!defined(__clang__) && defined(_MSC_VER) && _MSC_VER >= 1920))
+#  define Z_X86_SIMD
+#  define Z_X86_SSSE3   0x01
+#  define Z_X86_SSE41   0x02
+#  define Z_X86_PCLMUL  0x04
+#  define Z_X86_AVX2    0x08
+#  define Z_X86_VPCLMUL 0x10
+#  if defined(__GNUC__) || defined(__clang__)
+#    define Z_TARGET(x) __attribute__((target(x)))
+#  else
+#    define Z_TARGET(x)
+#  endif
+   int ZLIB_INTERNAL z_x86_cpu_features(void);
+#endif
+
 /* Reverse the bytes in a 32-bit value */
 #define ZSWAP32(q) ((((q) >> 24) & 0xff) + (((q) >> 8) & 0xff00) + \
                     (((q) & 0xff00) << 8) + (((q) & 0xff) << 24))